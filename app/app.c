@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include "sync.h"
 #include "circbuf.h"
+#include "mailbox.h"
 #include "sighandlers.h"
 #include "reader.h"
 #include "analyzer.h"
@@ -15,21 +16,269 @@
 #include "cpucount.h"
 #include "logger.h"
 #include "threadctl.h"
+#include "config.h"
+#include "flightrec.h"
+#include "recording.h"
+#include "snapsource.h"
+#include "latency.h"
+#include "topology.h"
+#include "cpulist.h"
+#include "cpumap.h"
+#include "proctrack.h"
+#include "cgtrack.h"
+#include "irqtrack.h"
+#include "idletrack.h"
+#include "stealtrack.h"
+#include "procscan.h"
 
 
 #define PROCSTAT_CBUF_CAPACITY 10u
-#define USAGEINFO_CBUF_CAPACITY 1u
 
 
-int main()
+int main(int argc, char* argv[])
 {
+	Config_t config;
+	Config_setDefaults(&config);
+
+	int configResult = Config_parseArgs(&config, argc, argv);
+
+	if (0 != configResult)
+	{
+		Config_printUsage((0 < configResult) ? stdout : stderr, argv[0]);
+		return (0 < configResult) ? 0 : 1;
+	}
+
 	RegisterSigintHandler();
 	RegisterSigtermHandler();
-	CpuCount_init();
+	RegisterSigusr2Handler();
 	ThreadInfo_init();
 	Logger_init();
+
+	if (NULL != config.procRoot)
+	{
+		ProcStat_setProcRoot(config.procRoot);
+	}
+
+	// Frequencies of this system do not describe simulated processors
+	const char* freqSysRoot = (NULL != config.sysRoot) ? config.sysRoot : TOPOLOGY_SYS_ROOT_DEFAULT;
+	SnapshotSource_t* source = (NULL != config.replayPath)
+		? SnapshotSource_createReplay(config.replayPath, config.replayFast)
+		: SnapshotSource_createLive((0u == config.cpuCount) ? freqSysRoot : NULL);
+
+	if (NULL == source)
+	{
+		fprintf(stderr, "cannot open snapshot source\n");
+		return 1;
+	}
+
+	// Replayed snapshots describe processors of the system they have been recorded on
+	if (NULL != config.replayPath)
+	{
+		CpuCount_override((int) SnapshotSource_getCpuStatsLength(source) - 1);
+	}
+	else if (0u != config.cpuCount)
+	{
+		CpuCount_override((int) config.cpuCount);
+	}
+	else if (NULL == config.cpuList)
+	{
+		// Processors that may be hot-added later are given slots up front, so that no buffer is ever resized
+		const int possibleCount = CpuMap_getPossibleCount(config.sysRoot);
+		CpuCount_init();
+
+		if (possibleCount > CpuCount_get())
+		{
+			CpuCount_override(possibleCount);
+		}
+	}
+
+	CpuList_t* cpuSelection = NULL;
+
+	if (NULL != config.cpuList)
+	{
+		cpuSelection = CpuList_fromSpec(config.cpuList);
+
+		if (NULL == cpuSelection)
+		{
+			fprintf(stderr, "invalid processor list: %s\n", config.cpuList);
+			return 1;
+		}
+
+		// Buffers of every stage are sized to selected processors from now on,
+		// ones missing from /proc/stat are offline and tracked once they come online
+		CpuCount_select(cpuSelection->cpus, cpuSelection->length);
+		ProcStat_t* probe = ProcStat_loadFromFile();
+
+		if (NULL == probe)
+		{
+			fprintf(stderr, "cannot read /proc/stat\n");
+			return 1;
+		}
+
+		ProcStat_destroy(probe);
+	}
+
+	CpuCount_init();
 	Watchdog_init();
 
+	// Room for frequency-weighted usage would otherwise be left unused in every buffer of usage
+	CpuUsageCompact_reserveEffective(SnapshotSource_hasFreqs(source));
+
+	CpuTopology_t* topology = NULL;
+
+	if (0u != config.rollupLevels)
+	{
+		// Topology of this system does not describe replayed or simulated processors
+		const bool foreignData = (NULL != config.replayPath) || (0u != config.cpuCount);
+		topology = foreignData ? NULL : Topology_load(config.sysRoot, (size_t) CpuCount_get());
+
+		if (NULL == topology)
+		{
+			if (!foreignData)
+			{
+				fprintf(stderr, "cannot load processor topology, assuming every processor is a separate core\n");
+			}
+
+			topology = Topology_createFlat((size_t) CpuCount_get());
+		}
+
+		if (NULL == topology)
+		{
+			fprintf(stderr, "cannot create processor topology\n");
+			return 1;
+		}
+	}
+
+	CpuMap_t* cpuMap = NULL;
+
+	// Online processor set only describes snapshots read from this system
+	if ((NULL == config.replayPath) && (0u == config.cpuCount))
+	{
+		cpuMap = CpuMap_create(config.sysRoot);
+
+		if (NULL == cpuMap)
+		{
+			fprintf(stderr, "cannot read online processor set, processor hotplug is not reported\n");
+		}
+	}
+
+	const bool flightRecorderEnabled = (0u != config.flightWindowMs);
+
+	if (flightRecorderEnabled &&
+		(0 != FlightRecorder_init(config.flightWindowMs, config.flightPeriodMs, config.flightThresholdPct, config.flightDirectory)))
+	{
+		fprintf(stderr, "cannot initialize flight recorder\n");
+		return 1;
+	}
+
+	if (!flightRecorderEnabled)
+	{
+		Watchdog_disableMonitoring(TID_RECORDER);
+		Watchdog_disableMonitoring(TID_DUMPER);
+	}
+
+	ProcTracker_t* procTracker = NULL;
+
+	if (NULL != config.threadsOf)
+	{
+		const int pid = ProcTracker_resolvePid(config.threadsOf);
+		procTracker = (0 < pid) ? ProcTracker_createForThreads(config.procRoot, pid, config.topCount, config.topSlices) : NULL;
+
+		if (NULL == procTracker)
+		{
+			fprintf(stderr, "cannot track threads of %s\n", config.threadsOf);
+			return 1;
+		}
+	}
+	else if (0u != config.topCount)
+	{
+		procTracker = ProcTracker_create(config.procRoot, config.topCount, config.topSlices);
+
+		if (NULL == procTracker)
+		{
+			fprintf(stderr, "cannot track processes\n");
+			return 1;
+		}
+	}
+
+	CgroupTracker_t* cgroupTracker = NULL;
+
+	if (NULL != config.cgroups)
+	{
+		cgroupTracker = CgroupTracker_create(config.cgroups, config.cgroupSubtree, config.cgroupTopCount, config.topSlices);
+
+		if (NULL == cgroupTracker)
+		{
+			fprintf(stderr, "cannot track cgroups %s\n", config.cgroups);
+			return 1;
+		}
+	}
+
+	IrqTracker_t* irqTracker = NULL;
+
+	if (0u != config.irqHotCount)
+	{
+		irqTracker = IrqTracker_create(config.procRoot, config.irqHotCount, config.topSlices);
+
+		if (NULL == irqTracker)
+		{
+			fprintf(stderr, "cannot track interrupts\n");
+			return 1;
+		}
+	}
+
+	IdleTracker_t* idleTracker = NULL;
+
+	if (0u != config.idleFilesPerCpu)
+	{
+		idleTracker = IdleTracker_create(config.sysRoot, config.idleFilesPerCpu, config.topSlices);
+
+		if (NULL == idleTracker)
+		{
+			fprintf(stderr, "cannot track idle states\n");
+			return 1;
+		}
+	}
+
+	// Cgroups, interrupts and idle states are scanned by the same thread as processes
+	const bool procScannerEnabled = (NULL != procTracker) || (NULL != cgroupTracker) || (NULL != irqTracker) ||
+		(NULL != idleTracker);
+
+	if (!procScannerEnabled)
+	{
+		Watchdog_disableMonitoring(TID_PROCSCAN);
+	}
+
+	StealTracker_t* stealTracker = NULL;
+
+	if (0u != config.stealThresholdPct)
+	{
+		stealTracker = StealTracker_create(config.stealThresholdPct, config.stealSustain);
+
+		if (NULL == stealTracker)
+		{
+			fprintf(stderr, "cannot track steal\n");
+			return 1;
+		}
+	}
+
+	RecordingWriter_t* recorder = NULL;
+
+	if (NULL != config.recordPath)
+	{
+		recorder = RecordingWriter_create(
+			config.recordPath,
+			(size_t) CpuCount_get() + 1u,
+			(size_t) config.recordSegmentMb * 1024u * 1024u,
+			config.recordKeyframeInterval);
+
+		if (NULL == recorder)
+		{
+			fprintf(stderr, "cannot start recording into %s\n", config.recordPath);
+			return 1;
+		}
+	}
+
 	Logger_setLogLevel(LLEVEL_DEBUG);
 
 	mtx_t procStatMtx;
@@ -39,20 +288,26 @@ int main()
 	cnd_t procStatNotEmptyCv;
 	cnd_t procStatNotFullCv;
 	cnd_t usageInfoNotEmptyCv;
-	cnd_t usageInfoNotFullCv;
 	cnd_init(&procStatNotEmptyCv);
 	cnd_init(&procStatNotFullCv);
 	cnd_init(&usageInfoNotEmptyCv);
-	cnd_init(&usageInfoNotFullCv);
 
-	CircularBuffer_t* procStatCbuf = CircularBuffer_create(ProcStat_size(), PROCSTAT_CBUF_CAPACITY);
-	CircularBuffer_t* usageInfoCbuf = CircularBuffer_create(CpuUsageInfo_size(), USAGEINFO_CBUF_CAPACITY);
+	CircularBuffer_t* procStatCbuf = CircularBuffer_create(config.deltaMode ? ProcStatDelta_size() : ProcStat_size(), PROCSTAT_CBUF_CAPACITY);
+	Mailbox_t* usageInfoMailbox = Mailbox_create(CpuUsageCompact_sizeWithRollups(topology));
+	Mailbox_t* procUsageMailbox = (NULL != procTracker) ? Mailbox_create(ProcUsageReport_size(config.topCount)) : NULL;
+	Mailbox_t* cgroupUsageMailbox = (NULL != cgroupTracker) ? Mailbox_create(CgroupUsageReport_size(config.cgroupTopCount)) : NULL;
+	Mailbox_t* irqUsageMailbox = (NULL != irqTracker) ? Mailbox_create(IrqUsageReport_size(config.irqHotCount)) : NULL;
+	Mailbox_t* idleUsageMailbox = (NULL != idleTracker) ? Mailbox_create(IdleUsageReport_size((size_t) CpuCount_get())) : NULL;
+	Mailbox_t* stealUsageMailbox = (NULL != stealTracker) ? Mailbox_create(StealUsageReport_size((size_t) CpuCount_get())) : NULL;
 	
 	thrd_t watchdogThrd;
 	thrd_t loggerThrd;
 	thrd_t readerThrd;
 	thrd_t analyzerThrd;
 	thrd_t printerThrd;
+	thrd_t recorderThrd;
+	thrd_t dumperThrd;
+	thrd_t procScannerThrd;
 
 	thrd_create(
 		&watchdogThrd,
@@ -72,7 +327,13 @@ int main()
 			.outMtx 		= &procStatMtx,
 			.outNotEmptyCv 	= &procStatNotEmptyCv,
 			.outNotFullCv 	= &procStatNotFullCv,
-			.outBuf 		= procStatCbuf
+			.outBuf 		= procStatCbuf,
+			.deltaMode 		= config.deltaMode,
+			.samplePeriodMs 	= config.samplePeriodMs,
+			.alignToWallClock 	= config.alignToWallClock,
+			.adaptiveParams 	= config.adaptive ? &config.adaptiveParams : NULL,
+			.source 			= source,
+			.cpuMap 			= cpuMap
 		});
 
 	thrd_create(
@@ -84,10 +345,15 @@ int main()
 			.inNotEmptyCv 	= &procStatNotEmptyCv,
 			.inNotFullCv 	= &procStatNotFullCv,
 			.inBuf 			= procStatCbuf,
+			.deltaMode 		= config.deltaMode,
 			.outMtx			= &usageInfoMtx,
 			.outNotEmptyCv 	= &usageInfoNotEmptyCv,
-			.outNotFullCv 	= &usageInfoNotFullCv,
-			.outBuf			= usageInfoCbuf
+			.outMailbox		= usageInfoMailbox,
+			.topology 		= topology,
+			.catchUp 		= config.catchUp,
+			.recorder 		= recorder,
+			.stealTracker 	= stealTracker,
+			.stealMailbox 	= stealUsageMailbox
 		});
 
 	thrd_create(
@@ -97,42 +363,141 @@ int main()
 		{
 			.inMtx 			= &usageInfoMtx,
 			.inNotEmptyCv 	= &usageInfoNotEmptyCv,
-			.inNotFullCv 	= &usageInfoNotFullCv,
-			.inBuf 			= usageInfoCbuf
+			.inMailbox 		= usageInfoMailbox,
+			.topology 		= topology,
+			.printCpus 		= config.printCpus,
+			.rollupLevels 	= config.rollupLevels,
+			.procMailbox 	= procUsageMailbox,
+			.procTopCount 	= config.topCount,
+			.cgroupMailbox 	= cgroupUsageMailbox,
+			.cgroupTopCount = config.cgroupTopCount,
+			.irqMailbox 	= irqUsageMailbox,
+			.irqHotCount 	= config.irqHotCount,
+			.idleMailbox 	= idleUsageMailbox,
+			.idleCpuCount 	= (size_t) CpuCount_get(),
+			.stealMailbox 	= stealUsageMailbox,
+			.stealCpuCount 	= (size_t) CpuCount_get(),
+			.out 			= stdout,
+			.clearScreen 	= config.clearScreen
 		});
 
+	if (flightRecorderEnabled)
+	{
+		thrd_create(
+			&recorderThrd,
+			FlightRecorderThread,
+			NULL);
+
+		thrd_create(
+			&dumperThrd,
+			FlightRecorderDumpThread,
+			NULL);
+	}
+
+	if (procScannerEnabled)
+	{
+		thrd_create(
+			&procScannerThrd,
+			ProcScannerThread,
+			&(ProcScannerThreadParams_t)
+			{
+				.tracker 		= procTracker,
+				.samplePeriodMs = config.samplePeriodMs,
+				.outMailbox 	= procUsageMailbox,
+				.targetSpec 	= config.threadsOf,
+				.cgroupTracker 	= cgroupTracker,
+				.cgroupMailbox 	= cgroupUsageMailbox,
+				.irqTracker 	= irqTracker,
+				.irqMailbox 	= irqUsageMailbox,
+				.idleTracker 	= idleTracker,
+				.idleMailbox 	= idleUsageMailbox
+			});
+	}
+
 	int watchdogResult;
 	int loggerResult;
 	int readerResult;
 	int analyzerResult;
 	int printerResult;
+	int recorderResult = 0;
+	int dumperResult = 0;
+	int procScannerResult = 0;
 	
 	thrd_join(printerThrd, &printerResult);
 	thrd_join(analyzerThrd, &analyzerResult);
 	thrd_join(readerThrd, &readerResult);
+
+	if (flightRecorderEnabled)
+	{
+		thrd_join(recorderThrd, &recorderResult);
+		thrd_join(dumperThrd, &dumperResult);
+	}
+
+	if (procScannerEnabled)
+	{
+		thrd_join(procScannerThrd, &procScannerResult);
+	}
+
 	thrd_join(loggerThrd, &loggerResult);
 	thrd_join(watchdogThrd, &watchdogResult);
 
-	cnd_destroy(&usageInfoNotFullCv);
 	cnd_destroy(&usageInfoNotEmptyCv);
 	cnd_destroy(&procStatNotFullCv);
-	cnd_destroy(&usageInfoNotEmptyCv);
+	cnd_destroy(&procStatNotEmptyCv);
 	mtx_destroy(&usageInfoMtx);
 	mtx_destroy(&procStatMtx);
 
-	CircularBuffer_destroy(usageInfoCbuf);
+	const uint64_t publishCount = Mailbox_getPublishCount(usageInfoMailbox);
+	const uint64_t dropCount = Mailbox_getDropCount(usageInfoMailbox);
+	Mailbox_destroy(usageInfoMailbox);
+	Mailbox_destroy(procUsageMailbox);
+	Mailbox_destroy(irqUsageMailbox);
+	Mailbox_destroy(idleUsageMailbox);
+	Mailbox_destroy(stealUsageMailbox);
+	Mailbox_destroy(cgroupUsageMailbox);
 	CircularBuffer_destroy(procStatCbuf);
 
+	RecordingWriter_destroy(recorder);
+	ProcTracker_destroy(procTracker);
+	CgroupTracker_destroy(cgroupTracker);
+	IrqTracker_destroy(irqTracker);
+	IdleTracker_destroy(idleTracker);
+	StealTracker_destroy(stealTracker);
+	Topology_destroy(topology);
+	CpuMap_destroy(cpuMap);
+	CpuList_destroy(cpuSelection);
+	SnapshotSource_destroy(source);
+	FlightRecorder_finalize();
 	ThreadInfo_finalize();
 	Watchdog_finalize();
 	Logger_finalize();
 
-	system("clear");
+	if (config.clearScreen)
+	{
+		system("clear");
+	}
+
 	printf("%-10s = %i\n", "Reader", readerResult);
 	printf("%-10s = %i\n", "Analyzer", analyzerResult);
 	printf("%-10s = %i\n", "Printer", printerResult);
 	printf("%-10s = %i\n", "Logger", loggerResult);
 	printf("%-10s = %i\n", "Watchdog", watchdogResult);
 
+	if (flightRecorderEnabled)
+	{
+		printf("%-10s = %i\n", "Recorder", recorderResult);
+		printf("%-10s = %i\n", "Dumper", dumperResult);
+	}
+
+	if (procScannerEnabled)
+	{
+		printf("%-10s = %i\n", "ProcScanner", procScannerResult);
+	}
+
+	Latency_printHistograms(stdout);
+	printf("Dropped frames: %llu of %llu\n",
+		(unsigned long long) dropCount,
+		(unsigned long long) publishCount);
+
 	return 0;
 }
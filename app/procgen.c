@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <getopt.h>
+#include "procgen.h"
+
+
+#define PROCGEN_DEFAULT_CPU_COUNT 	64u
+#define PROCGEN_DEFAULT_LOAD_PCT 	50.0
+#define PROCGEN_DEFAULT_PERIOD_MS 	100u
+#define PROCGEN_DEFAULT_ROOT 		"."
+#define PROCGEN_DEFAULT_SEED 		1u
+
+
+/**
+ * Generator parameters, populated from command-line arguments.
+*/
+typedef struct GeneratorParams
+{
+	/** Amount of generated processors. */
+	unsigned cpuCount;
+	/** Shape of applied load. */
+	ProcGenPattern_t pattern;
+	/** Base load, in percentage. */
+	double loadPct;
+	/** Period between consecutive file updates, in milliseconds. */
+	unsigned periodMs;
+	/** Amount of file updates to write, zero to write until killed. */
+	unsigned count;
+	/** Directory to write "stat" file into. */
+	const char* root;
+	/** Seed of pseudo-random number generator. */
+	unsigned seed;
+}
+GeneratorParams_t;
+
+
+static void printUsage(FILE* stream, const char* programName)
+{
+	fprintf(stream,
+		"Usage: %s [options]\n"
+		"Periodically writes synthetic DIR/stat file in /proc/stat format, to be read with --proc-root DIR.\n"
+		"  -n, --cpus N       amount of processors (default %u)\n"
+		"  -P, --pattern NAME load pattern: constant, wave, random or hotspot (default constant)\n"
+		"  -l, --load PCT     base load of every processor (default %.1f)\n"
+		"  -p, --period MS    period between file updates (default %u)\n"
+		"  -c, --count N      write N updates and exit, 0 to run until killed (default 0)\n"
+		"  -r, --root DIR     directory to write stat file into (default %s)\n"
+		"  -s, --seed N       seed of pseudo-random load, same seeds produce same files (default %u)\n"
+		"  -h, --help         print this message and exit\n",
+		programName,
+		PROCGEN_DEFAULT_CPU_COUNT,
+		PROCGEN_DEFAULT_LOAD_PCT,
+		PROCGEN_DEFAULT_PERIOD_MS,
+		PROCGEN_DEFAULT_ROOT,
+		PROCGEN_DEFAULT_SEED);
+}
+
+
+/**
+ * \brief Converts string into unsigned integer, rejecting malformed and out-of-range input.
+ * \param str String to convert.
+ * \param out Pointer to write the result into.
+ * \return True if successful, false otherwise.
+*/
+static bool parseUnsigned(const char* str, unsigned* out)
+{
+	char* end = NULL;
+	errno = 0;
+	unsigned long value = strtoul(str, &end, 10);
+
+	if ((0 != errno) || (end == str) || ('\0' != *end) || (value > UINT_MAX))
+	{
+		return false;
+	}
+
+	*out = (unsigned) value;
+	return true;
+}
+
+
+/**
+ * \brief Parses command-line arguments into given parameters structure.
+ * \return 0 if successful, 1 if help has been requested, negative value if arguments are invalid.
+*/
+static int parseArgs(GeneratorParams_t* params, int argc, char* argv[])
+{
+	static const struct option LONG_OPTIONS[] =
+	{
+		{ "cpus",		required_argument,	NULL,	'n' },
+		{ "pattern",	required_argument,	NULL,	'P' },
+		{ "load",		required_argument,	NULL,	'l' },
+		{ "period",		required_argument,	NULL,	'p' },
+		{ "count",		required_argument,	NULL,	'c' },
+		{ "root",		required_argument,	NULL,	'r' },
+		{ "seed",		required_argument,	NULL,	's' },
+		{ "help",		no_argument,		NULL,	'h' },
+		{ NULL,			0,					NULL,	0 }
+	};
+
+	int opt;
+
+	while (-1 != (opt = getopt_long(argc, argv, "n:P:l:p:c:r:s:h", LONG_OPTIONS, NULL)))
+	{
+		switch (opt)
+		{
+			case 'n':
+			{
+				if (!parseUnsigned(optarg, &params->cpuCount) || (0u == params->cpuCount))
+				{
+					fprintf(stderr, "invalid processor count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'P':
+			{
+				if (0 != ProcGen_parsePattern(optarg, &params->pattern))
+				{
+					fprintf(stderr, "unknown load pattern: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'l':
+			{
+				char* end = NULL;
+				errno = 0;
+				params->loadPct = strtod(optarg, &end);
+
+				if ((0 != errno) || (end == optarg) || ('\0' != *end) || (params->loadPct < 0.0) || (params->loadPct > 100.0))
+				{
+					fprintf(stderr, "invalid load: %s (expected 0-100)\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'p':
+			{
+				if (!parseUnsigned(optarg, &params->periodMs) || (0u == params->periodMs))
+				{
+					fprintf(stderr, "invalid period: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'c':
+			{
+				if (!parseUnsigned(optarg, &params->count))
+				{
+					fprintf(stderr, "invalid update count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'r':
+			{
+				params->root = optarg;
+			}
+			break;
+
+			case 's':
+			{
+				if (!parseUnsigned(optarg, &params->seed))
+				{
+					fprintf(stderr, "invalid seed: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'h':
+			{
+				return 1;
+			}
+
+			default:
+			{
+				return -2;
+			}
+		}
+	}
+
+	if (optind < argc)
+	{
+		fprintf(stderr, "unexpected argument: %s\n", argv[optind]);
+		return -3;
+	}
+
+	return 0;
+}
+
+
+static unsigned long long monotonicMs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long) ts.tv_sec * 1000u + (unsigned long long) ts.tv_nsec / 1000000u;
+}
+
+
+int main(int argc, char* argv[])
+{
+	GeneratorParams_t params =
+	{
+		.cpuCount 	= PROCGEN_DEFAULT_CPU_COUNT,
+		.pattern 	= PROCGEN_PATTERN_CONSTANT,
+		.loadPct 	= PROCGEN_DEFAULT_LOAD_PCT,
+		.periodMs 	= PROCGEN_DEFAULT_PERIOD_MS,
+		.count 		= 0u,
+		.root 		= PROCGEN_DEFAULT_ROOT,
+		.seed 		= PROCGEN_DEFAULT_SEED
+	};
+
+	int result = parseArgs(&params, argc, argv);
+
+	if (0 != result)
+	{
+		printUsage((0 < result) ? stdout : stderr, argv[0]);
+		return (0 < result) ? 0 : 1;
+	}
+
+	ProcGen_t* generator = ProcGen_create(params.cpuCount, params.pattern, params.loadPct, params.seed);
+
+	if (NULL == generator)
+	{
+		fprintf(stderr, "cannot create generator\n");
+		return 1;
+	}
+
+	int retval = 0;
+	unsigned long long lastUpdateMs = monotonicMs();
+
+	for (unsigned ii = 0; (0u == params.count) || (ii < params.count); ++ii)
+	{
+		if (0 != ProcGen_writeFile(generator, params.root))
+		{
+			fprintf(stderr, "cannot write %s/stat\n", params.root);
+			retval = 1;
+			break;
+		}
+
+		if ((0u != params.count) && (ii + 1u == params.count))
+		{
+			break;
+		}
+
+		const struct timespec period =
+		{
+			.tv_sec 	= params.periodMs / 1000u,
+			.tv_nsec 	= (long) (params.periodMs % 1000u) * 1000000l
+		};
+		nanosleep(&period, NULL);
+
+		// Counters follow time that has actually passed, so that readers sampling at any rate see consistent load
+		const unsigned long long nowMs = monotonicMs();
+		ProcGen_advance(generator, (unsigned) (nowMs - lastUpdateMs));
+		lastUpdateMs = nowMs;
+	}
+
+	ProcGen_destroy(generator);
+	return retval;
+}
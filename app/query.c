@@ -0,0 +1,198 @@
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include "recording.h"
+#include "recquery.h"
+
+
+#define NANOSECONDS_IN_SECOND 	1000000000ull
+
+
+static void printUsage(FILE* stream, const char* programName)
+{
+	fprintf(stream,
+		"Usage: %s [options] RECORDING...\n"
+		"RECORDING is either a segment file (*" RECORDING_SEGMENT_EXTENSION ") or path prefix given to --record.\n"
+		"  -f, --from TIME    beginning of queried range, epoch seconds or YYYY-MM-DDTHH:MM[:SS] local time\n"
+		"  -u, --until TIME   end of queried range\n"
+		"  -c, --cpu N        select processor N, 'total' or 'all' (default total), may be repeated\n"
+		"  -s, --step SEC     print usage downsampled into SEC-long buckets instead of aggregates\n"
+		"  -h, --help         print this message and exit\n",
+		programName);
+}
+
+
+/**
+ * \brief Parses time point given either as epoch seconds or as local date and time.
+ * \param str String to parse.
+ * \param out Pointer to write time point into, in nanoseconds since Epoch.
+ * \return True if successful, false otherwise.
+*/
+static bool parseTime(const char* str, uint64_t* out)
+{
+	static const char* FORMATS[] = { "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d %H:%M", "%Y-%m-%d" };
+	char* end = NULL;
+	errno = 0;
+	unsigned long long seconds = strtoull(str, &end, 10);
+
+	if ((0 == errno) && (end != str) && ('\0' == *end))
+	{
+		*out = seconds * NANOSECONDS_IN_SECOND;
+		return true;
+	}
+
+	for (size_t ii = 0; ii < sizeof(FORMATS) / sizeof(FORMATS[0]); ++ii)
+	{
+		struct tm tm = { 0 };
+		end = strptime(str, FORMATS[ii], &tm);
+
+		if ((NULL != end) && ('\0' == *end))
+		{
+			tm.tm_isdst = -1;
+			time_t t = mktime(&tm);
+
+			if (0 > t)
+			{
+				return false;
+			}
+
+			*out = (uint64_t) t * NANOSECONDS_IN_SECOND;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * \brief Parses command-line arguments.
+ * \return 0 if successful, 1 if help has been requested, negative value otherwise.
+*/
+static int parseArgs(RecordingQuery_t* params, int argc, char* argv[])
+{
+	static const struct option LONG_OPTIONS[] =
+	{
+		{ "from",	required_argument,	NULL,	'f' },
+		{ "until",	required_argument,	NULL,	'u' },
+		{ "cpu",	required_argument,	NULL,	'c' },
+		{ "step",	required_argument,	NULL,	's' },
+		{ "help",	no_argument,		NULL,	'h' },
+		{ NULL,		0,					NULL,	0 }
+	};
+
+	int opt;
+
+	while (-1 != (opt = getopt_long(argc, argv, "f:u:c:s:h", LONG_OPTIONS, NULL)))
+	{
+		switch (opt)
+		{
+			case 'f':
+			case 'u':
+			{
+				if (!parseTime(optarg, ('f' == opt) ? &params->fromNs : &params->untilNs))
+				{
+					fprintf(stderr, "invalid time: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'c':
+			{
+				char* end = NULL;
+				long cpu = strtol(optarg, &end, 10);
+
+				if (0 == strcmp(optarg, "all"))
+				{
+					params->allCpus = true;
+				}
+				else if (params->cpusLength == RECQUERY_MAX_SELECTED_CPUS)
+				{
+					fprintf(stderr, "too many processors selected\n");
+					return -2;
+				}
+				else if (0 == strcmp(optarg, "total"))
+				{
+					params->cpus[params->cpusLength++] = RECQUERY_SELECT_TOTAL;
+				}
+				else if ((end != optarg) && ('\0' == *end) && (0 <= cpu) && (cpu < 1000000))
+				{
+					params->cpus[params->cpusLength++] = (int) cpu;
+				}
+				else
+				{
+					fprintf(stderr, "invalid processor: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 's':
+			{
+				char* end = NULL;
+				errno = 0;
+				unsigned long long step = strtoull(optarg, &end, 10);
+
+				if ((0 != errno) || (end == optarg) || ('\0' != *end) || (0u == step))
+				{
+					fprintf(stderr, "invalid step: %s\n", optarg);
+					return -2;
+				}
+
+				params->stepNs = step * NANOSECONDS_IN_SECOND;
+			}
+			break;
+
+			case 'h':
+			{
+				return 1;
+			}
+
+			default:
+			{
+				return -2;
+			}
+		}
+	}
+
+	if (optind >= argc)
+	{
+		fprintf(stderr, "no recording given\n");
+		return -3;
+	}
+
+	if (params->fromNs > params->untilNs)
+	{
+		fprintf(stderr, "beginning of range cannot follow it's end\n");
+		return -4;
+	}
+
+	return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	RecordingQuery_t query =
+	{
+		.fromNs 	= 0u,
+		.untilNs 	= UINT64_MAX
+	};
+
+	int result = parseArgs(&query, argc, argv);
+
+	if (0 != result)
+	{
+		printUsage((0 < result) ? stdout : stderr, argv[0]);
+		return (0 < result) ? 0 : 1;
+	}
+
+	return (0 == RecordingQuery_run(&query, &argv[optind], (size_t) (argc - optind), stdout)) ? 0 : 1;
+}
@@ -0,0 +1,1435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <getopt.h>
+#include "procstat.h"
+#include "procgen.h"
+#include "cpucount.h"
+#include "cpuusage.h"
+#include "circbuf.h"
+#include "helpers.h"
+#include "batchread.h"
+#include "irqtrack.h"
+#include "cpufreq.h"
+#include "recording.h"
+#include "recquery.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_CYCLE_COUNTER 1
+#else
+#define BENCH_HAVE_CYCLE_COUNTER 0
+#endif
+
+
+#define BENCH_MAX_PARAMS 			32u
+#define BENCH_REPETITIONS 			5u
+#define BENCH_DEFAULT_MIN_TIME_MS 	200u
+#define BENCH_DEFAULT_CPU_COUNTS 	"1,64,1024,4096"
+#define BENCH_DEFAULT_ITEM_SIZES 	"64,1024,65536"
+#define BENCH_DEFAULT_FILE_COUNTS 	"10000"
+#define BENCH_CBUF_CAPACITY 		10u
+#define BENCH_GENERATOR_STEP_MS 	1000u
+#define BENCH_GENERATOR_LOAD_PCT 	50.0
+#define BENCH_SUBSET_STRIDE 		16u
+#define BENCH_GENERATOR_SEED 		1u
+#define BENCH_JSON_FORMAT_VERSION 	1
+#define BENCH_FILE_SIZE_MAX 		1024u
+#define BENCH_FILE_PATH_MAX 		96u
+// System calls glibc makes to read a small file through fopen(), fread() and fclose(): openat, fstat, read twice
+// (the second one returning end of file) and close
+#define BENCH_STDIO_SYSCALLS 		5u
+// Rows of generated interrupts file, about as many as on a server with a multi-queue network card
+#define BENCH_IRQ_SOURCES 			96u
+#define BENCH_IRQ_HOT_CPUS 			4u
+// Maximum frequency of generated cpufreq directories, in kHz
+#define BENCH_MAX_FREQ_KHZ 			3000000u
+// Queried recording spans a week at a sample per minute, a recording sampled every second holds 60 times as many
+#define BENCH_QUERY_RANGE_S 		(7u * 24u * 3600u)
+#define BENCH_QUERY_PERIOD_S 		60u
+#define BENCH_QUERY_SEGMENT_BYTES 	(64u * 1024u * 1024u)
+#define BENCH_QUERY_KEYFRAME 		60u
+
+
+/**
+ * Allocation counters, updated by malloc() family wrappers installed with -Wl,--wrap.
+ * Only allocations made from code linked into the benchmark are counted, not those made inside libc.
+*/
+static atomic_ullong g_allocCount;
+static atomic_ullong g_allocBytes;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+	atomic_fetch_add_explicit(&g_allocCount, 1u, memory_order_relaxed);
+	atomic_fetch_add_explicit(&g_allocBytes, size, memory_order_relaxed);
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size)
+{
+	atomic_fetch_add_explicit(&g_allocCount, 1u, memory_order_relaxed);
+	atomic_fetch_add_explicit(&g_allocBytes, count * size, memory_order_relaxed);
+	return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	atomic_fetch_add_explicit(&g_allocCount, 1u, memory_order_relaxed);
+	atomic_fetch_add_explicit(&g_allocBytes, size, memory_order_relaxed);
+	return __real_realloc(ptr, size);
+}
+
+
+/**
+ * Benchmark parameters, populated from command-line arguments.
+*/
+typedef struct BenchParams
+{
+	/** Processor counts to run processor-dependent benchmarks with. */
+	size_t cpuCounts[BENCH_MAX_PARAMS];
+	size_t cpuCountsLength;
+	/** Item sizes to run circular buffer benchmarks with, in bytes. */
+	size_t itemSizes[BENCH_MAX_PARAMS];
+	size_t itemSizesLength;
+	/** File counts to run batched read benchmarks with. */
+	size_t fileCounts[BENCH_MAX_PARAMS];
+	size_t fileCountsLength;
+	/** Minimum measured time of every benchmark, in milliseconds, split between repetitions. */
+	unsigned minTimeMs;
+	/** Path of JSON results file, "-" for standard output, NULL to skip JSON output. */
+	const char* jsonPath;
+	/** Name of the only benchmark to run, NULL to run every benchmark. */
+	const char* filter;
+}
+BenchParams_t;
+
+
+/**
+ * State shared by every benchmark, prepared before measurement.
+*/
+typedef struct BenchContext
+{
+	/** Processor count, for processor-dependent benchmarks. */
+	size_t cpuCount;
+	/** Item size, for circular buffer benchmarks. */
+	size_t itemSize;
+	/** File count, for batched read benchmarks. */
+	size_t fileCount;
+	/** Generated /proc/stat contents. */
+	char* statText;
+	/** Directory containing generated "stat" file. */
+	char procRoot[64];
+	/** Two consecutive parsed snapshots. */
+	ProcStat_t* stats[2];
+	/** Usage statistics output. */
+	CpuUsageInfo_t* usage;
+	/** Compact usage statistics output, as passed from analyzer to printer. */
+	CpuUsageCompact_t* compact;
+	/** Change between the two snapshots, as passed from reader to analyzer in delta mode. */
+	ProcStatDelta_t* delta;
+	/** Consecutive snapshots making up analyzer backlog, BENCH_CBUF_CAPACITY of them, and usage statistics of every interval. */
+	ProcStat_t* backlog;
+	CpuUsageInfo_t* backlogUsage;
+	/** Circular buffer, and items to be written into and read from it. */
+	CircularBuffer_t* cbuf;
+	unsigned char* items;
+	/** Numbers of processors tracked by subset benchmarks, NULL if every processor is tracked. */
+	uint32_t* selection;
+	/** Stream rendered statistics are written into. */
+	FILE* sink;
+	/** Directory containing files read by batched read benchmarks, their paths, descriptors and reads. */
+	char fileRoot[64];
+	char* filePaths;
+	int* fds;
+	char* fileBuffers;
+	BatchReadRequest_t* requests;
+	BatchReader_t* reader;
+	/** Tracker of generated interrupts and softirqs files, placed in procRoot. */
+	IrqTracker_t* irqTracker;
+	IrqUsageReport_t* irqReport;
+	/** Directory containing generated cpufreq directories of every processor, amount of them, and their sampler. */
+	char sysRoot[64];
+	size_t freqCpuCount;
+	CpuFreqSampler_t* freqSampler;
+	CpuFreqValue_t* freqs;
+	/** Directory containing recording queried by query benchmarks. */
+	char recordRoot[64];
+	/** System calls made by measured work, where benchmark counts them. */
+	unsigned long long syscalls;
+	/** Prevents the compiler from optimizing measured work away. */
+	volatile unsigned long long sideEffect;
+}
+BenchContext_t;
+
+
+/**
+ * Parameters benchmarks can be run with.
+*/
+typedef enum BenchParamKind
+{
+	BPARAM_CPUS = 0,
+	BPARAM_ITEM_SIZE,
+	BPARAM_FILES
+}
+BenchParamKind_t;
+
+
+/**
+ * Single benchmark, operating on context prepared by it's setup function.
+*/
+typedef struct Benchmark
+{
+	/** Name, used in results and by --filter. */
+	const char* name;
+	/** Parameter benchmark is run with. */
+	BenchParamKind_t paramKind;
+	/** Prepares context, returns false on failure. */
+	bool (*setup)(BenchContext_t* ctx);
+	/** Runs given amount of operations. */
+	void (*run)(BenchContext_t* ctx, unsigned long long iterations);
+}
+Benchmark_t;
+
+
+/**
+ * Measurement of a single benchmark repetition.
+*/
+typedef struct BenchSample
+{
+	double nsPerOp;
+	double cyclesPerOp;
+	double allocsPerOp;
+	double bytesPerOp;
+	double syscallsPerOp;
+}
+BenchSample_t;
+
+
+static const char* const PARAM_NAMES[] =
+{
+	[BPARAM_CPUS] 		= "cpus",
+	[BPARAM_ITEM_SIZE] 	= "item_size",
+	[BPARAM_FILES] 		= "files"
+};
+
+
+static unsigned long long readCycles(void)
+{
+#if BENCH_HAVE_CYCLE_COUNTER
+	return (unsigned long long) __rdtsc();
+#else
+	return 0u;
+#endif
+}
+
+
+/**
+ * \brief Generates /proc/stat contents for given processor count.
+ * \param steps Amount of steps counters should be advanced by, so that they differ from those generated with fewer steps.
+*/
+static char* generateStatText(size_t cpuCount, unsigned steps)
+{
+	ProcGen_t* generator = ProcGen_create(cpuCount, PROCGEN_PATTERN_RANDOM, BENCH_GENERATOR_LOAD_PCT, BENCH_GENERATOR_SEED);
+
+	if (NULL == generator)
+	{
+		return NULL;
+	}
+
+	for (unsigned ii = 0; ii < steps; ++ii)
+	{
+		ProcGen_advance(generator, BENCH_GENERATOR_STEP_MS);
+	}
+
+	char* text = NULL;
+	size_t textSize = 0u;
+	FILE* stream = open_memstream(&text, &textSize);
+
+	if (NULL != stream)
+	{
+		ProcGen_write(generator, stream);
+		fclose(stream);
+	}
+
+	ProcGen_destroy(generator);
+	return text;
+}
+
+
+static bool setupParse(BenchContext_t* ctx)
+{
+	ctx->statText = generateStatText(ctx->cpuCount, 0u);
+	return NULL != ctx->statText;
+}
+
+
+static void runParse(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ProcStat_t* stat = ProcStat_parse(ctx->statText);
+		ctx->sideEffect += (NULL != stat) ? stat->cpuStats[0].values[0] : 0u;
+		ProcStat_destroy(stat);
+	}
+}
+
+
+static bool setupRead(BenchContext_t* ctx)
+{
+	strcpy(ctx->procRoot, "/tmp/cut_bench_XXXXXX");
+
+	if (NULL == mkdtemp(ctx->procRoot))
+	{
+		ctx->procRoot[0] = '\0';
+		return false;
+	}
+
+	char path[sizeof(ctx->procRoot) + 8u];
+	snprintf(path, sizeof(path), "%s/stat", ctx->procRoot);
+	ctx->statText = generateStatText(ctx->cpuCount, 0u);
+	FILE* fp = fopen(path, "w");
+
+	if ((NULL == ctx->statText) || (NULL == fp))
+	{
+		if (NULL != fp)
+		{
+			fclose(fp);
+		}
+
+		return false;
+	}
+
+	fputs(ctx->statText, fp);
+	fclose(fp);
+	ProcStat_setProcRoot(ctx->procRoot);
+	ctx->stats[0] = malloc(ProcStat_size());
+	return NULL != ctx->stats[0];
+}
+
+
+static void runRead(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->sideEffect += ProcStat_read(ctx->stats[0]) ? ctx->stats[0]->cpuStats[0].values[0] : 0u;
+	}
+}
+
+
+static bool setupReadSubset(BenchContext_t* ctx)
+{
+	// Selected processors are spread over the whole file, so that lines of all others have to be skipped
+	const size_t count = (ctx->cpuCount + BENCH_SUBSET_STRIDE - 1u) / BENCH_SUBSET_STRIDE;
+	ctx->selection = malloc(count * sizeof(uint32_t));
+
+	if (NULL == ctx->selection)
+	{
+		return false;
+	}
+
+	for (size_t ii = 0; ii < count; ++ii)
+	{
+		ctx->selection[ii] = (uint32_t) (ii * BENCH_SUBSET_STRIDE);
+	}
+
+	CpuCount_select(ctx->selection, count);
+	return setupRead(ctx);
+}
+
+
+/**
+ * \brief Prepares two consecutive snapshots and usage statistics output, shared by calculate and render benchmarks.
+*/
+static bool setupSnapshots(BenchContext_t* ctx)
+{
+	for (size_t ii = 0; ii < 2u; ++ii)
+	{
+		char* text = generateStatText(ctx->cpuCount, (unsigned) ii);
+		ctx->stats[ii] = (NULL != text) ? ProcStat_parse(text) : NULL;
+		free(text);
+
+		if (NULL == ctx->stats[ii])
+		{
+			return false;
+		}
+
+		ctx->stats[ii]->timestampNs = 1u + ii * BENCH_GENERATOR_STEP_MS * 1000000ull;
+	}
+
+	ctx->usage = malloc(CpuUsageInfo_size());
+	ctx->compact = malloc(CpuUsageCompact_size());
+
+	if ((NULL == ctx->usage) || (NULL == ctx->compact))
+	{
+		return false;
+	}
+
+	CpuUsageInfo_calculate(ctx->stats[0], ctx->stats[1], ctx->usage);
+	CpuUsageCompact_calculate(ctx->stats[0], ctx->stats[1], ctx->compact);
+	return true;
+}
+
+
+static void runCalculate(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageInfo_calculate(ctx->stats[0], ctx->stats[1], ctx->usage);
+		ctx->sideEffect += (unsigned long long) ctx->usage->values[0];
+	}
+}
+
+
+static void runCalculateCompact(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageCompact_calculate(ctx->stats[0], ctx->stats[1], ctx->compact);
+		ctx->sideEffect += ctx->compact->values[0];
+	}
+}
+
+
+static bool setupDelta(BenchContext_t* ctx)
+{
+	if (!setupSnapshots(ctx))
+	{
+		return false;
+	}
+
+	ctx->delta = malloc(ProcStatDelta_size());
+
+	if (NULL == ctx->delta)
+	{
+		return false;
+	}
+
+	ProcStatDelta_encode(ctx->stats[0], ctx->stats[1], ctx->delta);
+	return true;
+}
+
+
+static void runEncode(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ProcStatDelta_encode(ctx->stats[0], ctx->stats[1], ctx->delta);
+		ctx->sideEffect += ctx->delta->cpuDeltas[0].values[0];
+	}
+}
+
+
+static void runCalculateDelta(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageInfo_calculateFromDelta(ctx->delta, ctx->usage);
+		ctx->sideEffect += (unsigned long long) ctx->usage->values[0];
+	}
+}
+
+
+/**
+ * \brief Prepares backlog of consecutive snapshots, as drained by analyzer catching up, preceded by the last processed one.
+*/
+static bool setupBacklog(BenchContext_t* ctx)
+{
+	if (!setupSnapshots(ctx))
+	{
+		return false;
+	}
+
+	const size_t procStatSize = ProcStat_size();
+	ctx->backlog = malloc(BENCH_CBUF_CAPACITY * procStatSize);
+	ctx->backlogUsage = malloc(BENCH_CBUF_CAPACITY * CpuUsageInfo_size());
+
+	if ((NULL == ctx->backlog) || (NULL == ctx->backlogUsage))
+	{
+		return false;
+	}
+
+	for (unsigned ii = 0; ii < BENCH_CBUF_CAPACITY; ++ii)
+	{
+		char* text = generateStatText(ctx->cpuCount, ii + 1u);
+		ProcStat_t* stat = (NULL != text) ? ProcStat_parse(text) : NULL;
+		free(text);
+
+		if (NULL == stat)
+		{
+			return false;
+		}
+
+		stat->timestampNs = 1u + (ii + 1u) * BENCH_GENERATOR_STEP_MS * 1000000ull;
+		memcpy((char*) ctx->backlog + ii * procStatSize, stat, procStatSize);
+		free(stat);
+	}
+
+	return true;
+}
+
+
+static void runBacklogEach(BenchContext_t* ctx, unsigned long long iterations)
+{
+	const size_t procStatSize = ProcStat_size();
+	const size_t usageInfoSize = CpuUsageInfo_size();
+
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		const ProcStat_t* prev = ctx->stats[0];
+
+		for (size_t kk = 0; kk < BENCH_CBUF_CAPACITY; ++kk)
+		{
+			const ProcStat_t* next = (const ProcStat_t*) ((const char*) ctx->backlog + kk * procStatSize);
+			CpuUsageInfo_calculate(prev, next, (CpuUsageInfo_t*) ((char*) ctx->backlogUsage + kk * usageInfoSize));
+			prev = next;
+		}
+
+		ctx->sideEffect += (unsigned long long) ctx->backlogUsage->values[0];
+	}
+}
+
+
+static void runBacklogBatch(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageInfo_calculateMany(ctx->stats[0], ctx->backlog, BENCH_CBUF_CAPACITY, ctx->backlogUsage);
+		ctx->sideEffect += (unsigned long long) ctx->backlogUsage->values[0];
+	}
+}
+
+
+static void runBacklogCoalesce(BenchContext_t* ctx, unsigned long long iterations)
+{
+	const ProcStat_t* newest = (const ProcStat_t*) ((const char*) ctx->backlog + (BENCH_CBUF_CAPACITY - 1u) * ProcStat_size());
+
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageInfo_calculate(ctx->stats[0], newest, ctx->usage);
+		ctx->sideEffect += (unsigned long long) ctx->usage->values[0];
+	}
+}
+
+
+static bool setupRender(BenchContext_t* ctx)
+{
+	if (!setupSnapshots(ctx))
+	{
+		return false;
+	}
+
+	ctx->sink = fopen("/dev/null", "w");
+	return NULL != ctx->sink;
+}
+
+
+static void runRender(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageInfo_print(ctx->sink, ctx->usage);
+		fflush(ctx->sink);
+	}
+}
+
+
+static void runRenderCompact(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		CpuUsageCompact_print(ctx->sink, ctx->compact);
+		fflush(ctx->sink);
+	}
+}
+
+
+static bool setupCircularBuffer(BenchContext_t* ctx)
+{
+	ctx->cbuf = CircularBuffer_create(ctx->itemSize, BENCH_CBUF_CAPACITY);
+	ctx->items = calloc(BENCH_CBUF_CAPACITY, ctx->itemSize);
+	return (NULL != ctx->cbuf) && (NULL != ctx->items);
+}
+
+
+static void runCircularBuffer(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->items[0] = (unsigned char) ii;
+		CircularBuffer_write(ctx->cbuf, ctx->items);
+		CircularBuffer_read(ctx->cbuf, ctx->items);
+		ctx->sideEffect += ctx->items[0];
+	}
+}
+
+
+static void runCircularBufferBatch(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->items[0] = (unsigned char) ii;
+		CircularBuffer_writeMany(ctx->cbuf, ctx->items, BENCH_CBUF_CAPACITY);
+		ctx->sideEffect += CircularBuffer_readMany(ctx->cbuf, ctx->items, BENCH_CBUF_CAPACITY);
+	}
+}
+
+
+/**
+ * \brief Creates files resembling /proc/[pid]/stat ones, and opens every one of them for batched reads.
+*/
+static bool setupFiles(BenchContext_t* ctx)
+{
+	strcpy(ctx->fileRoot, "/tmp/cut_bench_files_XXXXXX");
+
+	if (NULL == mkdtemp(ctx->fileRoot))
+	{
+		ctx->fileRoot[0] = '\0';
+		return false;
+	}
+
+	ctx->filePaths = calloc(ctx->fileCount, BENCH_FILE_PATH_MAX);
+	ctx->fds = malloc(ctx->fileCount * sizeof(int));
+	ctx->fileBuffers = malloc(BATCHREAD_DEFAULT_DEPTH * BENCH_FILE_SIZE_MAX);
+	ctx->requests = malloc(BATCHREAD_DEFAULT_DEPTH * sizeof(BatchReadRequest_t));
+
+	if ((NULL == ctx->filePaths) || (NULL == ctx->fds) || (NULL == ctx->fileBuffers) || (NULL == ctx->requests))
+	{
+		return false;
+	}
+
+	for (size_t ii = 0; ii < ctx->fileCount; ++ii)
+	{
+		ctx->fds[ii] = -1;
+	}
+
+	for (size_t ii = 0; ii < ctx->fileCount; ++ii)
+	{
+		char* path = &ctx->filePaths[ii * BENCH_FILE_PATH_MAX];
+		snprintf(path, BENCH_FILE_PATH_MAX, "%s/%zu", ctx->fileRoot, ii);
+		FILE* fp = fopen(path, "w");
+
+		if (NULL == fp)
+		{
+			return false;
+		}
+
+		fprintf(fp, "%zu (bench) S 1 %zu %zu 0 -1 4194560 %zu 0 0 0 %zu %zu 0 0 20 0 1 0 %zu 0 0 "
+			"18446744073709551615 0 0 0 0 0 0 0 0 0 0 0 0 17 %zu 0 0 0 0 0\n",
+			ii + 1u, ii, ii, ii * 7u, ii * 13u, ii * 3u, ii * 11u, ii % 64u);
+		fclose(fp);
+		ctx->fds[ii] = open(path, O_RDONLY | O_CLOEXEC);
+
+		if (0 > ctx->fds[ii])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+static bool setupFilesPreadv(BenchContext_t* ctx)
+{
+	ctx->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_PREADV);
+	return (NULL != ctx->reader) && setupFiles(ctx);
+}
+
+
+static bool setupFilesUring(BenchContext_t* ctx)
+{
+	ctx->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_URING);
+
+	// Comparison against preadv() would be meaningless if io_uring is unavailable
+	if ((NULL == ctx->reader) || (BREAD_BACKEND_URING != BatchReader_getBackend(ctx->reader)))
+	{
+		fprintf(stderr, "io_uring is unavailable\n");
+		return false;
+	}
+
+	return setupFiles(ctx);
+}
+
+
+static void runFilesStdio(BenchContext_t* ctx, unsigned long long iterations)
+{
+	char buf[BENCH_FILE_SIZE_MAX];
+
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		for (size_t jj = 0; jj < ctx->fileCount; ++jj)
+		{
+			ctx->sideEffect += (unsigned long long) ReadFileContent(&ctx->filePaths[jj * BENCH_FILE_PATH_MAX], buf, sizeof(buf));
+		}
+
+		ctx->syscalls += ctx->fileCount * BENCH_STDIO_SYSCALLS;
+	}
+}
+
+
+static void runFilesBatch(BenchContext_t* ctx, unsigned long long iterations)
+{
+	const unsigned long long syscalls = BatchReader_getSyscallCount(ctx->reader);
+
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		for (size_t first = 0; first < ctx->fileCount; first += BATCHREAD_DEFAULT_DEPTH)
+		{
+			const size_t count = (ctx->fileCount - first < BATCHREAD_DEFAULT_DEPTH) ? ctx->fileCount - first : BATCHREAD_DEFAULT_DEPTH;
+
+			for (size_t jj = 0; jj < count; ++jj)
+			{
+				ctx->requests[jj] = (BatchReadRequest_t)
+				{
+					.fd 	= ctx->fds[first + jj],
+					.buf 	= &ctx->fileBuffers[jj * BENCH_FILE_SIZE_MAX],
+					.size 	= BENCH_FILE_SIZE_MAX
+				};
+			}
+
+			BatchReader_read(ctx->reader, ctx->requests, count);
+			ctx->sideEffect += (unsigned long long) ctx->requests[0].result;
+		}
+	}
+
+	ctx->syscalls += BatchReader_getSyscallCount(ctx->reader) - syscalls;
+}
+
+
+/**
+ * \brief Writes file of interrupt counters in /proc/interrupts or /proc/softirqs format, a column per processor.
+*/
+static bool writeIrqFile(const char* path, size_t cpuCount, size_t sourceCount, bool softirq)
+{
+	FILE* fp = fopen(path, "w");
+
+	if (NULL == fp)
+	{
+		return false;
+	}
+
+	fputs(softirq ? "            " : "     ", fp);
+
+	for (size_t ii = 0; ii < cpuCount; ++ii)
+	{
+		fprintf(fp, "CPU%-8zu", ii);
+	}
+
+	fputc('\n', fp);
+
+	for (size_t row = 0; row < sourceCount; ++row)
+	{
+		if (softirq)
+		{
+			fprintf(fp, "%9s%zu:", "SOFTIRQ", row);
+		}
+		else
+		{
+			fprintf(fp, "%4zu:", row);
+		}
+
+		for (size_t ii = 0; ii < cpuCount; ++ii)
+		{
+			fprintf(fp, " %10zu", (row * 7919u + ii * 104729u) % 100000000u);
+		}
+
+		fprintf(fp, softirq ? "\n" : "  PCI-MSIX-0000:00:%02zu.0 %zu-edge      eth0-TxRx-%zu\n", row % 32u, row, row);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+
+static bool setupIrqs(BenchContext_t* ctx)
+{
+	strcpy(ctx->procRoot, "/tmp/cut_bench_XXXXXX");
+
+	if (NULL == mkdtemp(ctx->procRoot))
+	{
+		ctx->procRoot[0] = '\0';
+		return false;
+	}
+
+	char path[sizeof(ctx->procRoot) + 16u];
+	snprintf(path, sizeof(path), "%s/interrupts", ctx->procRoot);
+
+	if (!writeIrqFile(path, ctx->cpuCount, BENCH_IRQ_SOURCES, false))
+	{
+		return false;
+	}
+
+	snprintf(path, sizeof(path), "%s/softirqs", ctx->procRoot);
+
+	if (!writeIrqFile(path, ctx->cpuCount, 10u, true))
+	{
+		return false;
+	}
+
+	ctx->irqTracker = IrqTracker_create(ctx->procRoot, BENCH_IRQ_HOT_CPUS, 1u);
+	ctx->irqReport = malloc(IrqUsageReport_size(BENCH_IRQ_HOT_CPUS));
+	return (NULL != ctx->irqTracker) && (NULL != ctx->irqReport);
+}
+
+
+static void runIrqs(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->sideEffect += (unsigned long long) IrqTracker_step(ctx->irqTracker, ctx->irqReport);
+	}
+}
+
+
+/**
+ * \brief Writes single number into file of given path, creating it.
+*/
+static bool writeNumberFile(const char* path, unsigned long value)
+{
+	FILE* fp = fopen(path, "w");
+
+	if (NULL == fp)
+	{
+		return false;
+	}
+
+	fprintf(fp, "%lu\n", value);
+	return 0 == fclose(fp);
+}
+
+
+static bool setupCpuFreq(BenchContext_t* ctx)
+{
+	strcpy(ctx->sysRoot, "/tmp/cut_bench_sys_XXXXXX");
+
+	if (NULL == mkdtemp(ctx->sysRoot))
+	{
+		ctx->sysRoot[0] = '\0';
+		return false;
+	}
+
+	char path[sizeof(ctx->sysRoot) + 64u];
+	snprintf(path, sizeof(path), "%s/cpu", ctx->sysRoot);
+
+	if (0 != mkdir(path, 0755))
+	{
+		return false;
+	}
+
+	for (size_t ii = 0; ii < ctx->cpuCount; ++ii)
+	{
+		snprintf(path, sizeof(path), "%s/cpu/cpu%zu", ctx->sysRoot, ii);
+
+		if (0 != mkdir(path, 0755))
+		{
+			return false;
+		}
+
+		snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq", ctx->sysRoot, ii);
+
+		if (0 != mkdir(path, 0755))
+		{
+			return false;
+		}
+
+		++ctx->freqCpuCount;
+		snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq/cpuinfo_max_freq", ctx->sysRoot, ii);
+
+		if (!writeNumberFile(path, BENCH_MAX_FREQ_KHZ))
+		{
+			return false;
+		}
+
+		snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq/scaling_cur_freq", ctx->sysRoot, ii);
+
+		if (!writeNumberFile(path, BENCH_MAX_FREQ_KHZ / 2u + (unsigned long) (ii % 16u) * 100000u))
+		{
+			return false;
+		}
+	}
+
+	ctx->freqSampler = CpuFreqSampler_create(ctx->sysRoot);
+	ctx->freqs = malloc((ctx->cpuCount + 1u) * sizeof(CpuFreqValue_t));
+	return (NULL != ctx->freqSampler) && (NULL != ctx->freqs);
+}
+
+
+static void runCpuFreq(BenchContext_t* ctx, unsigned long long iterations)
+{
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->sideEffect += CpuFreqSampler_read(ctx->freqSampler, ctx->freqs) ? ctx->freqs[0] : 0u;
+	}
+}
+
+
+/**
+ * \brief Writes recording of a week of samples of every processor, with load of every processor changing every sample.
+*/
+static bool setupQuery(BenchContext_t* ctx)
+{
+	strcpy(ctx->recordRoot, "/tmp/cut_bench_rec_XXXXXX");
+
+	if (NULL == mkdtemp(ctx->recordRoot))
+	{
+		ctx->recordRoot[0] = '\0';
+		return false;
+	}
+
+	char basePath[sizeof(ctx->recordRoot) + 8u];
+	snprintf(basePath, sizeof(basePath), "%s/rec", ctx->recordRoot);
+	const size_t cpuStatsLength = ctx->cpuCount + 1u;
+	ProcStat_t* sample = calloc(1u, sizeof(ProcStat_t) + cpuStatsLength * sizeof(CpuStat_t));
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, cpuStatsLength, BENCH_QUERY_SEGMENT_BYTES, BENCH_QUERY_KEYFRAME);
+	bool result = (NULL != sample) && (NULL != writer);
+
+	for (unsigned ii = 0; result && (ii <= BENCH_QUERY_RANGE_S / BENCH_QUERY_PERIOD_S); ++ii)
+	{
+		sample->cpuStatsLength = cpuStatsLength;
+		sample->timestampNs = MonotonicTimeNs() + ii * BENCH_QUERY_PERIOD_S * 1000000000ull;
+
+		for (size_t jj = 1; jj < cpuStatsLength; ++jj)
+		{
+			const CpuStatValue_t busy = (ii * 7u + jj * 13u) % (BENCH_QUERY_PERIOD_S * 100u);
+			sample->cpuStats[jj].values[CSINDEX_USER] += busy;
+			sample->cpuStats[jj].values[CSINDEX_IDLE] += BENCH_QUERY_PERIOD_S * 100u - busy;
+			sample->cpuStats[0].values[CSINDEX_USER] += busy;
+			sample->cpuStats[0].values[CSINDEX_IDLE] += BENCH_QUERY_PERIOD_S * 100u - busy;
+		}
+
+		result = (0 == RecordingWriter_append(writer, sample));
+	}
+
+	RecordingWriter_destroy(writer);
+	free(sample);
+	ctx->sink = fopen("/dev/null", "w");
+	return result && (NULL != ctx->sink);
+}
+
+
+/**
+ * \brief Queries aggregates of a single processor over the whole recorded week, as CpuUsageTrackerQuery -c 0 does.
+*/
+static void runQuery(BenchContext_t* ctx, unsigned long long iterations)
+{
+	char basePath[sizeof(ctx->recordRoot) + 8u];
+	snprintf(basePath, sizeof(basePath), "%s/rec", ctx->recordRoot);
+	char* paths[] = { basePath };
+	const RecordingQuery_t query =
+	{
+		.fromNs 	= 0u,
+		.untilNs 	= UINT64_MAX,
+		.cpus 		= { 0 },
+		.cpusLength = 1u
+	};
+
+	for (unsigned long long ii = 0; ii < iterations; ++ii)
+	{
+		ctx->sideEffect += (0 == RecordingQuery_run(&query, paths, 1u, ctx->sink)) ? 1u : 0u;
+	}
+}
+
+
+static const Benchmark_t BENCHMARKS[] =
+{
+	{ "parse",			 BPARAM_CPUS,		 setupParse,				 runParse },
+	{ "read",			 BPARAM_CPUS,		 setupRead,					 runRead },
+	{ "read_subset",	 BPARAM_CPUS,		 setupReadSubset,			 runRead },
+	{ "calculate",		 BPARAM_CPUS,		 setupSnapshots,			 runCalculate },
+	{ "encode",			 BPARAM_CPUS,		 setupDelta,				 runEncode },
+	{ "calc_compact",	 BPARAM_CPUS,		 setupSnapshots,			 runCalculateCompact },
+	{ "delta_calc",		 BPARAM_CPUS,		 setupDelta,				 runCalculateDelta },
+	{ "render",			 BPARAM_CPUS,		 setupRender,				 runRender },
+	{ "render_compact",	 BPARAM_CPUS,		 setupRender,				 runRenderCompact },
+	{ "backlog_each",	 BPARAM_CPUS,		 setupBacklog,				 runBacklogEach },
+	{ "backlog_batch",	 BPARAM_CPUS,		 setupBacklog,				 runBacklogBatch },
+	{ "backlog_merge",	 BPARAM_CPUS,		 setupBacklog,				 runBacklogCoalesce },
+	{ "circbuf",		 BPARAM_ITEM_SIZE,	 setupCircularBuffer,		 runCircularBuffer },
+	{ "circbuf_batch",	 BPARAM_ITEM_SIZE,	 setupCircularBuffer,		 runCircularBufferBatch },
+	{ "files_stdio",	 BPARAM_FILES,		 setupFiles,				 runFilesStdio },
+	{ "files_preadv",	 BPARAM_FILES,		 setupFilesPreadv,			 runFilesBatch },
+	{ "files_uring",	 BPARAM_FILES,		 setupFilesUring,			 runFilesBatch },
+	{ "irqs",			 BPARAM_CPUS,		 setupIrqs,					 runIrqs },
+	{ "cpufreq",		 BPARAM_CPUS,		 setupCpuFreq,				 runCpuFreq },
+	{ "query_week",		 BPARAM_CPUS,		 setupQuery,				 runQuery }
+};
+
+
+static void teardown(BenchContext_t* ctx)
+{
+	free(ctx->statText);
+	free(ctx->stats[0]);
+	free(ctx->stats[1]);
+	free(ctx->usage);
+	free(ctx->compact);
+	free(ctx->delta);
+	free(ctx->backlog);
+	free(ctx->backlogUsage);
+	free(ctx->items);
+	CircularBuffer_destroy(ctx->cbuf);
+
+	if (NULL != ctx->selection)
+	{
+		CpuCount_select(NULL, 0u);
+		free(ctx->selection);
+	}
+
+	if (NULL != ctx->sink)
+	{
+		fclose(ctx->sink);
+	}
+
+	for (size_t ii = 0; (NULL != ctx->fds) && (ii < ctx->fileCount); ++ii)
+	{
+		if (0 <= ctx->fds[ii])
+		{
+			close(ctx->fds[ii]);
+		}
+	}
+
+	for (size_t ii = 0; (NULL != ctx->filePaths) && (ii < ctx->fileCount); ++ii)
+	{
+		remove(&ctx->filePaths[ii * BENCH_FILE_PATH_MAX]);
+	}
+
+	if ('\0' != ctx->fileRoot[0])
+	{
+		remove(ctx->fileRoot);
+	}
+
+	BatchReader_destroy(ctx->reader);
+	free(ctx->requests);
+	free(ctx->fileBuffers);
+	free(ctx->fds);
+	free(ctx->filePaths);
+
+	IrqTracker_destroy(ctx->irqTracker);
+	free(ctx->irqReport);
+	CpuFreqSampler_destroy(ctx->freqSampler);
+	free(ctx->freqs);
+
+	if ('\0' != ctx->sysRoot[0])
+	{
+		char path[sizeof(ctx->sysRoot) + 64u];
+
+		for (size_t ii = 0; ii < ctx->freqCpuCount; ++ii)
+		{
+			snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq/cpuinfo_max_freq", ctx->sysRoot, ii);
+			remove(path);
+			snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq/scaling_cur_freq", ctx->sysRoot, ii);
+			remove(path);
+			snprintf(path, sizeof(path), "%s/cpu/cpu%zu/cpufreq", ctx->sysRoot, ii);
+			remove(path);
+		}
+
+		// Directory of processor whose cpufreq directory has not been created is removed as well
+		for (size_t ii = 0; ii <= ctx->freqCpuCount; ++ii)
+		{
+			snprintf(path, sizeof(path), "%s/cpu/cpu%zu", ctx->sysRoot, ii);
+			remove(path);
+		}
+
+		snprintf(path, sizeof(path), "%s/cpu", ctx->sysRoot);
+		remove(path);
+		remove(ctx->sysRoot);
+	}
+
+	if ('\0' != ctx->recordRoot[0])
+	{
+		char path[sizeof(ctx->recordRoot) + 32u];
+
+		for (unsigned seq = 0u; ; ++seq)
+		{
+			snprintf(path, sizeof(path), "%s/rec.%06u" RECORDING_INDEX_EXTENSION, ctx->recordRoot, seq);
+			remove(path);
+			snprintf(path, sizeof(path), "%s/rec.%06u" RECORDING_SEGMENT_EXTENSION, ctx->recordRoot, seq);
+
+			if (0 != remove(path))
+			{
+				break;
+			}
+		}
+
+		remove(ctx->recordRoot);
+	}
+
+	if ('\0' != ctx->procRoot[0])
+	{
+		char path[sizeof(ctx->procRoot) + 16u];
+		snprintf(path, sizeof(path), "%s/stat", ctx->procRoot);
+		remove(path);
+		snprintf(path, sizeof(path), "%s/interrupts", ctx->procRoot);
+		remove(path);
+		snprintf(path, sizeof(path), "%s/softirqs", ctx->procRoot);
+		remove(path);
+		remove(ctx->procRoot);
+		ProcStat_setProcRoot(NULL);
+	}
+}
+
+
+/**
+ * \brief Runs given amount of operations, measuring time, cycles and allocations.
+*/
+static BenchSample_t measure(const Benchmark_t* bench, BenchContext_t* ctx, unsigned long long iterations)
+{
+	const unsigned long long allocCount = atomic_load(&g_allocCount);
+	const unsigned long long allocBytes = atomic_load(&g_allocBytes);
+	const unsigned long long syscalls = ctx->syscalls;
+	const unsigned long long startCycles = readCycles();
+	const unsigned long long startNs = MonotonicTimeNs();
+
+	bench->run(ctx, iterations);
+
+	const unsigned long long elapsedNs = MonotonicTimeNs() - startNs;
+	const unsigned long long elapsedCycles = readCycles() - startCycles;
+
+	return (BenchSample_t)
+	{
+		.nsPerOp 		= (double) elapsedNs / (double) iterations,
+		.cyclesPerOp 	= (double) elapsedCycles / (double) iterations,
+		.allocsPerOp 	= (double) (atomic_load(&g_allocCount) - allocCount) / (double) iterations,
+		.bytesPerOp 	= (double) (atomic_load(&g_allocBytes) - allocBytes) / (double) iterations,
+		.syscallsPerOp 	= (double) (ctx->syscalls - syscalls) / (double) iterations
+	};
+}
+
+
+static int compareSamples(const void* a, const void* b)
+{
+	const double lhs = ((const BenchSample_t*) a)->nsPerOp;
+	const double rhs = ((const BenchSample_t*) b)->nsPerOp;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+
+/**
+ * \brief Runs single benchmark with single parameter and reports results.
+ * \return 0 if successful, negative value if benchmark could not be prepared.
+*/
+static int runBenchmark(const Benchmark_t* bench, size_t param, const BenchParams_t* params, FILE* table, FILE* json, bool* firstJsonEntry)
+{
+	BenchContext_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+
+	if (BPARAM_ITEM_SIZE == bench->paramKind)
+	{
+		ctx.itemSize = param;
+	}
+	else if (BPARAM_FILES == bench->paramKind)
+	{
+		ctx.fileCount = param;
+	}
+	else
+	{
+		// Snapshot and usage structure sizes follow processor count
+		ctx.cpuCount = param;
+		CpuCount_override((int) param);
+	}
+
+	if (!bench->setup(&ctx))
+	{
+		fprintf(stderr, "cannot prepare benchmark %s/%zu\n", bench->name, param);
+		teardown(&ctx);
+		return -1;
+	}
+
+	// Warm up caches, then grow iteration count until a single run takes a noticeable fraction of target time
+	const unsigned long long targetNs = (unsigned long long) params->minTimeMs * 1000000u / BENCH_REPETITIONS;
+	unsigned long long iterations = 1u;
+	BenchSample_t sample = measure(bench, &ctx, iterations);
+
+	while ((sample.nsPerOp * (double) iterations < (double) targetNs / 10.0) && (iterations < (1ull << 40)))
+	{
+		iterations *= 2u;
+		sample = measure(bench, &ctx, iterations);
+	}
+
+	iterations = (unsigned long long) ((double) targetNs / sample.nsPerOp) + 1u;
+
+	BenchSample_t samples[BENCH_REPETITIONS];
+
+	for (size_t ii = 0; ii < BENCH_REPETITIONS; ++ii)
+	{
+		samples[ii] = measure(bench, &ctx, iterations);
+	}
+
+	qsort(samples, BENCH_REPETITIONS, sizeof(BenchSample_t), compareSamples);
+	const BenchSample_t* median = &samples[BENCH_REPETITIONS / 2u];
+
+	fprintf(table, "%-14s %-10s %8zu %14.1f %14.1f %14.1f %10.2f %12.1f %12.1f\n",
+		bench->name,
+		PARAM_NAMES[bench->paramKind],
+		param,
+		median->nsPerOp,
+		samples[0].nsPerOp,
+		median->cyclesPerOp,
+		median->allocsPerOp,
+		median->bytesPerOp,
+		median->syscallsPerOp);
+
+	if (NULL != json)
+	{
+		fprintf(json,
+			"%s\n    { \"name\": \"%s\", \"param\": \"%s\", \"value\": %zu, \"iterations\": %llu, \"repetitions\": %u, "
+			"\"ns_per_op\": %.3f, \"ns_per_op_min\": %.3f, \"cycles_per_op\": %.3f, "
+			"\"allocs_per_op\": %.4f, \"alloc_bytes_per_op\": %.2f, \"syscalls_per_op\": %.2f }",
+			*firstJsonEntry ? "" : ",",
+			bench->name,
+			PARAM_NAMES[bench->paramKind],
+			param,
+			iterations,
+			BENCH_REPETITIONS,
+			median->nsPerOp,
+			samples[0].nsPerOp,
+			median->cyclesPerOp,
+			median->allocsPerOp,
+			median->bytesPerOp,
+			median->syscallsPerOp);
+		*firstJsonEntry = false;
+	}
+
+	teardown(&ctx);
+	return 0;
+}
+
+
+static void printUsage(FILE* stream, const char* programName)
+{
+	fprintf(stream,
+		"Usage: %s [options]\n"
+		"Microbenchmarks of hot paths: parse, read, calculate, render, circbuf, circbuf_batch, files_*, query_week.\n"
+		"  -c, --cpus LIST       comma-separated processor counts (default " BENCH_DEFAULT_CPU_COUNTS ")\n"
+		"  -s, --item-sizes LIST comma-separated circular buffer item sizes in bytes (default " BENCH_DEFAULT_ITEM_SIZES ")\n"
+		"  -n, --files LIST      comma-separated counts of files read per operation (default " BENCH_DEFAULT_FILE_COUNTS ")\n"
+		"  -t, --min-time MS     measured time of every benchmark (default %u)\n"
+		"  -f, --filter NAME     run only benchmark of given name\n"
+		"  -j, --json PATH       write results as JSON into PATH, '-' for standard output\n"
+		"  -h, --help            print this message and exit\n",
+		programName,
+		BENCH_DEFAULT_MIN_TIME_MS);
+}
+
+
+/**
+ * \brief Parses comma-separated list of positive integers.
+ * \return True if successful, false otherwise.
+*/
+static bool parseList(const char* str, size_t* out, size_t* outLength)
+{
+	*outLength = 0u;
+
+	while ('\0' != *str)
+	{
+		char* end = NULL;
+		errno = 0;
+		unsigned long value = strtoul(str, &end, 10);
+
+		if ((0 != errno) || (end == str) || (0u == value) || (value > INT_MAX) ||
+			(('\0' != *end) && (',' != *end)) || (*outLength >= BENCH_MAX_PARAMS))
+		{
+			return false;
+		}
+
+		out[(*outLength)++] = (size_t) value;
+		str = ('\0' != *end) ? end + 1 : end;
+	}
+
+	return 0u != *outLength;
+}
+
+
+static int parseArgs(BenchParams_t* params, int argc, char* argv[])
+{
+	static const struct option LONG_OPTIONS[] =
+	{
+		{ "cpus",		required_argument,	NULL,	'c' },
+		{ "item-sizes",	required_argument,	NULL,	's' },
+		{ "files",		required_argument,	NULL,	'n' },
+		{ "min-time",	required_argument,	NULL,	't' },
+		{ "filter",		required_argument,	NULL,	'f' },
+		{ "json",		required_argument,	NULL,	'j' },
+		{ "help",		no_argument,		NULL,	'h' },
+		{ NULL,			0,					NULL,	0 }
+	};
+
+	parseList(BENCH_DEFAULT_CPU_COUNTS, params->cpuCounts, &params->cpuCountsLength);
+	parseList(BENCH_DEFAULT_ITEM_SIZES, params->itemSizes, &params->itemSizesLength);
+	parseList(BENCH_DEFAULT_FILE_COUNTS, params->fileCounts, &params->fileCountsLength);
+
+	int opt;
+
+	while (-1 != (opt = getopt_long(argc, argv, "c:s:n:t:f:j:h", LONG_OPTIONS, NULL)))
+	{
+		switch (opt)
+		{
+			case 'c':
+			{
+				if (!parseList(optarg, params->cpuCounts, &params->cpuCountsLength))
+				{
+					fprintf(stderr, "invalid processor counts: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 's':
+			{
+				if (!parseList(optarg, params->itemSizes, &params->itemSizesLength))
+				{
+					fprintf(stderr, "invalid item sizes: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'n':
+			{
+				if (!parseList(optarg, params->fileCounts, &params->fileCountsLength))
+				{
+					fprintf(stderr, "invalid file counts: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 't':
+			{
+				size_t minTime[1];
+				size_t length;
+
+				if (!parseList(optarg, minTime, &length) || (1u != length))
+				{
+					fprintf(stderr, "invalid minimum time: %s\n", optarg);
+					return -2;
+				}
+
+				params->minTimeMs = (unsigned) minTime[0];
+			}
+			break;
+
+			case 'f':
+			{
+				params->filter = optarg;
+			}
+			break;
+
+			case 'j':
+			{
+				params->jsonPath = optarg;
+			}
+			break;
+
+			case 'h':
+			{
+				return 1;
+			}
+
+			default:
+			{
+				return -2;
+			}
+		}
+	}
+
+	if (optind < argc)
+	{
+		fprintf(stderr, "unexpected argument: %s\n", argv[optind]);
+		return -3;
+	}
+
+	return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+	BenchParams_t params =
+	{
+		.minTimeMs 	= BENCH_DEFAULT_MIN_TIME_MS,
+		.jsonPath 	= NULL,
+		.filter 	= NULL
+	};
+
+	int result = parseArgs(&params, argc, argv);
+
+	if (0 != result)
+	{
+		printUsage((0 < result) ? stdout : stderr, argv[0]);
+		return (0 < result) ? 0 : 1;
+	}
+
+	FILE* json = NULL;
+
+	if (NULL != params.jsonPath)
+	{
+		json = (0 == strcmp(params.jsonPath, "-")) ? stdout : fopen(params.jsonPath, "w");
+
+		if (NULL == json)
+		{
+			fprintf(stderr, "cannot open %s\n", params.jsonPath);
+			return 1;
+		}
+	}
+
+	// Human-readable table goes to standard error when JSON is written to standard output
+	FILE* table = (stdout == json) ? stderr : stdout;
+
+	fprintf(table, "%-14s %-10s %8s %14s %14s %14s %10s %12s %12s\n",
+		"benchmark", "param", "value", "ns/op", "min ns/op", "cycles/op", "allocs/op", "bytes/op", "syscalls/op");
+
+	if (NULL != json)
+	{
+		fprintf(json, "{\n  \"format_version\": %d,\n  \"timestamp\": %llu,\n  \"cycle_counter\": %s,\n  \"results\": [",
+			BENCH_JSON_FORMAT_VERSION,
+			RealTimeNs() / 1000000000ull,
+			BENCH_HAVE_CYCLE_COUNTER ? "true" : "false");
+	}
+
+	int retval = 0;
+	bool firstJsonEntry = true;
+
+	for (size_t ii = 0; ii < sizeof(BENCHMARKS) / sizeof(*BENCHMARKS); ++ii)
+	{
+		const Benchmark_t* bench = &BENCHMARKS[ii];
+
+		if ((NULL != params.filter) && (0 != strcmp(params.filter, bench->name)))
+		{
+			continue;
+		}
+
+		const size_t* const VALUES[] = { params.cpuCounts, params.itemSizes, params.fileCounts };
+		const size_t VALUES_LENGTHS[] = { params.cpuCountsLength, params.itemSizesLength, params.fileCountsLength };
+		const size_t* values = VALUES[bench->paramKind];
+		const size_t valuesLength = VALUES_LENGTHS[bench->paramKind];
+
+		for (size_t jj = 0; jj < valuesLength; ++jj)
+		{
+			retval |= (0 != runBenchmark(bench, values[jj], &params, table, json, &firstJsonEntry)) ? 1 : 0;
+		}
+	}
+
+	if (NULL != json)
+	{
+		fprintf(json, "\n  ]\n}\n");
+
+		if (stdout != json)
+		{
+			fclose(json);
+		}
+	}
+
+	return retval;
+}
@@ -186,6 +186,27 @@ void CircularBuffer_writeMany(CircularBuffer_t* self, const void* inputBuffer, u
 }
 
 
+/**
+ * \brief Copy up to given amount of oldest items out of circular buffer, without removing them.
+ * Stored items occupy at most two contiguous regions, so at most two copies are made.
+ * \return Amount of items copied.
+*/
+static uint32_t copyOut(const CircularBuffer_t* self, void* outputBuffer, uint32_t itemCount)
+{
+	const uint32_t copyCount = uint32Min(itemCount, self->itemCount);
+	const uint32_t firstCount = uint32Min(copyCount, self->capacity - self->readOffset);
+
+	memcpy(outputBuffer, offsetBy(self->buffer, self->readOffset, self->itemSize), firstCount * self->itemSize);
+
+	if (firstCount < copyCount)
+	{
+		memcpy(offsetBy(outputBuffer, firstCount, self->itemSize), self->buffer, (copyCount - firstCount) * self->itemSize);
+	}
+
+	return copyCount;
+}
+
+
 uint32_t CircularBuffer_readMany(CircularBuffer_t* self, void* outputBuffer, uint32_t itemCount)
 {
 	if ( (NULL == self) ||  (NULL == outputBuffer) || (1u > itemCount) )
@@ -193,14 +214,10 @@ uint32_t CircularBuffer_readMany(CircularBuffer_t* self, void* outputBuffer, uin
 		return 0u;
 	}
 
-	uint32_t itemsReadCount = 0u;
-	const size_t itemSize = CircularBuffer_getItemSize(self);
+	const uint32_t itemsReadCount = copyOut(self, outputBuffer, itemCount);
 
-	while ( (itemsReadCount < itemCount) && (CircularBuffer_read(self, outputBuffer)) )
-	{
-		outputBuffer = (Byte_t*)outputBuffer + itemSize;
-		++itemsReadCount;
-	}
+	self->itemCount -= itemsReadCount;
+	self->readOffset = offsetForward(self->capacity, self->readOffset, itemsReadCount);
 
 	return itemsReadCount;
 }
@@ -213,16 +230,7 @@ uint32_t CircularBuffer_peekMany(const CircularBuffer_t* self, void* outputBuffe
 		return 0u;
 	}
 
-	uint32_t itemsPeekCount = 0u;
-	const size_t itemSize = CircularBuffer_getItemSize(self);
-
-	while ( (itemsPeekCount < itemCount) && (CircularBuffer_peek(self, outputBuffer)) )
-	{
-		outputBuffer = (Byte_t*)outputBuffer + itemSize;
-		++itemsPeekCount;
-	}
-
-	return itemsPeekCount;
+	return copyOut(self, outputBuffer, itemCount);
 }
 
 
@@ -122,11 +122,44 @@ static void test_CircularBuffer_peek(void)
 }
 
 
+static void test_CircularBuffer_readMany(void)
+{
+	CircularBuffer_t* cbuf = CircularBuffer_create(sizeof(double), TEST_CBUF_CAPACITY);
+	assert(NULL != cbuf); // Circular buffer couldn't be created
+
+	double output[TEST_CBUF_CAPACITY];
+
+	// Move read offset forward, so that stored items wrap around the end of underlying buffer
+	CircularBuffer_writeMany(cbuf, TEST_DATA, TEST_CBUF_CAPACITY / 2);
+	assert((TEST_CBUF_CAPACITY / 2) == CircularBuffer_readMany(cbuf, output, TEST_CBUF_CAPACITY)); // Not every stored item has been read
+	CircularBuffer_writeMany(cbuf, TEST_DATA + TEST_CBUF_CAPACITY, TEST_CBUF_CAPACITY);
+
+	assert(3 == CircularBuffer_peekMany(cbuf, output, 3)); // Amount of peeked items is different from the amount that has been requested
+	assert((TEST_DATA[TEST_CBUF_CAPACITY] == output[0]) && (TEST_DATA[TEST_CBUF_CAPACITY + 2] == output[2])); // Peeked items are not the oldest ones
+	assert(TEST_CBUF_CAPACITY == CircularBuffer_getItemCount(cbuf)); // Peeking removed items from circular buffer
+
+	assert(TEST_CBUF_CAPACITY == CircularBuffer_readMany(cbuf, output, TEST_CBUF_CAPACITY + 1)); // More items have been read than stored
+
+	for (size_t ii = 0; ii < TEST_CBUF_CAPACITY; ++ii)
+	{
+		assert(TEST_DATA[TEST_CBUF_CAPACITY + ii] == output[ii]); // Items wrapping around the end of buffer have been read out of order
+	}
+
+	assert(CircularBuffer_isEmpty(cbuf)); // Read items have not been removed from circular buffer
+
+	CircularBuffer_write(cbuf, &TEST_DATA[0]);
+	assert(CircularBuffer_read(cbuf, output) && (TEST_DATA[0] == output[0])); // Read offset is inconsistent after reading many items
+
+	CircularBuffer_destroy(cbuf);
+}
+
+
 int main()
 {
 	test_CircularBuffer_write();
 	test_CircularBuffer_read();
 	test_CircularBuffer_tryWrite();
 	test_CircularBuffer_peek();
+	test_CircularBuffer_readMany();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+/**
+ * \file mailbox.h
+ * Mailbox public interface.
+ * Mailbox passes items from a single producer to a single consumer with latest-value semantics:
+ * producer publishes without ever blocking or waiting for consumer, and consumer always takes the newest
+ * published item. Items published while consumer has been busy are replaced by newer ones and counted as dropped.
+ * Implemented as lock-free triple buffer, so items are never torn and never copied while holding a lock.
+*/
+#ifndef MAILBOX_H_INCLUDED
+#define MAILBOX_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/**
+ * Mailbox handle type, used in every operation on mailbox.
+*/
+typedef struct Mailbox Mailbox_t;
+
+
+/**
+ * \brief Create new mailbox for items of given size in dynamically allocated memory.
+ * \param itemSize Size of singular item.
+ * \return Pointer to newly created mailbox if successful, NULL otherwise.
+*/
+Mailbox_t* Mailbox_create(size_t itemSize);
+
+
+/**
+ * \brief Destroy given mailbox, freeing all resources used by it.
+ * \param self Mailbox to be destroyed.
+*/
+void Mailbox_destroy(Mailbox_t* self);
+
+
+/**
+ * \brief Retrieve size of singular item of given mailbox.
+ * \param self Mailbox.
+ * \return Size of singular item in bytes.
+*/
+size_t Mailbox_getItemSize(const Mailbox_t* self);
+
+
+/**
+ * \brief Retrieve slot producer should write next item into. Producer only.
+ * Slot stays owned by producer until Mailbox_publish() is called.
+ * \param self Mailbox.
+ * \return Pointer to slot, of size equal to item size.
+*/
+void* Mailbox_getWriteSlot(Mailbox_t* self);
+
+
+/**
+ * \brief Publish item written into slot retrieved by Mailbox_getWriteSlot(). Producer only, never blocks.
+ * If previously published item has not been taken by consumer yet, it is dropped.
+ * \param self Mailbox.
+*/
+void Mailbox_publish(Mailbox_t* self);
+
+
+/**
+ * \brief Copy item into mailbox and publish it. Producer only, never blocks.
+ * \param self Mailbox.
+ * \param itemPtr Pointer to item to be published.
+*/
+void Mailbox_write(Mailbox_t* self, const void* itemPtr);
+
+
+/**
+ * \brief Check whether item not yet taken by consumer has been published. May be called from any thread.
+ * \param self Mailbox.
+ * \return True if new item is available, false otherwise.
+*/
+bool Mailbox_hasNew(const Mailbox_t* self);
+
+
+/**
+ * \brief Take newest published item, if any has been published since previous call. Consumer only, never blocks.
+ * \param self Mailbox.
+ * \return Pointer to newest item, valid until next call, or NULL if there is no new item.
+*/
+const void* Mailbox_take(Mailbox_t* self);
+
+
+/**
+ * \brief Copy newest published item, if any has been published since previous call. Consumer only, never blocks.
+ * \param self Mailbox.
+ * \param itemOutPtr Pointer to buffer the item will be copied into.
+ * \return True if new item has been copied, false otherwise.
+*/
+bool Mailbox_read(Mailbox_t* self, void* itemOutPtr);
+
+
+/**
+ * \brief Retrieve amount of items published so far. May be called from any thread.
+ * \param self Mailbox.
+ * \return Amount of published items.
+*/
+uint64_t Mailbox_getPublishCount(const Mailbox_t* self);
+
+
+/**
+ * \brief Retrieve amount of items replaced by newer ones before consumer could take them. May be called from any thread.
+ * \param self Mailbox.
+ * \return Amount of dropped items.
+*/
+uint64_t Mailbox_getDropCount(const Mailbox_t* self);
+
+
+#endif // !MAILBOX_H_INCLUDED
@@ -0,0 +1,128 @@
+#include "mailbox.h"
+#include "mailbox_types.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+#define slotAt(self, index) ((Byte_t*)(self)->buffer + (index) * (self)->itemSize)
+
+
+Mailbox_t* Mailbox_create(size_t itemSize)
+{
+	Mailbox_t* self = malloc(sizeof(Mailbox_t));
+
+	if (NULL == self)
+	{
+		return NULL;
+	}
+
+	self->buffer = calloc(MAILBOX_SLOT_COUNT, itemSize);
+
+	if (NULL == self->buffer)
+	{
+		free(self);
+		return NULL;
+	}
+
+	self->itemSize = itemSize;
+	self->writeIndex = 0u;
+	self->readIndex = 1u;
+	atomic_init(&self->exchange, 2u);
+	atomic_init(&self->publishCount, 0u);
+	atomic_init(&self->dropCount, 0u);
+	return self;
+}
+
+
+void Mailbox_destroy(Mailbox_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	free(self->buffer);
+	free(self);
+}
+
+
+size_t Mailbox_getItemSize(const Mailbox_t* self)
+{
+	return self->itemSize;
+}
+
+
+void* Mailbox_getWriteSlot(Mailbox_t* self)
+{
+	return slotAt(self, self->writeIndex);
+}
+
+
+void Mailbox_publish(Mailbox_t* self)
+{
+	// Hand written slot over for exchange, taking back whichever slot has been there.
+	// Release makes slot contents visible to consumer, acquire makes sure consumer is done with the slot taken back.
+	const unsigned previous = atomic_exchange_explicit(&self->exchange, self->writeIndex | MAILBOX_FRESH_BIT, memory_order_acq_rel);
+
+	self->writeIndex = previous & MAILBOX_INDEX_MASK;
+	atomic_fetch_add_explicit(&self->publishCount, 1u, memory_order_relaxed);
+
+	if (0u != (previous & MAILBOX_FRESH_BIT))
+	{
+		atomic_fetch_add_explicit(&self->dropCount, 1u, memory_order_relaxed);
+	}
+}
+
+
+void Mailbox_write(Mailbox_t* self, const void* itemPtr)
+{
+	memcpy(Mailbox_getWriteSlot(self), itemPtr, self->itemSize);
+	Mailbox_publish(self);
+}
+
+
+bool Mailbox_hasNew(const Mailbox_t* self)
+{
+	return 0u != (atomic_load_explicit(&self->exchange, memory_order_acquire) & MAILBOX_FRESH_BIT);
+}
+
+
+const void* Mailbox_take(Mailbox_t* self)
+{
+	if (!Mailbox_hasNew(self))
+	{
+		return NULL;
+	}
+
+	// Only consumer clears fresh bit, so exchanged slot still holds new item, possibly even newer than the one seen above
+	const unsigned previous = atomic_exchange_explicit(&self->exchange, self->readIndex, memory_order_acq_rel);
+
+	self->readIndex = previous & MAILBOX_INDEX_MASK;
+	return slotAt(self, self->readIndex);
+}
+
+
+bool Mailbox_read(Mailbox_t* self, void* itemOutPtr)
+{
+	const void* item = Mailbox_take(self);
+
+	if (NULL == item)
+	{
+		return false;
+	}
+
+	memcpy(itemOutPtr, item, self->itemSize);
+	return true;
+}
+
+
+uint64_t Mailbox_getPublishCount(const Mailbox_t* self)
+{
+	return atomic_load_explicit(&self->publishCount, memory_order_relaxed);
+}
+
+
+uint64_t Mailbox_getDropCount(const Mailbox_t* self)
+{
+	return atomic_load_explicit(&self->dropCount, memory_order_relaxed);
+}
@@ -0,0 +1,77 @@
+/**
+ * \file mailbox_types.h
+ * Private type definitions for usage in mailbox implementation.
+*/
+#ifndef MAILBOX_TYPES_H_INCLUDED
+#define MAILBOX_TYPES_H_INCLUDED
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+
+/**
+ * Amount of item slots: one owned by producer, one owned by consumer and one exchanged between them.
+*/
+#define MAILBOX_SLOT_COUNT 3u
+
+/**
+ * Bits of exchange word holding index of exchanged slot.
+*/
+#define MAILBOX_INDEX_MASK 0x3u
+
+/**
+ * Bit of exchange word set when exchanged slot holds item not yet taken by consumer.
+*/
+#define MAILBOX_FRESH_BIT 0x4u
+
+
+/**
+ * Single-byte type.
+*/
+typedef char Byte_t;
+
+
+/**
+ * Mailbox control structure.
+*/
+struct Mailbox
+{
+	/**
+	 * Pointer to storage of every slot, each item size bytes long.
+	*/
+	void* buffer;
+
+	/**
+	 * Size of single item in bytes.
+	*/
+	size_t itemSize;
+
+	/**
+	 * Index of exchanged slot, combined with MAILBOX_FRESH_BIT.
+	 * The only member accessed by both producer and consumer.
+	*/
+	atomic_uint exchange;
+
+	/**
+	 * Index of slot currently written by producer. Accessed by producer only.
+	*/
+	unsigned writeIndex;
+
+	/**
+	 * Index of slot holding item most recently taken by consumer. Accessed by consumer only.
+	*/
+	unsigned readIndex;
+
+	/**
+	 * Amount of published items.
+	*/
+	atomic_uint_least64_t publishCount;
+
+	/**
+	 * Amount of published items replaced by newer ones before consumer could take them.
+	*/
+	atomic_uint_least64_t dropCount;
+};
+
+
+#endif // !MAILBOX_TYPES_H_INCLUDED
@@ -0,0 +1,127 @@
+#include "mailbox.h"
+#include <assert.h>
+#include <stdint.h>
+#include <threads.h>
+
+
+#define TEST_ITEM_LENGTH 		64u
+#define TEST_PUBLISH_COUNT 		200000u
+
+
+/**
+ * Item large enough to be torn if producer and consumer ever accessed the same slot.
+*/
+typedef struct TestItem
+{
+	uint64_t values[TEST_ITEM_LENGTH];
+}
+TestItem_t;
+
+
+static void fillItem(TestItem_t* item, uint64_t value)
+{
+	for (size_t ii = 0; ii < TEST_ITEM_LENGTH; ++ii)
+	{
+		item->values[ii] = value;
+	}
+}
+
+
+static void test_Mailbox_latestValue(void)
+{
+	Mailbox_t* mailbox = Mailbox_create(sizeof(uint64_t));
+	assert(NULL != mailbox); // Mailbox couldn't be created
+	assert(sizeof(uint64_t) == Mailbox_getItemSize(mailbox));
+
+	uint64_t value = 0u;
+	assert(!Mailbox_hasNew(mailbox)); // Mailbox is not created empty
+	assert(!Mailbox_read(mailbox, &value)); // Item has been read from empty mailbox
+	assert(NULL == Mailbox_take(mailbox));
+
+	value = 1u;
+	Mailbox_write(mailbox, &value);
+	assert(Mailbox_hasNew(mailbox));
+	value = 0u;
+	assert(Mailbox_read(mailbox, &value));
+	assert(1u == value);
+	assert(!Mailbox_hasNew(mailbox)); // Item can be taken only once
+	assert(NULL == Mailbox_take(mailbox));
+
+	// Only the newest of items published in the meantime is delivered, others are counted as dropped
+	for (uint64_t ii = 2u; ii <= 5u; ++ii)
+	{
+		*(uint64_t*) Mailbox_getWriteSlot(mailbox) = ii;
+		Mailbox_publish(mailbox);
+	}
+
+	const uint64_t* taken = Mailbox_take(mailbox);
+	assert(NULL != taken);
+	assert(5u == *taken);
+	assert(5u == Mailbox_getPublishCount(mailbox));
+	assert(3u == Mailbox_getDropCount(mailbox));
+
+	Mailbox_destroy(mailbox);
+}
+
+
+static int producerThread(void* arg)
+{
+	Mailbox_t* mailbox = arg;
+
+	for (uint64_t ii = 1u; ii <= TEST_PUBLISH_COUNT; ++ii)
+	{
+		fillItem(Mailbox_getWriteSlot(mailbox), ii);
+		Mailbox_publish(mailbox);
+	}
+
+	return 0;
+}
+
+
+static void test_Mailbox_concurrent(void)
+{
+	Mailbox_t* mailbox = Mailbox_create(sizeof(TestItem_t));
+	assert(NULL != mailbox);
+
+	thrd_t producer;
+	assert(thrd_success == thrd_create(&producer, producerThread, mailbox));
+
+	uint64_t last = 0u;
+	uint64_t takenCount = 0u;
+
+	while (last < TEST_PUBLISH_COUNT)
+	{
+		const TestItem_t* item = Mailbox_take(mailbox);
+
+		if (NULL == item)
+		{
+			continue;
+		}
+
+		// Items are complete and arrive in publication order
+		assert(item->values[0] > last);
+
+		for (size_t ii = 1; ii < TEST_ITEM_LENGTH; ++ii)
+		{
+			assert(item->values[ii] == item->values[0]); // Item has been torn
+		}
+
+		last = item->values[0];
+		++takenCount;
+	}
+
+	thrd_join(producer, NULL);
+
+	assert(TEST_PUBLISH_COUNT == Mailbox_getPublishCount(mailbox));
+	assert(TEST_PUBLISH_COUNT == takenCount + Mailbox_getDropCount(mailbox)); // Every item has been either taken or dropped
+
+	Mailbox_destroy(mailbox);
+}
+
+
+int main(void)
+{
+	test_Mailbox_latestValue();
+	test_Mailbox_concurrent();
+	return 0;
+}
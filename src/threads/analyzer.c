@@ -7,6 +7,9 @@
 #include "helpers.h"
 #include "watchdog.h"
 #include "threadctl.h"
+#include "latency.h"
+#include "flightrec.h"
+#include "recording.h"
 #include <stdlib.h>
 #include <string.h>
 #include <threads.h>
@@ -26,6 +29,97 @@ static ThreadInfo_t g_analyzerThreadInfo =
 };
 
 
+/**
+ * \brief Retrieves item of given index from array of variable-size items.
+ * \param batch Array of items.
+ * \param index Index of item.
+ * \param itemSize Size of every item, in bytes.
+ * \return Pointer to item.
+*/
+static inline void* batchItem(void* batch, size_t index, size_t itemSize)
+{
+	return (char*) batch + index * itemSize;
+}
+
+
+/**
+ * \brief Passes usage statistics of every calculated interval to flight recorder, and snapshots it has been calculated from
+ * to steal tracker.
+ * \param stealTracker Steal tracker, NULL if steal is not tracked.
+ * \param oldProcStat Snapshot taken at the start of the interval.
+ * \param newProcStat Snapshot taken at the end of the interval.
+ * \param usageInfo Usage statistics of the interval.
+*/
+static void checkUsage(StealTracker_t* stealTracker, const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, const CpuUsageCompact_t* usageInfo)
+{
+	FlightRecorder_checkUsage(usageInfo);
+
+	if ((NULL != stealTracker) && (0 > StealTracker_update(stealTracker, oldProcStat, newProcStat, usageInfo)))
+	{
+		Log(LLEVEL_ERROR, "cannot record steal of %zu processor lines", usageInfo->valuesLength);
+	}
+}
+
+
+/**
+ * \brief Counterpart of checkUsage() for usage calculated from change of counters.
+*/
+static void checkUsageFromDelta(StealTracker_t* stealTracker, const ProcStatDelta_t* delta, const CpuUsageCompact_t* usageInfo)
+{
+	FlightRecorder_checkUsage(usageInfo);
+
+	if ((NULL != stealTracker) && (0 > StealTracker_updateFromDelta(stealTracker, delta, usageInfo)))
+	{
+		Log(LLEVEL_ERROR, "cannot record steal of %zu processor lines", usageInfo->valuesLength);
+	}
+}
+
+
+/**
+ * \brief Calculates usage statistics from changes of data read from input buffer in delta mode.
+ * \param stealTracker Steal tracker every calculated interval is recorded into, NULL if steal is not tracked.
+ * \param catchUp Way of processing more than one change.
+ * \param deltaBatch Changes over consecutive intervals, modified in the process.
+ * \param count Amount of changes, at least one.
+ * \param usageInfoBatch Buffer for usage statistics of every interval but the last one, used in batch catch-up mode.
+ * \param output Buffer for usage statistics of the last interval, or all of them when coalesced.
+*/
+static void calculateFromDeltas(
+	StealTracker_t* stealTracker,
+	AnalyzerCatchUp_t catchUp,
+	ProcStatDelta_t* deltaBatch,
+	uint32_t count,
+	CpuUsageCompact_t* usageInfoBatch,
+	CpuUsageCompact_t* output)
+{
+	const size_t deltaSize = ProcStatDelta_size();
+
+	if (ACATCHUP_BATCH == catchUp)
+	{
+		for (uint32_t ii = 0; ii + 1u < count; ++ii)
+		{
+			CpuUsageCompact_t* const usageInfo = batchItem(usageInfoBatch, ii, CpuUsageCompact_size());
+			CpuUsageCompact_calculateFromDelta(batchItem(deltaBatch, ii, deltaSize), usageInfo);
+			checkUsageFromDelta(stealTracker, batchItem(deltaBatch, ii, deltaSize), usageInfo);
+		}
+
+		CpuUsageCompact_calculateFromDelta(batchItem(deltaBatch, count - 1u, deltaSize), output);
+		checkUsageFromDelta(stealTracker, batchItem(deltaBatch, count - 1u, deltaSize), output);
+	}
+	else
+	{
+		// Changes over consecutive intervals add up to the change over the whole backlog
+		for (uint32_t ii = 1u; ii < count; ++ii)
+		{
+			ProcStatDelta_merge(deltaBatch, batchItem(deltaBatch, ii, deltaSize));
+		}
+
+		CpuUsageCompact_calculateFromDelta(deltaBatch, output);
+		checkUsageFromDelta(stealTracker, deltaBatch, output);
+	}
+}
+
+
 int AnalyzerThread(void* rawParams)
 {
 	int retval = 0;
@@ -43,27 +137,35 @@ int AnalyzerThread(void* rawParams)
 	}
 
 	AnalyzerThreadParams_t* const params = (AnalyzerThreadParams_t*) rawParams;
-	ProcStat_t* oldStatBuffer = malloc(ProcStat_size());
-	ProcStat_t* newStatBuffer = malloc(ProcStat_size());
-	CpuUsageInfo_t* const usageInfoBuffer = malloc(CpuUsageInfo_size());
-	bool oldStatBufferInitialized = false;
-
-	if (NULL == oldStatBuffer)
+	// Without catch-up, snapshots are taken one at a time and batches hold a single one
+	const uint32_t batchCapacity = (ACATCHUP_NONE == params->catchUp) ? 1u : CircularBuffer_getCapacity(params->inBuf);
+	const size_t procStatSize = params->deltaMode ? ProcStatDelta_size() : ProcStat_size();
+	void* newStatBatch = malloc(batchCapacity * procStatSize);
+	void* prevStatBatch = malloc(batchCapacity * procStatSize);
+	CpuUsageCompact_t* usageInfoBatch = NULL;
+	const ProcStat_t* oldStatBuffer = NULL;
+
+	if (NULL == newStatBatch)
 	{
 		retval = -3;
 		goto error_exit_1;
 	}
 
-	if (NULL == newStatBuffer)
+	if (NULL == prevStatBatch)
 	{
 		retval = -3;
 		goto error_exit_2;
 	}
 
-	if (NULL == usageInfoBuffer)
+	if (ACATCHUP_BATCH == params->catchUp)
 	{
-		retval = -3;
-		goto error_exit_3;
+		usageInfoBatch = malloc(batchCapacity * CpuUsageCompact_size());
+
+		if (NULL == usageInfoBatch)
+		{
+			retval = -3;
+			goto error_exit_3;
+		}
 	}
 
 	// Main loop
@@ -108,7 +210,10 @@ int AnalyzerThread(void* rawParams)
 			break;
 		}
 
-		if (!CircularBuffer_read(params->inBuf, newStatBuffer))
+		// Whole backlog is drained at once, so that it is processed in a single pass
+		const uint32_t readCount = CircularBuffer_readMany(params->inBuf, newStatBatch, batchCapacity);
+
+		if (0u == readCount)
 		{
 			Log(LLEVEL_ERROR, "attempted read from empty buffer");
 			
@@ -120,6 +225,12 @@ int AnalyzerThread(void* rawParams)
 			continue;
 		}
 
+		for (uint32_t ii = 0; ii < readCount; ++ii)
+		{
+			void* const item = batchItem(newStatBatch, ii, procStatSize);
+			Latency_mark(params->deltaMode ? &((ProcStatDelta_t*) item)->stamps : &((ProcStat_t*) item)->stamps, LSTAGE_ANALYZER_IN);
+		}
+
 		if (thrd_success != Mutex_unlock(params->inMtx))
 		{
 			Log(LLEVEL_ERROR, "couldn't release input buffer mutex");
@@ -131,61 +242,131 @@ int AnalyzerThread(void* rawParams)
 			Log(LLEVEL_ERROR, "couldn't notify on input condition variable");
 		}
 
-		if (!oldStatBufferInitialized)
+		for (uint32_t ii = 0; (NULL != params->recorder) && !params->deltaMode && (ii < readCount); ++ii)
 		{
-			ProcStat_t* tmp 			= oldStatBuffer;
-			oldStatBuffer 				= newStatBuffer;
-			newStatBuffer 				= tmp;
-			oldStatBufferInitialized 	= true;
-			continue;
+			if (0 != RecordingWriter_append(params->recorder, batchItem(newStatBatch, ii, procStatSize)))
+			{
+				Log(LLEVEL_ERROR, "couldn't append sample to recording");
+			}
 		}
 
-		CpuUsageInfo_calculate(oldStatBuffer, newStatBuffer, usageInfoBuffer);
+		// Statistics are calculated in place, in the slot that is going to be published
+		CpuUsageCompact_t* const usageInfoBuffer = Mailbox_getWriteSlot(params->outMailbox);
 
-		if (thrd_success != Mutex_tryLockMs(params->outMtx, ANALYZER_MUTEX_WAIT_TIME_MS))
+		if (params->deltaMode)
 		{
-			Log(LLEVEL_WARNING, "couldn't acquire output buffer mutex");
-			continue;
-		}
+			if (1u < readCount)
+			{
+				Log(LLEVEL_DEBUG, "catching up on %u intervals", readCount);
+			}
 
-		// Wait and write to output buffer
-		timePoint = TimePointMs(ANALYZER_CONDVAR_WAIT_TIME_MS);
-		while (CircularBuffer_isFull(params->outBuf) && (false == Thread_getKillSwitchStatus()))
+			calculateFromDeltas(params->stealTracker, params->catchUp, newStatBatch, readCount, usageInfoBatch, usageInfoBuffer);
+		}
+		else
 		{
-			int result = CondVar_waitUntil(params->outNotFullCv, params->outMtx, &timePoint);
+			const ProcStat_t* const newStatBuffer = batchItem(newStatBatch, readCount - 1u, procStatSize);
+			const ProcStat_t* firstStatBuffer = newStatBatch;
+			uint32_t intervalCount = readCount;
 
-			if (thrd_success == result)
+			if (NULL == oldStatBuffer)
 			{
-				Log(LLEVEL_DEBUG, "received notification on output condition variable");
-				break;
+				oldStatBuffer 	= firstStatBuffer;
+				firstStatBuffer = batchItem(newStatBatch, 1u, procStatSize);
+				--intervalCount;
 			}
-			else if (thrd_timedout == result)
+
+			if (0u == intervalCount)
 			{
-				Log(LLEVEL_WARNING, "timeout while waiting on output condition variable");
-				break;
+				void* tmp 		= prevStatBatch;
+				prevStatBatch 	= newStatBatch;
+				newStatBatch 	= tmp;
+				oldStatBuffer 	= newStatBuffer;
+				continue;
+			}
+
+			if (1u < intervalCount)
+			{
+				Log(LLEVEL_DEBUG, "catching up on %u intervals", intervalCount);
+			}
+
+			if ((ACATCHUP_BATCH == params->catchUp) && (1u < intervalCount))
+			{
+				CpuUsageCompact_calculateMany(oldStatBuffer, firstStatBuffer, intervalCount, usageInfoBatch);
+
+				// Intervals end at the last intervalCount snapshots of the batch
+				const uint32_t firstIndex = readCount - intervalCount;
+
+				for (uint32_t ii = 0; ii < intervalCount; ++ii)
+				{
+					const ProcStat_t* const intervalStart = (0u == ii) ? oldStatBuffer : batchItem(newStatBatch, firstIndex + ii - 1u, procStatSize);
+					checkUsage(params->stealTracker, intervalStart, batchItem(newStatBatch, firstIndex + ii, procStatSize),
+						batchItem(usageInfoBatch, ii, CpuUsageCompact_size()));
+				}
+
+				memcpy(usageInfoBuffer, batchItem(usageInfoBatch, intervalCount - 1u, CpuUsageCompact_size()), CpuUsageCompact_size());
 			}
 			else
 			{
-				Log(LLEVEL_ERROR, "error while waiting on output condition variable");
+				// Counters are cumulative, so usage over the whole backlog does not need snapshots in between
+				CpuUsageCompact_calculate(oldStatBuffer, newStatBuffer, usageInfoBuffer);
+				checkUsage(params->stealTracker, oldStatBuffer, newStatBuffer, usageInfoBuffer);
 			}
-			
+
+			Log(LLEVEL_TRACE, "old data: %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
+				oldStatBuffer->cpuStats[0].values[0],
+				oldStatBuffer->cpuStats[0].values[1],
+				oldStatBuffer->cpuStats[0].values[2],
+				oldStatBuffer->cpuStats[0].values[3],
+				oldStatBuffer->cpuStats[0].values[4],
+				oldStatBuffer->cpuStats[0].values[5],
+				oldStatBuffer->cpuStats[0].values[6],
+				oldStatBuffer->cpuStats[0].values[7],
+				oldStatBuffer->cpuStats[0].values[8],
+				oldStatBuffer->cpuStats[0].values[9]);
+
+			Log(LLEVEL_TRACE, "new data: %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
+				newStatBuffer->cpuStats[0].values[0],
+				newStatBuffer->cpuStats[0].values[1],
+				newStatBuffer->cpuStats[0].values[2],
+				newStatBuffer->cpuStats[0].values[3],
+				newStatBuffer->cpuStats[0].values[4],
+				newStatBuffer->cpuStats[0].values[5],
+				newStatBuffer->cpuStats[0].values[6],
+				newStatBuffer->cpuStats[0].values[7],
+				newStatBuffer->cpuStats[0].values[8],
+				newStatBuffer->cpuStats[0].values[9]);
+
+			// Swap local incoming data batches so that in the next iteration, newest snapshot is kept and older ones are overwritten
+			void* tmp 		= prevStatBatch;
+			prevStatBatch 	= newStatBatch;
+			newStatBatch 	= tmp;
+			oldStatBuffer 	= newStatBuffer;
 		}
 
-		if (Thread_getKillSwitchStatus())
+		Log(LLEVEL_TRACE, "result: %u bp", (unsigned) usageInfoBuffer->values[0]);
+
+		// Groups are rolled up from per-processor usage of published interval only
+		CpuUsageCompact_rollup(params->topology, usageInfoBuffer);
+
+		// Steal report is published first, so that printer never takes it older than statistics
+		if (NULL != params->stealTracker)
 		{
-			if (thrd_success != Mutex_unlock(params->outMtx))
-			{
-				Log(LLEVEL_ERROR, "couldn't release output buffer mutex");
-			}
-			break;
+			StealTracker_report(params->stealTracker, Mailbox_getWriteSlot(params->stealMailbox));
+			Mailbox_publish(params->stealMailbox);
 		}
 
-		CircularBuffer_write(params->outBuf, usageInfoBuffer);
+		Latency_mark(&usageInfoBuffer->stamps, LSTAGE_ANALYZER_OUT);
+		Mailbox_publish(params->outMailbox);
 
-		if (thrd_success != Mutex_unlock(params->outMtx))
+		// Passing through the mutex orders this notification after printer's check for new data,
+		// so that it cannot be lost between the check and the wait
+		if (thrd_success != Mutex_tryLockMs(params->outMtx, ANALYZER_MUTEX_WAIT_TIME_MS))
 		{
-			Log(LLEVEL_ERROR, "couldn't release output buffer mutex");
-			continue;
+			Log(LLEVEL_WARNING, "couldn't acquire output mailbox mutex");
+		}
+		else if (thrd_success != Mutex_unlock(params->outMtx))
+		{
+			Log(LLEVEL_ERROR, "couldn't release output mailbox mutex");
 		}
 
 		if (thrd_success != CondVar_notify(params->outNotEmptyCv))
@@ -197,51 +378,24 @@ int AnalyzerThread(void* rawParams)
 			Log(LLEVEL_DEBUG, "notification sent on output condition variable");
 		}
 
-		Log(LLEVEL_TRACE, "old data: %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
-			oldStatBuffer->cpuStats[0].values[0],
-			oldStatBuffer->cpuStats[0].values[1],
-			oldStatBuffer->cpuStats[0].values[2],
-			oldStatBuffer->cpuStats[0].values[3],
-			oldStatBuffer->cpuStats[0].values[4],
-			oldStatBuffer->cpuStats[0].values[5],
-			oldStatBuffer->cpuStats[0].values[6],
-			oldStatBuffer->cpuStats[0].values[7],
-			oldStatBuffer->cpuStats[0].values[8],
-			oldStatBuffer->cpuStats[0].values[9]);
-
-		Log(LLEVEL_TRACE, "new data: %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu", 
-			newStatBuffer->cpuStats[0].values[0],
-			newStatBuffer->cpuStats[0].values[1],
-			newStatBuffer->cpuStats[0].values[2],
-			newStatBuffer->cpuStats[0].values[3],
-			newStatBuffer->cpuStats[0].values[4],
-			newStatBuffer->cpuStats[0].values[5],
-			newStatBuffer->cpuStats[0].values[6],
-			newStatBuffer->cpuStats[0].values[7],
-			newStatBuffer->cpuStats[0].values[8],
-			newStatBuffer->cpuStats[0].values[9]);
-
-		Log(LLEVEL_TRACE, "result: %.2f", usageInfoBuffer->values[0]);
-
-		// Swap local incoming data buffer pointers so that in the next iteration, old data is overwritten
-		ProcStat_t* tmp = oldStatBuffer;
-		oldStatBuffer 	= newStatBuffer;
-		newStatBuffer 	= tmp;
+		Log(LLEVEL_TRACE, "dropped: %llu of %llu", 
+			(unsigned long long) Mailbox_getDropCount(params->outMailbox),
+			(unsigned long long) Mailbox_getPublishCount(params->outMailbox));
 	}
 
 	Log(LLEVEL_INFO, "thread exiting");
 
-	free(newStatBuffer);
-	free(oldStatBuffer);
-	free(usageInfoBuffer);
+	free(usageInfoBatch);
+	free(prevStatBatch);
+	free(newStatBatch);
 	
 	// Exit as usual
 	thrd_exit(retval);
 
 error_exit_3:
-	free(newStatBuffer);
+	free(prevStatBatch);
 error_exit_2:
-	free(oldStatBuffer);
+	free(newStatBatch);
 error_exit_1:
 	thrd_exit(retval);
 }
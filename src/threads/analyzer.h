@@ -6,7 +6,25 @@
 #define ANALYZER_H_INCLUDED
 #include "sync.h"
 #include "circbuf.h"
+#include "mailbox.h"
 #include "cpuusage.h"
+#include "recording.h"
+#include "stealtrack.h"
+
+/**
+ * Ways of processing snapshots accumulated in input buffer while analyzer has been falling behind.
+*/
+typedef enum AnalyzerCatchUp
+{
+	/** Snapshots are taken one at a time and every interval is calculated and published. */
+	ACATCHUP_NONE,
+	/** Whole backlog is taken at once and a single interval, from the last processed snapshot to the newest one, is calculated. */
+	ACATCHUP_COALESCE,
+	/** Whole backlog is taken at once and every interval is calculated in a single pass, only the newest one is published. */
+	ACATCHUP_BATCH
+}
+AnalyzerCatchUp_t;
+
 
 /**
  * Paramters required by AnalyzerThread() function.
@@ -34,36 +52,67 @@ typedef struct AnalyzerThreadParams
 	/**
 	 * Buffer to read incoming data from.
 	 * Underlying CircularBuffer_t structure must be able to hold at least one ProcStat_t structure,
-	 * size equal to that retrieved by ProcStat_size() function.
+	 * size equal to that retrieved by ProcStat_size() function, or ProcStatDelta_t structure in delta mode.
 	 * This parameter should be shared with reader thread.
 	*/
 	CircularBuffer_t* inBuf;
 
 	/**
-	 * Mutex to lock on while writing data to output buffer.
+	 * Whether input buffer holds changes between consecutive snapshots (ProcStatDelta_t) rather than snapshots.
+	 * Must match delta mode of reader thread.
+	*/
+	bool deltaMode;
+
+	/**
+	 * Mutex to lock on while notifying printer thread about new data in output mailbox.
+	 * Never held while usage statistics are being calculated or published.
 	 * This parameter should be shared with printer thread.
 	*/
 	MutexHandle_t outMtx;
 
 	/** 
-	 * Condition variable to signal once data has been made available to other threads through output buffer.
+	 * Condition variable to signal once data has been published to output mailbox.
 	 * This parameter should be shared with printer thread.
 	*/
 	CondVarHandle_t outNotEmptyCv;
 
 	/**
-	 * Condition variable to wait on while data is being consumed from output buffer.
+	 * Output mailbox to publish calculated usage statistics into. Publishing never waits for printer thread,
+	 * statistics it has not taken in time are replaced by newer ones.
+	 * Mailbox item size must be equal to that retrieved by CpuUsageCompact_sizeWithRollups() function for given topology.
 	 * This parameter should be shared with printer thread.
 	*/
-	CondVarHandle_t outNotFullCv;
+	Mailbox_t* outMailbox;
+
+	/**
+	 * Topology of processors, usage of every group of which is published along with per-processor usage.
+	 * NULL disables topology rollups.
+	*/
+	const CpuTopology_t* topology;
+
+	/**
+	 * Way of processing backlog of snapshots in input buffer.
+	*/
+	AnalyzerCatchUp_t catchUp;
+
+	/**
+	 * Recording writer every received sample is appended to. NULL disables recording.
+	 * Not supported in delta mode, since raw samples never reach analyzer.
+	*/
+	RecordingWriter_t* recorder;
+
+	/**
+	 * Steal tracker every calculated interval is recorded into, including ones of batches that are not published.
+	 * NULL disables steal tracking.
+	*/
+	StealTracker_t* stealTracker;
 
 	/**
-	 * Output buffer to periodically write calculated usage statistics into.
-	 * Underlying CircularBuffer_t structure must be able to hold at least one CpuUsageInfo_t structure,
-	 * size equal to that retrieved by CpuUsageInfo_size() function.
+	 * Output mailbox to publish steal report into along with every set of usage statistics. Ignored if stealTracker is NULL.
+	 * Mailbox item size must be equal to that retrieved by StealUsageReport_size() function for tracked processor count.
 	 * This parameter should be shared with printer thread.
 	*/
-	CircularBuffer_t* outBuf;
+	Mailbox_t* stealMailbox;
 }
 AnalyzerThreadParams_t;
 
@@ -72,7 +121,7 @@ AnalyzerThreadParams_t;
  * \brief Thread function for analyzing data from /proc/stat file
  * and calculating usage statistics for logical processor.
  * \details Thread will periodically read data from input buffer (inBuf) and use it to calculate
- * usage statistics for logical processors, subsequently writing them into output buffer (outBuf).
+ * usage statistics for logical processors, subsequently publishing them into output mailbox (outMailbox).
  * \param params Pointer to valid ReaderThreadParams_t structure.
 */
 int AnalyzerThread(void* params);
@@ -0,0 +1,473 @@
+#include "flightrec.h"
+#include "procstat.h"
+#include "cpucount.h"
+#include "circbuf.h"
+#include "sampler.h"
+#include "sync.h"
+#include "logger.h"
+#include "helpers.h"
+#include "watchdog.h"
+#include "threadctl.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <threads.h>
+
+
+#define FREC_MUTEX_WAIT_TIME_MS 		50
+#define FREC_CONDVAR_WAIT_TIME_MS 		500
+#define FREC_SLEEP_SLICE_MS 			250
+#define FREC_THREAD_ID 					TID_RECORDER
+#define FREC_THREAD_NAME 				"Recorder"
+#define FREC_DUMP_THREAD_ID 			TID_DUMPER
+#define FREC_DUMP_THREAD_NAME 			"Dumper"
+#define FREC_FILE_NAME_FORMAT 			"%s/cut_flightrec_%llu_%s.bin"
+
+
+static ThreadInfo_t g_recorderThreadInfo =
+{
+	.tid 	= FREC_THREAD_ID,
+	.name 	= FREC_THREAD_NAME
+};
+
+static ThreadInfo_t g_dumperThreadInfo =
+{
+	.tid 	= FREC_DUMP_THREAD_ID,
+	.name 	= FREC_DUMP_THREAD_NAME
+};
+
+static const char* TRIGGER_NAMES[FREC_TRIGGER_COUNT_] =
+{
+	[FREC_TRIGGER_NONE] 		= "none",
+	[FREC_TRIGGER_THRESHOLD] 	= "threshold",
+	[FREC_TRIGGER_SIGNAL] 		= "signal",
+	[FREC_TRIGGER_WATCHDOG] 	= "watchdog"
+};
+
+static atomic_bool g_initialized = false;
+// Trigger awaiting handover, written from signal handlers and other threads
+static atomic_int g_pendingTrigger = FREC_TRIGGER_NONE;
+// Set while spare ring is owned by dump thread
+static atomic_bool g_spareBusy = false;
+// Set once sampling thread has exited, so that dump thread knows no more handovers will come
+static atomic_bool g_samplerFinished = false;
+static atomic_ullong g_lastThresholdTriggerNs = 0u;
+
+static unsigned g_periodMs;
+static unsigned g_windowMs;
+static double g_usageThresholdPct;
+static char g_dumpDirectory[PATH_MAX];
+
+// Ring currently being sampled into, accessed by sampling thread only
+static CircularBuffer_t* g_ring = NULL;
+// Ring handed over to dump thread, accessed under g_dumpMtx
+static CircularBuffer_t* g_spare = NULL;
+static ProcStat_t* g_sampleScratch = NULL;
+static ProcStat_t* g_dumpScratch = NULL;
+static mtx_t g_dumpMtx;
+static cnd_t g_dumpReadyCv;
+static bool g_dumpReady = false;
+static FlightRecorderTrigger_t g_dumpTrigger = FREC_TRIGGER_NONE;
+static unsigned long long g_dumpRealTimeNs = 0u;
+static unsigned long long g_dumpMonotonicNs = 0u;
+
+
+/**
+ * \brief Hands current ring over to dump thread and continues sampling into the spare one.
+ * \param trigger Event that triggered the dump.
+ * \return True if ring has been handed over, false otherwise.
+*/
+static bool handOverRing(FlightRecorderTrigger_t trigger)
+{
+	if (thrd_success != Mutex_tryLockMs(&g_dumpMtx, FREC_MUTEX_WAIT_TIME_MS))
+	{
+		Log(LLEVEL_WARNING, "couldn't acquire dump mutex");
+		return false;
+	}
+
+	CircularBuffer_t* tmp 	= g_ring;
+	g_ring 					= g_spare;
+	g_spare 				= tmp;
+	g_spareBusy 			= true;
+	g_dumpReady 			= true;
+	g_dumpTrigger 			= trigger;
+	g_dumpRealTimeNs 		= RealTimeNs();
+	g_dumpMonotonicNs 		= MonotonicTimeNs();
+
+	if (thrd_success != Mutex_unlock(&g_dumpMtx))
+	{
+		Log(LLEVEL_ERROR, "couldn't release dump mutex");
+	}
+
+	if (thrd_success != CondVar_notify(&g_dumpReadyCv))
+	{
+		Log(LLEVEL_ERROR, "couldn't notify on dump condition variable");
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Hands ring over to dump thread if dump has been requested and previous one has already been written.
+*/
+static void processPendingTrigger(void)
+{
+	if (g_spareBusy)
+	{
+		return;
+	}
+
+	const int trigger = atomic_exchange(&g_pendingTrigger, FREC_TRIGGER_NONE);
+
+	if (FREC_TRIGGER_NONE == trigger)
+	{
+		return;
+	}
+
+	if (!handOverRing((FlightRecorderTrigger_t) trigger))
+	{
+		// Retry in next iteration unless another trigger took it's place
+		int expected = FREC_TRIGGER_NONE;
+		atomic_compare_exchange_strong(&g_pendingTrigger, &expected, trigger);
+	}
+}
+
+
+/**
+ * \brief Writes content of given ring into new dump file, emptying the ring in the process.
+ * \param ring Ring containing snapshots, from oldest to newest.
+ * \param trigger Event that triggered the dump.
+ * \param realTimeNs Time of the trigger on CLOCK_REALTIME, in nanoseconds.
+ * \param monotonicNs Time of the trigger on CLOCK_MONOTONIC, in nanoseconds.
+ * \return 0 if successful, negative value otherwise.
+*/
+static int writeDump(CircularBuffer_t* ring, FlightRecorderTrigger_t trigger, unsigned long long realTimeNs, unsigned long long monotonicNs)
+{
+	char fileName[PATH_MAX];
+	const int fileNameLength = snprintf(fileName, sizeof fileName, FREC_FILE_NAME_FORMAT,
+		g_dumpDirectory, realTimeNs / 1000000000ull, TRIGGER_NAMES[trigger]);
+
+	if ((fileNameLength < 0) || ((size_t) fileNameLength >= sizeof fileName))
+	{
+		Log(LLEVEL_ERROR, "dump file path too long");
+		CircularBuffer_clear(ring);
+		return -1;
+	}
+
+	FILE* fp = fopen(fileName, "wb");
+
+	if (NULL == fp)
+	{
+		Log(LLEVEL_ERROR, "cannot open dump file: %s", fileName);
+		CircularBuffer_clear(ring);
+		return -1;
+	}
+
+	const size_t cpuStatsLength = CpuCount_get() + 1;
+	FlightRecorderFileHeader_t header =
+	{
+		.magic 				= FREC_FILE_MAGIC,
+		.version 			= FREC_FILE_VERSION,
+		.trigger 			= trigger,
+		.cpuStatsLength 	= cpuStatsLength,
+		.snapshotCount 		= CircularBuffer_getItemCount(ring),
+		.periodNs 			= g_periodMs * 1000000ull,
+		.triggerRealTimeNs 	= realTimeNs,
+		.triggerMonotonicNs = monotonicNs
+	};
+
+	bool writeFailed = (1u != fwrite(&header, sizeof header, 1u, fp));
+
+	while (CircularBuffer_read(ring, g_dumpScratch))
+	{
+		const uint64_t timestampNs = g_dumpScratch->timestampNs;
+		writeFailed |= (1u != fwrite(&timestampNs, sizeof timestampNs, 1u, fp));
+		writeFailed |= (cpuStatsLength != fwrite(g_dumpScratch->cpuStats, sizeof(CpuStat_t), cpuStatsLength, fp));
+	}
+
+	writeFailed |= (0 != fclose(fp));
+
+	if (writeFailed)
+	{
+		Log(LLEVEL_ERROR, "an error has been encountered while writing dump file: %s", fileName);
+		return -2;
+	}
+
+	Log(LLEVEL_INFO, "flight recorder dump (%s) written: %s", TRIGGER_NAMES[trigger], fileName);
+	return 0;
+}
+
+
+int FlightRecorder_init(unsigned windowMs, unsigned periodMs, double usageThresholdPct, const char* dumpDirectory)
+{
+	if ((NULL == dumpDirectory) || (0u == periodMs) || (windowMs < periodMs))
+	{
+		return -1;
+	}
+
+	g_periodMs 			= periodMs;
+	g_windowMs 			= windowMs;
+	g_usageThresholdPct = usageThresholdPct;
+	snprintf(g_dumpDirectory, sizeof g_dumpDirectory, "%s", dumpDirectory);
+
+	// Both rings and scratch buffers are allocated upfront, so memory usage stays fixed while running
+	const uint32_t capacity = windowMs / periodMs;
+	g_ring 				= CircularBuffer_create(ProcStat_size(), capacity);
+	g_spare 			= CircularBuffer_create(ProcStat_size(), capacity);
+	g_sampleScratch 	= ProcStat_create();
+	g_dumpScratch 		= ProcStat_create();
+
+	if ((NULL == g_ring) || (NULL == g_spare) || (NULL == g_sampleScratch) || (NULL == g_dumpScratch))
+	{
+		FlightRecorder_finalize();
+		return -2;
+	}
+
+	if (thrd_success != mtx_init(&g_dumpMtx, mtx_timed))
+	{
+		FlightRecorder_finalize();
+		return -3;
+	}
+
+	if (thrd_success != cnd_init(&g_dumpReadyCv))
+	{
+		mtx_destroy(&g_dumpMtx);
+		FlightRecorder_finalize();
+		return -4;
+	}
+
+	g_initialized = true;
+	return 0;
+}
+
+
+void FlightRecorder_finalize(void)
+{
+	if (g_initialized)
+	{
+		g_initialized = false;
+		cnd_destroy(&g_dumpReadyCv);
+		mtx_destroy(&g_dumpMtx);
+	}
+
+	ProcStat_destroy(g_dumpScratch);
+	ProcStat_destroy(g_sampleScratch);
+	CircularBuffer_destroy(g_spare);
+	CircularBuffer_destroy(g_ring);
+	g_dumpScratch 	= NULL;
+	g_sampleScratch = NULL;
+	g_spare 		= NULL;
+	g_ring 			= NULL;
+}
+
+
+void FlightRecorder_trigger(FlightRecorderTrigger_t trigger)
+{
+	if (!g_initialized || g_spareBusy || (FREC_TRIGGER_NONE == trigger) || (trigger >= FREC_TRIGGER_COUNT_))
+	{
+		return;
+	}
+
+	// Keep the first trigger if several arrive before handover
+	int expected = FREC_TRIGGER_NONE;
+	atomic_compare_exchange_strong(&g_pendingTrigger, &expected, (int) trigger);
+}
+
+
+void FlightRecorder_checkUsage(const CpuUsageCompact_t* usageInfo)
+{
+	if (!g_initialized || (g_usageThresholdPct <= 0.0) || (NULL == usageInfo))
+	{
+		return;
+	}
+
+	// Skip total "cpu" line, only saturation of individual processors is of interest
+	const double thresholdBp = g_usageThresholdPct * 100.0;
+	bool saturated = false;
+
+	for (size_t ii = 1; (ii < usageInfo->valuesLength) && !saturated; ++ii)
+	{
+		// Invalid and offline markers lie above full usage
+		saturated = (CPUUSAGE_BP_FULL >= usageInfo->values[ii]) && (usageInfo->values[ii] >= thresholdBp);
+	}
+
+	if (!saturated)
+	{
+		return;
+	}
+
+	// Rate-limit to one dump per window, otherwise sustained saturation would dump continuously
+	const unsigned long long nowNs = MonotonicTimeNs();
+	const unsigned long long lastNs = g_lastThresholdTriggerNs;
+
+	if ((0u != lastNs) && (nowNs - lastNs < g_windowMs * 1000000ull))
+	{
+		return;
+	}
+
+	g_lastThresholdTriggerNs = nowNs;
+	FlightRecorder_trigger(FREC_TRIGGER_THRESHOLD);
+}
+
+
+int FlightRecorderThread(void* rawParams)
+{
+	(void) rawParams;
+
+	int retval = 0;
+
+	if (thrd_success != ThreadInfo_set(&g_recorderThreadInfo))
+	{
+		retval = -1;
+		goto error_exit_1;
+	}
+
+	if (!g_initialized)
+	{
+		retval = -2;
+		goto error_exit_1;
+	}
+
+	SamplerClock_t sampler;
+
+	if (0 != SamplerClock_init(&sampler, g_periodMs, false))
+	{
+		Log(LLEVEL_ERROR, "invalid sampling period: %u ms", g_periodMs);
+		retval = -3;
+		goto error_exit_1;
+	}
+
+	while (false == Thread_getKillSwitchStatus())
+	{
+		Watchdog_reportActive();
+
+		int waitResult = SamplerClock_wait(&sampler, FREC_SLEEP_SLICE_MS);
+
+		if (0 == waitResult)
+		{
+			continue;
+		}
+		else if (0 > waitResult)
+		{
+			Log(LLEVEL_ERROR, "error while waiting for sampling deadline");
+		}
+
+		if (ProcStat_read(g_sampleScratch))
+		{
+			// Ring keeps most recent window, overwriting oldest snapshots
+			CircularBuffer_write(g_ring, g_sampleScratch);
+		}
+		else
+		{
+			Log(LLEVEL_ERROR, "cannot load data from /proc/stat file");
+		}
+
+		processPendingTrigger();
+	}
+
+	// Trigger could have been raised on the way down, eg. by watchdog
+	processPendingTrigger();
+
+	Log(LLEVEL_INFO, "sampler: %llu ticks, %llu missed deadlines",
+		SamplerClock_getStats(&sampler)->ticks,
+		SamplerClock_getStats(&sampler)->missedDeadlines);
+
+	Log(LLEVEL_INFO, "thread exiting");
+
+error_exit_1:
+	g_samplerFinished = true;
+
+	if (g_initialized)
+	{
+		CondVar_notify(&g_dumpReadyCv);
+	}
+
+	thrd_exit(retval);
+}
+
+
+int FlightRecorderDumpThread(void* rawParams)
+{
+	(void) rawParams;
+
+	int retval = 0;
+
+	if (thrd_success != ThreadInfo_set(&g_dumperThreadInfo))
+	{
+		retval = -1;
+		thrd_exit(retval);
+	}
+
+	if (!g_initialized)
+	{
+		retval = -2;
+		thrd_exit(retval);
+	}
+
+	// Keep running after kill switch activation until sampling thread exits, to write any last-moment dump
+	while (true)
+	{
+		Watchdog_reportActive();
+
+		// Checked before looking for a dump, as sampling thread hands over it's last ring before finishing
+		const bool finalPass = Thread_getKillSwitchStatus() && g_samplerFinished;
+
+		if (thrd_success != Mutex_tryLockMs(&g_dumpMtx, FREC_MUTEX_WAIT_TIME_MS))
+		{
+			Log(LLEVEL_WARNING, "couldn't acquire dump mutex");
+			continue;
+		}
+
+		if (!g_dumpReady)
+		{
+			int result = CondVar_waitMs(&g_dumpReadyCv, &g_dumpMtx, FREC_CONDVAR_WAIT_TIME_MS);
+
+			if (thrd_error == result)
+			{
+				Log(LLEVEL_ERROR, "error while waiting on dump condition variable");
+			}
+		}
+
+		const bool dumpReady 						= g_dumpReady;
+		CircularBuffer_t* const ring 				= g_spare;
+		const FlightRecorderTrigger_t trigger 		= g_dumpTrigger;
+		const unsigned long long realTimeNs 		= g_dumpRealTimeNs;
+		const unsigned long long monotonicNs 		= g_dumpMonotonicNs;
+
+		if (thrd_success != Mutex_unlock(&g_dumpMtx))
+		{
+			Log(LLEVEL_ERROR, "couldn't release dump mutex");
+		}
+
+		if (!dumpReady)
+		{
+			if (finalPass)
+			{
+				break;
+			}
+
+			continue;
+		}
+
+		// Ring is owned by this thread until g_spareBusy is cleared, no need to hold the mutex while writing
+		writeDump(ring, trigger, realTimeNs, monotonicNs);
+
+		if (thrd_success == Mutex_tryLockMs(&g_dumpMtx, FREC_MUTEX_WAIT_TIME_MS))
+		{
+			g_dumpReady = false;
+			Mutex_unlock(&g_dumpMtx);
+			g_spareBusy = false;
+		}
+		else
+		{
+			Log(LLEVEL_ERROR, "couldn't acquire dump mutex, further dumps are disabled");
+		}
+	}
+
+	Log(LLEVEL_INFO, "thread exiting");
+
+	thrd_exit(retval);
+}
@@ -0,0 +1,127 @@
+/**
+ * \file flightrec.h
+ * Flight recorder threads and interface. Flight recorder keeps most recent raw /proc/stat snapshots,
+ * sampled at high rate, in a preallocated ring and dumps them into binary file once triggered.
+*/
+#ifndef FLIGHTREC_H_INCLUDED
+#define FLIGHTREC_H_INCLUDED
+#include <stdbool.h>
+#include <stdint.h>
+#include "cpuusage.h"
+
+
+/**
+ * Magic value opening every flight recorder dump file.
+*/
+#define FREC_FILE_MAGIC "CUTFREC"
+
+/**
+ * Version of flight recorder dump file format.
+*/
+#define FREC_FILE_VERSION 1u
+
+
+/**
+ * Events that can trigger flight recorder dump.
+*/
+typedef enum FlightRecorderTrigger
+{
+	/** No trigger pending. */
+	FREC_TRIGGER_NONE = 0,
+
+	/** Usage of a processor reached configured threshold. */
+	FREC_TRIGGER_THRESHOLD,
+
+	/** SIGUSR2 signal has been received. */
+	FREC_TRIGGER_SIGNAL,
+
+	/** Watchdog detected unresponsive thread. */
+	FREC_TRIGGER_WATCHDOG,
+
+	/** Amount of values in this enum, not a valid value by itself. */
+	FREC_TRIGGER_COUNT_
+}
+FlightRecorderTrigger_t;
+
+
+/**
+ * Header of flight recorder dump file. Header is followed by snapshotCount snapshots, from oldest to newest,
+ * each consisting of sampling timestamp (uint64_t, CLOCK_MONOTONIC nanoseconds) followed by
+ * cpuStatsLength CpuStat_t structures. All values are stored in host byte order.
+*/
+typedef struct FlightRecorderFileHeader
+{
+	/** Equal to FREC_FILE_MAGIC, including null terminator. */
+	char 		magic[8];
+	/** Equal to FREC_FILE_VERSION. */
+	uint32_t 	version;
+	/** Event that has triggered the dump, one of FlightRecorderTrigger_t values. */
+	uint32_t 	trigger;
+	/** Amount of "cpu(N)" lines in every snapshot, including total "cpu" line. */
+	uint64_t 	cpuStatsLength;
+	/** Amount of snapshots stored in file. */
+	uint64_t 	snapshotCount;
+	/** Sampling period, in nanoseconds. */
+	uint64_t 	periodNs;
+	/** Time of the trigger, on CLOCK_REALTIME, in nanoseconds since Epoch. */
+	uint64_t 	triggerRealTimeNs;
+	/** Time of the trigger, on CLOCK_MONOTONIC, in nanoseconds. Relates snapshot timestamps to real time. */
+	uint64_t 	triggerMonotonicNs;
+}
+FlightRecorderFileHeader_t;
+
+
+/**
+ * \brief Initializes flight recorder module, allocating all memory it is going to use.
+ * Until this function succeeds, every other function of this module is a no-op.
+ * \warning Since ring item size depends on ProcStat_size(), CpuCount_init() should be called before using it.
+ * \param windowMs Length of history kept in memory, in milliseconds.
+ * \param periodMs Sampling period, in milliseconds.
+ * \param usageThresholdPct Usage of a single processor, in percentage, at which dump is triggered.
+ * Zero or negative value disables threshold trigger.
+ * \param dumpDirectory Directory to write dump files into.
+ * \return 0 if successful, negative error code otherwise.
+*/
+int FlightRecorder_init(unsigned windowMs, unsigned periodMs, double usageThresholdPct, const char* dumpDirectory);
+
+
+/**
+ * \brief Finalizes flight recorder module, cleaning up any resources used by it.
+ * Should only be called once both flight recorder threads have exited.
+*/
+void FlightRecorder_finalize(void);
+
+
+/**
+ * \brief Requests flight recorder dump. Only sets a flag, thus being safe to call from signal handlers.
+ * Request is ignored while previous dump is still being written.
+ * \param trigger Event that triggered the dump.
+*/
+void FlightRecorder_trigger(FlightRecorderTrigger_t trigger);
+
+
+/**
+ * \brief Requests flight recorder dump if usage of any processor has reached the configured threshold.
+ * Threshold triggers are rate-limited to one per recorded window.
+ * \param usageInfo Usage statistics calculated by analyzer.
+*/
+void FlightRecorder_checkUsage(const CpuUsageCompact_t* usageInfo);
+
+
+/**
+ * \brief Thread function sampling /proc/stat at flight recorder period into in-memory ring.
+ * \details Once dump has been requested, ring is handed over to dump thread and sampling continues
+ * into the spare ring, so that writing the file never delays sampling.
+ * \param params Ignored.
+*/
+int FlightRecorderThread(void* params);
+
+
+/**
+ * \brief Thread function writing rings handed over by FlightRecorderThread() into dump files.
+ * \param params Ignored.
+*/
+int FlightRecorderDumpThread(void* params);
+
+
+#endif // !FLIGHTREC_H_INCLUDED
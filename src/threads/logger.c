@@ -211,9 +211,9 @@ int LoggerThread(void* rawParams)
 	{
 		Watchdog_reportActive();
 
-		if (thrd_success != Mutex_tryLockMs(&g_inMtx, LOGGER_MUTEX_WAIT_TIME_MS))
+		if (thrd_success == Mutex_tryLockMs(&g_inMtx, LOGGER_MUTEX_WAIT_TIME_MS))
 		{
-
+			// Input mutex is not recursive, so nothing can be logged until it is released
 			struct timespec timePoint = TimePointMs(LOGGER_CONDVAR_WAIT_TIME_MS);
 			while (CircularBuffer_isEmpty(g_inBuf) && (false == Thread_getKillSwitchStatus()))
 			{
@@ -221,20 +221,10 @@ int LoggerThread(void* rawParams)
 
 				int result = CondVar_waitUntil(&g_inNotEmptyCv, &g_inMtx, &timePoint);
 
-				if (thrd_success == result)
-				{
-					Log(LLEVEL_DEBUG, "received notification on input condition variable");
-					break;
-				}
-				else if (thrd_timedout == result)
+				if ((thrd_success == result) || (thrd_timedout == result))
 				{
-					Log(LLEVEL_WARNING, "timeout while waiting on input condition variable");
 					break;
 				}
-				else
-				{
-					Log(LLEVEL_ERROR, "error while waiting on input condition variable");
-				}
 			}
 
 			if (Thread_getKillSwitchStatus())
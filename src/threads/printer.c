@@ -3,9 +3,10 @@
 #include "cpuusage.h"
 #include "logger.h"
 #include "watchdog.h"
-#include "circbuf.h"
+#include "mailbox.h"
 #include "helpers.h"
 #include "threadctl.h"
+#include "latency.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -13,9 +14,9 @@
 
 #define PRINTER_CONDVAR_WAIT_TIME_MS 	2000
 #define PRINTER_MUTEX_WAIT_TIME_MS 		50
-#define PERCENTAGE_VALUE_FORMAT 		"%.2f"
 #define PRINTER_THREAD_ID 				TID_PRINTER
 #define PRINTER_THREAD_NAME 			"Printer"
+#define CLEAR_SCREEN_SEQUENCE 			"\033[H\033[2J"
 
 
 static ThreadInfo_t g_printerThreadInfo =
@@ -25,24 +26,6 @@ static ThreadInfo_t g_printerThreadInfo =
 };
 
 
-static void printFormattedCpuUsage(const CpuUsageInfo_t* cuinfo)
-{
-	if ((NULL == cuinfo) || (cuinfo->valuesLength < 1))
-	{
-		return;
-	}
-
-	printf("CPU:\t" PERCENTAGE_VALUE_FORMAT " %%\n", cuinfo->values[0]);
-
-	for (unsigned ii = 1; ii < (unsigned long long) cuinfo->valuesLength; ++ii)
-	{
-		printf("CPU%d:\t" PERCENTAGE_VALUE_FORMAT " %%\n",
-			ii - 1,
-			cuinfo->values[ii]);
-	}
-}
-
-
 int PrinterThread(void* rawParams)
 {
 	int retval = 0;
@@ -60,8 +43,9 @@ int PrinterThread(void* rawParams)
 	}
 
 	PrinterThreadParams_t* params = (PrinterThreadParams_t*) rawParams;
+	FILE* out = (NULL != params->out) ? params->out : stdout;
 
-	CpuUsageInfo_t* usageInfoBuffer = malloc(CpuUsageInfo_size());
+	CpuUsageCompact_t* usageInfoBuffer = malloc(CpuUsageCompact_sizeWithRollups(params->topology));
 
 	if (NULL == usageInfoBuffer)
 	{
@@ -69,18 +53,84 @@ int PrinterThread(void* rawParams)
 		goto error_exit_1;
 	}
 
+	// Scan reports come far less often than frames, the last one is kept and printed with every frame
+	ProcUsageReport_t* procReport = NULL;
+
+	if (NULL != params->procMailbox)
+	{
+		procReport = calloc(1u, ProcUsageReport_size(params->procTopCount));
+
+		if (NULL == procReport)
+		{
+			retval = -4;
+			goto error_exit_2;
+		}
+	}
+
+	CgroupUsageReport_t* cgroupReport = NULL;
+
+	if (NULL != params->cgroupMailbox)
+	{
+		cgroupReport = calloc(1u, CgroupUsageReport_size(params->cgroupTopCount));
+
+		if (NULL == cgroupReport)
+		{
+			retval = -5;
+			goto error_exit_3;
+		}
+	}
+
+	IrqUsageReport_t* irqReport = NULL;
+
+	if (NULL != params->irqMailbox)
+	{
+		irqReport = calloc(1u, IrqUsageReport_size(params->irqHotCount));
+
+		if (NULL == irqReport)
+		{
+			retval = -6;
+			goto error_exit_4;
+		}
+	}
+
+	IdleUsageReport_t* idleReport = NULL;
+
+	if (NULL != params->idleMailbox)
+	{
+		idleReport = calloc(1u, IdleUsageReport_size(params->idleCpuCount));
+
+		if (NULL == idleReport)
+		{
+			retval = -7;
+			goto error_exit_5;
+		}
+	}
+
+	StealUsageReport_t* stealReport = NULL;
+
+	if (NULL != params->stealMailbox)
+	{
+		stealReport = calloc(1u, StealUsageReport_size(params->stealCpuCount));
+
+		if (NULL == stealReport)
+		{
+			retval = -8;
+			goto error_exit_6;
+		}
+	}
+
 	while (false == Thread_getKillSwitchStatus())
 	{
 		Watchdog_reportActive();
 
 		if (thrd_success != Mutex_tryLockMs(params->inMtx, PRINTER_MUTEX_WAIT_TIME_MS))
 		{
-			Log(LLEVEL_WARNING, "couldn't acquire input buffer mutex");
+			Log(LLEVEL_WARNING, "couldn't acquire input mailbox mutex");
 			continue;
 		}
 
 		struct timespec timePoint = TimePointMs(PRINTER_CONDVAR_WAIT_TIME_MS);
-		while (CircularBuffer_isEmpty(params->inBuf) && (false == Thread_getKillSwitchStatus()))
+		while (!Mailbox_hasNew(params->inMailbox) && (false == Thread_getKillSwitchStatus()))
 		{
 			int result = CondVar_waitUntil(params->inNotEmptyCv, params->inMtx, &timePoint);
 
@@ -104,32 +154,106 @@ int PrinterThread(void* rawParams)
 		{
 			if (thrd_success != Mutex_unlock(params->inMtx))
 			{
-				Log(LLEVEL_ERROR, "couldn't release input buffer mutex");
+				Log(LLEVEL_ERROR, "couldn't release input mailbox mutex");
 			}
 			break;
 		}
 
-		if (!CircularBuffer_read(params->inBuf, usageInfoBuffer))
+		if (thrd_success != Mutex_unlock(params->inMtx))
 		{
-			Log(LLEVEL_ERROR, "attempted read from empty buffer");
+			Log(LLEVEL_ERROR, "couldn't release input mailbox mutex");
+			continue;
 		}
 
-		if (thrd_success != Mutex_unlock(params->inMtx))
+		// Analyzer never waits for printer, so statistics are copied out without holding the mutex
+		if (!Mailbox_read(params->inMailbox, usageInfoBuffer))
 		{
-			Log(LLEVEL_ERROR, "couldn't release input buffer mutex");
+			Log(LLEVEL_WARNING, "no new statistics in input mailbox");
 			continue;
 		}
 
-		system("clear");
-		printFormattedCpuUsage(usageInfoBuffer);
-		Log(LLEVEL_TRACE, "usage statistics printed to standard output");
+		Latency_mark(&usageInfoBuffer->stamps, LSTAGE_PRINTER_IN);
+
+		// Escape sequence instead of spawning clear(1) for every frame
+		if (params->clearScreen)
+		{
+			fputs(CLEAR_SCREEN_SEQUENCE, out);
+		}
+
+		if (params->printCpus)
+		{
+			CpuUsageCompact_print(out, usageInfoBuffer);
+		}
+		else
+		{
+			CpuUsageCompact_printTotal(out, usageInfoBuffer);
+		}
+
+		CpuUsageCompact_printRollups(out, params->topology, usageInfoBuffer, params->rollupLevels);
+		CpuUsageCompact_printSched(out, usageInfoBuffer);
+
+		if (NULL != stealReport)
+		{
+			Mailbox_read(params->stealMailbox, stealReport);
+			StealUsageReport_print(out, stealReport, params->printCpus);
+		}
+
+		if (NULL != procReport)
+		{
+			Mailbox_read(params->procMailbox, procReport);
+			ProcUsageReport_print(out, procReport);
+		}
+
+		if (NULL != cgroupReport)
+		{
+			Mailbox_read(params->cgroupMailbox, cgroupReport);
+			CgroupUsageReport_print(out, cgroupReport);
+		}
+
+		if (NULL != irqReport)
+		{
+			Mailbox_read(params->irqMailbox, irqReport);
+			IrqUsageReport_print(out, irqReport);
+		}
+
+		if (NULL != idleReport)
+		{
+			Mailbox_read(params->idleMailbox, idleReport);
+			IdleUsageReport_print(out, idleReport, params->printCpus);
+		}
+
+		Latency_printSummary(out);
+		fprintf(out, "Dropped frames:\t%llu of %llu\n",
+			(unsigned long long) Mailbox_getDropCount(params->inMailbox),
+			(unsigned long long) Mailbox_getPublishCount(params->inMailbox));
+		fflush(out);
+
+		// Latency of this frame becomes part of statistics printed with the next one
+		Latency_mark(&usageInfoBuffer->stamps, LSTAGE_PRINTED);
+		Latency_record(&usageInfoBuffer->stamps);
+		Log(LLEVEL_TRACE, "usage statistics printed");
 	}
 
 	Log(LLEVEL_INFO, "thread exiting");
 
+	free(stealReport);
+	free(idleReport);
+	free(irqReport);
+	free(cgroupReport);
+	free(procReport);
 	free(usageInfoBuffer);
 	thrd_exit(retval);
 
+error_exit_6:
+	free(idleReport);
+error_exit_5:
+	free(irqReport);
+error_exit_4:
+	free(cgroupReport);
+error_exit_3:
+	free(procReport);
+error_exit_2:
+	free(usageInfoBuffer);
 error_exit_1:
 	thrd_exit(retval);
 }
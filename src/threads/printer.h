@@ -4,9 +4,16 @@
 */
 #ifndef PRINTER_H_INCLUDED
 #define PRINTER_H_INCLUDED
+#include <stdio.h>
+#include <stdbool.h>
 #include "sync_types.h"
-#include "circbuf.h"
+#include "mailbox.h"
 #include "cpuusage.h"
+#include "proctrack.h"
+#include "cgtrack.h"
+#include "irqtrack.h"
+#include "idletrack.h"
+#include "stealtrack.h"
 
 
 /**
@@ -15,38 +22,119 @@
 typedef struct PrinterThreadParams
 {
 	/**
-	 * Mutex to lock on while reading usage statistics from input buffer.
+	 * Mutex to lock on while waiting for new usage statistics.
 	 * This parameter should be shared with analyzer thread.
 	*/
 	MutexHandle_t inMtx;
 	
 	/**
-	 * Condition variable to wait on while no data is available in the input buffer.
+	 * Condition variable to wait on while no new data has been published to input mailbox.
 	 * This parameter should be shared with analyzer thread.
 	*/
 	CondVarHandle_t inNotEmptyCv;
 
 	/**
-	 * Condition variable to signal once data has been consumed from input buffer.
+	 * Input mailbox to take CPU usage statistics from. Only the newest statistics are printed,
+	 * those replaced before printer could take them are counted as dropped frames.
+	 * Mailbox item size must be equal to that retrieved by CpuUsageCompact_sizeWithRollups() function for given topology.
 	 * This parameter should be shared with analyzer thread.
 	*/
-	CondVarHandle_t inNotFullCv;
+	Mailbox_t* inMailbox;
 
 	/**
-	 * Input buffer to read CPU usage statistics from.
-	 * Underlying CircularBuffer_t structure must be able to hold at least one CpuUsageInfo_t structure,
-	 * size equal to that retrieved by CpuUsageInfo_size() function.
+	 * Topology of processors usage of groups has been calculated for. NULL if analyzer publishes no group usage.
 	 * This parameter should be shared with analyzer thread.
 	*/
-	CircularBuffer_t* inBuf;
+	const CpuTopology_t* topology;
+
+	/**
+	 * Whether usage of every logical processor should be printed, rather than total usage only.
+	*/
+	bool printCpus;
+
+	/**
+	 * Topology levels usage of which should be printed, as combination of TOPOLOGY_LEVEL_BIT() values.
+	 * Ignored if topology is NULL.
+	*/
+	unsigned rollupLevels;
+
+	/**
+	 * Mailbox to take reports of top consuming processes from, NULL if processes are not tracked.
+	 * Newest report is printed along with every set of statistics, without waiting for it.
+	 * This parameter should be shared with process scanner thread.
+	*/
+	Mailbox_t* procMailbox;
+
+	/**
+	 * Amount of top consumers reports in procMailbox are sized for. Ignored if procMailbox is NULL.
+	*/
+	size_t procTopCount;
+
+	/**
+	 * Mailbox to take reports of cgroups using the most of their quota from, NULL if cgroups are not tracked.
+	 * Newest report is printed along with every set of statistics, without waiting for it.
+	 * This parameter should be shared with process scanner thread.
+	*/
+	Mailbox_t* cgroupMailbox;
+
+	/**
+	 * Amount of top cgroups reports in cgroupMailbox are sized for. Ignored if cgroupMailbox is NULL.
+	*/
+	size_t cgroupTopCount;
+
+	/**
+	 * Mailbox to take reports of processors handling the most interrupts from, NULL if interrupts are not tracked.
+	 * Newest report is printed along with every set of statistics, without waiting for it.
+	 * This parameter should be shared with process scanner thread.
+	*/
+	Mailbox_t* irqMailbox;
+
+	/**
+	 * Amount of hot processors reports in irqMailbox are sized for. Ignored if irqMailbox is NULL.
+	*/
+	size_t irqHotCount;
+
+	/**
+	 * Mailbox to take reports of idle state residency and thermal throttling from, NULL if idle states are not tracked.
+	 * Newest report is printed along with every set of statistics, without waiting for it.
+	 * This parameter should be shared with process scanner thread.
+	*/
+	Mailbox_t* idleMailbox;
+
+	/**
+	 * Amount of processors reports in idleMailbox are sized for. Ignored if idleMailbox is NULL.
+	*/
+	size_t idleCpuCount;
+
+	/**
+	 * Mailbox to take steal reports from, NULL if steal is not tracked. Report is published by analyzer thread
+	 * before statistics it belongs to, and newest one is printed along with them.
+	 * This parameter should be shared with analyzer thread.
+	*/
+	Mailbox_t* stealMailbox;
+
+	/**
+	 * Amount of processors reports in stealMailbox are sized for. Ignored if stealMailbox is NULL.
+	*/
+	size_t stealCpuCount;
+
+	/**
+	 * Stream to print usage statistics into, NULL for standard output.
+	*/
+	FILE* out;
+
+	/**
+	 * Whether terminal screen should be cleared before printing every set of statistics.
+	*/
+	bool clearScreen;
 }
 PrinterThreadParams_t;
 
 
 /**
  * \brief Thread function for retrieving information about CPU usage and printing it to standard output.
- * \details Thread will periodically read data from provided buffer and print it to
- * standard output using predefined format showing usage of every logical processor in percentages.
+ * \details Thread will wait for statistics published to provided mailbox and print the newest ones to
+ * configured stream using predefined format showing usage of every logical processor in percentages.
  * \param params Pointer to valid PrinterThreadParams_t structure.
 */
 int PrinterThread(void* params);
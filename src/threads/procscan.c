@@ -0,0 +1,204 @@
+#include "procscan.h"
+#include "sampler.h"
+#include "logger.h"
+#include "watchdog.h"
+#include "threadctl.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <threads.h>
+
+
+#define PROCSCAN_SLEEP_SLICE_MS 		250
+#define PROCSCAN_THREAD_ID 				TID_PROCSCAN
+#define PROCSCAN_THREAD_NAME 			"ProcScanner"
+
+
+static ThreadInfo_t g_procScannerThreadInfo =
+{
+	.tid 	= PROCSCAN_THREAD_ID,
+	.name 	= PROCSCAN_THREAD_NAME
+};
+
+
+/**
+ * \brief Switches tracker to process currently listed in target specification, if it differs from tracked one.
+ * \param targetLost Set once tracked process has been reported as exited, so that it is only reported once.
+*/
+static void followTarget(ProcTracker_t* tracker, const char* targetSpec, bool* targetLost)
+{
+	const int oldPid = ProcTracker_getTargetPid(tracker);
+	const int newPid = ProcTracker_resolvePid(targetSpec);
+
+	if ((0 < newPid) && (newPid != oldPid) && (0 == ProcTracker_setTargetPid(tracker, newPid)))
+	{
+		Log(LLEVEL_INFO, "tracking threads of PID%d instead of PID%d", newPid, oldPid);
+		*targetLost = false;
+	}
+	else if (!*targetLost)
+	{
+		Log(LLEVEL_WARNING, "tracked process PID%d has exited", oldPid);
+		*targetLost = true;
+	}
+}
+
+
+/**
+ * \brief Advances process tracker by one slice, publishing report once scan is complete.
+ * \param targetLost Set once tracked process has been reported as exited, so that it is only reported once.
+*/
+static void stepProcesses(ProcScannerThreadParams_t* params, bool* targetLost)
+{
+	// Report is written in place, mailbox slot is only published once scan is complete
+	ProcUsageReport_t* report = Mailbox_getWriteSlot(params->outMailbox);
+	const int stepResult = ProcTracker_step(params->tracker, report);
+
+	if ((PROCTRACK_TARGET_EXITED == stepResult) && (NULL != params->targetSpec))
+	{
+		followTarget(params->tracker, params->targetSpec, targetLost);
+	}
+	else if (0 > stepResult)
+	{
+		Log(LLEVEL_ERROR, "cannot scan process directories");
+	}
+	else if (0 < stepResult)
+	{
+		*targetLost = false;
+		Mailbox_publish(params->outMailbox);
+		Log(LLEVEL_TRACE, "process scan of %zu processes took %llu us",
+			report->processCount, report->scanCostNs / 1000u);
+	}
+}
+
+
+/**
+ * \brief Advances cgroup tracker by one slice, publishing report once scan is complete.
+*/
+static void stepCgroups(ProcScannerThreadParams_t* params)
+{
+	CgroupUsageReport_t* report = Mailbox_getWriteSlot(params->cgroupMailbox);
+	const int stepResult = CgroupTracker_step(params->cgroupTracker, report);
+
+	if (0 > stepResult)
+	{
+		Log(LLEVEL_ERROR, "cannot walk cgroups");
+	}
+	else if (0 < stepResult)
+	{
+		Mailbox_publish(params->cgroupMailbox);
+		Log(LLEVEL_TRACE, "cgroup scan of %zu cgroups took %llu us",
+			report->cgroupCount, report->scanCostNs / 1000u);
+	}
+}
+
+
+/**
+ * \brief Advances interrupt tracker by one step, publishing report once an interval has been sampled.
+*/
+static void stepIrqs(ProcScannerThreadParams_t* params)
+{
+	IrqUsageReport_t* report = Mailbox_getWriteSlot(params->irqMailbox);
+	const int stepResult = IrqTracker_step(params->irqTracker, report);
+
+	if (0 > stepResult)
+	{
+		Log(LLEVEL_ERROR, "cannot read interrupt counters");
+	}
+	else if (0 < stepResult)
+	{
+		Mailbox_publish(params->irqMailbox);
+		Log(LLEVEL_TRACE, "interrupts of %zu sources read in %llu us",
+			report->sourceCount, report->scanCostNs / 1000u);
+	}
+}
+
+
+/**
+ * \brief Advances idle state tracker by one step, publishing report once a scan has been completed.
+*/
+static void stepIdle(ProcScannerThreadParams_t* params)
+{
+	IdleUsageReport_t* report = Mailbox_getWriteSlot(params->idleMailbox);
+	const int stepResult = IdleTracker_step(params->idleTracker, report);
+
+	if (0 > stepResult)
+	{
+		Log(LLEVEL_ERROR, "cannot read idle state counters");
+	}
+	else if (0 < stepResult)
+	{
+		Mailbox_publish(params->idleMailbox);
+		Log(LLEVEL_TRACE, "idle states of %zu processors read in %llu us",
+			report->cpuCount, report->scanCostNs / 1000u);
+	}
+}
+
+
+int ProcScannerThread(void* rawParams)
+{
+	int retval = 0;
+
+	if (NULL == rawParams)
+	{
+		retval = -1;
+		goto error_exit_1;
+	}
+
+	if (thrd_success != ThreadInfo_set(&g_procScannerThreadInfo))
+	{
+		retval = -2;
+		goto error_exit_1;
+	}
+
+	ProcScannerThreadParams_t* params = (ProcScannerThreadParams_t*) rawParams;
+	SamplerClock_t sampler;
+
+	if (0 != SamplerClock_init(&sampler, params->samplePeriodMs, false))
+	{
+		Log(LLEVEL_ERROR, "invalid sampling period: %u ms", params->samplePeriodMs);
+		retval = -3;
+		goto error_exit_1;
+	}
+
+	bool targetLost = false;
+
+	while (false == Thread_getKillSwitchStatus())
+	{
+		Watchdog_reportActive();
+
+		int waitResult = SamplerClock_wait(&sampler, PROCSCAN_SLEEP_SLICE_MS);
+
+		if (0 == waitResult)
+		{
+			continue;
+		}
+		else if (0 > waitResult)
+		{
+			Log(LLEVEL_ERROR, "error while waiting for sampling deadline");
+		}
+
+		if (NULL != params->tracker)
+		{
+			stepProcesses(params, &targetLost);
+		}
+
+		if (NULL != params->cgroupTracker)
+		{
+			stepCgroups(params);
+		}
+
+		if (NULL != params->irqTracker)
+		{
+			stepIrqs(params);
+		}
+
+		if (NULL != params->idleTracker)
+		{
+			stepIdle(params);
+		}
+	}
+
+	Log(LLEVEL_INFO, "thread exiting");
+
+error_exit_1:
+	thrd_exit(retval);
+}
@@ -0,0 +1,94 @@
+/**
+ * \file procscan.h
+ * Process scanner thread interface.
+*/
+#ifndef PROCSCAN_H_INCLUDED
+#define PROCSCAN_H_INCLUDED
+#include "mailbox.h"
+#include "proctrack.h"
+#include "cgtrack.h"
+#include "irqtrack.h"
+#include "idletrack.h"
+
+
+/**
+ * Paramters required by ProcScannerThread() function.
+*/
+typedef struct ProcScannerThreadParams
+{
+	/**
+	 * Tracker to advance by one step every sampling period, NULL if processes are not tracked.
+	*/
+	ProcTracker_t* tracker;
+
+	/**
+	 * Sampling period, in milliseconds. Every process is read once per as many periods as tracker has slices.
+	*/
+	unsigned samplePeriodMs;
+
+	/**
+	 * Output mailbox to publish report of every completed scan into.
+	 * Mailbox item size must be equal to that retrieved by ProcUsageReport_size() function for tracker's top count.
+	 * This parameter should be shared with printer thread.
+	*/
+	Mailbox_t* outMailbox;
+
+	/**
+	 * Process identifier or PID file path threads of which are tracked, NULL if processes are tracked.
+	 * Once tracked process exits, it is resolved again, so that a restarted process listed in PID file is followed.
+	*/
+	const char* targetSpec;
+
+	/**
+	 * Cgroup tracker to advance by one step every sampling period along with process tracker,
+	 * NULL if cgroups are not tracked.
+	*/
+	CgroupTracker_t* cgroupTracker;
+
+	/**
+	 * Output mailbox to publish report of every completed cgroup scan into. Ignored if cgroupTracker is NULL.
+	 * Mailbox item size must be equal to that retrieved by CgroupUsageReport_size() function for tracker's top count.
+	 * This parameter should be shared with printer thread.
+	*/
+	Mailbox_t* cgroupMailbox;
+
+	/**
+	 * Interrupt tracker to advance by one step every sampling period along with other trackers,
+	 * NULL if interrupts are not tracked.
+	*/
+	IrqTracker_t* irqTracker;
+
+	/**
+	 * Output mailbox to publish report of every sampled interval of interrupts into. Ignored if irqTracker is NULL.
+	 * Mailbox item size must be equal to that retrieved by IrqUsageReport_size() function for tracker's hot count.
+	 * This parameter should be shared with printer thread.
+	*/
+	Mailbox_t* irqMailbox;
+
+	/**
+	 * Idle state tracker to advance by one step every sampling period along with other trackers,
+	 * NULL if idle states are not tracked.
+	*/
+	IdleTracker_t* idleTracker;
+
+	/**
+	 * Output mailbox to publish report of every completed idle state scan into. Ignored if idleTracker is NULL.
+	 * Mailbox item size must be equal to that retrieved by IdleUsageReport_size() function for tracked processor count.
+	 * This parameter should be shared with printer thread.
+	*/
+	Mailbox_t* idleMailbox;
+}
+ProcScannerThreadParams_t;
+
+
+/**
+ * \brief Thread function tracking per-process and per-cgroup CPU usage, distribution of interrupts,
+ * and idle state residency.
+ * \details Thread advances trackers by one slice every sampling period, so that cost of reading every process
+ * and cgroup is spread evenly over time, and publishes top consumers into output mailboxes once every full scan.
+ * \param params Pointer to valid ProcScannerThreadParams_t structure.
+*/
+int ProcScannerThread(void* params);
+
+
+#endif // !PROCSCAN_H_INCLUDED
@@ -5,13 +5,22 @@
 #include "watchdog.h"
 #include "helpers.h"
 #include "threadctl.h"
+#include "latency.h"
+#include "sampler.h"
+#include "cpuusage.h"
+#include "snapsource.h"
+#include "cpumap.h"
 #include <threads.h>
 #include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 #define READER_MUTEX_WAIT_TIME_MS 		50
 #define READER_CONDVAR_WAIT_TIME_MS 	2000
-#define READER_SLEEP_TIME_MS			500
+#define READER_SLEEP_SLICE_MS			250
+#define READER_STATS_LOG_INTERVAL		100
+#define READER_DRAIN_POLL_MS			20
 #define READER_THREAD_ID				TID_READER
 #define READER_THREAD_NAME 				"Reader"
 
@@ -23,6 +32,159 @@ static ThreadInfo_t g_readerThreadInfo =
 };
 
 
+/**
+ * Data required to measure change of load between consecutive samples in adaptive sampling mode.
+ * Only total "cpu" line is followed, so that cost per sample does not grow with processor count.
+*/
+typedef struct AdaptiveState
+{
+	/** Total line of previous sample. */
+	ProcStat_t* 	prevTotal;
+	/** Total line of most recent sample. */
+	ProcStat_t* 	total;
+	/** Usage statistics calculated for previous interval. */
+	CpuUsageInfo_t* prevUsage;
+	/** Usage statistics calculated for most recent interval. */
+	CpuUsageInfo_t* usage;
+	/** Amount of samples stored so far, saturating at two. */
+	unsigned 		sampleCount;
+}
+AdaptiveState_t;
+
+
+/**
+ * \brief Allocates buffers used by adaptive sampling mode, each holding a single line.
+ * \param state State to initialize.
+ * \return True if successful, false otherwise.
+*/
+static bool adaptiveStateInit(AdaptiveState_t* state)
+{
+	state->prevTotal 	= calloc(1u, sizeof(ProcStat_t) + sizeof(CpuStat_t));
+	state->total 		= calloc(1u, sizeof(ProcStat_t) + sizeof(CpuStat_t));
+	state->prevUsage 	= calloc(1u, sizeof(CpuUsageInfo_t) + sizeof(PercentageValue_t));
+	state->usage 		= calloc(1u, sizeof(CpuUsageInfo_t) + sizeof(PercentageValue_t));
+	state->sampleCount 	= 0u;
+
+	return (NULL != state->prevTotal) && (NULL != state->total) && (NULL != state->prevUsage) && (NULL != state->usage);
+}
+
+
+/**
+ * \brief Releases buffers used by adaptive sampling mode.
+ * \param state State to finalize.
+*/
+static void adaptiveStateFinalize(AdaptiveState_t* state)
+{
+	free(state->usage);
+	free(state->prevUsage);
+	free(state->total);
+	free(state->prevTotal);
+}
+
+
+/**
+ * \brief Measures change of total load caused by new sample and adjusts sampling period accordingly.
+ * Change is only known once two consecutive intervals have been calculated, until then period is left unchanged.
+ * \param sampler Sampling clock to adjust.
+ * \param adaptiveParams Adaptive sampling mode parameters.
+ * \param state Adaptive sampling mode state.
+ * \param procStat Newest sample.
+*/
+static void adaptSamplingPeriod(
+	SamplerClock_t* sampler,
+	const SamplerAdaptiveParams_t* adaptiveParams,
+	AdaptiveState_t* state,
+	const ProcStat_t* procStat)
+{
+	state->total->cpuStatsLength 	= 1u;
+	state->total->timestampNs 		= procStat->timestampNs;
+	state->total->cpuStats[0] 		= procStat->cpuStats[0];
+
+	if (0u < state->sampleCount)
+	{
+		CpuUsageInfo_t* tmp = state->prevUsage;
+		state->prevUsage 	= state->usage;
+		state->usage 		= tmp;
+		CpuUsageInfo_calculate(state->prevTotal, state->total, state->usage);
+	}
+
+	if (1u < state->sampleCount)
+	{
+		const unsigned oldPeriodMs = SamplerClock_getPeriod(sampler);
+		SamplerClock_adapt(sampler, adaptiveParams, CpuUsageInfo_maxDifference(state->prevUsage, state->usage));
+
+		if (oldPeriodMs != SamplerClock_getPeriod(sampler))
+		{
+			Log(LLEVEL_DEBUG, "sampling period changed from %u ms to %u ms", oldPeriodMs, SamplerClock_getPeriod(sampler));
+		}
+	}
+	else
+	{
+		++state->sampleCount;
+	}
+
+	ProcStat_t* tmp 	= state->prevTotal;
+	state->prevTotal 	= state->total;
+	state->total 		= tmp;
+}
+
+
+/**
+ * \brief Waits until every snapshot written into output buffer has been consumed, or until kill switch is activated.
+ * \param params Reader thread parameters.
+*/
+static void waitForDrain(const ReaderThreadParams_t* params)
+{
+	while (false == Thread_getKillSwitchStatus())
+	{
+		Watchdog_reportActive();
+
+		if (thrd_success != Mutex_tryLockMs(params->outMtx, READER_MUTEX_WAIT_TIME_MS))
+		{
+			continue;
+		}
+
+		const bool empty = CircularBuffer_isEmpty(params->outBuf);
+
+		if (thrd_success != Mutex_unlock(params->outMtx))
+		{
+			Log(LLEVEL_ERROR, "couldn't release input buffer mutex");
+		}
+
+		if (empty)
+		{
+			break;
+		}
+
+		thrd_sleep(&(struct timespec) { .tv_nsec = READER_DRAIN_POLL_MS * 1000000L }, NULL);
+	}
+}
+
+
+/**
+ * \brief Refreshes online processor set, stamping it's epoch into just acquired snapshot.
+ * Lines of processors gone offline are already zeroed by the parser, the epoch lets following stages
+ * tell snapshots taken before and after the change apart.
+*/
+static void trackOnlineSet(CpuMap_t* cpuMap, ProcStat_t* procStat)
+{
+	const int result = CpuMap_refresh(cpuMap);
+
+	if (0 < result)
+	{
+		Log(LLEVEL_INFO, "online processor set changed, %zu online, epoch %u",
+			CpuMap_getOnline(cpuMap)->length,
+			CpuMap_getEpoch(cpuMap));
+	}
+	else if (0 > result)
+	{
+		Log(LLEVEL_WARNING, "cannot refresh online processor set");
+	}
+
+	procStat->onlineEpoch = CpuMap_getEpoch(cpuMap);
+}
+
+
 int ReaderThread(void* rawParams)
 {
 	int retval = 0;
@@ -41,19 +203,140 @@ int ReaderThread(void* rawParams)
 		thrd_exit(retval);
 	}
 
+	SamplerClock_t sampler;
+
+	if (0 != SamplerClock_init(&sampler, params->samplePeriodMs, params->alignToWallClock))
+	{
+		Log(LLEVEL_ERROR, "invalid sampling period: %u ms", params->samplePeriodMs);
+		retval = -3;
+		thrd_exit(retval);
+	}
+
+	const SamplerStats_t* samplerStats = SamplerClock_getStats(&sampler);
+	AdaptiveState_t adaptiveState = { NULL, NULL, NULL, NULL, 0u };
+
+	if ((NULL != params->adaptiveParams) && !adaptiveStateInit(&adaptiveState))
+	{
+		adaptiveStateFinalize(&adaptiveState);
+		retval = -4;
+		thrd_exit(retval);
+	}
+
+	ProcStat_t* procStat = malloc(ProcStat_size());
+	// Delta mode only: previous snapshot written into output buffer, and change since it
+	ProcStat_t* prevProcStat = params->deltaMode ? malloc(ProcStat_size()) : NULL;
+	ProcStatDelta_t* procStatDelta = params->deltaMode ? malloc(ProcStatDelta_size()) : NULL;
+	bool prevProcStatValid = false;
+
+	if ((NULL == procStat) || (params->deltaMode && ((NULL == prevProcStat) || (NULL == procStatDelta))))
+	{
+		free(procStatDelta);
+		free(prevProcStat);
+		free(procStat);
+		adaptiveStateFinalize(&adaptiveState);
+		retval = -5;
+		thrd_exit(retval);
+	}
+
+	const SnapshotPacing_t pacing = SnapshotSource_getPacing(params->source);
+	// Offset between CLOCK_MONOTONIC and timestamps of replayed snapshots, valid once first snapshot has been read
+	unsigned long long replayOffsetNs = 0u;
+	bool replayStarted = false;
+	bool snapshotPending = false;
+	bool sourceExhausted = false;
+
 	// Only continue execution if kill switch hasn't been activated
 	while (false == Thread_getKillSwitchStatus())
 	{
 		Watchdog_reportActive();
 
-		// Load procstat from file
-		ProcStat_t* procStat = ProcStat_loadFromFile();
+		if (SNAPSHOT_PACING_CLOCK == pacing)
+		{
+			// Sleep in slices until next deadline, so that activity is still reported during long periods.
+			// Probing frequency higher than USER_HZ can cause issues.
+			int waitResult = SamplerClock_wait(&sampler, READER_SLEEP_SLICE_MS);
 
-		if (NULL == procStat)
+			if (0 == waitResult)
+			{
+				continue;
+			}
+			else if (0 > waitResult)
+			{
+				Log(LLEVEL_ERROR, "error while waiting for sampling deadline");
+			}
+
+			if (0 == samplerStats->ticks % READER_STATS_LOG_INTERVAL)
+			{
+				Log(LLEVEL_DEBUG, "sampler: %llu ticks, %llu missed, jitter last %llu ns, max %llu ns",
+					samplerStats->ticks,
+					samplerStats->missedDeadlines,
+					samplerStats->lastJitterNs,
+					samplerStats->maxJitterNs);
+			}
+		}
+
+		if (!snapshotPending)
 		{
-			// Procstat is unavailable, log error and try again in next iteration
-			Log(LLEVEL_ERROR, "cannot load data from /proc/stat file");
-			continue;
+			int sourceResult = SnapshotSource_next(params->source, procStat);
+
+			if (0 == sourceResult)
+			{
+				Log(LLEVEL_INFO, "snapshot source exhausted");
+				sourceExhausted = true;
+				break;
+			}
+			else if (0 > sourceResult)
+			{
+				// Snapshot is unavailable, log error and try again in next iteration
+				Log(LLEVEL_ERROR, "cannot acquire snapshot");
+				continue;
+			}
+
+			if (NULL != params->cpuMap)
+			{
+				trackOnlineSet(params->cpuMap, procStat);
+			}
+
+			snapshotPending = true;
+		}
+
+		if (SNAPSHOT_PACING_RECORDED == pacing)
+		{
+			if (!replayStarted)
+			{
+				replayOffsetNs = MonotonicTimeNs() - procStat->timestampNs;
+				replayStarted = true;
+			}
+
+			// Keep original spacing between snapshots, reporting activity while waiting
+			int waitResult = SamplerClock_waitUntil(procStat->timestampNs + replayOffsetNs, READER_SLEEP_SLICE_MS);
+
+			if (0 == waitResult)
+			{
+				continue;
+			}
+			else if (0 > waitResult)
+			{
+				Log(LLEVEL_ERROR, "error while waiting for replay deadline");
+			}
+		}
+
+		snapshotPending = false;
+		Latency_mark(&procStat->stamps, LSTAGE_READ);
+
+		if (params->deltaMode)
+		{
+			if (!prevProcStatValid)
+			{
+				// Nothing to compare the first snapshot with yet
+				ProcStat_t* tmp 	= prevProcStat;
+				prevProcStat 		= procStat;
+				procStat 			= tmp;
+				prevProcStatValid 	= true;
+				continue;
+			}
+
+			ProcStatDelta_encode(prevProcStat, procStat, procStatDelta);
 		}
 
 		// Procstat has been acquired, lock mutex on circular buffer and write
@@ -96,8 +379,27 @@ int ReaderThread(void* rawParams)
 			break;
 		}
 		
+		// Change overwriting the oldest one would lose it's interval, so it's kept out and the next one spans both
+		if (params->deltaMode && CircularBuffer_isFull(params->outBuf))
+		{
+			if (thrd_success != Mutex_unlock(params->outMtx))
+			{
+				Log(LLEVEL_ERROR, "couldn't release input buffer mutex");
+			}
+
+			Log(LLEVEL_WARNING, "input buffer still full, change will be carried over into the next one");
+			continue;
+		}
+
 		// Buffer isn't full, write data
-		CircularBuffer_write(params->outBuf, procStat);
+		if (params->deltaMode)
+		{
+			CircularBuffer_write(params->outBuf, procStatDelta);
+		}
+		else
+		{
+			CircularBuffer_write(params->outBuf, procStat);
+		}
 		
 		// Unlock mutex so analyzer thread can access it
 		if (thrd_success != Mutex_unlock(params->outMtx))
@@ -124,14 +426,38 @@ int ReaderThread(void* rawParams)
 			procStat->cpuStats[0].values[8],
 			procStat->cpuStats[0].values[9]);
 
-		// Remove obsolete procstat object and move on
-		ProcStat_destroy(procStat);
+		if ((NULL != params->adaptiveParams) && (SNAPSHOT_PACING_CLOCK == pacing))
+		{
+			adaptSamplingPeriod(&sampler, params->adaptiveParams, &adaptiveState, procStat);
+		}
+
+		// Next change is measured from the snapshot just written, skipped snapshots are covered by the change spanning them
+		if (params->deltaMode)
+		{
+			ProcStat_t* tmp = prevProcStat;
+			prevProcStat 	= procStat;
+			procStat 		= tmp;
+		}
+	}
 
-		// Introduce delay here to reduce probing frequency.
-		// Probing frequency higher than USER_HZ can cause issues.
-		Thread_sleepMs(READER_SLEEP_TIME_MS);
+	if (sourceExhausted)
+	{
+		waitForDrain(params);
+		Log(LLEVEL_INFO, "all snapshots have been consumed, shutting down");
+		Thread_activateKillSwitch();
 	}
 
+	free(procStatDelta);
+	free(prevProcStat);
+	free(procStat);
+	adaptiveStateFinalize(&adaptiveState);
+
+	Log(LLEVEL_INFO, "sampler: %llu ticks, %llu missed deadlines, mean jitter %llu ns, max jitter %llu ns",
+		samplerStats->ticks,
+		samplerStats->missedDeadlines,
+		(0u < samplerStats->ticks) ? samplerStats->totalJitterNs / samplerStats->ticks : 0u,
+		samplerStats->maxJitterNs);
+
 	Log(LLEVEL_INFO, "thread exiting");
 
 	// Exit as usual
@@ -6,6 +6,10 @@
 #define READER_H_INCLUDED
 #include "sync_types.h"
 #include "circbuf.h"
+#include "sampler.h"
+#include "snapsource.h"
+#include "cpumap.h"
+#include <stdbool.h>
 
 
 /**
@@ -33,20 +37,57 @@ typedef struct ReaderThreadParams
 
 	/**
 	 * Buffer to write outgoing data to.
-	 * Underlying CircularBuffer_t structure must be able to hold at least one ProcStat_t structure.
+	 * Underlying CircularBuffer_t structure must be able to hold at least one ProcStat_t structure,
+	 * or ProcStatDelta_t structure in delta mode.
 	 * This parameter should be shared with analyzer thread.
 	*/
 	CircularBuffer_t* outBuf;
+
+	/**
+	 * Whether changes between consecutive snapshots (ProcStatDelta_t) should be written into output buffer
+	 * instead of snapshots themselves (ProcStat_t). First snapshot is only kept as a reference.
+	 * Changes are never overwritten in a full buffer, one which doesn't fit is carried over into the next one instead.
+	*/
+	bool deltaMode;
+
+	/**
+	 * Period between consecutive samples, in milliseconds.
+	 * Has to lie within range accepted by SamplerClock_isValidPeriod().
+	*/
+	unsigned samplePeriodMs;
+
+	/**
+	 * Whether samples should be taken at wall-clock multiples of the sampling period.
+	*/
+	bool alignToWallClock;
+
+	/**
+	 * Adaptive sampling mode parameters, or NULL to sample at fixed period.
+	 * In adaptive mode, sampling period starts at samplePeriodMs and is adjusted after every sample.
+	*/
+	const SamplerAdaptiveParams_t* adaptiveParams;
+
+	/**
+	 * Source of snapshots. Sampling clock and adaptive mode only apply to sources paced by SNAPSHOT_PACING_CLOCK,
+	 * other sources dictate their own pacing. Once source is exhausted, thread waits for remaining snapshots
+	 * to be consumed and activates kill switch.
+	*/
+	SnapshotSource_t* source;
+
+	/**
+	 * Online processor set of this system, refreshed after every snapshot and it's epoch stamped into it,
+	 * or NULL if snapshots do not come from this system.
+	*/
+	CpuMap_t* cpuMap;
 }
 ReaderThreadParams_t;
 
 
 /**
- * \brief Thread function for reading /proc/stat file and parsing it's content
- * into ProcStat_t structure.
- * \details Thread will periodically read and parse /proc/stat file, subsequently writing the result
- * into output buffer (outBuf) provided through params. Those writes will be only performed if mutex
- * is successfully acquired and output buffer can hold the data.
+ * \brief Thread function for acquiring /proc/stat snapshots from snapshot source.
+ * \details Thread will acquire snapshots from given source at absolute deadlines spaced by the sampling period,
+ * or as dictated by the source, subsequently writing them into output buffer (outBuf) provided through params. Those writes
+ * will be only performed if mutex is successfully acquired and output buffer can hold the data.
  * \param params Pointer to valid ReaderThreadParams_t structure.
 */
 int ReaderThread(void* params);
@@ -3,6 +3,7 @@
 #include "logger.h"
 #include "threadctl.h"
 #include "helpers.h"
+#include "flightrec.h"
 #include <signal.h>
 #include <string.h>
 #include <stdio.h>
@@ -28,12 +29,16 @@ static const char* THREAD_NAMES[TID_COUNT_] =
 	[TID_ANALYZER]	= "Analyzer",
 	[TID_PRINTER]	= "Printer",
 	[TID_LOGGER]	= "Logger",
-	[TID_WATCHDOG]	= "Watchdog"
+	[TID_WATCHDOG]	= "Watchdog",
+	[TID_RECORDER]	= "Recorder",
+	[TID_DUMPER]	= "Dumper",
+	[TID_PROCSCAN]	= "ProcScanner"
 };
 
 static volatile struct timespec g_timestamps[TID_COUNT_];
 static mtx_t g_timestampsMtx;
 static cnd_t g_timestampsUpdatedCv;
+static bool g_unmonitored[TID_COUNT_];
 
 
 /**
@@ -196,6 +201,15 @@ bool Watchdog_init(void)
 }
 
 
+void Watchdog_disableMonitoring(ThreadId_t threadId)
+{
+	if ((unsigned) threadId < TID_COUNT_)
+	{
+		g_unmonitored[threadId] = true;
+	}
+}
+
+
 void Watchdog_reportActive(void)
 {
 	static const unsigned MAX_LOCK_TIME_MS = 50u;
@@ -284,6 +298,15 @@ int WatchdogThread(void* rawParams)
 		// Ensure we won't detect Watchdog thread as unresponsive
 		g_timestamps[TID_WATCHDOG] = now;
 
+		// Same goes for threads excluded from monitoring
+		for (unsigned ii = 0; ii < sizeof g_timestamps / sizeof *g_timestamps; ++ii)
+		{
+			if (g_unmonitored[ii])
+			{
+				g_timestamps[ii] = now;
+			}
+		}
+
 		int iiOldest = findLowestTimespecIndex((struct timespec*) g_timestamps, sizeof g_timestamps / sizeof *g_timestamps);
 
 		// Check if difference between now and oldest timestamp exceeds maximum allowed unresponsive time.
@@ -291,6 +314,8 @@ int WatchdogThread(void* rawParams)
 			(false == Thread_getKillSwitchStatus()))
 		{
 			retval = Thread_getKillSwitchStatus() ? (iiOldest + 1) : 0;
+			// Preserve history preceding the stall before everything shuts down
+			FlightRecorder_trigger(FREC_TRIGGER_WATCHDOG);
 			triggerKillSwitch();
 			Log(LLEVEL_FATAL, "thread \"%s\" unresponsive, terminating", THREAD_NAMES[iiOldest]);
 			break;
@@ -5,6 +5,7 @@
 #ifndef WATCHDOG_H_INCLUDED
 #define WATCHDOG_H_INCLUDED
 #include <stdbool.h>
+#include "threadctl.h"
 
 
 /**
@@ -22,6 +23,14 @@ void Watchdog_finalize(void);
 bool Watchdog_init(void);
 
 
+/**
+ * \brief Excludes given thread from monitoring. Used for optional threads that have not been launched.
+ * \warning Should be called before watchdog thread is launched.
+ * \param threadId Identifier of thread to be excluded.
+*/
+void Watchdog_disableMonitoring(ThreadId_t threadId);
+
+
 /**
  * \brief Reports this thread as active. Should be used on a regular basis within
  * given thread, as program uses those reports to detect unresponsive threads.
@@ -0,0 +1,346 @@
+#include "batchread.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if defined(IORING_OFF_SQES) && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define BATCHREAD_HAVE_URING 1
+#else
+#define BATCHREAD_HAVE_URING 0
+#endif
+
+
+struct BatchReader
+{
+	BatchReadBackend_t backend;
+	/** Amount of reads submitted together. */
+	size_t depth;
+	unsigned long long syscallCount;
+	/** Whether io_uring has completed any read, telling unsupported read operation apart from failed reads. */
+	bool uringProven;
+#if BATCHREAD_HAVE_URING
+	int ringFd;
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	struct io_uring_sqe* sqes;
+	size_t sqesSize;
+	uint32_t* sqTail;
+	uint32_t sqMask;
+	uint32_t* sqArray;
+	uint32_t* cqHead;
+	uint32_t* cqTail;
+	uint32_t cqMask;
+	struct io_uring_cqe* cqes;
+#endif
+};
+
+
+/**
+ * \brief Reads single file with preadv(), retrying if interrupted.
+ * \return Amount of bytes read, or negated errno value.
+*/
+static ssize_t readOne(BatchReader_t* self, const BatchReadRequest_t* request)
+{
+	const struct iovec iov = { .iov_base = request->buf, .iov_len = request->size };
+	ssize_t result;
+
+	do
+	{
+		++self->syscallCount;
+		result = preadv(request->fd, &iov, 1, 0);
+	}
+	while ((0 > result) && (EINTR == errno));
+
+	return (0 > result) ? -errno : result;
+}
+
+
+#if BATCHREAD_HAVE_URING
+/**
+ * \brief Sets up io_uring with given amount of submission queue entries, mapping both rings.
+ * \return True if successful, false if kernel does not support io_uring or it has been disabled.
+*/
+static bool setupRing(BatchReader_t* self)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	self->ringFd = (int) syscall(__NR_io_uring_setup, (unsigned) self->depth, &params);
+
+	if (0 > self->ringFd)
+	{
+		return false;
+	}
+
+	self->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	self->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	// Newer kernels map both rings at once
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		self->sqRingSize = (self->sqRingSize > self->cqRingSize) ? self->sqRingSize : self->cqRingSize;
+		self->cqRingSize = 0u;
+	}
+
+	self->sqRing = mmap(NULL, self->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_SQ_RING);
+	self->cqRing = (0u == self->cqRingSize)
+		? self->sqRing
+		: mmap(NULL, self->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_CQ_RING);
+	self->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	self->sqes = mmap(NULL, self->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, self->ringFd, IORING_OFF_SQES);
+
+	if ((MAP_FAILED == self->sqRing) || (MAP_FAILED == self->cqRing) || (MAP_FAILED == self->sqes))
+	{
+		return false;
+	}
+
+	self->sqTail 	= (uint32_t*) ((char*) self->sqRing + params.sq_off.tail);
+	self->sqMask 	= *(uint32_t*) ((char*) self->sqRing + params.sq_off.ring_mask);
+	self->sqArray 	= (uint32_t*) ((char*) self->sqRing + params.sq_off.array);
+	self->cqHead 	= (uint32_t*) ((char*) self->cqRing + params.cq_off.head);
+	self->cqTail 	= (uint32_t*) ((char*) self->cqRing + params.cq_off.tail);
+	self->cqMask 	= *(uint32_t*) ((char*) self->cqRing + params.cq_off.ring_mask);
+	self->cqes 		= (struct io_uring_cqe*) ((char*) self->cqRing + params.cq_off.cqes);
+
+	// Kernel may round submission queue up, but never down
+	self->depth = (params.sq_entries < self->depth) ? params.sq_entries : self->depth;
+	return true;
+}
+
+
+/**
+ * \brief Unmaps rings and closes io_uring descriptor, if set up.
+*/
+static void teardownRing(BatchReader_t* self)
+{
+	if ((NULL != self->sqes) && (MAP_FAILED != self->sqes))
+	{
+		munmap(self->sqes, self->sqesSize);
+	}
+
+	if ((NULL != self->cqRing) && (MAP_FAILED != self->cqRing) && (self->cqRing != self->sqRing))
+	{
+		munmap(self->cqRing, self->cqRingSize);
+	}
+
+	if ((NULL != self->sqRing) && (MAP_FAILED != self->sqRing))
+	{
+		munmap(self->sqRing, self->sqRingSize);
+	}
+
+	if (0 <= self->ringFd)
+	{
+		close(self->ringFd);
+	}
+
+	self->sqes 		= NULL;
+	self->cqRing 	= NULL;
+	self->sqRing 	= NULL;
+	self->ringFd 	= -1;
+}
+
+
+/**
+ * \brief Submits single batch of reads, no larger than ring depth, and waits for all of them to complete.
+ * Normally takes a single io_uring_enter() call, which both submits reads and reaps completions.
+ * \return 0 if successful, negative value if io_uring_enter() has failed, leaving result of every read not yet completed
+ * as -EINPROGRESS.
+*/
+static int readBatchUring(BatchReader_t* self, BatchReadRequest_t* requests, size_t count)
+{
+	// Submission queue is only written by this thread, kernel consumes it during io_uring_enter()
+	const uint32_t tail = *self->sqTail;
+
+	for (size_t ii = 0; ii < count; ++ii)
+	{
+		const uint32_t index = (tail + (uint32_t) ii) & self->sqMask;
+		struct io_uring_sqe* sqe = &self->sqes[index];
+		memset(sqe, 0, sizeof(*sqe));
+		sqe->opcode 	= IORING_OP_READ;
+		sqe->fd 		= requests[ii].fd;
+		sqe->addr 		= (uint64_t) (uintptr_t) requests[ii].buf;
+		sqe->len 		= (uint32_t) requests[ii].size;
+		sqe->off 		= 0u;
+		sqe->user_data 	= ii;
+		self->sqArray[index] = index;
+		requests[ii].result = -EINPROGRESS;
+	}
+
+	__atomic_store_n(self->sqTail, tail + (uint32_t) count, __ATOMIC_RELEASE);
+
+	size_t pending = count;
+	size_t completed = 0u;
+
+	while (completed < count)
+	{
+		++self->syscallCount;
+		const long submitted = syscall(__NR_io_uring_enter, self->ringFd, (unsigned) pending, (unsigned) (count - completed),
+			IORING_ENTER_GETEVENTS, NULL, 0);
+
+		if ((0 > submitted) && (EINTR != errno))
+		{
+			return -1;
+		}
+
+		pending -= (0 < submitted) ? (size_t) submitted : 0u;
+
+		uint32_t head = *self->cqHead;
+		const uint32_t cqTail = __atomic_load_n(self->cqTail, __ATOMIC_ACQUIRE);
+
+		while (head != cqTail)
+		{
+			const struct io_uring_cqe* cqe = &self->cqes[head & self->cqMask];
+			requests[cqe->user_data].result = cqe->res;
+			++head;
+			++completed;
+		}
+
+		__atomic_store_n(self->cqHead, head, __ATOMIC_RELEASE);
+	}
+
+	return 0;
+}
+#endif
+
+
+BatchReader_t* BatchReader_create(size_t depth, BatchReadBackend_t backend)
+{
+	if ((0u == depth) || (depth > UINT16_MAX) || (backend > BREAD_BACKEND_PREADV))
+	{
+		return NULL;
+	}
+
+	BatchReader_t* self = calloc(1u, sizeof(BatchReader_t));
+
+	if (NULL == self)
+	{
+		return NULL;
+	}
+
+	self->depth = depth;
+	self->backend = BREAD_BACKEND_PREADV;
+
+#if BATCHREAD_HAVE_URING
+	self->ringFd = -1;
+
+	if (BREAD_BACKEND_PREADV != backend)
+	{
+		if (setupRing(self))
+		{
+			self->backend = BREAD_BACKEND_URING;
+		}
+		else
+		{
+			teardownRing(self);
+		}
+	}
+#endif
+
+	return self;
+}
+
+
+void BatchReader_destroy(BatchReader_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+#if BATCHREAD_HAVE_URING
+	teardownRing(self);
+#endif
+
+	free(self);
+}
+
+
+int BatchReader_read(BatchReader_t* self, BatchReadRequest_t* requests, size_t count)
+{
+	if ((NULL == self) || ((NULL == requests) && (0u != count)))
+	{
+		return -1;
+	}
+
+	size_t done = 0u;
+
+#if BATCHREAD_HAVE_URING
+	for (size_t first = 0; (first < count) && (BREAD_BACKEND_URING == self->backend); first += self->depth)
+	{
+		const size_t batch = (count - first < self->depth) ? count - first : self->depth;
+
+		if (0 != readBatchUring(self, &requests[first], batch))
+		{
+			// Reads still in flight would complete into a later batch, or into buffers reused by then,
+			// so ring is torn down and reads are done one by one from then on
+			teardownRing(self);
+			self->backend = BREAD_BACKEND_PREADV;
+		}
+
+		for (size_t ii = first; ii < first + batch; ++ii)
+		{
+			if (-EINPROGRESS == requests[ii].result)
+			{
+				requests[ii].result = readOne(self, &requests[ii]);
+			}
+			// Kernels predating IORING_OP_READ reject it as invalid, reads are done one by one from then on
+			else if ((-EINVAL == requests[ii].result) && !self->uringProven)
+			{
+				self->backend = BREAD_BACKEND_PREADV;
+				requests[ii].result = readOne(self, &requests[ii]);
+			}
+			else if (0 <= requests[ii].result)
+			{
+				self->uringProven = true;
+			}
+		}
+
+		done = first + batch;
+	}
+#endif
+
+	for (size_t ii = done; ii < count; ++ii)
+	{
+		requests[ii].result = readOne(self, &requests[ii]);
+	}
+
+	return 0;
+}
+
+
+BatchReadBackend_t BatchReader_getBackend(const BatchReader_t* self)
+{
+	return self->backend;
+}
+
+
+unsigned long long BatchReader_getSyscallCount(const BatchReader_t* self)
+{
+	return self->syscallCount;
+}
+
+
+const char* BatchReader_getBackendName(BatchReadBackend_t backend)
+{
+	static const char* const BACKEND_NAMES[] =
+	{
+		[BREAD_BACKEND_AUTO] 	= "auto",
+		[BREAD_BACKEND_URING] 	= "io_uring",
+		[BREAD_BACKEND_PREADV] 	= "preadv"
+	};
+
+	return ((0 <= (int) backend) && (backend <= BREAD_BACKEND_PREADV)) ? BACKEND_NAMES[backend] : "?";
+}
@@ -0,0 +1,108 @@
+/**
+ * \file batchread.h
+ * Batched reads of many small files, such as those of procfs, submitted through io_uring with a single system call
+ * per batch, or read one by one with preadv() where io_uring is unavailable.
+*/
+#ifndef BATCHREAD_H_INCLUDED
+#define BATCHREAD_H_INCLUDED
+#include <stddef.h>
+#include <sys/types.h>
+
+
+/**
+ * Default amount of reads submitted together, bounding size of io_uring rings.
+*/
+#define BATCHREAD_DEFAULT_DEPTH 256u
+
+
+typedef struct BatchReader BatchReader_t;
+
+
+/**
+ * Ways of reading files.
+*/
+typedef enum BatchReadBackend
+{
+	/** io_uring if kernel supports it, preadv() otherwise. Only valid when creating reader. */
+	BREAD_BACKEND_AUTO = 0,
+
+	/** Every batch submitted through io_uring and reaped with a single io_uring_enter() call. */
+	BREAD_BACKEND_URING,
+
+	/** Every file read with a separate preadv() call. */
+	BREAD_BACKEND_PREADV
+}
+BatchReadBackend_t;
+
+
+/**
+ * Single read, from the beginning of an already open file.
+*/
+typedef struct BatchReadRequest
+{
+	/** Descriptor of file to read. */
+	int 		fd;
+	/** Buffer to read into. */
+	char* 		buf;
+	/** Size of buffer, in bytes. */
+	size_t 		size;
+	/** Amount of bytes read, or negated errno value if read has failed. Filled by BatchReader_read(). */
+	ssize_t 	result;
+}
+BatchReadRequest_t;
+
+
+/**
+ * \brief Creates batch reader.
+ * \param depth Amount of reads submitted together, at least 1. Larger batches are split.
+ * \param backend Way of reading files. io_uring falls back to preadv() if kernel does not support it,
+ * or if it has been disabled.
+ * \return Pointer to reader if successful, NULL otherwise.
+*/
+BatchReader_t* BatchReader_create(size_t depth, BatchReadBackend_t backend);
+
+
+/**
+ * \brief Destroys batch reader. Does nothing if NULL.
+ * \param self Reader to destroy.
+*/
+void BatchReader_destroy(BatchReader_t* self);
+
+
+/**
+ * \brief Reads beginning of every requested file, filling result of every request.
+ * Failure of a single read is reported in it's result only, failure of io_uring has reads redone with preadv().
+ * \param self Reader.
+ * \param requests Reads to perform.
+ * \param count Amount of reads.
+ * \return 0 if every read has been attempted, negative value on error.
+*/
+int BatchReader_read(BatchReader_t* self, BatchReadRequest_t* requests, size_t count);
+
+
+/**
+ * \brief Retrieves way reader reads files, which may change from io_uring to preadv() if kernel rejects reads,
+ * or if io_uring fails.
+ * \param self Reader.
+ * \return Either BREAD_BACKEND_URING or BREAD_BACKEND_PREADV.
+*/
+BatchReadBackend_t BatchReader_getBackend(const BatchReader_t* self);
+
+
+/**
+ * \brief Retrieves amount of system calls reader has made to read files, since creation.
+ * \param self Reader.
+ * \return Amount of system calls.
+*/
+unsigned long long BatchReader_getSyscallCount(const BatchReader_t* self);
+
+
+/**
+ * \brief Retrieves name of given backend.
+ * \param backend Backend.
+ * \return Name of backend, "?" if invalid.
+*/
+const char* BatchReader_getBackendName(BatchReadBackend_t backend);
+
+
+#endif // !BATCHREAD_H_INCLUDED
@@ -0,0 +1,844 @@
+#include "cgtrack.h"
+#include "helpers.h"
+#include "batchread.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define CGROUP_FILE_MAX 			1024u
+#define CGROUP_ENTRIES_INITIAL 		64u
+// Nesting of cgroups below a configured one past which subtree is not walked
+#define CGROUP_DEPTH_MAX 			16u
+#define CGROUP_LIST_SEPARATOR 		','
+// Every cgroup takes two reads, cpu.stat and cpu.max
+#define CGROUP_BATCH_ENTRIES 		(BATCHREAD_DEFAULT_DEPTH / 2u)
+#define NO_INDEX 					UINT32_MAX
+
+
+/**
+ * State of a single tracked cgroup.
+*/
+typedef struct CgroupEntry
+{
+	/** Path of cgroup, relative to cgroup hierarchy root unless absolute. */
+	char* 		path;
+	/** Descriptors of cgroup's cpu.stat and cpu.max files, the latter negative for root cgroup, which has no quota. */
+	int 		statFd;
+	int 		maxFd;
+	/** Whether cgroup has been listed by the last walk of configured cgroups. */
+	bool 		listed;
+	/** Whether usage has been calculated, which takes two reads of the same cgroup. */
+	bool 		measured;
+	/** Usage and throttling over the interval between the last two reads. */
+	uint32_t 	usageBp;
+	uint32_t 	throttledPeriodsBp;
+	uint32_t 	throttledTimeBp;
+	/** Quota and it's enforcement period, in microseconds, quota of 0 if cgroup has none. */
+	unsigned long long quotaUsec;
+	unsigned long long periodUsec;
+	/** Counters of cpu.stat as of the last read. */
+	unsigned long long usageUsec;
+	unsigned long long nrPeriods;
+	unsigned long long nrThrottled;
+	unsigned long long throttledUsec;
+	/** Point in time of the last read, on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long readNs;
+}
+CgroupEntry_t;
+
+
+/**
+ * Values extracted from cpu.stat and cpu.max files of a single cgroup.
+*/
+typedef struct CgroupSample
+{
+	unsigned long long usageUsec;
+	unsigned long long nrPeriods;
+	unsigned long long nrThrottled;
+	unsigned long long throttledUsec;
+	unsigned long long quotaUsec;
+	unsigned long long periodUsec;
+}
+CgroupSample_t;
+
+
+struct CgroupTracker
+{
+	/** Descriptor of cgroup hierarchy root, relative paths are opened against it. */
+	int 			rootFd;
+	/** Configured cgroups, as one buffer of null-terminated paths. */
+	char* 			list;
+	size_t 			listLength;
+	/** Whether descendants of configured cgroups are tracked as well. */
+	bool 			subtree;
+	/** Tracked cgroups, in order of discovery. */
+	CgroupEntry_t* 	entries;
+	size_t 			entriesLength;
+	size_t 			entriesCapacity;
+	/** Open addressing index of entries by path, power of two in size. */
+	uint32_t* 		index;
+	size_t 			indexCapacity;
+	/** Amount of top cgroups to report. */
+	size_t 			topCount;
+	/** Indices of top cgroups found so far, ordered from the top one. */
+	uint32_t* 		top;
+	/** Amount of steps a scan is spread across, and the step to be taken next. */
+	unsigned 		slices;
+	unsigned 		slice;
+	/** Reader of cgroup files, along with a buffer and a request for every read of a single batch. */
+	BatchReader_t* 	reader;
+	char* 			batchBuffers;
+	BatchReadRequest_t* batchRequests;
+	/** Start of the current and the previous scan, on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long scanStartNs;
+	unsigned long long prevScanStartNs;
+	/** Processor time spent on the current scan so far, in nanoseconds. */
+	unsigned long long scanCostNs;
+};
+
+
+/**
+ * \brief Retrieves processor time consumed by the calling thread, in nanoseconds.
+*/
+static unsigned long long threadCpuTimeNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+
+/**
+ * \brief Hashes cgroup path into position in index of given capacity, with FNV-1a.
+*/
+static inline size_t hashPath(const char* path, size_t capacity)
+{
+	uint32_t hash = 2166136261u;
+
+	for (const char* p = path; '\0' != *p; ++p)
+	{
+		hash = (hash ^ (uint8_t) *p) * 16777619u;
+	}
+
+	return (size_t) (hash & (uint32_t) (capacity - 1u));
+}
+
+
+/**
+ * \brief Finds entry of given cgroup.
+ * \return Pointer to index slot holding entry's position if found, or empty slot it would be inserted into.
+*/
+static uint32_t* findSlot(CgroupTracker_t* self, const char* path)
+{
+	size_t position = hashPath(path, self->indexCapacity);
+
+	while ((NO_INDEX != self->index[position]) && (0 != strcmp(self->entries[self->index[position]].path, path)))
+	{
+		position = (position + 1u) & (self->indexCapacity - 1u);
+	}
+
+	return &self->index[position];
+}
+
+
+/**
+ * \brief Rebuilds index of entries, with room for twice as many entries as can currently be stored.
+ * \return True if successful, false if allocation fails.
+*/
+static bool rebuildIndex(CgroupTracker_t* self)
+{
+	size_t capacity = 1u;
+
+	while (capacity < 2u * self->entriesCapacity)
+	{
+		capacity *= 2u;
+	}
+
+	if (capacity != self->indexCapacity)
+	{
+		uint32_t* index = realloc(self->index, capacity * sizeof(uint32_t));
+
+		if (NULL == index)
+		{
+			return false;
+		}
+
+		self->index = index;
+		self->indexCapacity = capacity;
+	}
+
+	memset(self->index, 0xFF, self->indexCapacity * sizeof(uint32_t));
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		*findSlot(self, self->entries[ii].path) = (uint32_t) ii;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Closes descriptors of given cgroup's files, if open.
+*/
+static void closeFiles(CgroupEntry_t* entry)
+{
+	if (0 <= entry->statFd)
+	{
+		close(entry->statFd);
+		entry->statFd = -1;
+	}
+
+	if (0 <= entry->maxFd)
+	{
+		close(entry->maxFd);
+		entry->maxFd = -1;
+	}
+}
+
+
+/**
+ * \brief Opens files of given cgroup, unless already open. Counters are read from scratch once reopened.
+ * \return True if cpu.stat is open, false if cgroup does not exist.
+*/
+static bool openFiles(const CgroupTracker_t* self, CgroupEntry_t* entry)
+{
+	if (0 <= entry->statFd)
+	{
+		return true;
+	}
+
+	char path[PATH_MAX];
+
+	if ((size_t) snprintf(path, sizeof(path), "%s/cpu.stat", entry->path) >= sizeof(path))
+	{
+		return false;
+	}
+
+	entry->statFd = openat(self->rootFd, path, O_RDONLY | O_CLOEXEC);
+	snprintf(path, sizeof(path), "%s/cpu.max", entry->path);
+	entry->maxFd = (0 <= entry->statFd) ? openat(self->rootFd, path, O_RDONLY | O_CLOEXEC) : -1;
+	entry->measured = false;
+	entry->readNs = 0u;
+	return 0 <= entry->statFd;
+}
+
+
+/**
+ * \brief Parses unsigned decimal number, advancing given pointer past it.
+*/
+static inline unsigned long long parseNumber(const char** str, const char* end)
+{
+	const char* p = *str;
+	unsigned long long value = 0u;
+
+	while ((p < end) && ('0' <= *p) && ('9' >= *p))
+	{
+		value = value * 10u + (unsigned long long) (*p - '0');
+		++p;
+	}
+
+	*str = p;
+	return value;
+}
+
+
+/**
+ * \brief Extracts counters from contents of cpu.stat file, made of "key value" lines.
+ * Keys are matched by name, as their set and order depend on kernel version and enabled controllers.
+ * \return True if successful, false if usage_usec is missing.
+*/
+static bool parseCpuStat(const char* text, size_t length, CgroupSample_t* out)
+{
+	static const struct { const char* key; size_t offset; } KEYS[] =
+	{
+		{ "usage_usec",		offsetof(CgroupSample_t, usageUsec) },
+		{ "nr_periods",		offsetof(CgroupSample_t, nrPeriods) },
+		{ "nr_throttled",	offsetof(CgroupSample_t, nrThrottled) },
+		{ "throttled_usec",	offsetof(CgroupSample_t, throttledUsec) }
+	};
+
+	const char* const end = text + length;
+	const char* p = text;
+	bool hasUsage = false;
+
+	while (p < end)
+	{
+		const char* space = memchr(p, ' ', (size_t) (end - p));
+		const char* eol = memchr(p, '\n', (size_t) (end - p));
+		eol = (NULL != eol) ? eol : end;
+
+		if ((NULL != space) && (space < eol))
+		{
+			for (size_t ii = 0; ii < sizeof(KEYS) / sizeof(KEYS[0]); ++ii)
+			{
+				if ((strlen(KEYS[ii].key) == (size_t) (space - p)) && (0 == memcmp(p, KEYS[ii].key, (size_t) (space - p))))
+				{
+					const char* value = space + 1;
+					*(unsigned long long*) ((char*) out + KEYS[ii].offset) = parseNumber(&value, eol);
+					hasUsage = hasUsage || (0u == ii);
+					break;
+				}
+			}
+		}
+
+		p = eol + 1;
+	}
+
+	return hasUsage;
+}
+
+
+/**
+ * \brief Extracts quota and period from contents of cpu.max file, either "max PERIOD" or "QUOTA PERIOD".
+ * Malformed contents are treated as no quota.
+*/
+static void parseCpuMax(const char* text, size_t length, CgroupSample_t* out)
+{
+	const char* const end = text + length;
+	const char* p = text;
+	out->quotaUsec = ((3u <= length) && (0 == memcmp(text, "max", 3u))) ? 0u : parseNumber(&p, end);
+
+	while ((p < end) && (' ' != *p))
+	{
+		++p;
+	}
+
+	++p;
+	out->periodUsec = (p < end) ? parseNumber(&p, end) : 0u;
+	out->quotaUsec = (0u != out->periodUsec) ? out->quotaUsec : 0u;
+}
+
+
+/**
+ * \brief Calculates ratio of given counter deltas in basis points, 0 if denominator is 0.
+*/
+static inline uint32_t ratioBp(double numerator, double denominator)
+{
+	return (0.0 < denominator) ? (uint32_t) (numerator * 10000.0 / denominator + 0.5) : 0u;
+}
+
+
+/**
+ * \brief Updates given cgroup from it's counters, calculating it's usage and throttling since the previous read.
+ * \param nowNs Point in time of the read, on CLOCK_MONOTONIC, in nanoseconds.
+*/
+static void updateEntry(CgroupEntry_t* entry, const CgroupSample_t* sample, unsigned long long nowNs)
+{
+	// Counters only go backwards if cgroup has been removed and created again under the same name
+	if ((0u != entry->readNs) && (nowNs > entry->readNs) && (sample->usageUsec >= entry->usageUsec) &&
+		(sample->nrPeriods >= entry->nrPeriods) && (sample->nrThrottled >= entry->nrThrottled) &&
+		(sample->throttledUsec >= entry->throttledUsec))
+	{
+		const double elapsedUsec = (double) (nowNs - entry->readNs) / 1000.0;
+		const double usedUsec = (double) (sample->usageUsec - entry->usageUsec);
+
+		// Usage against quota is usage against processors quota is worth, quota of a period per period
+		entry->usageBp = (0u != sample->quotaUsec)
+			? ratioBp(usedUsec * (double) sample->periodUsec, elapsedUsec * (double) sample->quotaUsec)
+			: ratioBp(usedUsec, elapsedUsec);
+		entry->throttledPeriodsBp = ratioBp((double) (sample->nrThrottled - entry->nrThrottled), (double) (sample->nrPeriods - entry->nrPeriods));
+		entry->throttledTimeBp = ratioBp((double) (sample->throttledUsec - entry->throttledUsec), elapsedUsec);
+		entry->measured = true;
+	}
+	else
+	{
+		entry->measured = false;
+	}
+
+	entry->quotaUsec 		= sample->quotaUsec;
+	entry->periodUsec 		= sample->periodUsec;
+	entry->usageUsec 		= sample->usageUsec;
+	entry->nrPeriods 		= sample->nrPeriods;
+	entry->nrThrottled 		= sample->nrThrottled;
+	entry->throttledUsec 	= sample->throttledUsec;
+	entry->readNs 			= nowNs;
+}
+
+
+/**
+ * \brief Reads given range of cgroups in batches through batch reader, two files per cgroup.
+ * Cgroups files of which cannot be read anymore have been removed, their files are closed
+ * and reopened if cgroup is listed again.
+*/
+static void readEntries(CgroupTracker_t* self, size_t first, size_t last)
+{
+	for (size_t batchFirst = first; batchFirst < last; batchFirst += CGROUP_BATCH_ENTRIES)
+	{
+		const size_t batchLast = (last - batchFirst < CGROUP_BATCH_ENTRIES) ? last : batchFirst + CGROUP_BATCH_ENTRIES;
+		size_t count = 0u;
+
+		for (size_t ii = batchFirst; ii < batchLast; ++ii)
+		{
+			const int fds[] = { self->entries[ii].statFd, self->entries[ii].maxFd };
+
+			for (size_t file = 0; file < sizeof(fds) / sizeof(fds[0]); ++file)
+			{
+				self->batchRequests[count] = (BatchReadRequest_t)
+				{
+					.fd 	= fds[file],
+					.buf 	= &self->batchBuffers[count * CGROUP_FILE_MAX],
+					.size 	= CGROUP_FILE_MAX
+				};
+				++count;
+			}
+		}
+
+		// Entries of batch that could not be read keep their previous sample
+		if (0 != BatchReader_read(self->reader, self->batchRequests, count))
+		{
+			continue;
+		}
+
+		const unsigned long long batchNs = MonotonicTimeNs();
+
+		for (size_t ii = batchFirst; ii < batchLast; ++ii)
+		{
+			CgroupEntry_t* entry = &self->entries[ii];
+			const BatchReadRequest_t* stat = &self->batchRequests[2u * (ii - batchFirst)];
+			const BatchReadRequest_t* max = stat + 1;
+			CgroupSample_t sample = { 0 };
+
+			if ((0 >= stat->result) || !parseCpuStat(stat->buf, (size_t) stat->result, &sample))
+			{
+				closeFiles(entry);
+				entry->measured = false;
+				entry->listed = false;
+				continue;
+			}
+
+			if (0 < max->result)
+			{
+				parseCpuMax(max->buf, (size_t) max->result, &sample);
+			}
+
+			updateEntry(entry, &sample, batchNs);
+		}
+	}
+}
+
+
+/**
+ * \brief Marks given cgroup as listed, adding an entry for it if it is not tracked yet, and opening it's files.
+ * \return True if successful, false if allocation fails.
+*/
+static bool listCgroup(CgroupTracker_t* self, const char* path)
+{
+	uint32_t* slot = findSlot(self, path);
+
+	if (NO_INDEX != *slot)
+	{
+		CgroupEntry_t* entry = &self->entries[*slot];
+		entry->listed = openFiles(self, entry);
+		return true;
+	}
+
+	if (self->entriesLength == self->entriesCapacity)
+	{
+		CgroupEntry_t* entries = realloc(self->entries, 2u * self->entriesCapacity * sizeof(CgroupEntry_t));
+
+		if (NULL == entries)
+		{
+			return false;
+		}
+
+		self->entries = entries;
+		self->entriesCapacity *= 2u;
+
+		if (!rebuildIndex(self))
+		{
+			return false;
+		}
+
+		slot = findSlot(self, path);
+	}
+
+	CgroupEntry_t entry = { .path = strdup(path), .statFd = -1, .maxFd = -1 };
+
+	if (NULL == entry.path)
+	{
+		return false;
+	}
+
+	// Cgroup which does not exist is added unlisted, so that it is dropped by the end of the walk
+	entry.listed = openFiles(self, &entry);
+	*slot = (uint32_t) self->entriesLength;
+	self->entries[self->entriesLength++] = entry;
+	return true;
+}
+
+
+/**
+ * \brief Lists every descendant of given cgroup, depth first.
+ * \param path Path of cgroup, which is extended in place with names of descendants.
+ * \param length Length of path.
+ * \param depth Nesting below configured cgroup.
+ * \return True if successful, false if allocation fails.
+*/
+static bool walkSubtree(CgroupTracker_t* self, char* path, size_t length, unsigned depth)
+{
+	const int dirFd = openat(self->rootFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR* dir = (0 <= dirFd) ? fdopendir(dirFd) : NULL;
+
+	if (NULL == dir)
+	{
+		if (0 <= dirFd)
+		{
+			close(dirFd);
+		}
+
+		// Cgroup removed while being walked has no descendants left to list
+		return true;
+	}
+
+	bool result = true;
+	struct dirent* dirEntry;
+
+	while (result && (NULL != (dirEntry = readdir(dir))))
+	{
+		// Every directory of cgroup hierarchy is a cgroup, every other entry is one of it's files
+		if ((DT_DIR != dirEntry->d_type) || ('.' == dirEntry->d_name[0]))
+		{
+			continue;
+		}
+
+		const size_t nameLength = strlen(dirEntry->d_name);
+
+		if (length + 1u + nameLength >= PATH_MAX)
+		{
+			continue;
+		}
+
+		path[length] = '/';
+		memcpy(&path[length + 1u], dirEntry->d_name, nameLength + 1u);
+		result = listCgroup(self, path) &&
+			((depth + 1u >= CGROUP_DEPTH_MAX) || walkSubtree(self, path, length + 1u + nameLength, depth + 1u));
+		path[length] = '\0';
+	}
+
+	closedir(dir);
+	return result;
+}
+
+
+/**
+ * \brief Lists configured cgroups, along with their subtrees if enabled, adding entries of new cgroups
+ * and dropping those of removed ones.
+ * \return True if successful, false if allocation fails.
+*/
+static bool walkCgroups(CgroupTracker_t* self)
+{
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		self->entries[ii].listed = false;
+	}
+
+	char path[PATH_MAX];
+
+	for (const char* item = self->list; item < self->list + self->listLength; item += strlen(item) + 1u)
+	{
+		const size_t length = strlen(item);
+		memcpy(path, item, length + 1u);
+
+		// Configured cgroup which does not exist yet is dropped as well, and picked up by the first walk after it is created
+		if (!listCgroup(self, path) || (self->subtree && !walkSubtree(self, path, length, 0u)))
+		{
+			return false;
+		}
+	}
+
+	// Entries of removed cgroups are dropped, keeping the rest in order
+	size_t kept = 0u;
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		if (self->entries[ii].listed)
+		{
+			self->entries[kept++] = self->entries[ii];
+		}
+		else
+		{
+			closeFiles(&self->entries[ii]);
+			free(self->entries[ii].path);
+		}
+	}
+
+	if (kept != self->entriesLength)
+	{
+		self->entriesLength = kept;
+		return rebuildIndex(self);
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Finds top cgroups among measured ones, by usage against their quota, ordered from the top one.
+ * \return Amount of top cgroups found.
+*/
+static size_t rankEntries(CgroupTracker_t* self)
+{
+	size_t count = 0u;
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		const CgroupEntry_t* entry = &self->entries[ii];
+
+		if (!entry->measured || ((count == self->topCount) && (entry->usageBp <= self->entries[self->top[count - 1u]].usageBp)))
+		{
+			continue;
+		}
+
+		size_t position = (count < self->topCount) ? count++ : count - 1u;
+
+		while ((0u < position) && (self->entries[self->top[position - 1u]].usageBp < entry->usageBp))
+		{
+			self->top[position] = self->top[position - 1u];
+			--position;
+		}
+
+		self->top[position] = (uint32_t) ii;
+	}
+
+	return count;
+}
+
+
+CgroupTracker_t* CgroupTracker_create(const char* list, bool subtree, size_t topCount, unsigned slices)
+{
+	if ((NULL == list) || (0u == topCount) || (0u == slices))
+	{
+		goto error_exit_1;
+	}
+
+	CgroupTracker_t* self = calloc(1u, sizeof(CgroupTracker_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	self->rootFd = open(CGTRACK_ROOT_DEFAULT, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	self->list = malloc(strlen(list) + 1u);
+
+	if (NULL == self->list)
+	{
+		goto error_exit_2;
+	}
+
+	// Empty items are skipped, as are trailing slashes, which would make the same cgroup be tracked twice
+	for (const char* item = list; '\0' != *item; )
+	{
+		const char* separator = strchr(item, CGROUP_LIST_SEPARATOR);
+		size_t length = (NULL != separator) ? (size_t) (separator - item) : strlen(item);
+		const char* next = (NULL != separator) ? separator + 1 : item + length;
+
+		while ((1u < length) && ('/' == item[length - 1u]))
+		{
+			--length;
+		}
+
+		if ((0u != length) && (length < PATH_MAX - 1u))
+		{
+			memcpy(&self->list[self->listLength], item, length);
+			self->list[self->listLength + length] = '\0';
+			self->listLength += length + 1u;
+		}
+
+		item = next;
+	}
+
+	if (0u == self->listLength)
+	{
+		goto error_exit_2;
+	}
+
+	// Relative paths only resolve against mounted hierarchy, absolute ones are opened as they are
+	for (const char* item = self->list; item < self->list + self->listLength; item += strlen(item) + 1u)
+	{
+		if (('/' != item[0]) && (0 > self->rootFd))
+		{
+			goto error_exit_2;
+		}
+	}
+
+	self->entriesCapacity = CGROUP_ENTRIES_INITIAL;
+	self->entries = malloc(self->entriesCapacity * sizeof(CgroupEntry_t));
+	self->top = malloc(topCount * sizeof(uint32_t));
+	self->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_AUTO);
+	self->batchBuffers = malloc(2u * CGROUP_BATCH_ENTRIES * CGROUP_FILE_MAX);
+	self->batchRequests = malloc(2u * CGROUP_BATCH_ENTRIES * sizeof(BatchReadRequest_t));
+
+	if ((NULL == self->entries) || (NULL == self->top) || (NULL == self->reader) ||
+		(NULL == self->batchBuffers) || (NULL == self->batchRequests) || !rebuildIndex(self))
+	{
+		goto error_exit_3;
+	}
+
+	self->subtree 	= subtree;
+	self->topCount 	= topCount;
+	self->slices 	= slices;
+	return self;
+
+error_exit_3:
+	free(self->batchRequests);
+	free(self->batchBuffers);
+	BatchReader_destroy(self->reader);
+	free(self->top);
+	free(self->index);
+	free(self->entries);
+error_exit_2:
+	if (0 <= self->rootFd)
+	{
+		close(self->rootFd);
+	}
+
+	free(self->list);
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void CgroupTracker_destroy(CgroupTracker_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		closeFiles(&self->entries[ii]);
+		free(self->entries[ii].path);
+	}
+
+	if (0 <= self->rootFd)
+	{
+		close(self->rootFd);
+	}
+
+	free(self->batchRequests);
+	free(self->batchBuffers);
+	BatchReader_destroy(self->reader);
+	free(self->top);
+	free(self->index);
+	free(self->entries);
+	free(self->list);
+	free(self);
+}
+
+
+int CgroupTracker_step(CgroupTracker_t* self, CgroupUsageReport_t* report)
+{
+	if ((NULL == self) || (NULL == report))
+	{
+		return -1;
+	}
+
+	const unsigned long long costStartNs = threadCpuTimeNs();
+
+	if (0u == self->slice)
+	{
+		self->prevScanStartNs = self->scanStartNs;
+		self->scanStartNs = MonotonicTimeNs();
+		self->scanCostNs = 0u;
+
+		if (!walkCgroups(self))
+		{
+			return -2;
+		}
+	}
+
+	// Cgroups are split evenly between steps, listing order keeps every cgroup in the same step of every scan
+	const size_t first = self->entriesLength * self->slice / self->slices;
+	const size_t last = self->entriesLength * (self->slice + 1u) / self->slices;
+
+	readEntries(self, first, last);
+
+	self->slice = (self->slice + 1u) % self->slices;
+	self->scanCostNs += threadCpuTimeNs() - costStartNs;
+
+	if (0u != self->slice)
+	{
+		return 0;
+	}
+
+	report->count 			= rankEntries(self);
+	report->cgroupCount 	= self->entriesLength;
+	report->intervalNs 		= (0u != self->prevScanStartNs) ? self->scanStartNs - self->prevScanStartNs : 0u;
+	report->scanCostNs 		= self->scanCostNs;
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		const CgroupEntry_t* entry = &self->entries[self->top[ii]];
+		CgroupUsage_t* usage = &report->top[ii];
+		usage->usageBp 				= entry->usageBp;
+		usage->quotaMilliCpus 		= (0u != entry->quotaUsec) ? (uint32_t) (entry->quotaUsec * 1000u / entry->periodUsec) : 0u;
+		usage->throttledPeriodsBp 	= entry->throttledPeriodsBp;
+		usage->throttledTimeBp 		= entry->throttledTimeBp;
+
+		// End of a long path tells nested cgroups apart better than it's beginning
+		const size_t length = strlen(entry->path);
+
+		if (length < CGTRACK_PATH_LENGTH)
+		{
+			memcpy(usage->path, entry->path, length + 1u);
+		}
+		else
+		{
+			memcpy(usage->path, "...", 3u);
+			memcpy(&usage->path[3], &entry->path[length - (CGTRACK_PATH_LENGTH - 4u)], CGTRACK_PATH_LENGTH - 3u);
+		}
+	}
+
+	return 1;
+}
+
+
+size_t CgroupUsageReport_size(size_t topCount)
+{
+	return sizeof(CgroupUsageReport_t) + topCount * sizeof(CgroupUsage_t);
+}
+
+
+void CgroupUsageReport_print(FILE* out, const CgroupUsageReport_t* report)
+{
+	if ((NULL == out) || (NULL == report) || (0u == report->cgroupCount))
+	{
+		return;
+	}
+
+	fprintf(out, "Cgroups:\t%zu tracked, scan took %.2f ms of CPU every %.1f ms\n",
+		report->cgroupCount,
+		report->scanCostNs / 1000000.0,
+		report->intervalNs / 1000000.0);
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		const CgroupUsage_t* usage = &report->top[ii];
+
+		if (0u == usage->quotaMilliCpus)
+		{
+			fprintf(out, "%s:\t%u.%02u %%\tno quota\n", usage->path, usage->usageBp / 100u, usage->usageBp % 100u);
+			continue;
+		}
+
+		fprintf(out, "%s:\t%u.%02u %% of %u.%03u CPU quota\tthrottled in %u.%02u %% of periods, for %u.%02u %% of time\n",
+			usage->path,
+			usage->usageBp / 100u,
+			usage->usageBp % 100u,
+			usage->quotaMilliCpus / 1000u,
+			usage->quotaMilliCpus % 1000u,
+			usage->throttledPeriodsBp / 100u,
+			usage->throttledPeriodsBp % 100u,
+			usage->throttledTimeBp / 100u,
+			usage->throttledTimeBp % 100u);
+	}
+}
@@ -0,0 +1,112 @@
+/**
+ * \file cgtrack.h
+ * CPU usage and throttling of cgroup v2 control groups, relative to their cpu.max quota,
+ * read from cpu.stat and cpu.max files kept open between scans.
+*/
+#ifndef CGTRACK_H_INCLUDED
+#define CGTRACK_H_INCLUDED
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Default mount point of cgroup v2 hierarchy, cgroup paths are relative to it unless absolute.
+*/
+#define CGTRACK_ROOT_DEFAULT "/sys/fs/cgroup"
+
+/**
+ * Length of reported cgroup path buffer, including terminating null character. Longer paths keep their end.
+*/
+#define CGTRACK_PATH_LENGTH 64u
+
+
+typedef struct CgroupTracker CgroupTracker_t;
+
+
+/**
+ * Usage and throttling of a single cgroup over the last full scan.
+*/
+typedef struct CgroupUsage
+{
+	/** Usage in basis points of cpu.max quota, or of a single processor if cgroup has no quota. */
+	uint32_t 	usageBp;
+	/** Quota in thousandths of a processor, 0 if cgroup has no quota. */
+	uint32_t 	quotaMilliCpus;
+	/** Share of enforcement periods cgroup has been throttled in, in basis points. */
+	uint32_t 	throttledPeriodsBp;
+	/** Share of time cgroup has spent throttled, in basis points. */
+	uint32_t 	throttledTimeBp;
+	/** Path of cgroup, as configured, extended with names of descendants for cgroups found by walking a subtree. */
+	char 		path[CGTRACK_PATH_LENGTH];
+}
+CgroupUsage_t;
+
+
+/**
+ * Cgroups using the largest share of their quota over the last full scan, from the top one.
+*/
+typedef struct CgroupUsageReport
+{
+	/** Amount of cgroups in top array. */
+	size_t 		count;
+	/** Amount of cgroups tracked during the scan. */
+	size_t 		cgroupCount;
+	/** Length of the scan, from start of the previous one, in nanoseconds. */
+	unsigned long long intervalNs;
+	/** Processor time spent on the scan, in nanoseconds. */
+	unsigned long long scanCostNs;
+	/** Top cgroups. */
+	CgroupUsage_t top[];
+}
+CgroupUsageReport_t;
+
+
+/**
+ * \brief Creates cgroup tracker.
+ * \param list Comma-separated cgroup paths, relative to CGTRACK_ROOT_DEFAULT unless absolute.
+ * Cgroups that do not exist yet are picked up once created.
+ * \param subtree Whether every descendant of listed cgroups should be tracked as well.
+ * \param topCount Amount of top cgroups to report, at least 1.
+ * \param slices Amount of CgroupTracker_step() calls a full scan of every cgroup is spread across, at least 1.
+ * \return Pointer to tracker if successful, NULL otherwise.
+*/
+CgroupTracker_t* CgroupTracker_create(const char* list, bool subtree, size_t topCount, unsigned slices);
+
+
+/**
+ * \brief Destroys cgroup tracker, closing every file descriptor. Does nothing if NULL.
+ * \param self Tracker to destroy.
+*/
+void CgroupTracker_destroy(CgroupTracker_t* self);
+
+
+/**
+ * \brief Scans next slice of tracked cgroups. The first slice of every scan lists configured cgroups, along with
+ * their subtrees if enabled, picking up new cgroups and dropping removed ones. Files of every cgroup are kept open
+ * between scans, and a slice is read in batches through BatchReader.
+ * \param self Tracker to advance.
+ * \param report Output buffer, of size retrieved by CgroupUsageReport_size(), filled once scan is complete.
+ * \return 1 if scan has been completed and report filled, 0 if scan is still in progress, negative value on error.
+*/
+int CgroupTracker_step(CgroupTracker_t* self, CgroupUsageReport_t* report);
+
+
+/**
+ * \brief Retrieves size of report of given amount of top cgroups.
+ * \param topCount Amount of top cgroups.
+ * \return Size of CgroupUsageReport structure, in bytes.
+*/
+size_t CgroupUsageReport_size(size_t topCount);
+
+
+/**
+ * \brief Prints top cgroups, one line per cgroup. Prints nothing for zeroed report, as no scan has been completed yet.
+ * \param out Stream to print into.
+ * \param report Report to print.
+*/
+void CgroupUsageReport_print(FILE* out, const CgroupUsageReport_t* report);
+
+
+#endif // !CGTRACK_H_INCLUDED
@@ -0,0 +1,734 @@
+#include "config.h"
+#include "cpulist.h"
+#include "proctrack.h"
+#include "cgtrack.h"
+#include "stealtrack.h"
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <limits.h>
+
+
+/**
+ * Values identifying long options without short equivalent.
+*/
+enum LongOnlyOption
+{
+	OPT_FLIGHT_PERIOD = 256,
+	OPT_FLIGHT_THRESHOLD,
+	OPT_FLIGHT_DIRECTORY,
+	OPT_RECORD,
+	OPT_RECORD_SEGMENT_MB,
+	OPT_RECORD_KEYFRAME,
+	OPT_REPLAY,
+	OPT_REPLAY_FAST,
+	OPT_PROC_ROOT,
+	OPT_CPUS,
+	OPT_NO_CLEAR,
+	OPT_CATCH_UP,
+	OPT_DELTA,
+	OPT_LEVELS,
+	OPT_SYS_ROOT,
+	OPT_CPU_LIST,
+	OPT_TOP,
+	OPT_TOP_SLICES,
+	OPT_THREADS_OF,
+	OPT_CGROUPS,
+	OPT_CGROUP_SUBTREE,
+	OPT_CGROUPS_TOP,
+	OPT_IRQS,
+	OPT_IDLE,
+	OPT_STEAL,
+	OPT_STEAL_SUSTAIN
+};
+
+
+/**
+ * \brief Converts string into unsigned integer, rejecting malformed and out-of-range input.
+ * \param str String to convert.
+ * \param out Pointer to write the result into.
+ * \return True if successful, false otherwise.
+*/
+static bool parseUnsigned(const char* str, unsigned* out)
+{
+	char* end = NULL;
+	errno = 0;
+	unsigned long value = strtoul(str, &end, 10);
+
+	if ((0 != errno) || (end == str) || ('\0' != *end) || (value > UINT_MAX))
+	{
+		return false;
+	}
+
+	*out = (unsigned) value;
+	return true;
+}
+
+
+/**
+ * \brief Converts string into non-negative floating-point number, rejecting malformed input.
+ * \param str String to convert.
+ * \param out Pointer to write the result into.
+ * \return True if successful, false otherwise.
+*/
+static bool parseDouble(const char* str, double* out)
+{
+	char* end = NULL;
+	errno = 0;
+	double value = strtod(str, &end);
+
+	if ((0 != errno) || (end == str) || ('\0' != *end) || (value < 0.0))
+	{
+		return false;
+	}
+
+	*out = value;
+	return true;
+}
+
+
+/**
+ * \brief Parses comma-separated list of printed levels, "cpu" and names of topology levels, case insensitive.
+ * \param str Option argument.
+ * \param printCpus Pointer to write whether usage of every processor is printed into.
+ * \param rollupLevels Pointer to write mask of printed topology levels into.
+ * \return True if successful, false otherwise.
+*/
+static bool parseLevels(const char* str, bool* printCpus, unsigned* rollupLevels)
+{
+	bool cpus = false;
+	unsigned levels = 0u;
+
+	while ('\0' != *str)
+	{
+		const size_t length = strcspn(str, ",");
+		bool known = (length == strlen("cpu")) && (0 == strncasecmp(str, "cpu", length));
+		cpus = cpus || known;
+
+		for (int level = 0; (level < TLEVEL_COUNT_) && !known; ++level)
+		{
+			const char* name = Topology_getLevelName((TopologyLevel_t) level);
+
+			if ((length == strlen(name)) && (0 == strncasecmp(str, name, length)))
+			{
+				levels |= TOPOLOGY_LEVEL_BIT(level);
+				known = true;
+			}
+		}
+
+		if (!known)
+		{
+			return false;
+		}
+
+		str += length;
+		str += (',' == *str) ? 1 : 0;
+	}
+
+	if (!cpus && (0u == levels))
+	{
+		return false;
+	}
+
+	*printCpus = cpus;
+	*rollupLevels = levels;
+	return true;
+}
+
+
+/**
+ * \brief Parses sampling period option argument, reporting invalid values.
+ * \param str Option argument.
+ * \param out Pointer to write the period into, in milliseconds.
+ * \return True if successful, false otherwise.
+*/
+static bool parsePeriod(const char* str, unsigned* out)
+{
+	if (!parseUnsigned(str, out) || !SamplerClock_isValidPeriod(*out))
+	{
+		fprintf(stderr, "invalid sampling period: %s (expected %u-%u ms)\n",
+			str, SAMPLER_MIN_PERIOD_MS, SAMPLER_MAX_PERIOD_MS);
+		return false;
+	}
+
+	return true;
+}
+
+
+void Config_setDefaults(Config_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	self->samplePeriodMs 	= CONFIG_DEFAULT_SAMPLE_PERIOD_MS;
+	self->alignToWallClock 	= false;
+	self->adaptive 			= false;
+	self->adaptiveParams 	= (SamplerAdaptiveParams_t)
+	{
+		.floorMs 		= CONFIG_DEFAULT_ADAPTIVE_FLOOR_MS,
+		.ceilingMs 		= CONFIG_DEFAULT_ADAPTIVE_CEILING_MS,
+		.thresholdPct 	= CONFIG_DEFAULT_ADAPTIVE_THRESHOLD_PCT
+	};
+	self->flightWindowMs 		= 0u;
+	self->flightPeriodMs 		= CONFIG_DEFAULT_FLIGHT_PERIOD_MS;
+	self->flightThresholdPct 	= CONFIG_DEFAULT_FLIGHT_THRESHOLD_PCT;
+	self->flightDirectory 		= CONFIG_DEFAULT_FLIGHT_DIRECTORY;
+	self->recordPath 				= NULL;
+	self->recordSegmentMb 			= CONFIG_DEFAULT_RECORD_SEGMENT_MB;
+	self->recordKeyframeInterval 	= CONFIG_DEFAULT_RECORD_KEYFRAME_INTERVAL;
+	self->replayPath 				= NULL;
+	self->replayFast 				= false;
+	self->procRoot 					= NULL;
+	self->cpuCount 					= 0u;
+	self->clearScreen 				= true;
+	self->catchUp 					= ACATCHUP_NONE;
+	self->deltaMode 				= false;
+	self->printCpus 				= true;
+	self->rollupLevels 				= 0u;
+	self->sysRoot 					= NULL;
+	self->cpuList 					= NULL;
+	self->topCount 					= 0u;
+	self->topSlices 				= PROCTRACK_DEFAULT_SLICES;
+	self->threadsOf 				= NULL;
+	self->cgroups 					= NULL;
+	self->cgroupSubtree 			= false;
+	self->cgroupTopCount 			= CONFIG_DEFAULT_TOP_CGROUPS;
+	self->irqHotCount 				= 0u;
+	self->idleFilesPerCpu 			= 0u;
+	self->stealThresholdPct 		= 0u;
+	self->stealSustain 				= STEALTRACK_DEFAULT_SUSTAIN;
+}
+
+
+int Config_parseArgs(Config_t* self, int argc, char* argv[])
+{
+	static const struct option LONG_OPTIONS[] =
+	{
+		{ "period",					required_argument,	NULL,	'p' },
+		{ "align",					no_argument,		NULL,	'a' },
+		{ "adaptive",				no_argument,		NULL,	'A' },
+		{ "min-period",				required_argument,	NULL,	'm' },
+		{ "max-period",				required_argument,	NULL,	'M' },
+		{ "threshold",				required_argument,	NULL,	't' },
+		{ "flight-window",			required_argument,	NULL,	'F' },
+		{ "flight-period",			required_argument,	NULL,	OPT_FLIGHT_PERIOD },
+		{ "flight-threshold",		required_argument,	NULL,	OPT_FLIGHT_THRESHOLD },
+		{ "flight-dir",				required_argument,	NULL,	OPT_FLIGHT_DIRECTORY },
+		{ "record",					required_argument,	NULL,	OPT_RECORD },
+		{ "record-segment-mb",		required_argument,	NULL,	OPT_RECORD_SEGMENT_MB },
+		{ "record-keyframe",		required_argument,	NULL,	OPT_RECORD_KEYFRAME },
+		{ "replay",					required_argument,	NULL,	OPT_REPLAY },
+		{ "replay-fast",			no_argument,		NULL,	OPT_REPLAY_FAST },
+		{ "proc-root",				required_argument,	NULL,	OPT_PROC_ROOT },
+		{ "cpus",					required_argument,	NULL,	OPT_CPUS },
+		{ "no-clear",				no_argument,		NULL,	OPT_NO_CLEAR },
+		{ "catch-up",				required_argument,	NULL,	OPT_CATCH_UP },
+		{ "delta",					no_argument,		NULL,	OPT_DELTA },
+		{ "levels",					required_argument,	NULL,	OPT_LEVELS },
+		{ "sys-root",				required_argument,	NULL,	OPT_SYS_ROOT },
+		{ "cpu-list",				required_argument,	NULL,	OPT_CPU_LIST },
+		{ "top",					required_argument,	NULL,	OPT_TOP },
+		{ "top-slices",				required_argument,	NULL,	OPT_TOP_SLICES },
+		{ "threads-of",				required_argument,	NULL,	OPT_THREADS_OF },
+		{ "cgroups",				required_argument,	NULL,	OPT_CGROUPS },
+		{ "cgroup-subtree",			no_argument,		NULL,	OPT_CGROUP_SUBTREE },
+		{ "cgroups-top",			required_argument,	NULL,	OPT_CGROUPS_TOP },
+		{ "irqs",					required_argument,	NULL,	OPT_IRQS },
+		{ "idle",					required_argument,	NULL,	OPT_IDLE },
+		{ "steal",					required_argument,	NULL,	OPT_STEAL },
+		{ "steal-sustain",			required_argument,	NULL,	OPT_STEAL_SUSTAIN },
+		{ "help",					no_argument,		NULL,	'h' },
+		{ NULL,						0,					NULL,	0 }
+	};
+
+	if ((NULL == self) || (NULL == argv))
+	{
+		return -1;
+	}
+
+	int opt;
+
+	while (-1 != (opt = getopt_long(argc, argv, "p:aAm:M:t:F:h", LONG_OPTIONS, NULL)))
+	{
+		switch (opt)
+		{
+			case 'p':
+			{
+				if (!parsePeriod(optarg, &self->samplePeriodMs))
+				{
+					return -2;
+				}
+			}
+			break;
+
+			case 'a':
+			{
+				self->alignToWallClock = true;
+			}
+			break;
+
+			case 'A':
+			{
+				self->adaptive = true;
+			}
+			break;
+
+			case 'm':
+			{
+				if (!parsePeriod(optarg, &self->adaptiveParams.floorMs))
+				{
+					return -2;
+				}
+			}
+			break;
+
+			case 'M':
+			{
+				if (!parsePeriod(optarg, &self->adaptiveParams.ceilingMs))
+				{
+					return -2;
+				}
+			}
+			break;
+
+			case 't':
+			{
+				if (!parseDouble(optarg, &self->adaptiveParams.thresholdPct))
+				{
+					fprintf(stderr, "invalid usage change threshold: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'F':
+			{
+				if (!parseUnsigned(optarg, &self->flightWindowMs))
+				{
+					fprintf(stderr, "invalid flight recorder window: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_FLIGHT_PERIOD:
+			{
+				if (!parsePeriod(optarg, &self->flightPeriodMs))
+				{
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_FLIGHT_THRESHOLD:
+			{
+				if (!parseDouble(optarg, &self->flightThresholdPct))
+				{
+					fprintf(stderr, "invalid flight recorder threshold: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_FLIGHT_DIRECTORY:
+			{
+				self->flightDirectory = optarg;
+			}
+			break;
+
+			case OPT_RECORD:
+			{
+				self->recordPath = optarg;
+			}
+			break;
+
+			case OPT_RECORD_SEGMENT_MB:
+			{
+				if (!parseUnsigned(optarg, &self->recordSegmentMb) || (0u == self->recordSegmentMb))
+				{
+					fprintf(stderr, "invalid recording segment size: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_RECORD_KEYFRAME:
+			{
+				if (!parseUnsigned(optarg, &self->recordKeyframeInterval) || (0u == self->recordKeyframeInterval))
+				{
+					fprintf(stderr, "invalid recording keyframe interval: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_REPLAY:
+			{
+				self->replayPath = optarg;
+			}
+			break;
+
+			case OPT_REPLAY_FAST:
+			{
+				self->replayFast = true;
+			}
+			break;
+
+			case OPT_PROC_ROOT:
+			{
+				self->procRoot = optarg;
+			}
+			break;
+
+			case OPT_CPUS:
+			{
+				if (!parseUnsigned(optarg, &self->cpuCount) || (0u == self->cpuCount) || (self->cpuCount > INT_MAX))
+				{
+					fprintf(stderr, "invalid processor count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_NO_CLEAR:
+			{
+				self->clearScreen = false;
+			}
+			break;
+
+			case OPT_CATCH_UP:
+			{
+				if (0 == strcmp(optarg, "none"))
+				{
+					self->catchUp = ACATCHUP_NONE;
+				}
+				else if (0 == strcmp(optarg, "coalesce"))
+				{
+					self->catchUp = ACATCHUP_COALESCE;
+				}
+				else if (0 == strcmp(optarg, "batch"))
+				{
+					self->catchUp = ACATCHUP_BATCH;
+				}
+				else
+				{
+					fprintf(stderr, "unknown catch-up mode: %s (expected none, coalesce or batch)\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_DELTA:
+			{
+				self->deltaMode = true;
+			}
+			break;
+
+			case OPT_LEVELS:
+			{
+				if (!parseLevels(optarg, &self->printCpus, &self->rollupLevels))
+				{
+					fprintf(stderr, "invalid printed levels: %s (expected comma-separated cpu, core, package or node)\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_SYS_ROOT:
+			{
+				self->sysRoot = optarg;
+			}
+			break;
+
+			case OPT_CPU_LIST:
+			{
+				self->cpuList = optarg;
+			}
+			break;
+
+			case OPT_TOP:
+			{
+				if (!parseUnsigned(optarg, &self->topCount))
+				{
+					fprintf(stderr, "invalid process count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_TOP_SLICES:
+			{
+				if (!parseUnsigned(optarg, &self->topSlices) || (0u == self->topSlices))
+				{
+					fprintf(stderr, "invalid process scan slice count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_THREADS_OF:
+			{
+				self->threadsOf = optarg;
+			}
+			break;
+
+			case OPT_CGROUPS:
+			{
+				self->cgroups = optarg;
+			}
+			break;
+
+			case OPT_CGROUP_SUBTREE:
+			{
+				self->cgroupSubtree = true;
+			}
+			break;
+
+			case OPT_CGROUPS_TOP:
+			{
+				if (!parseUnsigned(optarg, &self->cgroupTopCount) || (0u == self->cgroupTopCount))
+				{
+					fprintf(stderr, "invalid cgroup count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_IRQS:
+			{
+				if (!parseUnsigned(optarg, &self->irqHotCount))
+				{
+					fprintf(stderr, "invalid processor count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_IDLE:
+			{
+				if (!parseUnsigned(optarg, &self->idleFilesPerCpu))
+				{
+					fprintf(stderr, "invalid file count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_STEAL:
+			{
+				if (!parseUnsigned(optarg, &self->stealThresholdPct) || (100u < self->stealThresholdPct))
+				{
+					fprintf(stderr, "invalid steal threshold: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case OPT_STEAL_SUSTAIN:
+			{
+				if (!parseUnsigned(optarg, &self->stealSustain) || (0u == self->stealSustain))
+				{
+					fprintf(stderr, "invalid interval count: %s\n", optarg);
+					return -2;
+				}
+			}
+			break;
+
+			case 'h':
+			{
+				return 1;
+			}
+
+			default:
+			{
+				return -2;
+			}
+		}
+	}
+
+	if (optind < argc)
+	{
+		fprintf(stderr, "unexpected argument: %s\n", argv[optind]);
+		return -3;
+	}
+
+	if (self->adaptive)
+	{
+		if (self->adaptiveParams.floorMs > self->adaptiveParams.ceilingMs)
+		{
+			fprintf(stderr, "minimum sampling period cannot exceed maximum sampling period\n");
+			return -4;
+		}
+
+		// Start from configured period, kept within adaptive range
+		if (self->samplePeriodMs < self->adaptiveParams.floorMs)
+		{
+			self->samplePeriodMs = self->adaptiveParams.floorMs;
+		}
+		else if (self->samplePeriodMs > self->adaptiveParams.ceilingMs)
+		{
+			self->samplePeriodMs = self->adaptiveParams.ceilingMs;
+		}
+	}
+
+	if ((0u != self->flightWindowMs) && (self->flightWindowMs < self->flightPeriodMs))
+	{
+		fprintf(stderr, "flight recorder window cannot be shorter than it's sampling period\n");
+		return -5;
+	}
+
+	if ((NULL != self->replayPath) && (self->adaptive || (0u != self->flightWindowMs)))
+	{
+		fprintf(stderr, "replay cannot be combined with adaptive mode or flight recorder\n");
+		return -6;
+	}
+
+	if (self->replayFast && (NULL == self->replayPath))
+	{
+		fprintf(stderr, "--replay-fast requires --replay\n");
+		return -6;
+	}
+
+	if ((NULL != self->replayPath) && ((NULL != self->procRoot) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "replay cannot be combined with --proc-root or --cpus\n");
+		return -6;
+	}
+
+	if (self->deltaMode && (NULL != self->recordPath))
+	{
+		fprintf(stderr, "--delta cannot be combined with --record, since raw samples never reach analyzer\n");
+		return -7;
+	}
+
+	// Recordings and flight recorder dumps do not carry ids of selected processors, so they would be mislabeled when read
+	if ((NULL != self->cpuList) && ((NULL != self->replayPath) || (NULL != self->recordPath) || (0u != self->flightWindowMs) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "--cpu-list cannot be combined with --replay, --record, --flight-window or --cpus\n");
+		return -8;
+	}
+
+	if (((0u != self->topCount) || (NULL != self->threadsOf)) && ((NULL != self->replayPath) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "--top and --threads-of cannot be combined with --replay or --cpus, since processes are only tracked live\n");
+		return -9;
+	}
+
+	if ((NULL != self->cgroups) && ((NULL != self->replayPath) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "--cgroups cannot be combined with --replay or --cpus, since cgroups are only tracked live\n");
+		return -10;
+	}
+
+	if ((0u != self->irqHotCount) && ((NULL != self->replayPath) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "--irqs cannot be combined with --replay or --cpus, since interrupts are only tracked live\n");
+		return -11;
+	}
+
+	if ((0u != self->idleFilesPerCpu) && ((NULL != self->replayPath) || (0u != self->cpuCount)))
+	{
+		fprintf(stderr, "--idle cannot be combined with --replay or --cpus, since idle states are only tracked live\n");
+		return -12;
+	}
+
+	if ((NULL != self->threadsOf) && (0u == self->topCount))
+	{
+		self->topCount = CONFIG_DEFAULT_TOP_THREADS;
+	}
+
+	return 0;
+}
+
+
+void Config_printUsage(FILE* stream, const char* programName)
+{
+	fprintf(stream,
+		"Usage: %s [options]\n"
+		"  -p, --period MS    sampling period in milliseconds (%u-%u, default %u)\n"
+		"  -a, --align        align samples to wall-clock multiples of the period\n"
+		"  -A, --adaptive     adapt sampling period to observed changes of load\n"
+		"  -m, --min-period MS\n"
+		"                     shortest period in adaptive mode (default %u)\n"
+		"  -M, --max-period MS\n"
+		"                     longest period in adaptive mode (default %u)\n"
+		"  -t, --threshold PCT\n"
+		"                     usage change tightening the period in adaptive mode (default %.1f)\n"
+		"  -F, --flight-window MS\n"
+		"                     keep this much high-rate history in flight recorder (default 0, disabled)\n"
+		"      --flight-period MS\n"
+		"                     flight recorder sampling period (default %u)\n"
+		"      --flight-threshold PCT\n"
+		"                     single processor usage triggering a dump, 0 to disable (default %.1f)\n"
+		"      --flight-dir DIR\n"
+		"                     directory for flight recorder dumps (default %s)\n"
+		"      --record PATH  record raw samples into compact segment files PATH.NNNNNN.cutrec\n"
+		"      --record-segment-mb MB\n"
+		"                     size at which recording rolls over to next segment (default %u)\n"
+		"      --record-keyframe N\n"
+		"                     samples between recording keyframes (default %u)\n"
+		"      --replay PATH  process snapshots from recording instead of /proc/stat, at original cadence\n"
+		"      --replay-fast  replay snapshots as fast as they can be processed\n"
+		"      --proc-root DIR\n"
+		"                     read DIR/stat instead of /proc/stat, e.g. one written by CpuUsageTrackerProcGen\n"
+		"      --cpus N       assume N processors instead of detecting them\n"
+		"      --no-clear     do not clear the screen before printing statistics\n"
+		"      --catch-up MODE\n"
+		"                     how analyzer processes snapshots it has fallen behind on: none, one at a time,\n"
+		"                     coalesce, into a single interval, or batch, every interval in one pass (default none)\n"
+		"      --delta        pass 32-bit changes of counters from reader to analyzer instead of whole snapshots\n"
+		"      --levels LIST  print usage of comma-separated levels: cpu, core, package, node (default cpu)\n"
+		"      --sys-root DIR\n"
+		"                     read processor topology from DIR/cpu instead of %s/cpu\n"
+		"      --cpu-list LIST\n"
+		"                     track only listed processors, e.g. 0-3,8,16-31, '%s' for affinity mask,\n"
+		"                     '%s' for effective cpuset of own cgroup, or absolute path of a file with the list\n"
+		"      --top N        print N processes using the most of processor time (default 0, disabled)\n"
+		"      --top-slices N\n"
+		"                     spread scan of every process and cgroup across N sampling periods (default %u)\n"
+		"      --threads-of PID|FILE\n"
+		"                     print top threads of process PID, or of one listed in PID file FILE, instead of\n"
+		"                     top processes; --top threads are printed (default %u)\n"
+		"      --cgroups LIST\n"
+		"                     print usage against cpu.max quota and throttling of comma-separated cgroups,\n"
+		"                     relative to %s unless absolute\n"
+		"      --cgroup-subtree\n"
+		"                     track every descendant of listed cgroups as well\n"
+		"      --cgroups-top N\n"
+		"                     print N cgroups using the most of their quota (default %u)\n"
+		"      --irqs N       print N processors handling the most interrupts and softirqs, with their most\n"
+		"                     frequent sources, sampled once per --top-slices periods (default 0, disabled)\n"
+		"      --idle N       print idle state residency and thermal throttling, reading at most N files per\n"
+		"                     processor, deepest states first, across --top-slices periods (default 0, disabled)\n"
+		"      --steal PCT    print time lost to hypervisor and spent running guests apart from own work, with\n"
+		"                     histogram percentile of every processor, flagging ones losing PCT %% or more\n"
+		"                     (default 0, disabled)\n"
+		"      --steal-sustain N\n"
+		"                     intervals steal has to stay at or above --steal PCT to flag a processor, or below\n"
+		"                     half of it to clear one (default %u)\n"
+		"  -h, --help         print this message and exit\n",
+		programName,
+		SAMPLER_MIN_PERIOD_MS,
+		SAMPLER_MAX_PERIOD_MS,
+		CONFIG_DEFAULT_SAMPLE_PERIOD_MS,
+		CONFIG_DEFAULT_ADAPTIVE_FLOOR_MS,
+		CONFIG_DEFAULT_ADAPTIVE_CEILING_MS,
+		CONFIG_DEFAULT_ADAPTIVE_THRESHOLD_PCT,
+		CONFIG_DEFAULT_FLIGHT_PERIOD_MS,
+		CONFIG_DEFAULT_FLIGHT_THRESHOLD_PCT,
+		CONFIG_DEFAULT_FLIGHT_DIRECTORY,
+		CONFIG_DEFAULT_RECORD_SEGMENT_MB,
+		CONFIG_DEFAULT_RECORD_KEYFRAME_INTERVAL,
+		TOPOLOGY_SYS_ROOT_DEFAULT,
+		CPULIST_SPEC_AFFINITY,
+		CPULIST_SPEC_CPUSET,
+		PROCTRACK_DEFAULT_SLICES,
+		CONFIG_DEFAULT_TOP_THREADS,
+		CGTRACK_ROOT_DEFAULT,
+		CONFIG_DEFAULT_TOP_CGROUPS,
+		STEALTRACK_DEFAULT_SUSTAIN);
+}
@@ -0,0 +1,199 @@
+/**
+ * \file config.h
+ * Program configuration and command-line argument parsing.
+*/
+#ifndef CONFIG_H_INCLUDED
+#define CONFIG_H_INCLUDED
+#include <stdbool.h>
+#include <stdio.h>
+#include "sampler.h"
+#include "analyzer.h"
+
+
+/**
+ * Default sampling period of /proc/stat file, in milliseconds.
+*/
+#define CONFIG_DEFAULT_SAMPLE_PERIOD_MS 500u
+
+/**
+ * Default shortest sampling period in adaptive mode, in milliseconds.
+*/
+#define CONFIG_DEFAULT_ADAPTIVE_FLOOR_MS 50u
+
+/**
+ * Default longest sampling period in adaptive mode, in milliseconds.
+*/
+#define CONFIG_DEFAULT_ADAPTIVE_CEILING_MS 5000u
+
+/**
+ * Default usage change threshold in adaptive mode, in percentage points.
+*/
+#define CONFIG_DEFAULT_ADAPTIVE_THRESHOLD_PCT 5.0
+
+/**
+ * Default sampling period of flight recorder, in milliseconds.
+*/
+#define CONFIG_DEFAULT_FLIGHT_PERIOD_MS 20u
+
+/**
+ * Default usage of a single processor triggering flight recorder dump, in percentage.
+*/
+#define CONFIG_DEFAULT_FLIGHT_THRESHOLD_PCT 95.0
+
+/**
+ * Default directory for flight recorder dump files.
+*/
+#define CONFIG_DEFAULT_FLIGHT_DIRECTORY "."
+
+/**
+ * Default size at which recording rolls over to next segment, in mebibytes.
+*/
+#define CONFIG_DEFAULT_RECORD_SEGMENT_MB 64u
+
+/**
+ * Default amount of samples between consecutive recording keyframes.
+*/
+#define CONFIG_DEFAULT_RECORD_KEYFRAME_INTERVAL 60u
+
+/**
+ * Default amount of top consuming threads printed when threads of a process are tracked.
+*/
+#define CONFIG_DEFAULT_TOP_THREADS 10u
+
+/**
+ * Default amount of cgroups using the most of their quota printed when cgroups are tracked.
+*/
+#define CONFIG_DEFAULT_TOP_CGROUPS 10u
+
+
+/**
+ * Program configuration, populated from command-line arguments.
+*/
+typedef struct Config
+{
+	/** Period between consecutive /proc/stat samples, in milliseconds. */
+	unsigned samplePeriodMs;
+
+	/** Whether samples should be aligned to wall-clock multiples of the sampling period. */
+	bool alignToWallClock;
+
+	/** Whether sampling period should adapt to observed changes of load. */
+	bool adaptive;
+
+	/** Adaptive sampling mode parameters. Only used if adaptive mode is enabled. */
+	SamplerAdaptiveParams_t adaptiveParams;
+
+	/** Length of history kept by flight recorder, in milliseconds. Zero disables flight recorder. */
+	unsigned flightWindowMs;
+
+	/** Flight recorder sampling period, in milliseconds. */
+	unsigned flightPeriodMs;
+
+	/** Usage of a single processor triggering flight recorder dump, in percentage. Zero disables the trigger. */
+	double flightThresholdPct;
+
+	/** Directory for flight recorder dump files. */
+	const char* flightDirectory;
+
+	/** Path prefix of recording segment files. NULL disables recording. */
+	const char* recordPath;
+
+	/** Size at which recording rolls over to next segment, in mebibytes. */
+	unsigned recordSegmentMb;
+
+	/** Amount of samples between consecutive recording keyframes. */
+	unsigned recordKeyframeInterval;
+
+	/** Recording to replay instead of reading /proc/stat, segment path or path prefix. NULL disables replay. */
+	const char* replayPath;
+
+	/** Whether recording should be replayed as fast as possible rather than at original cadence. */
+	bool replayFast;
+
+	/** Directory to read "stat" file from instead of /proc. NULL reads /proc/stat. */
+	const char* procRoot;
+
+	/** Amount of processors to assume instead of detecting it. Zero detects processor count. */
+	unsigned cpuCount;
+
+	/** Whether screen should be cleared before printing every set of statistics. */
+	bool clearScreen;
+
+	/** Way analyzer processes backlog of snapshots it has fallen behind on. */
+	AnalyzerCatchUp_t catchUp;
+
+	/** Whether reader should pass changes between snapshots to analyzer, rather than snapshots themselves. */
+	bool deltaMode;
+
+	/** Whether usage of every logical processor should be printed. */
+	bool printCpus;
+
+	/** Topology levels usage of which should be printed, as combination of TOPOLOGY_LEVEL_BIT() values. */
+	unsigned rollupLevels;
+
+	/** Directory to read processor topology from instead of /sys/devices/system. NULL reads the default one. */
+	const char* sysRoot;
+
+	/** Specification of tracked processors, as accepted by CpuList_fromSpec(). NULL tracks every processor. */
+	const char* cpuList;
+
+	/** Amount of top consuming processes to print. Zero disables per-process tracking. */
+	unsigned topCount;
+
+	/** Amount of sampling periods a scan of every process is spread across. */
+	unsigned topSlices;
+
+	/** Process identifier or PID file path threads of which should be tracked instead of processes. NULL tracks processes. */
+	const char* threadsOf;
+
+	/** Comma-separated paths of cgroups to track, relative to CGTRACK_ROOT_DEFAULT unless absolute. NULL disables cgroup tracking. */
+	const char* cgroups;
+
+	/** Whether every descendant of listed cgroups should be tracked as well. */
+	bool cgroupSubtree;
+
+	/** Amount of cgroups using the most of their quota to print. */
+	unsigned cgroupTopCount;
+
+	/** Amount of processors handling the most interrupts to print, along with their top sources. Zero disables interrupt tracking. */
+	unsigned irqHotCount;
+
+	/** Largest amount of idle state and thermal throttling files to read per processor. Zero disables idle state tracking. */
+	unsigned idleFilesPerCpu;
+
+	/** Steal of a processor, in percent, flagging it once sustained. Zero disables steal tracking. */
+	unsigned stealThresholdPct;
+
+	/** Amount of consecutive intervals steal has to stay past threshold for, to flag or clear a processor. */
+	unsigned stealSustain;
+}
+Config_t;
+
+
+/**
+ * \brief Fills given configuration structure with default values.
+ * \param self Configuration to initialize.
+*/
+void Config_setDefaults(Config_t* self);
+
+
+/**
+ * \brief Parses command-line arguments into given configuration structure.
+ * Options not present in arguments are left unchanged.
+ * \param self Configuration to be filled.
+ * \param argc Argument count, as received by main().
+ * \param argv Argument vector, as received by main().
+ * \return 0 if successful, 1 if help has been requested, negative value if arguments are invalid.
+*/
+int Config_parseArgs(Config_t* self, int argc, char* argv[]);
+
+
+/**
+ * \brief Prints description of accepted command-line arguments.
+ * \param stream Stream to print into.
+ * \param programName Name of the executable, usually argv[0].
+*/
+void Config_printUsage(FILE* stream, const char* programName);
+
+
+#endif // !CONFIG_H_INCLUDED
@@ -1,11 +1,14 @@
 #include "cpucount.h"
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <sys/sysinfo.h>
 
 
 static atomic_int g_cpuCount;
 static atomic_bool g_cpuCountInitialized = false;
+// Only set before any thread is started
+static const uint32_t* g_cpuSelection = NULL;
 
 
 void CpuCount_init(void)
@@ -15,11 +18,54 @@ void CpuCount_init(void)
 		return;
 	}
 
-	g_cpuCount = get_nprocs();
+	// Configured rather than online processors, so that ones brought online later have slots of their own
+	g_cpuCount = get_nprocs_conf();
 	g_cpuCountInitialized = true;
 }
 
 
+void CpuCount_override(int cpuCount)
+{
+	if (0 >= cpuCount)
+	{
+		return;
+	}
+
+	g_cpuCount = cpuCount;
+	g_cpuCountInitialized = true;
+}
+
+
+void CpuCount_select(const uint32_t* cpuIds, size_t count)
+{
+	if (NULL == cpuIds)
+	{
+		g_cpuSelection = NULL;
+		return;
+	}
+
+	if ((0u == count) || (count > INT_MAX))
+	{
+		return;
+	}
+
+	g_cpuSelection = cpuIds;
+	CpuCount_override((int) count);
+}
+
+
+const uint32_t* CpuCount_getSelection(void)
+{
+	return g_cpuSelection;
+}
+
+
+int CpuCount_getCpuId(int index)
+{
+	return (NULL != g_cpuSelection) ? (int) g_cpuSelection[index] : index;
+}
+
+
 int CpuCount_get(void)
 {
 	return g_cpuCount;
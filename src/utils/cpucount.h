@@ -4,15 +4,56 @@
 */
 #ifndef CPUCOUNT_H_INCLUDED
 #define CPUCOUNT_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
 
 
 /**
  * \brief Initializes CPU count with information retrieved from system.
+ * Every configured processor is counted, whether online or not, so that processors coming online
+ * while the program runs are tracked without resizing any buffer.
  * \warning This function is NOT thread-safe and should never be called from many threads.
 */
 void CpuCount_init(void);
 
 
+/**
+ * \brief Initializes CPU count with given value instead of one retrieved from system.
+ * Used when processed data does not come from this system, e.g. while replaying recordings.
+ * Subsequent calls to CpuCount_init() have no effect.
+ * \warning This function is NOT thread-safe and should be called before any other module is initialized.
+ * \param cpuCount Amount of logical processors to assume, at least 1.
+*/
+void CpuCount_override(int cpuCount);
+
+
+/**
+ * \brief Restricts processors tracked throughout the program to given ones, so that CpuCount_get() retrieves their amount
+ * and CpuCount_getCpuId() their numbers. Subsequent calls to CpuCount_init() have no effect.
+ * \warning This function is NOT thread-safe and should be called before any other module is initialized.
+ * Given array is not copied and has to outlive every module using processor count.
+ * \param cpuIds Numbers of tracked processors, as N in "cpuN" lines of /proc/stat, in ascending order.
+ * NULL lifts the restriction, leaving processor count unchanged.
+ * \param count Amount of tracked processors, at least 1.
+*/
+void CpuCount_select(const uint32_t* cpuIds, size_t count);
+
+
+/**
+ * \brief Retrieves numbers of tracked processors, if they have been restricted with CpuCount_select().
+ * \return Array of CpuCount_get() processor numbers, NULL if every processor is tracked.
+*/
+const uint32_t* CpuCount_getSelection(void);
+
+
+/**
+ * \brief Retrieves number of tracked processor with given index, as N in it's "cpuN" line of /proc/stat.
+ * \param index Index of processor, in 0 to CpuCount_get() - 1 range.
+ * \return Processor number, equal to index unless processors have been restricted with CpuCount_select().
+*/
+int CpuCount_getCpuId(int index);
+
+
 /**
  * \brief Retreives amount of available processors. This function is thread-safe.
  * \warning CpuCount_init has be to called at least once before using this function,
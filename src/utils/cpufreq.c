@@ -0,0 +1,284 @@
+#include "cpufreq.h"
+#include "cpucount.h"
+#include "helpers.h"
+#include "batchread.h"
+#include "topology.h"
+#include "logger.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// Frequencies are single numbers in kHz
+#define CPUFREQ_FILE_MAX 		32u
+#define CPUFREQ_BP_FULL 		10000u
+// Samples after which files of processors that could not be read are opened again
+#define CPUFREQ_REOPEN_SAMPLES 	64u
+
+
+struct CpuFreqSampler
+{
+	/** Directory containing "cpu" sysfs directory. */
+	char 			sysRoot[PATH_MAX];
+	/** Amount of tracked processors. */
+	size_t 			cpuCount;
+	/** Maximum frequency of every tracked processor in kHz, 0 if it has not been read yet. */
+	unsigned long* 	maxKHz;
+	/** Descriptors of scaling_cur_freq file of every tracked processor, negative if not open. */
+	int* 			fds;
+	/** Whether any processor has it's file closed. */
+	bool 			anyClosed;
+	/** Samples taken since files have last been opened again. */
+	unsigned 		samplesSinceReopen;
+	/** Reader of frequency files, along with a buffer, a request and a processor index for every read. */
+	BatchReader_t* 	reader;
+	char* 			buffers;
+	BatchReadRequest_t* requests;
+	size_t* 		requestCpus;
+};
+
+
+/**
+ * \brief Parses single frequency in kHz, as written into cpufreq files.
+ * \return Frequency, 0 if file does not hold a number.
+*/
+static unsigned long parseKHz(const char* text)
+{
+	char* end;
+	const unsigned long value = strtoul(text, &end, 10);
+	return (end != text) ? value : 0u;
+}
+
+
+/**
+ * \brief Opens current frequency file of tracked processor of given index, reading it's maximum frequency first if needed.
+ * \return True if file has been opened, false otherwise.
+*/
+static bool openCpu(CpuFreqSampler_t* self, size_t index)
+{
+	char path[PATH_MAX];
+	const int cpuId = CpuCount_getCpuId((int) index);
+
+	if (0u == self->maxKHz[index])
+	{
+		char text[CPUFREQ_FILE_MAX];
+
+		if (((size_t) snprintf(path, sizeof(path), "%s/cpu/cpu%d/cpufreq/cpuinfo_max_freq", self->sysRoot, cpuId) >= sizeof(path)) ||
+			(0 >= ReadFileContent(path, text, sizeof(text))))
+		{
+			return false;
+		}
+
+		self->maxKHz[index] = parseKHz(text);
+
+		if (0u == self->maxKHz[index])
+		{
+			return false;
+		}
+	}
+
+	if ((size_t) snprintf(path, sizeof(path), "%s/cpu/cpu%d/cpufreq/scaling_cur_freq", self->sysRoot, cpuId) >= sizeof(path))
+	{
+		return false;
+	}
+
+	self->fds[index] = open(path, O_RDONLY);
+	return 0 <= self->fds[index];
+}
+
+
+/**
+ * \brief Attempts to open files of every processor that does not have it's file open.
+ * \return Amount of processors having their file open.
+*/
+static size_t openClosed(CpuFreqSampler_t* self)
+{
+	size_t opened = 0u;
+	self->anyClosed = false;
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		if ((0 <= self->fds[ii]) || openCpu(self, ii))
+		{
+			++opened;
+		}
+		else
+		{
+			self->anyClosed = true;
+		}
+	}
+
+	return opened;
+}
+
+
+CpuFreqSampler_t* CpuFreqSampler_create(const char* sysRoot)
+{
+	if (NULL == sysRoot)
+	{
+		sysRoot = TOPOLOGY_SYS_ROOT_DEFAULT;
+	}
+
+	CpuFreqSampler_t* self = calloc(1u, sizeof(CpuFreqSampler_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	if (strlen(sysRoot) >= sizeof(self->sysRoot))
+	{
+		goto error_exit_2;
+	}
+
+	strcpy(self->sysRoot, sysRoot);
+	self->cpuCount 		= (size_t) CpuCount_get();
+	self->maxKHz 		= calloc(self->cpuCount, sizeof(unsigned long));
+	self->fds 			= malloc(self->cpuCount * sizeof(int));
+	self->buffers 		= malloc(self->cpuCount * CPUFREQ_FILE_MAX);
+	self->requests 		= malloc(self->cpuCount * sizeof(BatchReadRequest_t));
+	self->requestCpus 	= malloc(self->cpuCount * sizeof(size_t));
+
+	for (size_t ii = 0; (NULL != self->fds) && (ii < self->cpuCount); ++ii)
+	{
+		self->fds[ii] = -1;
+	}
+
+	if ((NULL == self->maxKHz) || (NULL == self->fds) || (NULL == self->buffers) ||
+		(NULL == self->requests) || (NULL == self->requestCpus))
+	{
+		goto error_exit_3;
+	}
+
+	if (0u == openClosed(self))
+	{
+		Log(LLEVEL_INFO, "no cpufreq data under %s, processor frequencies are not sampled", self->sysRoot);
+		goto error_exit_3;
+	}
+
+	self->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_AUTO);
+
+	if (NULL == self->reader)
+	{
+		goto error_exit_3;
+	}
+
+	return self;
+
+error_exit_3:
+	CpuFreqSampler_destroy(self);
+	return NULL;
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void CpuFreqSampler_destroy(CpuFreqSampler_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; (NULL != self->fds) && (ii < self->cpuCount); ++ii)
+	{
+		if (0 <= self->fds[ii])
+		{
+			close(self->fds[ii]);
+		}
+	}
+
+	BatchReader_destroy(self->reader);
+	free(self->requestCpus);
+	free(self->requests);
+	free(self->buffers);
+	free(self->fds);
+	free(self->maxKHz);
+	free(self);
+}
+
+
+bool CpuFreqSampler_read(CpuFreqSampler_t* self, CpuFreqValue_t* out)
+{
+	if ((NULL == self) || (NULL == out))
+	{
+		return false;
+	}
+
+	// Processors brought online, or ones whose driver has been loaded, are picked up after a while
+	if (self->anyClosed && (++self->samplesSinceReopen >= CPUFREQ_REOPEN_SAMPLES))
+	{
+		self->samplesSinceReopen = 0u;
+		openClosed(self);
+	}
+
+	size_t count = 0u;
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		out[ii + 1u] = CPUFREQ_UNKNOWN;
+
+		if (0 <= self->fds[ii])
+		{
+			// One byte is left for terminating null character
+			self->requests[count] = (BatchReadRequest_t)
+			{
+				.fd 	= self->fds[ii],
+				.buf 	= self->buffers + count * CPUFREQ_FILE_MAX,
+				.size 	= CPUFREQ_FILE_MAX - 1u
+			};
+			self->requestCpus[count++] = ii;
+		}
+	}
+
+	out[0] = CPUFREQ_UNKNOWN;
+
+	if ((0u == count) || (0 != BatchReader_read(self->reader, self->requests, count)))
+	{
+		return false;
+	}
+
+	unsigned long sum = 0u;
+	unsigned long known = 0u;
+
+	for (size_t kk = 0; kk < count; ++kk)
+	{
+		BatchReadRequest_t* request = &self->requests[kk];
+		const size_t index = self->requestCpus[kk];
+		unsigned long kHz = 0u;
+
+		if (0 < request->result)
+		{
+			request->buf[request->result] = '\0';
+			kHz = parseKHz(request->buf);
+		}
+
+		if (0u == kHz)
+		{
+			// Reads fail once processor goes offline, until it is back and it's file is opened again
+			close(self->fds[index]);
+			self->fds[index] = -1;
+			self->anyClosed = true;
+			continue;
+		}
+
+		// Boost frequencies above the advertised maximum count as full capacity
+		const unsigned long long bp = ((unsigned long long) kHz * CPUFREQ_BP_FULL + self->maxKHz[index] / 2u) / self->maxKHz[index];
+		out[index + 1u] = (CpuFreqValue_t) ((bp > CPUFREQ_BP_FULL) ? CPUFREQ_BP_FULL : bp);
+		sum += out[index + 1u];
+		++known;
+	}
+
+	if (0u == known)
+	{
+		return false;
+	}
+
+	out[0] = (CpuFreqValue_t) ((sum + known / 2u) / known);
+	return true;
+}
@@ -0,0 +1,42 @@
+/**
+ * \file cpufreq.h
+ * Sampling of current frequency of every tracked processor, relative to it's maximum, from scaling_cur_freq
+ * files of cpufreq sysfs directories kept open between samples.
+*/
+#ifndef CPUFREQ_H_INCLUDED
+#define CPUFREQ_H_INCLUDED
+#include "procstat.h"
+#include <stdbool.h>
+
+
+typedef struct CpuFreqSampler CpuFreqSampler_t;
+
+
+/**
+ * \brief Creates frequency sampler of processors tracked at the time of the call, see CpuCount_getCpuId().
+ * Maximum frequency of every processor is read once, from it's cpuinfo_max_freq file.
+ * \param sysRoot Directory containing "cpu" sysfs directory, NULL for TOPOLOGY_SYS_ROOT_DEFAULT.
+ * \return Pointer to sampler if successful, NULL if no tracked processor has cpufreq directory or allocation fails.
+*/
+CpuFreqSampler_t* CpuFreqSampler_create(const char* sysRoot);
+
+
+/**
+ * \brief Destroys frequency sampler, closing every file descriptor. Does nothing if NULL.
+ * \param self Sampler to destroy.
+*/
+void CpuFreqSampler_destroy(CpuFreqSampler_t* self);
+
+
+/**
+ * \brief Reads current frequency of every tracked processor in a single batch, through BatchReader.
+ * Processors file of which cannot be read, as is the case for offline ones, are reopened every few samples.
+ * \param self Sampler.
+ * \param out Array of one more frequency than there are tracked processors, laid out as ProcStat_getFreqs() one:
+ * mean frequency of processors it is known for first, CPUFREQ_UNKNOWN for processors it is not known for.
+ * \return True if frequency of at least one processor is known, false otherwise.
+*/
+bool CpuFreqSampler_read(CpuFreqSampler_t* self, CpuFreqValue_t* out);
+
+
+#endif // !CPUFREQ_H_INCLUDED
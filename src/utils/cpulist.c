@@ -0,0 +1,291 @@
+#define _GNU_SOURCE
+#include "cpulist.h"
+#include "helpers.h"
+#include <ctype.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define CPULIST_FILE_MAX 			65536u
+#define PROC_SELF_CGROUP 			"/proc/self/cgroup"
+#define CGROUP_ROOT 				"/sys/fs/cgroup"
+#define CGROUP_V2_CPUSET_FILE 		"cpuset.cpus.effective"
+#define CGROUP_V1_CPUSET_FILE 		"cpuset.effective_cpus"
+#define CGROUP_LINE_MAX 			PATH_MAX
+
+
+/**
+ * \brief Parses processor number, advancing given pointer past it.
+ * \return True if successful, false if there is no number or it is out of range.
+*/
+static bool parseCpuNumber(const char** str, uint32_t* out)
+{
+	const char* p = *str;
+	unsigned long value = 0u;
+
+	if (!isdigit((unsigned char) *p))
+	{
+		return false;
+	}
+
+	while (isdigit((unsigned char) *p))
+	{
+		value = value * 10u + (unsigned long) (*p - '0');
+
+		if (value > CPULIST_MAX_CPU)
+		{
+			return false;
+		}
+
+		++p;
+	}
+
+	*str = p;
+	*out = (uint32_t) value;
+	return true;
+}
+
+
+/**
+ * \brief Creates CPU list of processors marked in given map.
+ * \param selected Array of CPULIST_MAX_CPU + 1 flags.
+ * \return Pointer to CPU list if successful, NULL if no processor is marked or allocation fails.
+*/
+static CpuList_t* fromMap(const bool* selected)
+{
+	size_t length = 0u;
+
+	for (size_t ii = 0; ii <= CPULIST_MAX_CPU; ++ii)
+	{
+		length += selected[ii] ? 1u : 0u;
+	}
+
+	if (0u == length)
+	{
+		return NULL;
+	}
+
+	CpuList_t* self = malloc(sizeof(CpuList_t) + length * sizeof(uint32_t));
+
+	if (NULL == self)
+	{
+		return NULL;
+	}
+
+	self->length = 0u;
+
+	for (uint32_t ii = 0; ii <= CPULIST_MAX_CPU; ++ii)
+	{
+		if (selected[ii])
+		{
+			self->cpus[self->length++] = ii;
+		}
+	}
+
+	return self;
+}
+
+
+CpuList_t* CpuList_parse(const char* text)
+{
+	if (NULL == text)
+	{
+		return NULL;
+	}
+
+	bool* selected = calloc(CPULIST_MAX_CPU + 1u, sizeof(bool));
+
+	if (NULL == selected)
+	{
+		return NULL;
+	}
+
+	const char* p = text;
+
+	while (isspace((unsigned char) *p))
+	{
+		++p;
+	}
+
+	// Kernel writes empty line for empty set, which selects nothing
+	while (('\0' != *p) && !isspace((unsigned char) *p))
+	{
+		uint32_t first;
+		uint32_t last;
+
+		if (!parseCpuNumber(&p, &first))
+		{
+			goto error_exit;
+		}
+
+		last = first;
+
+		if ('-' == *p)
+		{
+			++p;
+
+			if (!parseCpuNumber(&p, &last) || (last < first))
+			{
+				goto error_exit;
+			}
+		}
+
+		for (uint32_t ii = first; ii <= last; ++ii)
+		{
+			selected[ii] = true;
+		}
+
+		if (',' == *p)
+		{
+			++p;
+
+			if (!isdigit((unsigned char) *p))
+			{
+				goto error_exit;
+			}
+		}
+		else if (('\0' != *p) && !isspace((unsigned char) *p))
+		{
+			goto error_exit;
+		}
+	}
+
+	while (isspace((unsigned char) *p))
+	{
+		++p;
+	}
+
+	if ('\0' != *p)
+	{
+		goto error_exit;
+	}
+
+	CpuList_t* self = fromMap(selected);
+	free(selected);
+	return self;
+
+error_exit:
+	free(selected);
+	return NULL;
+}
+
+
+CpuList_t* CpuList_fromAffinity(void)
+{
+	const size_t setSize = CPU_ALLOC_SIZE(CPULIST_MAX_CPU + 1u);
+	cpu_set_t* set = CPU_ALLOC(CPULIST_MAX_CPU + 1u);
+	bool* selected = calloc(CPULIST_MAX_CPU + 1u, sizeof(bool));
+	CpuList_t* self = NULL;
+
+	if ((NULL != set) && (NULL != selected) && (0 == sched_getaffinity(0, setSize, set)))
+	{
+		for (size_t ii = 0; ii <= CPULIST_MAX_CPU; ++ii)
+		{
+			selected[ii] = CPU_ISSET_S(ii, setSize, set);
+		}
+
+		self = fromMap(selected);
+	}
+
+	free(selected);
+	CPU_FREE(set);
+	return self;
+}
+
+
+CpuList_t* CpuList_fromFile(const char* path)
+{
+	if (NULL == path)
+	{
+		return NULL;
+	}
+
+	char* content = malloc(CPULIST_FILE_MAX);
+
+	if (NULL == content)
+	{
+		return NULL;
+	}
+
+	CpuList_t* self = (0 <= ReadFileContent(path, content, CPULIST_FILE_MAX)) ? CpuList_parse(content) : NULL;
+	free(content);
+	return self;
+}
+
+
+/**
+ * \brief Creates CPU list from effective cpuset of cgroup the program runs in, trying unified hierarchy first.
+ * \return Pointer to set of processors if successful, NULL otherwise.
+*/
+static CpuList_t* fromCpuset(void)
+{
+	FILE* fp = fopen(PROC_SELF_CGROUP, "r");
+
+	if (NULL == fp)
+	{
+		return NULL;
+	}
+
+	char line[CGROUP_LINE_MAX];
+	char path[PATH_MAX + sizeof(CGROUP_ROOT "/cpuset/" CGROUP_V1_CPUSET_FILE)];
+	CpuList_t* self = NULL;
+	CpuList_t* legacy = NULL;
+
+	// Lines have "hierarchy-ID:controller-list:cgroup-path" format, unified hierarchy has ID 0 and no controllers
+	while ((NULL == self) && (NULL != fgets(line, sizeof(line), fp)))
+	{
+		line[strcspn(line, "\n")] = '\0';
+
+		if (0 == strncmp(line, "0::", 3u))
+		{
+			snprintf(path, sizeof(path), CGROUP_ROOT "%s/" CGROUP_V2_CPUSET_FILE, line + 3);
+			self = CpuList_fromFile(path);
+		}
+		else if ((NULL == legacy) && (NULL != strstr(line, ":cpuset:")))
+		{
+			snprintf(path, sizeof(path), CGROUP_ROOT "/cpuset%s/" CGROUP_V1_CPUSET_FILE, strstr(line, ":cpuset:") + 8);
+			legacy = CpuList_fromFile(path);
+		}
+	}
+
+	fclose(fp);
+
+	if (NULL != self)
+	{
+		CpuList_destroy(legacy);
+		return self;
+	}
+
+	return legacy;
+}
+
+
+CpuList_t* CpuList_fromSpec(const char* spec)
+{
+	if (NULL == spec)
+	{
+		return NULL;
+	}
+
+	if (0 == strcmp(spec, CPULIST_SPEC_AFFINITY))
+	{
+		return CpuList_fromAffinity();
+	}
+
+	if (0 == strcmp(spec, CPULIST_SPEC_CPUSET))
+	{
+		return fromCpuset();
+	}
+
+	return ('/' == spec[0]) ? CpuList_fromFile(spec) : CpuList_parse(spec);
+}
+
+
+void CpuList_destroy(CpuList_t* self)
+{
+	free(self);
+}
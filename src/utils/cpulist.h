@@ -0,0 +1,81 @@
+/**
+ * \file cpulist.h
+ * Sets of logical processors, as written in kernel CPU list format, e.g. "0-3,8,16-31".
+*/
+#ifndef CPULIST_H_INCLUDED
+#define CPULIST_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Largest processor number accepted in CPU lists.
+*/
+#define CPULIST_MAX_CPU 65535u
+
+/**
+ * Specification of CPU list taken from affinity mask of the calling thread.
+*/
+#define CPULIST_SPEC_AFFINITY "affinity"
+
+/**
+ * Specification of CPU list taken from effective cpuset of cgroup the program runs in.
+*/
+#define CPULIST_SPEC_CPUSET "cpuset"
+
+
+/**
+ * Set of logical processors, listed in ascending order without repetitions.
+*/
+typedef struct CpuList
+{
+	/** Amount of processors in the set. */
+	size_t length;
+	/** Numbers of processors, as N in "cpuN" lines of /proc/stat. */
+	uint32_t cpus[];
+}
+CpuList_t;
+
+
+/**
+ * \brief Parses CPU list, comma-separated processor numbers and inclusive ranges of them, e.g. "0-3,8,16-31".
+ * Surrounding whitespace is ignored, repeated and overlapping entries are merged.
+ * \param text CPU list to parse.
+ * \return Pointer to non-empty set of processors if successful, NULL if text is malformed or empty.
+*/
+CpuList_t* CpuList_parse(const char* text);
+
+
+/**
+ * \brief Creates CPU list from processors given thread is allowed to run on, as reported by sched_getaffinity().
+ * \return Pointer to set of processors if successful, NULL otherwise.
+*/
+CpuList_t* CpuList_fromAffinity(void);
+
+
+/**
+ * \brief Creates CPU list from file containing one, such as cpuset.cpus.effective of cgroup
+ * or /sys/devices/system/cpu/isolated.
+ * \param path Path of the file.
+ * \return Pointer to set of processors if successful, NULL if file cannot be read or does not contain valid list.
+*/
+CpuList_t* CpuList_fromFile(const char* path);
+
+
+/**
+ * \brief Creates CPU list from specification: CPULIST_SPEC_AFFINITY, CPULIST_SPEC_CPUSET,
+ * absolute path of a file containing CPU list, or CPU list itself.
+ * \param spec Specification of CPU list.
+ * \return Pointer to set of processors if successful, NULL otherwise.
+*/
+CpuList_t* CpuList_fromSpec(const char* spec);
+
+
+/**
+ * \brief Destroys CPU list. Does nothing if NULL.
+ * \param self CPU list to destroy.
+*/
+void CpuList_destroy(CpuList_t* self);
+
+
+#endif // !CPULIST_H_INCLUDED
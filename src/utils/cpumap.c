@@ -0,0 +1,176 @@
+#include "cpumap.h"
+#include "topology.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+#define CPUMAP_FILE_MAX 		4096u
+#define ONLINE_FILE_NAME 		"/cpu/online"
+#define POSSIBLE_FILE_NAME 		"/cpu/possible"
+
+
+struct CpuMap
+{
+	/** Path of the file listing online processors. */
+	char 		path[PATH_MAX];
+	/** Contents of the file as of the last refresh, compared with instead of parsing it on every refresh. */
+	char 		text[CPUMAP_FILE_MAX];
+	/** Online processors as of the last refresh. */
+	CpuList_t* 	online;
+	/** Amount of changes of online processor set observed so far. */
+	uint32_t 	epoch;
+};
+
+
+/**
+ * \brief Reads short sysfs file into given buffer, terminating it's contents.
+ * Unlike ReadFileContent(), does not log errors, since file is read at every sample.
+ * \return True if successful, false if file cannot be read or does not fit in the buffer.
+*/
+static bool readShortFile(const char* path, char* buf, size_t bufSize)
+{
+	const int fd = open(path, O_RDONLY);
+
+	if (0 > fd)
+	{
+		return false;
+	}
+
+	const ssize_t length = read(fd, buf, bufSize);
+	close(fd);
+
+	if ((0 > length) || ((size_t) length >= bufSize))
+	{
+		return false;
+	}
+
+	buf[length] = '\0';
+	return true;
+}
+
+
+CpuMap_t* CpuMap_create(const char* sysRoot)
+{
+	if (NULL == sysRoot)
+	{
+		sysRoot = TOPOLOGY_SYS_ROOT_DEFAULT;
+	}
+
+	CpuMap_t* self = calloc(1u, sizeof(CpuMap_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	if ((size_t) snprintf(self->path, sizeof(self->path), "%s" ONLINE_FILE_NAME, sysRoot) >= sizeof(self->path))
+	{
+		goto error_exit_2;
+	}
+
+	if (!readShortFile(self->path, self->text, sizeof(self->text)))
+	{
+		goto error_exit_2;
+	}
+
+	self->online = CpuList_parse(self->text);
+
+	if (NULL == self->online)
+	{
+		goto error_exit_2;
+	}
+
+	return self;
+
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void CpuMap_destroy(CpuMap_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	CpuList_destroy(self->online);
+	free(self);
+}
+
+
+int CpuMap_refresh(CpuMap_t* self)
+{
+	if (NULL == self)
+	{
+		return -1;
+	}
+
+	char text[CPUMAP_FILE_MAX];
+
+	if (!readShortFile(self->path, text, sizeof(text)))
+	{
+		return -2;
+	}
+
+	if (0 == strcmp(text, self->text))
+	{
+		return 0;
+	}
+
+	CpuList_t* online = CpuList_parse(text);
+
+	if (NULL == online)
+	{
+		return -3;
+	}
+
+	CpuList_destroy(self->online);
+	self->online = online;
+	strcpy(self->text, text);
+	++self->epoch;
+	return 1;
+}
+
+
+uint32_t CpuMap_getEpoch(const CpuMap_t* self)
+{
+	return (NULL != self) ? self->epoch : 0u;
+}
+
+
+const CpuList_t* CpuMap_getOnline(const CpuMap_t* self)
+{
+	return (NULL != self) ? self->online : NULL;
+}
+
+
+int CpuMap_getPossibleCount(const char* sysRoot)
+{
+	char path[PATH_MAX];
+
+	if ((size_t) snprintf(path, sizeof(path), "%s" POSSIBLE_FILE_NAME,
+		(NULL != sysRoot) ? sysRoot : TOPOLOGY_SYS_ROOT_DEFAULT) >= sizeof(path))
+	{
+		return 0;
+	}
+
+	CpuList_t* possible = CpuList_fromFile(path);
+
+	if (NULL == possible)
+	{
+		return 0;
+	}
+
+	// Processors are listed in ascending order
+	const int count = (int) possible->cpus[possible->length - 1u] + 1;
+	CpuList_destroy(possible);
+	return count;
+}
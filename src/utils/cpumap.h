@@ -0,0 +1,64 @@
+/**
+ * \file cpumap.h
+ * Tracking of online processor set, as listed in /sys/devices/system/cpu/online, while processors are hot-plugged.
+*/
+#ifndef CPUMAP_H_INCLUDED
+#define CPUMAP_H_INCLUDED
+#include "cpulist.h"
+#include <stdint.h>
+
+
+typedef struct CpuMap CpuMap_t;
+
+
+/**
+ * \brief Creates map of online processors, reading their current set.
+ * \param sysRoot Directory containing "cpu" sysfs directory, NULL for TOPOLOGY_SYS_ROOT_DEFAULT.
+ * \return Pointer to map if successful, NULL if online processor set cannot be read or allocation fails.
+*/
+CpuMap_t* CpuMap_create(const char* sysRoot);
+
+
+/**
+ * \brief Destroys map of online processors. Does nothing if NULL.
+ * \param self Map to destroy.
+*/
+void CpuMap_destroy(CpuMap_t* self);
+
+
+/**
+ * \brief Reads online processor set again, advancing epoch if it has changed.
+ * Costs a single read of a short file and comparison of it's contents if set is unchanged.
+ * \param self Map to refresh.
+ * \return 1 if set has changed, 0 if it has not, negative value if it cannot be read, in which case map is unchanged.
+*/
+int CpuMap_refresh(CpuMap_t* self);
+
+
+/**
+ * \brief Retrieves epoch of online processor set, starting from 0 and advanced by every change of the set.
+ * Stamped into snapshots, so that every stage of the pipeline sees the change at the same snapshot.
+ * \param self Map to query.
+ * \return Current epoch.
+*/
+uint32_t CpuMap_getEpoch(const CpuMap_t* self);
+
+
+/**
+ * \brief Retrieves set of online processors as of the last refresh.
+ * \param self Map to query.
+ * \return Set of online processors, valid until the next refresh.
+*/
+const CpuList_t* CpuMap_getOnline(const CpuMap_t* self);
+
+
+/**
+ * \brief Retrieves amount of processor slots needed to track every processor that may ever come online,
+ * one past the highest processor number listed in /sys/devices/system/cpu/possible.
+ * \param sysRoot Directory containing "cpu" sysfs directory, NULL for TOPOLOGY_SYS_ROOT_DEFAULT.
+ * \return Amount of processor slots, 0 if possible processor set cannot be read.
+*/
+int CpuMap_getPossibleCount(const char* sysRoot);
+
+
+#endif // !CPUMAP_H_INCLUDED
@@ -1,11 +1,112 @@
 #include "cpuusage.h"
 #include "cpucount.h"
 #include "procstat.h"
+#include <stdbool.h>
 #include <stdio.h>
 
 
+#define PERCENTAGE_VALUE_FORMAT "%.2f"
+
+
+/** Whether compact statistics have room for frequency-weighted usage, see CpuUsageCompact_reserveEffective(). */
+static bool effectiveReserved = false;
+
+
+/**
+ * \brief Sums time processor has spent idle and in total, as of given measurement.
+ * \param stat Processor state time unit measurement.
+ * \param idle Pointer to write idle time into.
+ * \param total Pointer to write total time into.
+*/
+static inline void sumCpuTimes(const CpuStat_t* stat, CpuStatValue_t* idle, CpuStatValue_t* total)
+{
+	const CpuStatValue_t idleTime = stat->values[CSINDEX_IDLE] + stat->values[CSINDEX_IOWAIT];
+
+	const CpuStatValue_t nonIdleTime =
+		stat->values[CSINDEX_USER] +
+		stat->values[CSINDEX_NICE] +
+		stat->values[CSINDEX_SYSTEM] +
+		stat->values[CSINDEX_IRQ] +
+		stat->values[CSINDEX_SOFTIRQ] +
+		stat->values[CSINDEX_STEAL];
+
+	*idle = idleTime;
+	*total = idleTime + nonIdleTime;
+}
+
+
+/**
+ * \brief Calculates CPU usage percentage from time spent idle and in total over measurement period.
+ * Formula taken from https://stackoverflow.com/a/23376195.
+ * \return Processor usage as percentage value in 0-100 range, negative if no time has passed over the period.
+*/
+static inline PercentageValue_t usageFromChanges(CpuStatValue_t idled, CpuStatValue_t totald)
+{
+	static const double ERROR_VAL = -1.0;
+
+	PercentageValue_t result = (totald != 0.0) ? ((double) totald - idled) / totald : ERROR_VAL;
+	// Adjust from fraction to percentage
+	return result * 100.0;
+}
+
+
+/**
+ * \brief Calculates CPU usage in basis points from time spent idle and in total over measurement period,
+ * using integer arithmetic only. Rounds to nearest, as printing percentage with two decimal places does.
+ * \return Processor usage in 0-10000 range, CPUUSAGE_BP_INVALID if no time has passed over the period.
+*/
+static inline BasisPointValue_t basisPointsFromChanges(CpuStatValue_t idled, CpuStatValue_t totald)
+{
+	// Counters going backwards leave no meaningful usage either
+	if ((0u == totald) || (idled > totald))
+	{
+		return CPUUSAGE_BP_INVALID;
+	}
+
+	// Interval changes are far below 2^50, so multiplication cannot overflow
+	return (BasisPointValue_t) (((totald - idled) * CPUUSAGE_BP_FULL + totald / 2u) / totald);
+}
+
+
+/**
+ * \brief Calculates CPU usage percentage from idle and total times at the start and end of measurement period.
+ * \return Processor usage as percentage value in 0-100 range, negative if no time has passed between measurements
+ * or processor has been offline at either of them.
+*/
+static inline PercentageValue_t usageFromTimes(CpuStatValue_t prevIdle, CpuStatValue_t prevTotal, CpuStatValue_t idle, CpuStatValue_t total)
+{
+	// Offline processors have every time zeroed
+	return ((0u == prevTotal) || (total < prevTotal)) ? usageFromChanges(0u, 0u) : usageFromChanges(idle - prevIdle, total - prevTotal);
+}
+
+
+/**
+ * \brief Calculates CPU usage in basis points from idle and total times at the start and end of measurement period.
+ * \return Processor usage in 0-10000 range, CPUUSAGE_BP_OFFLINE if processor has been offline at the end of the period,
+ * CPUUSAGE_BP_INVALID if no time has passed over it or processor has been offline at it's start.
+*/
+static inline BasisPointValue_t basisPointsFromTimes(CpuStatValue_t prevIdle, CpuStatValue_t prevTotal, CpuStatValue_t idle, CpuStatValue_t total)
+{
+	if (0u == total)
+	{
+		return CPUUSAGE_BP_OFFLINE;
+	}
+
+	return ((0u == prevTotal) || (total < prevTotal)) ? CPUUSAGE_BP_INVALID : basisPointsFromChanges(idle - prevIdle, total - prevTotal);
+}
+
+
 /**
- * \brief Calculates CPU usage percentage. Formula taken from https://stackoverflow.com/a/23376195.
+ * \brief Checks whether processor has been offline at the end of interval change has been measured over.
+*/
+static inline bool isOfflineDelta(const CpuStatDeltaValue_t* values)
+{
+	return (CPUSTAT_DELTA_OFFLINE == values[CSINDEX_IDLE]) && (CPUSTAT_DELTA_OFFLINE == values[CSINDEX_USER]);
+}
+
+
+/**
+ * \brief Calculates CPU usage percentage.
  * \param oldStat Processor state time unit measurement taken at the start of measurement period. 
  * \param newStat Processor state time unit measurement taken at the end of measurement period.
  * \return Processor usage as percentage value in 0-100 range.
@@ -19,34 +120,26 @@ static PercentageValue_t calculateCpuUsagePercentage(const CpuStat_t* oldStat, c
 		return ERROR_VAL;
 	}
 
-	CpuStatValue_t prevIdle = oldStat->values[CSINDEX_IDLE] + oldStat->values[CSINDEX_IOWAIT];
-	CpuStatValue_t idle = newStat->values[CSINDEX_IDLE] + newStat->values[CSINDEX_IOWAIT];
-
-	CpuStatValue_t prevNonIdle = 
-		oldStat->values[CSINDEX_USER] +
-		oldStat->values[CSINDEX_NICE] +
-		oldStat->values[CSINDEX_SYSTEM] +
-		oldStat->values[CSINDEX_IRQ] +
-		oldStat->values[CSINDEX_SOFTIRQ] +
-		oldStat->values[CSINDEX_STEAL];
-
-	CpuStatValue_t nonIdle =
-		newStat->values[CSINDEX_USER] +
-		newStat->values[CSINDEX_NICE] +
-		newStat->values[CSINDEX_SYSTEM] +
-		newStat->values[CSINDEX_IRQ] +
-		newStat->values[CSINDEX_SOFTIRQ] +
-		newStat->values[CSINDEX_STEAL];
+	CpuStatValue_t prevIdle;
+	CpuStatValue_t prevTotal;
+	CpuStatValue_t idle;
+	CpuStatValue_t total;
+	sumCpuTimes(oldStat, &prevIdle, &prevTotal);
+	sumCpuTimes(newStat, &idle, &total);
 
-	CpuStatValue_t prevTotal = prevIdle + prevNonIdle;
-	CpuStatValue_t total = idle + nonIdle;
+	return usageFromTimes(prevIdle, prevTotal, idle, total);
+}
 
-	CpuStatValue_t totald = total - prevTotal;
-	CpuStatValue_t idled = idle - prevIdle;
 
-	PercentageValue_t result = (totald != 0.0) ? ((double) totald - idled) / totald : ERROR_VAL;
-	// Adjust from fraction to percentage
-	return result * 100.0;
+/**
+ * \brief Calculates length of interval between two measurements.
+ * \return Interval in nanoseconds, 0 if unknown.
+*/
+static inline unsigned long long intervalBetween(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat)
+{
+	return ((0u != oldProcStat->timestampNs) && (newProcStat->timestampNs > oldProcStat->timestampNs))
+		? newProcStat->timestampNs - oldProcStat->timestampNs
+		: 0u;
 }
 
 
@@ -70,6 +163,8 @@ void CpuUsageInfo_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* new
 
 	const size_t cpuLineCount = oldProcStat->cpuStatsLength;
 	output->valuesLength = cpuLineCount;
+	output->intervalNs = intervalBetween(oldProcStat, newProcStat);
+	output->stamps = newProcStat->stamps;
 
 	for (unsigned ii = 0; ii < cpuLineCount; ++ii)
 	{
@@ -78,7 +173,595 @@ void CpuUsageInfo_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* new
 }
 
 
+void CpuUsageInfo_calculateSelected(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, const size_t* lines, size_t linesLength,
+	CpuUsageInfo_t* output)
+{
+	if ((NULL == oldProcStat) || (NULL == newProcStat) || (NULL == lines) || (NULL == output))
+	{
+		return;
+	}
+
+	output->valuesLength = oldProcStat->cpuStatsLength;
+	output->intervalNs = intervalBetween(oldProcStat, newProcStat);
+	output->stamps = newProcStat->stamps;
+
+	for (size_t ii = 0; ii < linesLength; ++ii)
+	{
+		if (lines[ii] < output->valuesLength)
+		{
+			output->values[lines[ii]] = calculateCpuUsagePercentage(&oldProcStat->cpuStats[lines[ii]], &newProcStat->cpuStats[lines[ii]]);
+		}
+	}
+}
+
+
+void CpuUsageInfo_calculateMany(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStats, size_t count, CpuUsageInfo_t* outputs)
+{
+	if ((NULL == oldProcStat) || (NULL == newProcStats) || (NULL == outputs) || (0u == count))
+	{
+		return;
+	}
+
+	const size_t procStatSize = ProcStat_size();
+	const size_t usageInfoSize = CpuUsageInfo_size();
+	const size_t cpuLineCount = oldProcStat->cpuStatsLength;
+	const ProcStat_t* prevProcStat = oldProcStat;
+
+	for (size_t kk = 0; kk < count; ++kk)
+	{
+		const ProcStat_t* newProcStat = (const ProcStat_t*) ((const char*) newProcStats + kk * procStatSize);
+		CpuUsageInfo_t* output = (CpuUsageInfo_t*) ((char*) outputs + kk * usageInfoSize);
+
+		output->valuesLength = cpuLineCount;
+		output->intervalNs = intervalBetween(prevProcStat, newProcStat);
+		output->stamps = newProcStat->stamps;
+		prevProcStat = newProcStat;
+	}
+
+	// Every processor's times are summed once per snapshot and reused by both intervals it bounds,
+	// instead of twice as consecutive CpuUsageInfo_calculate() calls would do
+	for (size_t ii = 0; ii < cpuLineCount; ++ii)
+	{
+		CpuStatValue_t prevIdle;
+		CpuStatValue_t prevTotal;
+		sumCpuTimes(&oldProcStat->cpuStats[ii], &prevIdle, &prevTotal);
+
+		for (size_t kk = 0; kk < count; ++kk)
+		{
+			const ProcStat_t* newProcStat = (const ProcStat_t*) ((const char*) newProcStats + kk * procStatSize);
+			CpuUsageInfo_t* output = (CpuUsageInfo_t*) ((char*) outputs + kk * usageInfoSize);
+
+			CpuStatValue_t idle;
+			CpuStatValue_t total;
+			sumCpuTimes(&newProcStat->cpuStats[ii], &idle, &total);
+			output->values[ii] = usageFromTimes(prevIdle, prevTotal, idle, total);
+			prevIdle = idle;
+			prevTotal = total;
+		}
+	}
+}
+
+
+void CpuUsageInfo_calculateFromDelta(const ProcStatDelta_t* delta, CpuUsageInfo_t* output)
+{
+	if ((NULL == delta) || (NULL == output))
+	{
+		return;
+	}
+
+	output->valuesLength = delta->cpuDeltasLength;
+	output->intervalNs = delta->intervalNs;
+	output->stamps = delta->stamps;
+
+	for (size_t ii = 0; ii < delta->cpuDeltasLength; ++ii)
+	{
+		const CpuStatDeltaValue_t* values = delta->cpuDeltas[ii].values;
+		const CpuStatValue_t idled = (CpuStatValue_t) values[CSINDEX_IDLE] + values[CSINDEX_IOWAIT];
+
+		const CpuStatValue_t nonIdled =
+			(CpuStatValue_t) values[CSINDEX_USER] +
+			values[CSINDEX_NICE] +
+			values[CSINDEX_SYSTEM] +
+			values[CSINDEX_IRQ] +
+			values[CSINDEX_SOFTIRQ] +
+			values[CSINDEX_STEAL];
+
+		output->values[ii] = isOfflineDelta(values) ? usageFromChanges(0u, 0u) : usageFromChanges(idled, idled + nonIdled);
+	}
+}
+
+
+/**
+ * \brief Calculates rates of scheduler counters from their change over measurement period.
+ * \param change Change of counters, as calculated by SchedStat_change().
+ * \param intervalNs Length of measurement period, in nanoseconds. Zero leaves every rate zero.
+*/
+static void calculateSched(const SchedStat_t* change, unsigned long long intervalNs, SchedUsage_t* output)
+{
+	const unsigned long long intervalUs = intervalNs / 1000u;
+
+	*output = (SchedUsage_t)
+	{
+		.procsRunning 	= change->procsRunning,
+		.procsBlocked 	= change->procsBlocked,
+		.loadAvg 		= { change->loadAvg[0], change->loadAvg[1], change->loadAvg[2] },
+		.flags 			= change->flags
+	};
+
+	if (0u == intervalUs)
+	{
+		return;
+	}
+
+	const unsigned long long switches = change->contextSwitches * 1000000u / intervalUs;
+	const unsigned long long interrupts = change->interrupts * 1000000u / intervalUs;
+	const unsigned long long someBp = (change->pressureSomeUs * CPUUSAGE_BP_FULL + intervalUs / 2u) / intervalUs;
+	const unsigned long long fullBp = (change->pressureFullUs * CPUUSAGE_BP_FULL + intervalUs / 2u) / intervalUs;
+
+	// Stall totals are updated on task state changes, so a period may be credited slightly more than it's length
+	output->contextSwitchesPerSec 	= (uint32_t) ((switches > UINT32_MAX) ? UINT32_MAX : switches);
+	output->interruptsPerSec 		= (uint32_t) ((interrupts > UINT32_MAX) ? UINT32_MAX : interrupts);
+	output->pressureSomeBp 			= (BasisPointValue_t) ((someBp > CPUUSAGE_BP_FULL) ? CPUUSAGE_BP_FULL : someBp);
+	output->pressureFullBp 			= (BasisPointValue_t) ((fullBp > CPUUSAGE_BP_FULL) ? CPUUSAGE_BP_FULL : fullBp);
+}
+
+
+/**
+ * \brief Calculates usage weighted by frequency of every processor, following per-processor usage already calculated.
+ * Total is the average of processors, as they are ticking at the same rate.
+ * \param oldFreqs Frequencies at the start of measurement period, NULL if not known.
+ * \param newFreqs Frequencies at the end of measurement period, or mean ones over it.
+ * \param output Usage statistics to append frequency-weighted usage to.
+*/
+static void calculateEffective(const CpuFreqValue_t* oldFreqs, const CpuFreqValue_t* newFreqs, CpuUsageCompact_t* output)
+{
+	BasisPointValue_t* effective = output->values + output->valuesLength;
+	unsigned long sum = 0u;
+	unsigned long valid = 0u;
+
+	for (size_t ii = 1; ii < output->valuesLength; ++ii)
+	{
+		const BasisPointValue_t value = output->values[ii];
+		CpuFreqValue_t freq = (NULL != oldFreqs) ? CpuFreq_mean(oldFreqs[ii], 1u, newFreqs[ii], 1u) : newFreqs[ii];
+		freq = (CPUFREQ_UNKNOWN == freq) ? CPUUSAGE_BP_FULL : freq;
+
+		if (CPUUSAGE_BP_FULL < value)
+		{
+			effective[ii] = value;
+			continue;
+		}
+
+		effective[ii] = (BasisPointValue_t) (((unsigned long) value * freq + CPUUSAGE_BP_FULL / 2u) / CPUUSAGE_BP_FULL);
+		sum += effective[ii];
+		++valid;
+	}
+
+	effective[0] = (0u != valid) ? (BasisPointValue_t) ((sum + valid / 2u) / valid) : output->values[0];
+	output->effectiveLength = output->valuesLength;
+}
+
+
+void CpuUsageCompact_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, CpuUsageCompact_t* output)
+{
+	if ((NULL == oldProcStat) || (NULL == newProcStat) || (NULL == output))
+	{
+		return;
+	}
+
+	const size_t cpuLineCount = oldProcStat->cpuStatsLength;
+	output->valuesLength = cpuLineCount;
+	output->effectiveLength = 0u;
+	output->rollupsLength = 0u;
+	output->intervalNs = intervalBetween(oldProcStat, newProcStat);
+	output->stamps = newProcStat->stamps;
+	output->onlineEpoch = newProcStat->onlineEpoch;
+
+	SchedStat_t schedChange;
+	SchedStat_change(&oldProcStat->sched, &newProcStat->sched, &schedChange);
+	calculateSched(&schedChange, output->intervalNs, &output->sched);
+
+	for (size_t ii = 0; ii < cpuLineCount; ++ii)
+	{
+		CpuStatValue_t prevIdle;
+		CpuStatValue_t prevTotal;
+		CpuStatValue_t idle;
+		CpuStatValue_t total;
+		sumCpuTimes(&oldProcStat->cpuStats[ii], &prevIdle, &prevTotal);
+		sumCpuTimes(&newProcStat->cpuStats[ii], &idle, &total);
+		output->values[ii] = basisPointsFromTimes(prevIdle, prevTotal, idle, total);
+	}
+
+	if (effectiveReserved && (0u != newProcStat->freqsLength))
+	{
+		calculateEffective((0u != oldProcStat->freqsLength) ? ProcStat_getFreqs(oldProcStat) : NULL, ProcStat_getFreqs(newProcStat), output);
+	}
+}
+
+
+void CpuUsageCompact_calculateMany(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStats, size_t count, CpuUsageCompact_t* outputs)
+{
+	if ((NULL == oldProcStat) || (NULL == newProcStats) || (NULL == outputs) || (0u == count))
+	{
+		return;
+	}
+
+	const size_t procStatSize = ProcStat_size();
+	const size_t compactSize = CpuUsageCompact_size();
+	const size_t cpuLineCount = oldProcStat->cpuStatsLength;
+	const ProcStat_t* prevProcStat = oldProcStat;
+
+	for (size_t kk = 0; kk < count; ++kk)
+	{
+		const ProcStat_t* newProcStat = (const ProcStat_t*) ((const char*) newProcStats + kk * procStatSize);
+		CpuUsageCompact_t* output = (CpuUsageCompact_t*) ((char*) outputs + kk * compactSize);
+
+		output->valuesLength = cpuLineCount;
+		output->effectiveLength = 0u;
+		output->rollupsLength = 0u;
+		output->intervalNs = intervalBetween(prevProcStat, newProcStat);
+		output->stamps = newProcStat->stamps;
+		output->onlineEpoch = newProcStat->onlineEpoch;
+
+		SchedStat_t schedChange;
+		SchedStat_change(&prevProcStat->sched, &newProcStat->sched, &schedChange);
+		calculateSched(&schedChange, output->intervalNs, &output->sched);
+		prevProcStat = newProcStat;
+	}
+
+	for (size_t ii = 0; ii < cpuLineCount; ++ii)
+	{
+		CpuStatValue_t prevIdle;
+		CpuStatValue_t prevTotal;
+		sumCpuTimes(&oldProcStat->cpuStats[ii], &prevIdle, &prevTotal);
+
+		for (size_t kk = 0; kk < count; ++kk)
+		{
+			const ProcStat_t* newProcStat = (const ProcStat_t*) ((const char*) newProcStats + kk * procStatSize);
+			CpuUsageCompact_t* output = (CpuUsageCompact_t*) ((char*) outputs + kk * compactSize);
+
+			CpuStatValue_t idle;
+			CpuStatValue_t total;
+			sumCpuTimes(&newProcStat->cpuStats[ii], &idle, &total);
+			output->values[ii] = basisPointsFromTimes(prevIdle, prevTotal, idle, total);
+			prevIdle = idle;
+			prevTotal = total;
+		}
+	}
+
+	prevProcStat = oldProcStat;
+
+	for (size_t kk = 0; kk < count; ++kk)
+	{
+		const ProcStat_t* newProcStat = (const ProcStat_t*) ((const char*) newProcStats + kk * procStatSize);
+		CpuUsageCompact_t* output = (CpuUsageCompact_t*) ((char*) outputs + kk * compactSize);
+
+		if (effectiveReserved && (0u != newProcStat->freqsLength))
+		{
+			calculateEffective((0u != prevProcStat->freqsLength) ? ProcStat_getFreqs(prevProcStat) : NULL, ProcStat_getFreqs(newProcStat), output);
+		}
+
+		prevProcStat = newProcStat;
+	}
+}
+
+
+void CpuUsageCompact_calculateFromDelta(const ProcStatDelta_t* delta, CpuUsageCompact_t* output)
+{
+	if ((NULL == delta) || (NULL == output))
+	{
+		return;
+	}
+
+	output->valuesLength = delta->cpuDeltasLength;
+	output->effectiveLength = 0u;
+	output->rollupsLength = 0u;
+	output->intervalNs = delta->intervalNs;
+	output->stamps = delta->stamps;
+	output->onlineEpoch = delta->onlineEpoch;
+	calculateSched(&delta->sched, delta->intervalNs, &output->sched);
+
+	for (size_t ii = 0; ii < delta->cpuDeltasLength; ++ii)
+	{
+		const CpuStatDeltaValue_t* values = delta->cpuDeltas[ii].values;
+		const CpuStatValue_t idled = (CpuStatValue_t) values[CSINDEX_IDLE] + values[CSINDEX_IOWAIT];
+
+		const CpuStatValue_t nonIdled =
+			(CpuStatValue_t) values[CSINDEX_USER] +
+			values[CSINDEX_NICE] +
+			values[CSINDEX_SYSTEM] +
+			values[CSINDEX_IRQ] +
+			values[CSINDEX_SOFTIRQ] +
+			values[CSINDEX_STEAL];
+
+		output->values[ii] = isOfflineDelta(values) ? CPUUSAGE_BP_OFFLINE : basisPointsFromChanges(idled, idled + nonIdled);
+	}
+
+	if (effectiveReserved && (0u != delta->freqsLength))
+	{
+		calculateEffective(NULL, ProcStatDelta_getFreqs(delta), output);
+	}
+}
+
+
+void CpuUsageCompact_rollup(const CpuTopology_t* topology, CpuUsageCompact_t* cucompact)
+{
+	if ((NULL == topology) || (NULL == cucompact) || (cucompact->valuesLength != topology->cpuCount + 1u))
+	{
+		return;
+	}
+
+	// Skip total "cpu" line, processor indices in topology start from the first "cpuN" one
+	const BasisPointValue_t* cpuValues = cucompact->values + 1;
+	BasisPointValue_t* output = cucompact->values + cucompact->valuesLength + cucompact->effectiveLength;
+
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		const uint32_t* members = topology->members[level];
+		const uint32_t* memberStarts = topology->memberStarts[level];
+
+		for (size_t group = 0; group < topology->groupCounts[level]; ++group)
+		{
+			unsigned long sum = 0u;
+			unsigned long valid = 0u;
+			bool online = false;
+
+			for (uint32_t ii = memberStarts[group]; ii < memberStarts[group + 1u]; ++ii)
+			{
+				const BasisPointValue_t value = cpuValues[members[ii]];
+
+				if (CPUUSAGE_BP_FULL >= value)
+				{
+					sum += value;
+					++valid;
+				}
+
+				online = online || (CPUUSAGE_BP_OFFLINE != value);
+			}
+
+			*output++ = (0u != valid)
+				? (BasisPointValue_t) ((sum + valid / 2u) / valid)
+				: (online ? CPUUSAGE_BP_INVALID : CPUUSAGE_BP_OFFLINE);
+		}
+	}
+
+	cucompact->rollupsLength = topology->groupTotal;
+}
+
+
+PercentageValue_t CpuUsageInfo_maxDifference(const CpuUsageInfo_t* a, const CpuUsageInfo_t* b)
+{
+	if ((NULL == a) || (NULL == b))
+	{
+		return 0.0;
+	}
+
+	const size_t length = (a->valuesLength < b->valuesLength) ? a->valuesLength : b->valuesLength;
+	PercentageValue_t result = 0.0;
+
+	for (size_t ii = 0; ii < length; ++ii)
+	{
+		if ((a->values[ii] < 0.0) || (b->values[ii] < 0.0))
+		{
+			continue;
+		}
+
+		const PercentageValue_t difference = (a->values[ii] > b->values[ii])
+			? a->values[ii] - b->values[ii]
+			: b->values[ii] - a->values[ii];
+
+		result = (difference > result) ? difference : result;
+	}
+
+	return result;
+}
+
+
 size_t CpuUsageInfo_size(void)
 {
 	return sizeof (CpuUsageInfo_t) + (CpuCount_get() + 1) * sizeof (PercentageValue_t);
 }
+
+
+void CpuUsageInfo_print(FILE* out, const CpuUsageInfo_t* cuinfo)
+{
+	if ((NULL == out) || (NULL == cuinfo) || (cuinfo->valuesLength < 1))
+	{
+		return;
+	}
+
+	fprintf(out, "Interval:\t%.1f ms\n", cuinfo->intervalNs / 1000000.0);
+	fprintf(out, "CPU:\t" PERCENTAGE_VALUE_FORMAT " %%\n", cuinfo->values[0]);
+
+	for (unsigned ii = 1; ii < (unsigned long long) cuinfo->valuesLength; ++ii)
+	{
+		fprintf(out, "CPU%d:\t" PERCENTAGE_VALUE_FORMAT " %%\n",
+			CpuCount_getCpuId((int) ii - 1),
+			cuinfo->values[ii]);
+	}
+}
+
+
+/**
+ * \brief Prints single compact usage value as percentage with two decimal places, without ending the line.
+ * Invalid values are printed as -100.00, as CpuUsageInfo_print() prints invalid percentage values,
+ * usage of groups of offline processors only as "offline".
+*/
+static void printBasisPointsValue(FILE* out, BasisPointValue_t value)
+{
+	if (CPUUSAGE_BP_INVALID == value)
+	{
+		fputs("-100.00 %", out);
+	}
+	else if (CPUUSAGE_BP_OFFLINE == value)
+	{
+		fputs("offline", out);
+	}
+	else
+	{
+		fprintf(out, "%u.%02u %%", value / 100u, value % 100u);
+	}
+}
+
+
+/**
+ * \brief Prints single compact usage value, see printBasisPointsValue(), ending the line.
+*/
+static void printBasisPoints(FILE* out, BasisPointValue_t value)
+{
+	printBasisPointsValue(out, value);
+	fputc('\n', out);
+}
+
+
+/**
+ * \brief Prints usage of processor, or total one, of given index, followed by it's frequency-weighted usage if calculated.
+*/
+static void printUsage(FILE* out, const CpuUsageCompact_t* cucompact, size_t index)
+{
+	if (0u == cucompact->effectiveLength)
+	{
+		printBasisPoints(out, cucompact->values[index]);
+		return;
+	}
+
+	printBasisPointsValue(out, cucompact->values[index]);
+	fputs(", ", out);
+	printBasisPointsValue(out, cucompact->values[cucompact->valuesLength + index]);
+	fputs(" of capacity\n", out);
+}
+
+
+void CpuUsageCompact_printTotal(FILE* out, const CpuUsageCompact_t* cucompact)
+{
+	if ((NULL == out) || (NULL == cucompact) || (cucompact->valuesLength < 1))
+	{
+		return;
+	}
+
+	fprintf(out, "Interval:\t%.1f ms\n", cucompact->intervalNs / 1000000.0);
+	fputs("CPU:\t", out);
+	printUsage(out, cucompact, 0u);
+}
+
+
+void CpuUsageCompact_print(FILE* out, const CpuUsageCompact_t* cucompact)
+{
+	if ((NULL == out) || (NULL == cucompact) || (cucompact->valuesLength < 1))
+	{
+		return;
+	}
+
+	CpuUsageCompact_printTotal(out, cucompact);
+
+	// Offline processors are left out, as they are from /proc/stat
+	for (unsigned ii = 1; ii < (unsigned long long) cucompact->valuesLength; ++ii)
+	{
+		if (CPUUSAGE_BP_OFFLINE == cucompact->values[ii])
+		{
+			continue;
+		}
+
+		fprintf(out, "CPU%d:\t", CpuCount_getCpuId((int) ii - 1));
+		printUsage(out, cucompact, ii);
+	}
+}
+
+
+void CpuUsageCompact_printSched(FILE* out, const CpuUsageCompact_t* cucompact)
+{
+	if ((NULL == out) || (NULL == cucompact))
+	{
+		return;
+	}
+
+	const SchedUsage_t* sched = &cucompact->sched;
+
+	if (0u != (sched->flags & SCHEDSTAT_HAVE_COUNTERS))
+	{
+		fprintf(out, "Run queue:\t%u running, %u blocked\n", sched->procsRunning, sched->procsBlocked);
+	}
+
+	if (0u != (sched->flags & SCHEDSTAT_HAVE_LOADAVG))
+	{
+		fprintf(out, "Load average:\t%u.%02u %u.%02u %u.%02u\n",
+			sched->loadAvg[0] / 100u, sched->loadAvg[0] % 100u,
+			sched->loadAvg[1] / 100u, sched->loadAvg[1] % 100u,
+			sched->loadAvg[2] / 100u, sched->loadAvg[2] % 100u);
+	}
+
+	if (0u != (sched->flags & SCHEDSTAT_HAVE_PRESSURE))
+	{
+		fprintf(out, "CPU pressure:\tsome %u.%02u %%, full %u.%02u %%\n",
+			sched->pressureSomeBp / 100u, sched->pressureSomeBp % 100u,
+			sched->pressureFullBp / 100u, sched->pressureFullBp % 100u);
+	}
+
+	if (0u != (sched->flags & SCHEDSTAT_HAVE_COUNTERS))
+	{
+		fprintf(out, "Context switches:\t%u /s, interrupts %u /s\n", sched->contextSwitchesPerSec, sched->interruptsPerSec);
+	}
+}
+
+
+void CpuUsageCompact_printRollups(FILE* out, const CpuTopology_t* topology, const CpuUsageCompact_t* cucompact, unsigned levelMask)
+{
+	if ((NULL == out) || (NULL == topology) || (NULL == cucompact) || (cucompact->rollupsLength != topology->groupTotal))
+	{
+		return;
+	}
+
+	const BasisPointValue_t* levelValues[TLEVEL_COUNT_];
+	levelValues[0] = cucompact->values + cucompact->valuesLength + cucompact->effectiveLength;
+
+	for (int level = 1; level < TLEVEL_COUNT_; ++level)
+	{
+		levelValues[level] = levelValues[level - 1] + topology->groupCounts[level - 1];
+	}
+
+	for (int level = TLEVEL_COUNT_ - 1; level >= 0; --level)
+	{
+		if (0u == (levelMask & TOPOLOGY_LEVEL_BIT(level)))
+		{
+			continue;
+		}
+
+		const char* name = Topology_getLevelName((TopologyLevel_t) level);
+
+		for (size_t group = 0; group < topology->groupCounts[level]; ++group)
+		{
+			const int id = topology->groupIds[level][group];
+
+			if (TLEVEL_CORE == level)
+			{
+				// Core identifiers repeat across packages, so cores are named after package they belong to
+				const uint32_t firstCpu = topology->members[level][topology->memberStarts[level][group]];
+				const uint32_t package = topology->groupOf[TLEVEL_PACKAGE][firstCpu];
+				fprintf(out, "%s%d.%d:\t", name, topology->groupIds[TLEVEL_PACKAGE][package], id);
+			}
+			else
+			{
+				fprintf(out, "%s%d:\t", name, id);
+			}
+
+			printBasisPoints(out, levelValues[level][group]);
+		}
+	}
+}
+
+
+void CpuUsageCompact_reserveEffective(bool reserve)
+{
+	effectiveReserved = reserve;
+}
+
+
+size_t CpuUsageCompact_size(void)
+{
+	return sizeof (CpuUsageCompact_t) + (effectiveReserved ? 2 : 1) * (CpuCount_get() + 1) * sizeof (BasisPointValue_t);
+}
+
+
+size_t CpuUsageCompact_sizeWithRollups(const CpuTopology_t* topology)
+{
+	return CpuUsageCompact_size() + ((NULL != topology) ? topology->groupTotal * sizeof (BasisPointValue_t) : 0u);
+}
@@ -6,7 +6,10 @@
 #ifndef CPUUSAGE_H_INCLUDED
 #define CPUUSAGE_H_INCLUDED
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #include "procstat.h"
+#include "topology.h"
 
 
 /**
@@ -22,12 +25,93 @@ typedef struct CpuUsageInfo
 {
 	/** Values array length. Expected to be equal to amount of logical processors available plus one. */
 	size_t valuesLength;
+	/** Length of measurement period the statistics have been calculated over, in nanoseconds. Zero if unknown. */
+	unsigned long long intervalNs;
+	/** Timestamps of pipeline stage boundaries, carried over from the newer of the snapshots statistics have been calculated from. */
+	LatencyStamps_t stamps;
 	/** Usage statistics for every CPU core, expressed in percentage. */
 	PercentageValue_t values[];
 }
 CpuUsageInfo_t;
 
 
+/**
+ * Type used to represent CPU usage value as fixed-point percentage with two decimal places, in basis points.
+*/
+typedef uint16_t BasisPointValue_t;
+
+
+/**
+ * Basis point value corresponding to full, 100% usage.
+*/
+#define CPUUSAGE_BP_FULL 10000u
+
+/**
+ * Basis point value marking usage that could not be calculated, since no time has passed over measurement period.
+*/
+#define CPUUSAGE_BP_INVALID UINT16_MAX
+
+/**
+ * Basis point value marking usage of processor offline at the end of measurement period.
+*/
+#define CPUUSAGE_BP_OFFLINE (UINT16_MAX - 1u)
+
+
+/**
+ * Scheduler saturation and contention over measurement period, calculated from SchedStat_t of it's snapshots.
+*/
+typedef struct SchedUsage
+{
+	/** Context switches and interrupts per second. */
+	uint32_t 	contextSwitchesPerSec;
+	uint32_t 	interruptsPerSec;
+	/** Share of time some tasks, and every non-idle task at once, have been stalled waiting for processor, in basis points. */
+	BasisPointValue_t pressureSomeBp;
+	BasisPointValue_t pressureFullBp;
+	/** Tasks runnable and blocked on I/O at the end of period. */
+	uint32_t 	procsRunning;
+	uint32_t 	procsBlocked;
+	/** Load averages over 1, 5 and 15 minutes at the end of period, in hundredths. */
+	uint32_t 	loadAvg[3];
+	/** Parts sampled at both ends of period, as combination of SCHEDSTAT_HAVE_* flags. */
+	uint32_t 	flags;
+}
+SchedUsage_t;
+
+
+/**
+ * Compact counterpart of CpuUsageInfo_t, holding usage of every core in basis points rather than as double.
+ * Four times smaller, or half the size with room for frequency-weighted usage reserved, calculated with integer
+ * arithmetic only, and at least as precise as printed statistics.
+*/
+typedef struct CpuUsageCompact
+{
+	/** Length of per-processor part of values array. Expected to be equal to amount of logical processors available plus one. */
+	size_t valuesLength;
+	/** Amount of frequency-weighted values following per-processor ones, zero if no frequencies have been sampled
+	 * or no room has been reserved for them. */
+	size_t effectiveLength;
+	/** Amount of topology group values following frequency-weighted ones, zero if none have been calculated. */
+	size_t rollupsLength;
+	/** Length of measurement period the statistics have been calculated over, in nanoseconds. Zero if unknown. */
+	unsigned long long intervalNs;
+	/** Timestamps of pipeline stage boundaries, carried over from the newer of the snapshots statistics have been calculated from. */
+	LatencyStamps_t stamps;
+	/** Epoch of online processor set, carried over from the newer of the snapshots statistics have been calculated from. */
+	uint32_t onlineEpoch;
+	/** Scheduler saturation and contention over the same period. */
+	SchedUsage_t sched;
+	/**
+	 * Usage statistics for every CPU core, in basis points (0-10000), CPUUSAGE_BP_INVALID or CPUUSAGE_BP_OFFLINE, followed by
+	 * usage of every core weighted by it's frequency relative to maximum one, share of capacity core would have at full speed,
+	 * laid out the same way, and by usage of every topology group, level after level in TopologyLevel_t order,
+	 * as calculated by CpuUsageCompact_rollup().
+	*/
+	BasisPointValue_t values[];
+}
+CpuUsageCompact_t;
+
+
 /**
  * \brief Calculates usage statistics for every core using raw data retrieved at start and end of measurement period.
  * \param oldProcStat Data from /proc/stat retrieved at start of measurement period.
@@ -37,6 +121,58 @@ CpuUsageInfo_t;
 void CpuUsageInfo_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, CpuUsageInfo_t* output);
 
 
+/**
+ * \brief Calculates usage statistics of selected cores only, leaving values of all others unchanged.
+ * Equivalent to CpuUsageInfo_calculate() for selected cores, so that a few of thousands can be followed cheaply.
+ * \param oldProcStat Data from /proc/stat retrieved at start of measurement period.
+ * \param newProcStat Data from /proc/stat retrieved at end of measurement period.
+ * \param lines Indices of "cpu(N)" lines to calculate usage of, total "cpu" line being 0. Indices out of range are skipped.
+ * \param linesLength Amount of indices in lines array.
+ * \param output Output buffer for calculated statistics.
+*/
+void CpuUsageInfo_calculateSelected(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, const size_t* lines, size_t linesLength,
+	CpuUsageInfo_t* output);
+
+
+/**
+ * \brief Calculates usage statistics for every interval between consecutive snapshots in a single pass.
+ * Equivalent to calling CpuUsageInfo_calculate() for every pair of consecutive snapshots.
+ * \param oldProcStat Data from /proc/stat retrieved at start of the first interval.
+ * \param newProcStats Array of count snapshots, each of size retrieved by ProcStat_size(), ordered from oldest.
+ * \param count Amount of snapshots in newProcStats array, and of intervals to calculate.
+ * \param outputs Output array for count sets of statistics, each of size retrieved by CpuUsageInfo_size().
+*/
+void CpuUsageInfo_calculateMany(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStats, size_t count, CpuUsageInfo_t* outputs);
+
+
+/**
+ * \brief Calculates usage statistics for every core using change of data over measurement period.
+ * Equivalent to CpuUsageInfo_calculate() called with snapshots the change has been encoded from.
+ * \param delta Change of /proc/stat data over measurement period.
+ * \param output Output buffer for calculated statistics.
+*/
+void CpuUsageInfo_calculateFromDelta(const ProcStatDelta_t* delta, CpuUsageInfo_t* output);
+
+
+/**
+ * \brief Finds the largest change of usage of any single processor between two sets of usage statistics.
+ * Processors with invalid (negative) usage values in either set are ignored.
+ * \param a First set of usage statistics.
+ * \param b Second set of usage statistics.
+ * \return Largest absolute difference between corresponding values, in percentage points.
+*/
+PercentageValue_t CpuUsageInfo_maxDifference(const CpuUsageInfo_t* a, const CpuUsageInfo_t* b);
+
+
+/**
+ * \brief Prints usage statistics in the format shown by printer thread: measurement interval,
+ * followed by usage of every logical processor in percentages, one per line.
+ * \param out Stream to print into.
+ * \param cuinfo Usage statistics to print.
+*/
+void CpuUsageInfo_print(FILE* out, const CpuUsageInfo_t* cuinfo);
+
+
 /**
  * \brief Retrieves expected size of CpuUsageInfo_t structure in bytes.
  * \warning Since this function uses CpuCount_get() internally, CpuCount_init() should be called before using it.
@@ -45,4 +181,113 @@ void CpuUsageInfo_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* new
 size_t CpuUsageInfo_size(void);
 
 
+/**
+ * \brief Calculates compact usage statistics for every core using raw data retrieved at start and end of measurement period.
+ * Every value is equal to the corresponding one calculated by CpuUsageInfo_calculate(), multiplied by 100 and rounded
+ * to the nearest integer. Processors offline at the end of the period are marked with CPUUSAGE_BP_OFFLINE,
+ * ones brought online over it with CPUUSAGE_BP_INVALID. If room for it has been reserved with CpuUsageCompact_reserveEffective()
+ * and the newer snapshot has processor frequencies, usage weighted
+ * by mean frequency over the period is calculated as well, processors of unknown frequency counting as running at maximum one,
+ * and the total one as average of processors.
+ * \param oldProcStat Data from /proc/stat retrieved at start of measurement period.
+ * \param newProcStat Data from /proc/stat retrieved at end of measurement period.
+ * \param output Output buffer for calculated statistics, of size retrieved by CpuUsageCompact_size().
+*/
+void CpuUsageCompact_calculate(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, CpuUsageCompact_t* output);
+
+
+/**
+ * \brief Calculates compact usage statistics for every interval between consecutive snapshots in a single pass.
+ * Counterpart of CpuUsageInfo_calculateMany().
+ * \param oldProcStat Data from /proc/stat retrieved at start of the first interval.
+ * \param newProcStats Array of count snapshots, each of size retrieved by ProcStat_size(), ordered from oldest.
+ * \param count Amount of snapshots in newProcStats array, and of intervals to calculate.
+ * \param outputs Output array for count sets of statistics, each of size retrieved by CpuUsageCompact_size().
+*/
+void CpuUsageCompact_calculateMany(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStats, size_t count, CpuUsageCompact_t* outputs);
+
+
+/**
+ * \brief Calculates compact usage statistics for every core using change of data over measurement period.
+ * Counterpart of CpuUsageInfo_calculateFromDelta().
+ * \param delta Change of /proc/stat data over measurement period.
+ * \param output Output buffer for calculated statistics.
+*/
+void CpuUsageCompact_calculateFromDelta(const ProcStatDelta_t* delta, CpuUsageCompact_t* output);
+
+
+/**
+ * \brief Calculates usage of every topology group from per-processor usage, as average of it's processors.
+ * Processors are ticking at the same rate, so average is equal to usage calculated from summed times, save for rounding.
+ * Groups with every processor offline are marked with CPUUSAGE_BP_OFFLINE, other groups with no valid processor values
+ * with CPUUSAGE_BP_INVALID.
+ * \param topology Topology of processors the statistics have been calculated for.
+ * \param cucompact Usage statistics, of size retrieved by CpuUsageCompact_sizeWithRollups(), to append group usage to.
+*/
+void CpuUsageCompact_rollup(const CpuTopology_t* topology, CpuUsageCompact_t* cucompact);
+
+
+/**
+ * \brief Prints compact usage statistics in the same format as CpuUsageInfo_print(), leaving offline processors out.
+ * Frequency-weighted usage, if calculated, follows usage on the same line, as share of capacity.
+ * \param out Stream to print into.
+ * \param cucompact Usage statistics to print.
+*/
+void CpuUsageCompact_print(FILE* out, const CpuUsageCompact_t* cucompact);
+
+
+/**
+ * \brief Prints measurement interval and total usage only, first lines of CpuUsageCompact_print() output.
+ * \param out Stream to print into.
+ * \param cucompact Usage statistics to print.
+*/
+void CpuUsageCompact_printTotal(FILE* out, const CpuUsageCompact_t* cucompact);
+
+
+/**
+ * \brief Prints scheduler saturation and contention, one line per sampled part: run queue and load averages,
+ * processor pressure, and rates of context switches and interrupts. Prints nothing if no part has been sampled.
+ * \param out Stream to print into.
+ * \param cucompact Usage statistics to print.
+*/
+void CpuUsageCompact_printSched(FILE* out, const CpuUsageCompact_t* cucompact);
+
+
+/**
+ * \brief Prints usage of topology groups of selected levels, from the coarsest level.
+ * Does nothing if no group usage has been calculated.
+ * \param out Stream to print into.
+ * \param topology Topology group usage has been calculated for.
+ * \param cucompact Usage statistics to print.
+ * \param levelMask Levels to print, as combination of TOPOLOGY_LEVEL_BIT() values.
+*/
+void CpuUsageCompact_printRollups(FILE* out, const CpuTopology_t* topology, const CpuUsageCompact_t* cucompact, unsigned levelMask);
+
+
+/**
+ * \brief Reserves room for frequency-weighted usage in compact statistics, which are calculated only if it has been reserved.
+ * Only worth it if snapshots carry processor frequencies, otherwise it would be left unused in every set of statistics.
+ * \warning This function is NOT thread-safe and should be called before size of compact statistics is retrieved for the first time.
+ * \param reserve Whether room for frequency-weighted usage should be reserved, false by default.
+*/
+void CpuUsageCompact_reserveEffective(bool reserve);
+
+
+/**
+ * \brief Retrieves expected size of CpuUsageCompact_t structure in bytes, including room for frequency-weighted usage
+ * if it has been reserved with CpuUsageCompact_reserveEffective().
+ * \warning Since this function uses CpuCount_get() internally, CpuCount_init() should be called before using it.
+ * \return Size of CpuUsageCompact structure, in bytes.
+*/
+size_t CpuUsageCompact_size(void);
+
+
+/**
+ * \brief Retrieves size of CpuUsageCompact_t structure in bytes, including room for usage of every topology group.
+ * \param topology Topology of processors, NULL for no groups.
+ * \return Size of CpuUsageCompact structure with group usage, in bytes.
+*/
+size_t CpuUsageCompact_sizeWithRollups(const CpuTopology_t* topology);
+
+
 #endif // !CPUUSAGE_H_INCLUDED
@@ -98,4 +98,34 @@ struct timespec TimePointMs(unsigned ms)
 	}
 
 	return timePoint;
-}
\ No newline at end of file
+}
+
+
+/**
+ * \brief Reads given clock and converts the result into nanoseconds.
+ * \param clockId Clock to read, eg. CLOCK_MONOTONIC.
+ * \return Clock value in nanoseconds, or 0 in case of failure.
+*/
+static unsigned long long clockNs(clockid_t clockId)
+{
+	struct timespec now;
+
+	if (0 != clock_gettime(clockId, &now))
+	{
+		return 0u;
+	}
+
+	return (unsigned long long) now.tv_sec * NANOSECONDS_IN_SECOND + (unsigned long long) now.tv_nsec;
+}
+
+
+unsigned long long MonotonicTimeNs(void)
+{
+	return clockNs(CLOCK_MONOTONIC);
+}
+
+
+unsigned long long RealTimeNs(void)
+{
+	return clockNs(CLOCK_REALTIME);
+}
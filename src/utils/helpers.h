@@ -16,6 +16,20 @@
 struct timespec TimePointMs(unsigned ms);
 
 
+/**
+ * \brief Retrieves current value of monotonic clock (CLOCK_MONOTONIC).
+ * \return Time elapsed since unspecified starting point, in nanoseconds.
+*/
+unsigned long long MonotonicTimeNs(void);
+
+
+/**
+ * \brief Retrieves current value of system-wide real time clock (CLOCK_REALTIME).
+ * \return Time elapsed since Epoch, in nanoseconds.
+*/
+unsigned long long RealTimeNs(void);
+
+
 /**
  * \brief Read content of requested file into user-provided buffer.
  * This fucntion appends null-terminator automatically, for which one byte of the buffer is reserved.
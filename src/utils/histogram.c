@@ -0,0 +1,139 @@
+#include "histogram.h"
+
+
+void Histogram_reset(Histogram_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < HISTOGRAM_BUCKETS; ++ii)
+	{
+		atomic_store_explicit(&self->counts[ii], 0u, memory_order_relaxed);
+	}
+
+	atomic_store_explicit(&self->total, 0u, memory_order_relaxed);
+	atomic_store_explicit(&self->max, 0u, memory_order_relaxed);
+}
+
+
+void Histogram_record(Histogram_t* self, unsigned long long value)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	atomic_fetch_add_explicit(&self->counts[Histogram_bucketIndex(value)], 1u, memory_order_relaxed);
+	atomic_fetch_add_explicit(&self->total, 1u, memory_order_relaxed);
+
+	unsigned long long max = atomic_load_explicit(&self->max, memory_order_relaxed);
+
+	while ((value > max) && !atomic_compare_exchange_weak_explicit(&self->max, &max, value, memory_order_relaxed, memory_order_relaxed))
+	{
+	}
+}
+
+
+unsigned long long Histogram_count(const Histogram_t* self)
+{
+	return (NULL != self) ? atomic_load_explicit(&self->total, memory_order_relaxed) : 0u;
+}
+
+
+unsigned long long Histogram_max(const Histogram_t* self)
+{
+	return (NULL != self) ? atomic_load_explicit(&self->max, memory_order_relaxed) : 0u;
+}
+
+
+unsigned long long Histogram_percentile(const Histogram_t* self, double percentile)
+{
+	const unsigned long long total = Histogram_count(self);
+
+	if (0u == total)
+	{
+		return 0u;
+	}
+
+	percentile = (percentile < 0.0) ? 0.0 : ((percentile > 100.0) ? 100.0 : percentile);
+
+	// Rank of requested value among recorded ones, counting from 1
+	unsigned long long rank = (unsigned long long) (percentile / 100.0 * (double) total + 0.5);
+	rank = (0u == rank) ? 1u : rank;
+
+	const unsigned long long max = Histogram_max(self);
+	unsigned long long seen = 0u;
+
+	for (size_t ii = 0; ii < HISTOGRAM_BUCKETS; ++ii)
+	{
+		seen += atomic_load_explicit(&self->counts[ii], memory_order_relaxed);
+
+		if (seen >= rank)
+		{
+			const unsigned long long upper = Histogram_bucketUpperBound(ii);
+			return (upper < max) ? upper : max;
+		}
+	}
+
+	// Only reachable if counters have been updated concurrently
+	return max;
+}
+
+
+size_t Histogram_bucketIndex(unsigned long long value)
+{
+	if (value < HISTOGRAM_SUB_BUCKETS)
+	{
+		return (size_t) value;
+	}
+
+	const unsigned msb = 63u - (unsigned) __builtin_clzll(value);
+	const unsigned shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+	return (size_t) (shift + 1u) * HISTOGRAM_SUB_BUCKETS + (size_t) ((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1u));
+}
+
+
+unsigned long long Histogram_bucketLowerBound(size_t index)
+{
+	if (index < HISTOGRAM_SUB_BUCKETS)
+	{
+		return index;
+	}
+
+	const size_t group = index / HISTOGRAM_SUB_BUCKETS;
+	const unsigned long long sub = index % HISTOGRAM_SUB_BUCKETS;
+	return (HISTOGRAM_SUB_BUCKETS + sub) << (group - 1u);
+}
+
+
+unsigned long long Histogram_bucketUpperBound(size_t index)
+{
+	if (index < HISTOGRAM_SUB_BUCKETS)
+	{
+		return index;
+	}
+
+	const size_t group = index / HISTOGRAM_SUB_BUCKETS;
+	return Histogram_bucketLowerBound(index) + ((1ull << (group - 1u)) - 1u);
+}
+
+
+void Histogram_print(const Histogram_t* self, FILE* stream)
+{
+	if ((NULL == self) || (NULL == stream))
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < HISTOGRAM_BUCKETS; ++ii)
+	{
+		const unsigned long long count = atomic_load_explicit(&self->counts[ii], memory_order_relaxed);
+
+		if (0u != count)
+		{
+			fprintf(stream, "%llu-%llu %llu\n", Histogram_bucketLowerBound(ii), Histogram_bucketUpperBound(ii), count);
+		}
+	}
+}
@@ -0,0 +1,118 @@
+/**
+ * \file histogram.h
+ * Lock-free histogram of non-negative integer values, with logarithmic buckets.
+ * Every power-of-two range is split into HISTOGRAM_SUB_BUCKETS equal buckets,
+ * which bounds relative error of reported percentiles to 1 / HISTOGRAM_SUB_BUCKETS.
+*/
+#ifndef HISTOGRAM_H_INCLUDED
+#define HISTOGRAM_H_INCLUDED
+#include <stddef.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+
+/**
+ * Amount of bits of every value, below the most significant one, that determine it's bucket.
+*/
+#define HISTOGRAM_SUB_BUCKET_BITS 3u
+
+/**
+ * Amount of buckets every power-of-two range is split into.
+*/
+#define HISTOGRAM_SUB_BUCKETS (1u << HISTOGRAM_SUB_BUCKET_BITS)
+
+/**
+ * Total amount of buckets, sufficient to cover every 64-bit value.
+*/
+#define HISTOGRAM_BUCKETS ((64u - HISTOGRAM_SUB_BUCKET_BITS + 1u) * HISTOGRAM_SUB_BUCKETS)
+
+
+/**
+ * Histogram of recorded values. Recording and reading may be done concurrently from different threads.
+*/
+typedef struct Histogram
+{
+	/** Amount of values recorded in every bucket. */
+	atomic_ullong counts[HISTOGRAM_BUCKETS];
+	/** Total amount of recorded values. */
+	atomic_ullong total;
+	/** Largest recorded value. */
+	atomic_ullong max;
+}
+Histogram_t;
+
+
+/**
+ * \brief Removes every recorded value from histogram. Also used to initialize histogram.
+ * \param self Histogram.
+*/
+void Histogram_reset(Histogram_t* self);
+
+
+/**
+ * \brief Records single value.
+ * \param self Histogram.
+ * \param value Value to record.
+*/
+void Histogram_record(Histogram_t* self, unsigned long long value);
+
+
+/**
+ * \brief Retrieves total amount of recorded values.
+ * \param self Histogram.
+ * \return Amount of values.
+*/
+unsigned long long Histogram_count(const Histogram_t* self);
+
+
+/**
+ * \brief Retrieves largest recorded value.
+ * \param self Histogram.
+ * \return Largest value, 0 if no values have been recorded.
+*/
+unsigned long long Histogram_max(const Histogram_t* self);
+
+
+/**
+ * \brief Retrieves value below or equal to which given percentage of recorded values lie.
+ * \param self Histogram.
+ * \param percentile Percentage, 0-100.
+ * \return Upper bound of the bucket holding requested percentile, never exceeding largest recorded value.
+ * 0 if no values have been recorded.
+*/
+unsigned long long Histogram_percentile(const Histogram_t* self, double percentile);
+
+
+/**
+ * \brief Retrieves index of the bucket given value is recorded in.
+ * \param value Value.
+ * \return Bucket index, lower than HISTOGRAM_BUCKETS.
+*/
+size_t Histogram_bucketIndex(unsigned long long value);
+
+
+/**
+ * \brief Retrieves smallest value recorded in bucket of given index.
+ * \param index Bucket index, lower than HISTOGRAM_BUCKETS.
+ * \return Lower bound of the bucket.
+*/
+unsigned long long Histogram_bucketLowerBound(size_t index);
+
+
+/**
+ * \brief Retrieves largest value recorded in bucket of given index.
+ * \param index Bucket index, lower than HISTOGRAM_BUCKETS.
+ * \return Upper bound of the bucket.
+*/
+unsigned long long Histogram_bucketUpperBound(size_t index);
+
+
+/**
+ * \brief Prints every non-empty bucket, one per line, as "LOWER-UPPER COUNT".
+ * \param self Histogram.
+ * \param stream Stream to print into.
+*/
+void Histogram_print(const Histogram_t* self, FILE* stream);
+
+
+#endif // !HISTOGRAM_H_INCLUDED
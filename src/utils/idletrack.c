@@ -0,0 +1,675 @@
+#include "idletrack.h"
+#include "batchread.h"
+#include "cpucount.h"
+#include "helpers.h"
+#include "logger.h"
+#include "topology.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+// Counters are single decimal numbers
+#define IDLE_FILE_MAX 			32u
+#define IDLE_BP_FULL 			10000u
+// States listed past this one are taken as a malformed directory
+#define IDLE_STATES_LISTED_MAX 	64u
+// Time and usage files of a state, core and package counters of throttling
+#define IDLE_FILES_PER_STATE 	2u
+#define IDLE_FILES_THROTTLE 	2u
+// Scans after which files that could not be read are opened again
+#define IDLE_REOPEN_SCANS 		16u
+#define IDLE_COUNT_NONE 		ULLONG_MAX
+
+
+struct IdleTracker
+{
+	/** Directory containing "cpu" sysfs directory. */
+	char 			sysRoot[PATH_MAX];
+	/** Amount of tracked processors, and of files read per processor. */
+	size_t 			cpuCount;
+	size_t 			filesPerCpu;
+	/** Amount of tracked states, their cpuidle numbers and names, from the shallowest. */
+	size_t 			stateCount;
+	unsigned 		stateIds[IDLETRACK_STATES_MAX];
+	char 			names[IDLETRACK_STATES_MAX][IDLETRACK_NAME_LENGTH];
+	/** Whether core and package throttling counters follow files of states. */
+	bool 			throttleTracked;
+	/** Descriptors, counters as of the last read and their changes against the previous one, filesPerCpu per processor.
+	 * Missing counters and changes are IDLE_COUNT_NONE. */
+	int* 			fds;
+	unsigned long long* counts;
+	unsigned long long* changes;
+	/** Point in time every processor has last been read at, on CLOCK_MONOTONIC, and length of the last interval, 0 if none. */
+	unsigned long long* readNs;
+	unsigned long long* cpuIntervalNs;
+	/** Whether any file is closed, and scans since files have last been opened again. */
+	bool 			anyClosed;
+	unsigned 		scansSinceReopen;
+	/** Reader of counter files, along with a buffer, a request and a file index for every read of a slice. */
+	BatchReader_t* 	reader;
+	char* 			buffers;
+	BatchReadRequest_t* requests;
+	size_t* 		requestFiles;
+	/** Amount of steps per scan, and the step to be taken next. */
+	unsigned 		slices;
+	unsigned 		slice;
+	/** Points in time the current and the previous scan have started at, and processor time spent on the current one. */
+	unsigned long long scanNs;
+	unsigned long long prevScanNs;
+	unsigned long long scanCostNs;
+};
+
+
+/**
+ * \brief Retrieves processor time consumed by the calling thread, in nanoseconds.
+*/
+static unsigned long long threadCpuTimeNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+
+static inline uint32_t ratePerSec(unsigned long long change, unsigned long long intervalNs)
+{
+	const unsigned long long rate = change * 1000000000ull / intervalNs;
+	return (UINT32_MAX < rate) ? UINT32_MAX : (uint32_t) rate;
+}
+
+
+/**
+ * \brief Parses single counter, as written into cpuidle and thermal_throttle files.
+ * \return Counter, IDLE_COUNT_NONE if file does not hold a number.
+*/
+static unsigned long long parseCount(const char* text)
+{
+	char* end;
+	const unsigned long long value = strtoull(text, &end, 10);
+	return ((end != text) && ('\n' == *end || '\0' == *end)) ? value : IDLE_COUNT_NONE;
+}
+
+
+/**
+ * \brief Formats path of given file of tracked processor, e.g. state of index 2 is the time file of the second state.
+ * \return True if path fits, false otherwise.
+*/
+static bool formatPath(const IdleTracker_t* self, int cpuId, size_t file, char* path, size_t size)
+{
+	const size_t stateFiles = self->stateCount * IDLE_FILES_PER_STATE;
+	int length;
+
+	if (file < stateFiles)
+	{
+		length = snprintf(path, size, "%s/cpu/cpu%d/cpuidle/state%u/%s", self->sysRoot, cpuId,
+			self->stateIds[file / IDLE_FILES_PER_STATE], (0u == file % IDLE_FILES_PER_STATE) ? "time" : "usage");
+	}
+	else
+	{
+		length = snprintf(path, size, "%s/cpu/cpu%d/thermal_throttle/%s", self->sysRoot, cpuId,
+			(stateFiles == file) ? "core_throttle_count" : "package_throttle_count");
+	}
+
+	return (0 <= length) && ((size_t) length < size);
+}
+
+
+/**
+ * \brief Checks whether file of given path, relative to "cpu" directory, exists and can be read.
+*/
+static bool isReadable(const IdleTracker_t* self, const char* relative)
+{
+	char path[PATH_MAX];
+	return ((size_t) snprintf(path, sizeof(path), "%s/cpu/%s", self->sysRoot, relative) < sizeof(path)) &&
+		(0 == access(path, R_OK));
+}
+
+
+/**
+ * \brief Lists states and throttling counters once, from the first tracked processor having them,
+ * keeping as many as fit the budget.
+ * \return Amount of files per processor, 0 if none is present or fits.
+*/
+static size_t discover(IdleTracker_t* self, size_t budget)
+{
+	char relative[PATH_MAX];
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		snprintf(relative, sizeof(relative), "cpu%d/thermal_throttle/core_throttle_count", CpuCount_getCpuId((int) ii));
+
+		if (isReadable(self, relative))
+		{
+			snprintf(relative, sizeof(relative), "cpu%d/thermal_throttle/package_throttle_count", CpuCount_getCpuId((int) ii));
+			self->throttleTracked = isReadable(self, relative) && (IDLE_FILES_THROTTLE <= budget);
+			break;
+		}
+	}
+
+	if (self->throttleTracked)
+	{
+		budget -= IDLE_FILES_THROTTLE;
+	}
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		const int cpuId = CpuCount_getCpuId((int) ii);
+		unsigned listed = 0u;
+
+		for (; listed < IDLE_STATES_LISTED_MAX; ++listed)
+		{
+			snprintf(relative, sizeof(relative), "cpu%d/cpuidle/state%u/time", cpuId, listed);
+
+			if (!isReadable(self, relative))
+			{
+				break;
+			}
+		}
+
+		if (0u == listed)
+		{
+			continue;
+		}
+
+		// Deep states are the ones worth knowing about, shallow ones are left out first
+		size_t kept = budget / IDLE_FILES_PER_STATE;
+		kept = (kept > IDLETRACK_STATES_MAX) ? IDLETRACK_STATES_MAX : kept;
+		kept = (kept > listed) ? listed : kept;
+		self->stateCount = kept;
+
+		for (size_t jj = 0; jj < kept; ++jj)
+		{
+			char path[PATH_MAX];
+			char name[IDLE_FILE_MAX];
+			self->stateIds[jj] = listed - (unsigned) kept + (unsigned) jj;
+			snprintf(self->names[jj], IDLETRACK_NAME_LENGTH, "state%u", self->stateIds[jj]);
+
+			if (((size_t) snprintf(path, sizeof(path), "%s/cpu/cpu%d/cpuidle/state%u/name", self->sysRoot, cpuId,
+				self->stateIds[jj]) < sizeof(path)) && (0 < ReadFileContent(path, name, sizeof(name))))
+			{
+				// Longer names are truncated
+				name[IDLETRACK_NAME_LENGTH - 1u] = '\0';
+				name[strcspn(name, "\n")] = '\0';
+
+				if ('\0' != name[0])
+				{
+					strcpy(self->names[jj], name);
+				}
+			}
+		}
+
+		break;
+	}
+
+	return self->stateCount * IDLE_FILES_PER_STATE + (self->throttleTracked ? IDLE_FILES_THROTTLE : 0u);
+}
+
+
+/**
+ * \brief Attempts to open every file that is not open.
+ * \return Amount of open files.
+*/
+static size_t openClosed(IdleTracker_t* self)
+{
+	size_t opened = 0u;
+	self->anyClosed = false;
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		const int cpuId = CpuCount_getCpuId((int) ii);
+
+		for (size_t jj = 0; jj < self->filesPerCpu; ++jj)
+		{
+			char path[PATH_MAX];
+			int* fd = &self->fds[ii * self->filesPerCpu + jj];
+
+			if ((0 > *fd) && formatPath(self, cpuId, jj, path, sizeof(path)))
+			{
+				*fd = open(path, O_RDONLY | O_CLOEXEC);
+			}
+
+			if (0 <= *fd)
+			{
+				++opened;
+			}
+			else
+			{
+				self->anyClosed = true;
+			}
+		}
+	}
+
+	return opened;
+}
+
+
+/**
+ * \brief Reads every file of processors of given index range in a single batch, updating counters and their changes.
+ * \return True if successful, false on reader error.
+*/
+static bool readCpus(IdleTracker_t* self, size_t begin, size_t end)
+{
+	size_t count = 0u;
+
+	for (size_t file = begin * self->filesPerCpu; file < end * self->filesPerCpu; ++file)
+	{
+		if (0 <= self->fds[file])
+		{
+			// One byte is left for terminating null character
+			self->requests[count] = (BatchReadRequest_t)
+			{
+				.fd 	= self->fds[file],
+				.buf 	= self->buffers + count * IDLE_FILE_MAX,
+				.size 	= IDLE_FILE_MAX - 1u
+			};
+			self->requestFiles[count++] = file;
+		}
+		else
+		{
+			self->counts[file] = IDLE_COUNT_NONE;
+		}
+
+		self->changes[file] = IDLE_COUNT_NONE;
+	}
+
+	if ((0u != count) && (0 != BatchReader_read(self->reader, self->requests, count)))
+	{
+		return false;
+	}
+
+	const unsigned long long nowNs = MonotonicTimeNs();
+
+	for (size_t ii = begin; ii < end; ++ii)
+	{
+		self->cpuIntervalNs[ii] = (0u != self->readNs[ii]) ? nowNs - self->readNs[ii] : 0u;
+		self->readNs[ii] = nowNs;
+	}
+
+	for (size_t kk = 0; kk < count; ++kk)
+	{
+		BatchReadRequest_t* request = &self->requests[kk];
+		const size_t file = self->requestFiles[kk];
+		unsigned long long value = IDLE_COUNT_NONE;
+
+		if (0 < request->result)
+		{
+			request->buf[request->result] = '\0';
+			value = parseCount(request->buf);
+		}
+
+		if (IDLE_COUNT_NONE == value)
+		{
+			// Reads fail once processor goes offline, until it is back and it's files are opened again
+			close(self->fds[file]);
+			self->fds[file] = -1;
+			self->anyClosed = true;
+		}
+		else if ((IDLE_COUNT_NONE != self->counts[file]) && (value >= self->counts[file]))
+		{
+			self->changes[file] = value - self->counts[file];
+		}
+
+		self->counts[file] = value;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Fills report from changes of the scan just completed.
+*/
+static void fillReport(const IdleTracker_t* self, IdleUsageReport_t* report)
+{
+	unsigned long long residencySums[IDLETRACK_STATES_MAX] = { 0u };
+	size_t residencyCounts[IDLETRACK_STATES_MAX] = { 0u };
+	unsigned long long entriesPerSec[IDLETRACK_STATES_MAX] = { 0u };
+	const size_t stateFiles = self->stateCount * IDLE_FILES_PER_STATE;
+
+	report->cpuCount 				= self->cpuCount;
+	report->measuredCount 			= 0u;
+	report->stateCount 				= self->stateCount;
+	report->filesPerCpu 			= self->filesPerCpu;
+	report->throttleTracked 		= self->throttleTracked;
+	report->throttledCount 			= 0u;
+	report->coreThrottlesPerSec 	= 0u;
+	report->packageThrottlesPerSec 	= 0u;
+	report->intervalNs 				= self->scanNs - self->prevScanNs;
+	report->scanCostNs 				= self->scanCostNs;
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		const unsigned long long* changes = &self->changes[ii * self->filesPerCpu];
+		const unsigned long long intervalNs = self->cpuIntervalNs[ii];
+		IdleCpuUsage_t* usage = &report->cpus[ii];
+		usage->cpu 						= (unsigned) CpuCount_getCpuId((int) ii);
+		usage->measured 				= false;
+		usage->coreThrottlesPerSec 		= 0u;
+		usage->packageThrottlesPerSec 	= 0u;
+
+		for (size_t jj = 0; jj < IDLETRACK_STATES_MAX; ++jj)
+		{
+			usage->residencyBp[jj] = IDLETRACK_BP_UNKNOWN;
+		}
+
+		if (0u == intervalNs)
+		{
+			continue;
+		}
+
+		for (size_t jj = 0; jj < self->stateCount; ++jj)
+		{
+			const unsigned long long timeUs = changes[jj * IDLE_FILES_PER_STATE];
+			const unsigned long long entries = changes[jj * IDLE_FILES_PER_STATE + 1u];
+
+			if (IDLE_COUNT_NONE != timeUs)
+			{
+				// Residency is reported in microseconds, and may run slightly past the interval it has been read over
+				const unsigned long long bp = timeUs * 1000u * IDLE_BP_FULL / intervalNs;
+				usage->residencyBp[jj] = (uint16_t) ((bp > IDLE_BP_FULL) ? IDLE_BP_FULL : bp);
+				residencySums[jj] += usage->residencyBp[jj];
+				++residencyCounts[jj];
+				usage->measured = true;
+			}
+
+			if (IDLE_COUNT_NONE != entries)
+			{
+				entriesPerSec[jj] += ratePerSec(entries, intervalNs);
+			}
+		}
+
+		if (self->throttleTracked)
+		{
+			const unsigned long long core = changes[stateFiles];
+			const unsigned long long package = changes[stateFiles + 1u];
+
+			if (IDLE_COUNT_NONE != core)
+			{
+				usage->coreThrottlesPerSec = ratePerSec(core, intervalNs);
+				usage->measured = true;
+			}
+
+			if (IDLE_COUNT_NONE != package)
+			{
+				usage->packageThrottlesPerSec = ratePerSec(package, intervalNs);
+				usage->measured = true;
+			}
+
+			if ((0u != usage->coreThrottlesPerSec) || (0u != usage->packageThrottlesPerSec))
+			{
+				++report->throttledCount;
+			}
+
+			// Every processor of a package reports the same package counter
+			const unsigned long long coreSum = (unsigned long long) report->coreThrottlesPerSec + usage->coreThrottlesPerSec;
+			report->coreThrottlesPerSec = (UINT32_MAX < coreSum) ? UINT32_MAX : (uint32_t) coreSum;
+			report->packageThrottlesPerSec = (report->packageThrottlesPerSec < usage->packageThrottlesPerSec) ?
+				usage->packageThrottlesPerSec : report->packageThrottlesPerSec;
+		}
+
+		if (usage->measured)
+		{
+			++report->measuredCount;
+		}
+	}
+
+	for (size_t jj = 0; jj < self->stateCount; ++jj)
+	{
+		IdleStateUsage_t* state = &report->states[jj];
+		state->residencyBp = (0u != residencyCounts[jj]) ?
+			(uint16_t) ((residencySums[jj] + residencyCounts[jj] / 2u) / residencyCounts[jj]) : IDLETRACK_BP_UNKNOWN;
+		state->entriesPerSec = (UINT32_MAX < entriesPerSec[jj]) ? UINT32_MAX : (uint32_t) entriesPerSec[jj];
+		memcpy(state->name, self->names[jj], IDLETRACK_NAME_LENGTH);
+	}
+}
+
+
+IdleTracker_t* IdleTracker_create(const char* sysRoot, unsigned filesPerCpu, unsigned slices)
+{
+	if ((0u == filesPerCpu) || (0u == slices))
+	{
+		goto error_exit_1;
+	}
+
+	if (NULL == sysRoot)
+	{
+		sysRoot = TOPOLOGY_SYS_ROOT_DEFAULT;
+	}
+
+	IdleTracker_t* self = calloc(1u, sizeof(IdleTracker_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	if (strlen(sysRoot) >= sizeof(self->sysRoot))
+	{
+		goto error_exit_2;
+	}
+
+	strcpy(self->sysRoot, sysRoot);
+	self->cpuCount 		= (size_t) CpuCount_get();
+	self->slices 		= slices;
+	self->filesPerCpu 	= discover(self, filesPerCpu);
+
+	if (0u == self->filesPerCpu)
+	{
+		Log(LLEVEL_INFO, "no cpuidle or thermal_throttle data under %s fits %u files per processor", self->sysRoot, filesPerCpu);
+		goto error_exit_2;
+	}
+
+	const size_t files = self->cpuCount * self->filesPerCpu;
+	const size_t sliceFiles = (self->cpuCount + slices - 1u) / slices * self->filesPerCpu;
+	self->fds 			= malloc(files * sizeof(int));
+	self->counts 		= malloc(files * sizeof(unsigned long long));
+	self->changes 		= malloc(files * sizeof(unsigned long long));
+	self->readNs 		= calloc(self->cpuCount, sizeof(unsigned long long));
+	self->cpuIntervalNs = calloc(self->cpuCount, sizeof(unsigned long long));
+	self->buffers 		= malloc(sliceFiles * IDLE_FILE_MAX);
+	self->requests 		= malloc(sliceFiles * sizeof(BatchReadRequest_t));
+	self->requestFiles 	= malloc(sliceFiles * sizeof(size_t));
+
+	for (size_t ii = 0; (NULL != self->fds) && (NULL != self->counts) && (ii < files); ++ii)
+	{
+		self->fds[ii] = -1;
+		self->counts[ii] = IDLE_COUNT_NONE;
+	}
+
+	if ((NULL == self->fds) || (NULL == self->counts) || (NULL == self->changes) || (NULL == self->readNs) ||
+		(NULL == self->cpuIntervalNs) || (NULL == self->buffers) || (NULL == self->requests) || (NULL == self->requestFiles))
+	{
+		goto error_exit_3;
+	}
+
+	if (0u == openClosed(self))
+	{
+		goto error_exit_3;
+	}
+
+	self->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_AUTO);
+
+	if (NULL == self->reader)
+	{
+		goto error_exit_3;
+	}
+
+	return self;
+
+error_exit_3:
+	IdleTracker_destroy(self);
+	return NULL;
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void IdleTracker_destroy(IdleTracker_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; (NULL != self->fds) && (ii < self->cpuCount * self->filesPerCpu); ++ii)
+	{
+		if (0 <= self->fds[ii])
+		{
+			close(self->fds[ii]);
+		}
+	}
+
+	BatchReader_destroy(self->reader);
+	free(self->requestFiles);
+	free(self->requests);
+	free(self->buffers);
+	free(self->cpuIntervalNs);
+	free(self->readNs);
+	free(self->changes);
+	free(self->counts);
+	free(self->fds);
+	free(self);
+}
+
+
+int IdleTracker_step(IdleTracker_t* self, IdleUsageReport_t* report)
+{
+	if ((NULL == self) || (NULL == report))
+	{
+		return -1;
+	}
+
+	const unsigned slice = self->slice;
+	self->slice = (self->slice + 1u) % self->slices;
+	const unsigned long long costStartNs = threadCpuTimeNs();
+
+	if (0u == slice)
+	{
+		self->prevScanNs = self->scanNs;
+		self->scanNs = MonotonicTimeNs();
+		self->scanCostNs = 0u;
+
+		// Processors brought online, or ones whose driver has been loaded, are picked up after a while
+		if (self->anyClosed && (++self->scansSinceReopen >= IDLE_REOPEN_SCANS))
+		{
+			self->scansSinceReopen = 0u;
+			openClosed(self);
+		}
+	}
+
+	const size_t begin = self->cpuCount * slice / self->slices;
+	const size_t end = self->cpuCount * (slice + 1u) / self->slices;
+
+	if (!readCpus(self, begin, end))
+	{
+		return -2;
+	}
+
+	self->scanCostNs += threadCpuTimeNs() - costStartNs;
+
+	if ((0u != self->slice) || (0u == self->prevScanNs))
+	{
+		return 0;
+	}
+
+	fillReport(self, report);
+	return 1;
+}
+
+
+size_t IdleUsageReport_size(size_t cpuCount)
+{
+	return sizeof(IdleUsageReport_t) + cpuCount * sizeof(IdleCpuUsage_t);
+}
+
+
+/**
+ * \brief Prints residency of state in percent, or a dash if it has not been measured.
+*/
+static void printResidency(FILE* out, const char* name, uint16_t residencyBp)
+{
+	if (IDLETRACK_BP_UNKNOWN == residencyBp)
+	{
+		fprintf(out, "%s -", name);
+	}
+	else
+	{
+		fprintf(out, "%s %.2f %%", name, residencyBp / 100.0);
+	}
+}
+
+
+void IdleUsageReport_print(FILE* out, const IdleUsageReport_t* report, bool printCpus)
+{
+	if ((NULL == out) || (NULL == report) || (0u == report->cpuCount))
+	{
+		return;
+	}
+
+	fprintf(out, "Idle states:\t%zu of %zu processors, %zu files each, read took %.2f ms of CPU every %.1f ms\n",
+		report->measuredCount,
+		report->cpuCount,
+		report->filesPerCpu,
+		report->scanCostNs / 1000000.0,
+		report->intervalNs / 1000000.0);
+
+	if (0u != report->stateCount)
+	{
+		fputs("Idle:", out);
+
+		for (size_t jj = 0; jj < report->stateCount; ++jj)
+		{
+			const IdleStateUsage_t* state = &report->states[jj];
+			fputs((0u != jj) ? ", " : "\t", out);
+			printResidency(out, state->name, state->residencyBp);
+			fprintf(out, " %u /s", state->entriesPerSec);
+		}
+
+		fputc('\n', out);
+	}
+
+	if (report->throttleTracked)
+	{
+		fprintf(out, "Throttling:\tcore %u /s, package %u /s, %zu processors throttled\n",
+			report->coreThrottlesPerSec,
+			report->packageThrottlesPerSec,
+			report->throttledCount);
+	}
+
+	for (size_t ii = 0; printCpus && (ii < report->cpuCount); ++ii)
+	{
+		const IdleCpuUsage_t* usage = &report->cpus[ii];
+
+		const bool throttled = report->throttleTracked &&
+			((0u != usage->coreThrottlesPerSec) || (0u != usage->packageThrottlesPerSec));
+
+		if (!usage->measured || ((0u == report->stateCount) && !throttled))
+		{
+			continue;
+		}
+
+		fprintf(out, "CPU%u idle:", usage->cpu);
+
+		for (size_t jj = 0; jj < report->stateCount; ++jj)
+		{
+			fputs((0u != jj) ? ", " : "\t", out);
+			printResidency(out, report->states[jj].name, usage->residencyBp[jj]);
+		}
+
+		if (throttled)
+		{
+			fprintf(out, "%sthrottled %u /s core, %u /s package",
+				(0u != report->stateCount) ? ", " : "\t",
+				usage->coreThrottlesPerSec,
+				usage->packageThrottlesPerSec);
+		}
+
+		fputc('\n', out);
+	}
+}
@@ -0,0 +1,145 @@
+/**
+ * \file idletrack.h
+ * Idle state residency and thermal throttling of every tracked processor, read from cpuidle and thermal_throttle
+ * sysfs files kept open between scans.
+*/
+#ifndef IDLETRACK_H_INCLUDED
+#define IDLETRACK_H_INCLUDED
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Largest amount of idle states tracked, the deepest ones are kept if processors have more.
+*/
+#define IDLETRACK_STATES_MAX 8u
+
+/**
+ * Length of idle state name buffer, including terminating null character. Longer names are truncated.
+*/
+#define IDLETRACK_NAME_LENGTH 16u
+
+/**
+ * Residency value of state not measured over the last scan, e.g. of processor offline for part of it.
+*/
+#define IDLETRACK_BP_UNKNOWN UINT16_MAX
+
+
+typedef struct IdleTracker IdleTracker_t;
+
+
+/**
+ * Use of a single idle state by every measured processor over the last scan.
+*/
+typedef struct IdleStateUsage
+{
+	/** Mean share of time processors have spent in the state, in basis points. */
+	uint16_t 	residencyBp;
+	/** Entries into the state per second, summed over processors. */
+	uint32_t 	entriesPerSec;
+	/** Name of state, as listed by cpuidle, e.g. "POLL" or "C6". */
+	char 		name[IDLETRACK_NAME_LENGTH];
+}
+IdleStateUsage_t;
+
+
+/**
+ * Idle state residency and thermal throttling of a single processor over the last scan.
+*/
+typedef struct IdleCpuUsage
+{
+	/** Processor number. */
+	unsigned 	cpu;
+	/** Whether processor has been read twice in a row, so that the rest of values are valid. */
+	bool 		measured;
+	/** Share of time spent in every tracked state, in basis points, IDLETRACK_BP_UNKNOWN if state has not been read. */
+	uint16_t 	residencyBp[IDLETRACK_STATES_MAX];
+	/** Thermal throttling events of processor's core and package per second. */
+	uint32_t 	coreThrottlesPerSec;
+	uint32_t 	packageThrottlesPerSec;
+}
+IdleCpuUsage_t;
+
+
+/**
+ * Idle state residency and thermal throttling of every tracked processor over the last full scan.
+*/
+typedef struct IdleUsageReport
+{
+	/** Amount of processors in cpus array, and of those measured. */
+	size_t 		cpuCount;
+	size_t 		measuredCount;
+	/** Amount of tracked states, from the shallowest, in states array and in residency array of every processor. */
+	size_t 		stateCount;
+	/** Amount of files read per processor. */
+	size_t 		filesPerCpu;
+	/** Whether thermal throttling counters are read. */
+	bool 		throttleTracked;
+	/** Amount of processors throttled at least once. */
+	size_t 		throttledCount;
+	/** Thermal throttling events per second, of cores summed over processors, of packages the highest one. */
+	uint32_t 	coreThrottlesPerSec;
+	uint32_t 	packageThrottlesPerSec;
+	/** Length of the scan, from start of the previous one, in nanoseconds. */
+	unsigned long long intervalNs;
+	/** Processor time spent on the scan, in nanoseconds. */
+	unsigned long long scanCostNs;
+	/** Tracked states. */
+	IdleStateUsage_t states[IDLETRACK_STATES_MAX];
+	/** Every tracked processor, in order of CpuCount_getCpuId() indices. */
+	IdleCpuUsage_t cpus[];
+}
+IdleUsageReport_t;
+
+
+/**
+ * \brief Creates idle state tracker of processors tracked at the time of the call, see CpuCount_getCpuId().
+ * States are listed once, from cpuidle directory of the first processor having one.
+ * \param sysRoot Directory containing "cpu" sysfs directory, NULL for TOPOLOGY_SYS_ROOT_DEFAULT.
+ * \param filesPerCpu Largest amount of files read per processor, at least 1. Both thermal throttling counters
+ * are read first if present, followed by time and usage files of as many of the deepest states as fit.
+ * \param slices Amount of IdleTracker_step() calls a full scan of every processor is spread across, at least 1.
+ * \return Pointer to tracker if successful, NULL if no file fits the budget, none is present, or allocation fails.
+*/
+IdleTracker_t* IdleTracker_create(const char* sysRoot, unsigned filesPerCpu, unsigned slices);
+
+
+/**
+ * \brief Destroys idle state tracker, closing every file descriptor. Does nothing if NULL.
+ * \param self Tracker to destroy.
+*/
+void IdleTracker_destroy(IdleTracker_t* self);
+
+
+/**
+ * \brief Reads next slice of tracked processors, every file of which is kept open, in batches through BatchReader.
+ * Files that cannot be read, as is the case for offline processors, are opened again every few scans.
+ * \param self Tracker to advance.
+ * \param report Output buffer, of size retrieved by IdleUsageReport_size() for amount of tracked processors,
+ * filled once a scan following the first one is complete.
+ * \return 1 if report has been filled, 0 if nothing has been reported this step, negative value on error.
+*/
+int IdleTracker_step(IdleTracker_t* self, IdleUsageReport_t* report);
+
+
+/**
+ * \brief Retrieves size of report of given amount of processors.
+ * \param cpuCount Amount of processors, as retrieved by CpuCount_get() when tracker has been created.
+ * \return Size of IdleUsageReport structure, in bytes.
+*/
+size_t IdleUsageReport_size(size_t cpuCount);
+
+
+/**
+ * \brief Prints residency of every tracked state and thermal throttling rates, followed by one line per measured
+ * processor if requested. Prints nothing for zeroed report, as no scan has been completed yet.
+ * \param out Stream to print into.
+ * \param report Report to print.
+ * \param printCpus Whether every measured processor should be printed as well.
+*/
+void IdleUsageReport_print(FILE* out, const IdleUsageReport_t* report, bool printCpus);
+
+
+#endif // !IDLETRACK_H_INCLUDED
@@ -0,0 +1,793 @@
+#include "irqtrack.h"
+#include "helpers.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define PROC_ROOT_DEFAULT 			"/proc"
+#define IRQ_FILE_INITIAL 			16384u
+#define IRQ_SOURCES_INITIAL 		64u
+#define IRQ_LABEL_LENGTH 			16u
+// Processor numbers above this one in a header are taken as a malformed file rather than a huge machine
+#define IRQ_CPU_MAX 				65535u
+#define IRQ_TABLE_INTERRUPTS 		0u
+#define IRQ_TABLE_SOFTIRQS 			1u
+#define IRQ_TABLE_COUNT 			2u
+
+
+/**
+ * Single row of interrupts or softirqs file.
+*/
+typedef struct IrqSource
+{
+	/** Label of row, without colon, e.g. "31", "LOC" or "NET_RX". */
+	char 		label[IRQ_LABEL_LENGTH];
+	/** Name of source, as reported. */
+	char 		name[IRQTRACK_NAME_LENGTH];
+	/** Whether counters of row hold a full sample, so that changes against them are valid. */
+	bool 		valid;
+	/** Whether changes of row have been calculated against the previous sample. */
+	bool 		measured;
+}
+IrqSource_t;
+
+
+/**
+ * Rows of a single file, along with counters of every processor.
+*/
+typedef struct IrqTable
+{
+	/** Descriptor of file, negative if it is not present. */
+	int 			fd;
+	/** Whether file is softirqs one. */
+	bool 			softirq;
+	/** Rows of file, in order of the last sample. */
+	IrqSource_t* 	sources;
+	size_t 			sourceCount;
+	size_t 			sourceCapacity;
+	/** Counters as of the last sample and their changes against the previous one, a row of cpuSlots per source. */
+	unsigned long long* counts;
+	uint32_t* 		changes;
+	/** Processor numbers of columns, as listed by header of the last sample. */
+	uint32_t* 		columns;
+	size_t 			columnCount;
+}
+IrqTable_t;
+
+
+/**
+ * One of the most frequent sources of a processor, found while ranking.
+*/
+typedef struct IrqRanked
+{
+	const IrqTable_t* 	table;
+	size_t 				row;
+	uint32_t 			change;
+}
+IrqRanked_t;
+
+
+struct IrqTracker
+{
+	/** Interrupts and softirqs files. */
+	IrqTable_t 		tables[IRQ_TABLE_COUNT];
+	/** Amount of processor slots of every counter row, one more than the highest processor number seen. */
+	size_t 			cpuSlots;
+	/** Interrupts of every processor over the last interval, from every measured source. */
+	unsigned long long* cpuTotals;
+	/** Contents of file being parsed. */
+	char* 			buf;
+	size_t 			bufCapacity;
+	/** Processor numbers of columns of header being parsed. */
+	uint32_t* 		header;
+	size_t 			headerCapacity;
+	/** Amount of hot processors to report, and their numbers found so far, ordered from the top one. */
+	size_t 			hotCount;
+	uint32_t* 		hot;
+	/** Amount of steps per sample, and the step to be taken next. */
+	unsigned 		slices;
+	unsigned 		slice;
+	/** Points in time of the current and the previous sample, on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long sampleNs;
+	unsigned long long prevSampleNs;
+};
+
+
+/**
+ * \brief Retrieves processor time consumed by the calling thread, in nanoseconds.
+*/
+static unsigned long long threadCpuTimeNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+
+static inline bool isDigit(char c)
+{
+	return (unsigned) (c - '0') <= 9u;
+}
+
+
+/**
+ * \brief Reads whole file into tracker's buffer, growing it as needed, and null-terminates it.
+ * \return Length of read contents, 0 if file cannot be read or is empty.
+*/
+static size_t readFile(IrqTracker_t* self, int fd)
+{
+	size_t length = 0u;
+
+	for (;;)
+	{
+		if (length + 1u == self->bufCapacity)
+		{
+			char* newBuf = realloc(self->buf, 2u * self->bufCapacity);
+
+			if (NULL == newBuf)
+			{
+				return 0u;
+			}
+
+			self->buf = newBuf;
+			self->bufCapacity *= 2u;
+		}
+
+		const ssize_t result = pread(fd, &self->buf[length], self->bufCapacity - 1u - length, (off_t) length);
+
+		if ((0 > result) && (EINTR == errno))
+		{
+			continue;
+		}
+		else if (0 > result)
+		{
+			return 0u;
+		}
+		else if (0 == result)
+		{
+			break;
+		}
+
+		length += (size_t) result;
+	}
+
+	self->buf[length] = '\0';
+	return length;
+}
+
+
+/**
+ * \brief Changes amount of processor slots of every counter row. Counters no longer line up with their processors,
+ * so every source of every table is invalidated.
+*/
+static bool resizeSlots(IrqTracker_t* self, size_t cpuSlots)
+{
+	unsigned long long* cpuTotals = realloc(self->cpuTotals, cpuSlots * sizeof(unsigned long long));
+
+	if (NULL == cpuTotals)
+	{
+		return false;
+	}
+
+	self->cpuTotals = cpuTotals;
+	memset(self->cpuTotals, 0, cpuSlots * sizeof(unsigned long long));
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		IrqTable_t* table = &self->tables[ii];
+		unsigned long long* counts = realloc(table->counts, table->sourceCapacity * cpuSlots * sizeof(unsigned long long));
+
+		if (NULL == counts)
+		{
+			return false;
+		}
+
+		table->counts = counts;
+		uint32_t* changes = realloc(table->changes, table->sourceCapacity * cpuSlots * sizeof(uint32_t));
+
+		if (NULL == changes)
+		{
+			return false;
+		}
+
+		table->changes = changes;
+
+		for (size_t row = 0; row < table->sourceCount; ++row)
+		{
+			table->sources[row].valid = false;
+		}
+	}
+
+	self->cpuSlots = cpuSlots;
+	return true;
+}
+
+
+/**
+ * \brief Makes room for at least given amount of rows in table. Rows already present keep their counters.
+*/
+static bool reserveSources(IrqTable_t* table, size_t count, size_t cpuSlots)
+{
+	if (count <= table->sourceCapacity)
+	{
+		return true;
+	}
+
+	const size_t capacity = (0u != table->sourceCapacity) ? 2u * table->sourceCapacity : IRQ_SOURCES_INITIAL;
+	IrqSource_t* sources = realloc(table->sources, capacity * sizeof(IrqSource_t));
+
+	if (NULL == sources)
+	{
+		return false;
+	}
+
+	table->sources = sources;
+	unsigned long long* counts = realloc(table->counts, capacity * cpuSlots * sizeof(unsigned long long));
+
+	if (NULL == counts)
+	{
+		return false;
+	}
+
+	table->counts = counts;
+	uint32_t* changes = realloc(table->changes, capacity * cpuSlots * sizeof(uint32_t));
+
+	if (NULL == changes)
+	{
+		return false;
+	}
+
+	table->changes = changes;
+	table->sourceCapacity = capacity;
+	return true;
+}
+
+
+/**
+ * \brief Parses "CPU0 CPU1 ..." header into tracker's header buffer.
+ * \param pos Beginning of file, moved past the header line.
+ * \param columnCount Output amount of columns.
+ * \param maxCpu Output highest processor number.
+ * \return Whether header is valid.
+*/
+static bool parseHeader(IrqTracker_t* self, const char** pos, const char* end, size_t* columnCount, uint32_t* maxCpu)
+{
+	const char* cursor = *pos;
+	size_t count = 0u;
+	*maxCpu = 0u;
+
+	for (;;)
+	{
+		while (' ' == *cursor)
+		{
+			++cursor;
+		}
+
+		if ((cursor == end) || ('\n' == *cursor))
+		{
+			break;
+		}
+
+		if ((0 != strncmp(cursor, "CPU", 3u)) || !isDigit(cursor[3]))
+		{
+			return false;
+		}
+
+		unsigned long cpu = 0u;
+
+		for (cursor += 3; isDigit(*cursor); ++cursor)
+		{
+			cpu = 10u * cpu + (unsigned long) (*cursor - '0');
+
+			if (IRQ_CPU_MAX < cpu)
+			{
+				return false;
+			}
+		}
+
+		if (count == self->headerCapacity)
+		{
+			const size_t capacity = (0u != self->headerCapacity) ? 2u * self->headerCapacity : IRQ_SOURCES_INITIAL;
+			uint32_t* header = realloc(self->header, capacity * sizeof(uint32_t));
+
+			if (NULL == header)
+			{
+				return false;
+			}
+
+			self->header = header;
+			self->headerCapacity = capacity;
+		}
+
+		self->header[count++] = (uint32_t) cpu;
+		*maxCpu = (*maxCpu < cpu) ? (uint32_t) cpu : *maxCpu;
+	}
+
+	*pos = (cursor < end) ? cursor + 1 : end;
+	*columnCount = count;
+	return 0u != count;
+}
+
+
+/**
+ * \brief Names source of a newly seen row, after it's label and description following counters:
+ * the last word of it for numbered interrupts, which is the device, or the whole of it for symbolic ones.
+*/
+static void nameSource(IrqSource_t* source, const char* description, const char* eol)
+{
+	while ((description < eol) && (' ' == *description))
+	{
+		++description;
+	}
+
+	while ((description < eol) && (' ' == eol[-1]))
+	{
+		--eol;
+	}
+
+	if (isDigit(source->label[0]))
+	{
+		const char* word = eol;
+
+		while ((word > description) && (' ' != word[-1]))
+		{
+			--word;
+		}
+
+		description = word;
+	}
+
+	if (description == eol)
+	{
+		snprintf(source->name, sizeof(source->name), "%s", source->label);
+	}
+	else
+	{
+		snprintf(source->name, sizeof(source->name), "%s %.*s", source->label, (int) (eol - description), description);
+	}
+}
+
+
+/**
+ * \brief Parses a single row, storing counters of every column into slots of their processors
+ * and accumulating changes of measured rows into totals of processors.
+ * \param pos Beginning of row, moved to the beginning of the next one.
+ * \return Whether line was a row, false if it has been skipped or there is no memory for it.
+*/
+static bool parseRow(IrqTracker_t* self, IrqTable_t* table, size_t row, const char** pos, const char* end)
+{
+	const char* cursor = *pos;
+	const char* eol = memchr(cursor, '\n', (size_t) (end - cursor));
+	eol = (NULL != eol) ? eol : end;
+	*pos = (eol < end) ? eol + 1 : end;
+
+	while ((cursor < eol) && (' ' == *cursor))
+	{
+		++cursor;
+	}
+
+	const char* colon = memchr(cursor, ':', (size_t) (eol - cursor));
+
+	if ((NULL == colon) || (cursor == colon) || !reserveSources(table, row + 1u, self->cpuSlots))
+	{
+		return false;
+	}
+
+	IrqSource_t* source = &table->sources[row];
+	const size_t labelLength = (size_t) (colon - cursor) < IRQ_LABEL_LENGTH ? (size_t) (colon - cursor) : IRQ_LABEL_LENGTH - 1u;
+	const bool renamed = (row >= table->sourceCount) ||
+		(0 != strncmp(source->label, cursor, labelLength)) || ('\0' != source->label[labelLength]);
+
+	if (renamed)
+	{
+		memcpy(source->label, cursor, labelLength);
+		source->label[labelLength] = '\0';
+		source->valid = false;
+	}
+
+	// Columns are dense runs of digits padded with spaces, parsed in place without tokenizing the line
+	const bool wasValid = source->valid;
+	const size_t slots = self->cpuSlots;
+	unsigned long long* counts = &table->counts[row * slots];
+	uint32_t* changes = &table->changes[row * slots];
+	size_t column = 0u;
+	cursor = colon + 1;
+
+	for (; column < table->columnCount; ++column)
+	{
+		while (' ' == *cursor)
+		{
+			++cursor;
+		}
+
+		if (!isDigit(*cursor))
+		{
+			break;
+		}
+
+		unsigned long long value = 0u;
+
+		do
+		{
+			value = 10u * value + (unsigned long long) (*cursor++ - '0');
+		}
+		while (isDigit(*cursor));
+
+		const uint32_t cpu = table->columns[column];
+		const uint32_t change = (wasValid && (value >= counts[cpu])) ? (uint32_t) (value - counts[cpu]) : 0u;
+		changes[cpu] = change;
+		counts[cpu] = value;
+		self->cpuTotals[cpu] += change;
+	}
+
+	// Rows of fewer values than columns, such as "ERR" one, are not per-processor
+	source->valid = (column == table->columnCount);
+	source->measured = wasValid && source->valid;
+
+	if (renamed)
+	{
+		nameSource(source, cursor, eol);
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Reads and parses a single file.
+ * \param comparable Cleared if counters of any table have been invalidated by new processor slots.
+*/
+static bool sampleTable(IrqTracker_t* self, IrqTable_t* table, bool* comparable)
+{
+	const size_t length = readFile(self, table->fd);
+
+	if (0u == length)
+	{
+		return false;
+	}
+
+	const char* pos = self->buf;
+	const char* end = &self->buf[length];
+	size_t columnCount;
+	uint32_t maxCpu;
+
+	if (!parseHeader(self, &pos, end, &columnCount, &maxCpu))
+	{
+		return false;
+	}
+
+	if (maxCpu >= self->cpuSlots)
+	{
+		if (!resizeSlots(self, (size_t) maxCpu + 1u))
+		{
+			return false;
+		}
+
+		*comparable = false;
+	}
+
+	// Processors going offline or online shift columns, counters of every row are then taken anew
+	if ((columnCount != table->columnCount) || (0 != memcmp(table->columns, self->header, columnCount * sizeof(uint32_t))))
+	{
+		uint32_t* columns = realloc(table->columns, columnCount * sizeof(uint32_t));
+
+		if (NULL == columns)
+		{
+			return false;
+		}
+
+		table->columns = columns;
+		table->columnCount = columnCount;
+		memcpy(table->columns, self->header, columnCount * sizeof(uint32_t));
+
+		for (size_t row = 0; row < table->sourceCount; ++row)
+		{
+			table->sources[row].valid = false;
+		}
+	}
+
+	size_t row = 0u;
+
+	while (pos < end)
+	{
+		row += parseRow(self, table, row, &pos, end) ? 1u : 0u;
+	}
+
+	table->sourceCount = row;
+	return true;
+}
+
+
+/**
+ * \brief Finds hot processors, by interrupts over the last interval, ordered from the top one.
+ * \return Amount of hot processors found.
+*/
+static size_t rankCpus(IrqTracker_t* self)
+{
+	size_t count = 0u;
+
+	for (size_t cpu = 0; cpu < self->cpuSlots; ++cpu)
+	{
+		const unsigned long long total = self->cpuTotals[cpu];
+
+		if ((0u == total) || ((count == self->hotCount) && (total <= self->cpuTotals[self->hot[count - 1u]])))
+		{
+			continue;
+		}
+
+		size_t position = (count < self->hotCount) ? count++ : count - 1u;
+
+		while ((0u < position) && (self->cpuTotals[self->hot[position - 1u]] < total))
+		{
+			self->hot[position] = self->hot[position - 1u];
+			--position;
+		}
+
+		self->hot[position] = (uint32_t) cpu;
+	}
+
+	return count;
+}
+
+
+/**
+ * \brief Finds the most frequent measured sources of a single processor, ordered from the top one.
+ * \return Amount of sources found.
+*/
+static size_t rankSources(const IrqTracker_t* self, uint32_t cpu, IrqRanked_t* top)
+{
+	size_t count = 0u;
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		const IrqTable_t* table = &self->tables[ii];
+
+		for (size_t row = 0; row < table->sourceCount; ++row)
+		{
+			const uint32_t change = table->changes[row * self->cpuSlots + cpu];
+
+			if (!table->sources[row].measured || (0u == change) ||
+				((IRQTRACK_SOURCES_PER_CPU == count) && (change <= top[count - 1u].change)))
+			{
+				continue;
+			}
+
+			size_t position = (count < IRQTRACK_SOURCES_PER_CPU) ? count++ : count - 1u;
+
+			while ((0u < position) && (top[position - 1u].change < change))
+			{
+				top[position] = top[position - 1u];
+				--position;
+			}
+
+			top[position] = (IrqRanked_t) { .table = table, .row = row, .change = change };
+		}
+	}
+
+	return count;
+}
+
+
+static inline uint32_t ratePerSec(unsigned long long change, unsigned long long intervalNs)
+{
+	const unsigned long long rate = change * 1000000000ull / intervalNs;
+	return (UINT32_MAX < rate) ? UINT32_MAX : (uint32_t) rate;
+}
+
+
+IrqTracker_t* IrqTracker_create(const char* procRoot, size_t hotCount, unsigned slices)
+{
+	if ((0u == hotCount) || (0u == slices))
+	{
+		goto error_exit_1;
+	}
+
+	if (NULL == procRoot)
+	{
+		procRoot = PROC_ROOT_DEFAULT;
+	}
+
+	IrqTracker_t* self = calloc(1u, sizeof(IrqTracker_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	static const char* const FILE_NAMES[IRQ_TABLE_COUNT] =
+	{
+		[IRQ_TABLE_INTERRUPTS] 	= "interrupts",
+		[IRQ_TABLE_SOFTIRQS] 	= "softirqs"
+	};
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		char path[PATH_MAX];
+		IrqTable_t* table = &self->tables[ii];
+		table->softirq = (IRQ_TABLE_SOFTIRQS == ii);
+		table->fd = ((size_t) snprintf(path, sizeof(path), "%s/%s", procRoot, FILE_NAMES[ii]) < sizeof(path)) ?
+			open(path, O_RDONLY | O_CLOEXEC) : -1;
+	}
+
+	if ((0 > self->tables[IRQ_TABLE_INTERRUPTS].fd) && (0 > self->tables[IRQ_TABLE_SOFTIRQS].fd))
+	{
+		goto error_exit_2;
+	}
+
+	self->bufCapacity = IRQ_FILE_INITIAL;
+	self->buf = malloc(self->bufCapacity);
+	self->hot = malloc(hotCount * sizeof(uint32_t));
+
+	if ((NULL == self->buf) || (NULL == self->hot))
+	{
+		goto error_exit_3;
+	}
+
+	self->hotCount 	= hotCount;
+	self->slices 	= slices;
+	return self;
+
+error_exit_3:
+	free(self->hot);
+	free(self->buf);
+error_exit_2:
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		if (0 <= self->tables[ii].fd)
+		{
+			close(self->tables[ii].fd);
+		}
+	}
+
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void IrqTracker_destroy(IrqTracker_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		IrqTable_t* table = &self->tables[ii];
+
+		if (0 <= table->fd)
+		{
+			close(table->fd);
+		}
+
+		free(table->columns);
+		free(table->changes);
+		free(table->counts);
+		free(table->sources);
+	}
+
+	free(self->hot);
+	free(self->header);
+	free(self->buf);
+	free(self->cpuTotals);
+	free(self);
+}
+
+
+int IrqTracker_step(IrqTracker_t* self, IrqUsageReport_t* report)
+{
+	if ((NULL == self) || (NULL == report))
+	{
+		return -1;
+	}
+
+	const unsigned slice = self->slice;
+	self->slice = (self->slice + 1u) % self->slices;
+
+	if (0u != slice)
+	{
+		return 0;
+	}
+
+	const unsigned long long costStartNs = threadCpuTimeNs();
+	self->prevSampleNs = self->sampleNs;
+	self->sampleNs = MonotonicTimeNs();
+
+	if (0u != self->cpuSlots)
+	{
+		memset(self->cpuTotals, 0, self->cpuSlots * sizeof(unsigned long long));
+	}
+
+	bool comparable = (0u != self->prevSampleNs);
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		if ((0 <= self->tables[ii].fd) && !sampleTable(self, &self->tables[ii], &comparable))
+		{
+			return -2;
+		}
+	}
+
+	if (!comparable)
+	{
+		return 0;
+	}
+
+	const unsigned long long intervalNs = self->sampleNs - self->prevSampleNs;
+	report->count 		= rankCpus(self);
+	report->cpuCount 	= 0u;
+	report->sourceCount = 0u;
+	report->intervalNs 	= intervalNs;
+
+	for (size_t ii = 0; ii < IRQ_TABLE_COUNT; ++ii)
+	{
+		const IrqTable_t* table = &self->tables[ii];
+		report->cpuCount = (report->cpuCount < table->columnCount) ? table->columnCount : report->cpuCount;
+		report->sourceCount += table->sourceCount;
+	}
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		IrqRanked_t top[IRQTRACK_SOURCES_PER_CPU];
+		IrqCpuUsage_t* usage = &report->hot[ii];
+		usage->cpu 			= self->hot[ii];
+		usage->perSec 		= ratePerSec(self->cpuTotals[usage->cpu], intervalNs);
+		usage->sourceCount 	= (uint32_t) rankSources(self, usage->cpu, top);
+
+		for (size_t jj = 0; jj < usage->sourceCount; ++jj)
+		{
+			IrqSourceUsage_t* source = &usage->sources[jj];
+			source->perSec 	= ratePerSec(top[jj].change, intervalNs);
+			source->softirq = top[jj].table->softirq;
+			memcpy(source->name, top[jj].table->sources[top[jj].row].name, IRQTRACK_NAME_LENGTH);
+		}
+	}
+
+	report->scanCostNs = threadCpuTimeNs() - costStartNs;
+	return 1;
+}
+
+
+size_t IrqUsageReport_size(size_t hotCount)
+{
+	return sizeof(IrqUsageReport_t) + hotCount * sizeof(IrqCpuUsage_t);
+}
+
+
+void IrqUsageReport_print(FILE* out, const IrqUsageReport_t* report)
+{
+	if ((NULL == out) || (NULL == report) || (0u == report->cpuCount))
+	{
+		return;
+	}
+
+	fprintf(out, "Interrupts:\t%zu sources on %zu processors, read took %.2f ms of CPU every %.1f ms\n",
+		report->sourceCount,
+		report->cpuCount,
+		report->scanCostNs / 1000000.0,
+		report->intervalNs / 1000000.0);
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		const IrqCpuUsage_t* usage = &report->hot[ii];
+		fprintf(out, "CPU%u:\t%u /s", usage->cpu, usage->perSec);
+
+		for (size_t jj = 0; jj < usage->sourceCount; ++jj)
+		{
+			const IrqSourceUsage_t* source = &usage->sources[jj];
+			fprintf(out, "%s%s%s %u /s",
+				(0u != jj) ? ", " : "\t",
+				source->name,
+				source->softirq ? " (softirq)" : "",
+				source->perSec);
+		}
+
+		fputc('\n', out);
+	}
+}
@@ -0,0 +1,129 @@
+/**
+ * \file irqtrack.h
+ * Distribution of hardware interrupts and softirqs across processors, read from /proc/interrupts
+ * and /proc/softirqs files kept open between samples.
+*/
+#ifndef IRQTRACK_H_INCLUDED
+#define IRQTRACK_H_INCLUDED
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Amount of sources reported for every processor, from the most frequent one.
+*/
+#define IRQTRACK_SOURCES_PER_CPU 4u
+
+/**
+ * Length of reported source name buffer, including terminating null character. Longer names are truncated.
+*/
+#define IRQTRACK_NAME_LENGTH 32u
+
+
+typedef struct IrqTracker IrqTracker_t;
+
+
+/**
+ * Rate of a single interrupt source on a single processor.
+*/
+typedef struct IrqSourceUsage
+{
+	/** Amount of interrupts per second. */
+	uint32_t 	perSec;
+	/** Whether source is a softirq, rather than a line of /proc/interrupts. */
+	bool 		softirq;
+	/**
+	 * Name of source: interrupt number followed by device, e.g. "31 eth0-rx-0", symbolic one followed by
+	 * it's description, e.g. "LOC Local timer interrupts", or softirq name, e.g. "NET_RX".
+	*/
+	char 		name[IRQTRACK_NAME_LENGTH];
+}
+IrqSourceUsage_t;
+
+
+/**
+ * Interrupts of a single processor over the last interval, with it's most frequent sources.
+*/
+typedef struct IrqCpuUsage
+{
+	/** Processor number. */
+	unsigned 	cpu;
+	/** Amount of interrupts and softirqs per second, from every source. */
+	uint32_t 	perSec;
+	/** Amount of sources in sources array. */
+	uint32_t 	sourceCount;
+	/** Most frequent sources, from the top one. */
+	IrqSourceUsage_t sources[IRQTRACK_SOURCES_PER_CPU];
+}
+IrqCpuUsage_t;
+
+
+/**
+ * Processors handling the most interrupts over the last interval, from the top one.
+*/
+typedef struct IrqUsageReport
+{
+	/** Amount of processors in hot array. */
+	size_t 		count;
+	/** Amount of processors listed by both files. */
+	size_t 		cpuCount;
+	/** Amount of interrupt sources and softirqs tracked. */
+	size_t 		sourceCount;
+	/** Length of the interval, in nanoseconds. */
+	unsigned long long intervalNs;
+	/** Processor time spent on reading both files, in nanoseconds. */
+	unsigned long long scanCostNs;
+	/** Hot processors. */
+	IrqCpuUsage_t hot[];
+}
+IrqUsageReport_t;
+
+
+/**
+ * \brief Creates interrupt tracker.
+ * \param procRoot Directory holding "interrupts" and "softirqs" files, NULL for "/proc".
+ * At least one of them has to be present.
+ * \param hotCount Amount of processors handling the most interrupts to report, at least 1.
+ * \param slices Amount of IrqTracker_step() calls per sample of both files, at least 1.
+ * \return Pointer to tracker if successful, NULL otherwise.
+*/
+IrqTracker_t* IrqTracker_create(const char* procRoot, size_t hotCount, unsigned slices);
+
+
+/**
+ * \brief Destroys interrupt tracker, closing every file descriptor. Does nothing if NULL.
+ * \param self Tracker to destroy.
+*/
+void IrqTracker_destroy(IrqTracker_t* self);
+
+
+/**
+ * \brief Advances tracker by one step. The first step of every slices ones samples both files, parsing every row
+ * as a run of per-processor columns, and calculates per-processor rates of every source against the previous sample.
+ * \param self Tracker to advance.
+ * \param report Output buffer, of size retrieved by IrqUsageReport_size(), filled once files have been sampled twice.
+ * \return 1 if report has been filled, 0 if nothing has been reported this step, negative value on error.
+*/
+int IrqTracker_step(IrqTracker_t* self, IrqUsageReport_t* report);
+
+
+/**
+ * \brief Retrieves size of report of given amount of hot processors.
+ * \param hotCount Amount of hot processors.
+ * \return Size of IrqUsageReport structure, in bytes.
+*/
+size_t IrqUsageReport_size(size_t hotCount);
+
+
+/**
+ * \brief Prints hot processors, one line per processor, followed by it's top sources.
+ * Prints nothing for zeroed report, as no interval has been sampled yet.
+ * \param out Stream to print into.
+ * \param report Report to print.
+*/
+void IrqUsageReport_print(FILE* out, const IrqUsageReport_t* report);
+
+
+#endif // !IRQTRACK_H_INCLUDED
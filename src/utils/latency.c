@@ -0,0 +1,125 @@
+#include "latency.h"
+#include "helpers.h"
+#include <string.h>
+
+
+#define NANOSECONDS_IN_MILLISECOND 1000000.0
+
+
+/**
+ * Histograms of every span. Written by printer thread, may be read by any thread.
+*/
+static Histogram_t g_spanHistograms[LSPAN_COUNT_];
+
+static const char* SPAN_NAMES[LSPAN_COUNT_] =
+{
+	[LSPAN_INPUT_QUEUE] 	= "input queue",
+	[LSPAN_ANALYSIS] 		= "analysis",
+	[LSPAN_OUTPUT_QUEUE] 	= "output queue",
+	[LSPAN_PRINT] 			= "print",
+	[LSPAN_END_TO_END] 		= "end-to-end"
+};
+
+/**
+ * Boundaries of every span.
+*/
+static const LatencyStage_t SPAN_BOUNDS[LSPAN_COUNT_][2] =
+{
+	[LSPAN_INPUT_QUEUE] 	= { LSTAGE_READ, 			LSTAGE_ANALYZER_IN },
+	[LSPAN_ANALYSIS] 		= { LSTAGE_ANALYZER_IN, 	LSTAGE_ANALYZER_OUT },
+	[LSPAN_OUTPUT_QUEUE] 	= { LSTAGE_ANALYZER_OUT, 	LSTAGE_PRINTER_IN },
+	[LSPAN_PRINT] 			= { LSTAGE_PRINTER_IN, 		LSTAGE_PRINTED },
+	[LSPAN_END_TO_END] 		= { LSTAGE_READ, 			LSTAGE_PRINTED }
+};
+
+
+void Latency_mark(LatencyStamps_t* stamps, LatencyStage_t stage)
+{
+	if ((NULL == stamps) || ((unsigned) stage >= LSTAGE_COUNT_))
+	{
+		return;
+	}
+
+	if (LSTAGE_READ == stage)
+	{
+		memset(stamps, 0, sizeof(LatencyStamps_t));
+	}
+
+	stamps->ns[stage] = MonotonicTimeNs();
+}
+
+
+void Latency_record(const LatencyStamps_t* stamps)
+{
+	if (NULL == stamps)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < LSPAN_COUNT_; ++ii)
+	{
+		const unsigned long long begin = stamps->ns[SPAN_BOUNDS[ii][0]];
+		const unsigned long long end = stamps->ns[SPAN_BOUNDS[ii][1]];
+
+		if ((0u != begin) && (end >= begin))
+		{
+			Histogram_record(&g_spanHistograms[ii], end - begin);
+		}
+	}
+}
+
+
+const Histogram_t* Latency_getHistogram(LatencySpan_t span)
+{
+	return ((unsigned) span < LSPAN_COUNT_) ? &g_spanHistograms[span] : NULL;
+}
+
+
+const char* Latency_getSpanName(LatencySpan_t span)
+{
+	return ((unsigned) span < LSPAN_COUNT_) ? SPAN_NAMES[span] : "unknown";
+}
+
+
+void Latency_reset(void)
+{
+	for (size_t ii = 0; ii < LSPAN_COUNT_; ++ii)
+	{
+		Histogram_reset(&g_spanHistograms[ii]);
+	}
+}
+
+
+void Latency_printSummary(FILE* stream)
+{
+	if (NULL == stream)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < LSPAN_COUNT_; ++ii)
+	{
+		const Histogram_t* histogram = &g_spanHistograms[ii];
+
+		fprintf(stream, "Latency %s:\tp50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+			SPAN_NAMES[ii],
+			Histogram_percentile(histogram, 50.0) / NANOSECONDS_IN_MILLISECOND,
+			Histogram_percentile(histogram, 99.0) / NANOSECONDS_IN_MILLISECOND,
+			Histogram_max(histogram) / NANOSECONDS_IN_MILLISECOND);
+	}
+}
+
+
+void Latency_printHistograms(FILE* stream)
+{
+	if (NULL == stream)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < LSPAN_COUNT_; ++ii)
+	{
+		fprintf(stream, "Latency histogram %s (ns), %llu samples:\n", SPAN_NAMES[ii], Histogram_count(&g_spanHistograms[ii]));
+		Histogram_print(&g_spanHistograms[ii], stream);
+	}
+}
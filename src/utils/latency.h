@@ -0,0 +1,127 @@
+/**
+ * \file latency.h
+ * Tracing of latency of samples flowing through the pipeline, from the moment they are read until their
+ * usage statistics are printed. Every sample carries monotonic timestamps of stage boundaries it has crossed,
+ * and once printed, time spent between boundaries is recorded in process-wide histograms.
+*/
+#ifndef LATENCY_H_INCLUDED
+#define LATENCY_H_INCLUDED
+#include <stdio.h>
+#include "histogram.h"
+
+
+/**
+ * Stage boundaries crossed by every sample, in order.
+*/
+typedef enum LatencyStage
+{
+	/** Sample has been read by reader thread and is about to be queued for analyzer. */
+	LSTAGE_READ = 0,
+
+	/** Sample has been taken out of the queue by analyzer thread. */
+	LSTAGE_ANALYZER_IN,
+
+	/** Usage statistics calculated from the sample are about to be queued for printer. */
+	LSTAGE_ANALYZER_OUT,
+
+	/** Usage statistics have been taken out of the queue by printer thread. */
+	LSTAGE_PRINTER_IN,
+
+	/** Usage statistics have been printed. */
+	LSTAGE_PRINTED,
+
+	/** Amount of values in this enum, not a valid value by itself. */
+	LSTAGE_COUNT_
+}
+LatencyStage_t;
+
+
+/**
+ * Time intervals between stage boundaries, each with it's own histogram.
+*/
+typedef enum LatencySpan
+{
+	/** Time spent in queue between reader and analyzer, LSTAGE_READ to LSTAGE_ANALYZER_IN. */
+	LSPAN_INPUT_QUEUE = 0,
+
+	/** Time spent in analyzer, LSTAGE_ANALYZER_IN to LSTAGE_ANALYZER_OUT. */
+	LSPAN_ANALYSIS,
+
+	/** Time spent in queue between analyzer and printer, LSTAGE_ANALYZER_OUT to LSTAGE_PRINTER_IN. */
+	LSPAN_OUTPUT_QUEUE,
+
+	/** Time spent printing, LSTAGE_PRINTER_IN to LSTAGE_PRINTED. */
+	LSPAN_PRINT,
+
+	/** Time from reading the sample until it's usage statistics have been printed. */
+	LSPAN_END_TO_END,
+
+	/** Amount of values in this enum, not a valid value by itself. */
+	LSPAN_COUNT_
+}
+LatencySpan_t;
+
+
+/**
+ * Timestamps of stage boundaries crossed by a single sample, on CLOCK_MONOTONIC, in nanoseconds.
+ * Zero marks boundary not crossed yet.
+*/
+typedef struct LatencyStamps
+{
+	unsigned long long ns[LSTAGE_COUNT_];
+}
+LatencyStamps_t;
+
+
+/**
+ * \brief Stamps given stage boundary with current time. Stamping LSTAGE_READ clears every later stamp.
+ * \param stamps Timestamps of the sample.
+ * \param stage Boundary crossed by the sample.
+*/
+void Latency_mark(LatencyStamps_t* stamps, LatencyStage_t stage);
+
+
+/**
+ * \brief Records every span of given sample, whose both boundaries have been stamped, in span histograms.
+ * \param stamps Timestamps of the sample.
+*/
+void Latency_record(const LatencyStamps_t* stamps);
+
+
+/**
+ * \brief Retrieves histogram of given span, values of which are in nanoseconds.
+ * \param span Span.
+ * \return Pointer to histogram, NULL if span is not valid.
+*/
+const Histogram_t* Latency_getHistogram(LatencySpan_t span);
+
+
+/**
+ * \brief Retrieves human-readable name of given span.
+ * \param span Span.
+ * \return Name of the span.
+*/
+const char* Latency_getSpanName(LatencySpan_t span);
+
+
+/**
+ * \brief Removes every recorded value from span histograms.
+*/
+void Latency_reset(void);
+
+
+/**
+ * \brief Prints median, 99th percentile and maximum of every span, one per line, in milliseconds.
+ * \param stream Stream to print into.
+*/
+void Latency_printSummary(FILE* stream);
+
+
+/**
+ * \brief Prints every non-empty bucket of every span histogram, in nanoseconds.
+ * \param stream Stream to print into.
+*/
+void Latency_printHistograms(FILE* stream);
+
+
+#endif // !LATENCY_H_INCLUDED
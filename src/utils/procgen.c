@@ -0,0 +1,390 @@
+#include "procgen.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+
+#define PROCGEN_INITIAL_UPTIME_S 		86400u
+#define PROCGEN_WAVE_AMPLITUDE_PCT 		40.0
+#define PROCGEN_WAVE_PERIOD_S 			60.0
+#define PROCGEN_RANDOM_STEP_PCT 		10.0
+#define PROCGEN_HOTSPOT_SPACING 		16u
+#define PROCGEN_HOTSPOT_MOVE_PERIOD_S 	10u
+#define PROCGEN_TMP_FILE_NAME 			"/.stat.tmp"
+#define PROCGEN_FILE_NAME 				"/stat"
+#define PROCGEN_PI 						3.14159265358979323846
+
+
+/**
+ * Share of busy time spent in every busy state, in hundredths.
+*/
+static const unsigned BUSY_SHARES[CSINDEX_COUNT_] =
+{
+	[CSINDEX_USER] 		= 70u,
+	[CSINDEX_NICE] 		= 3u,
+	[CSINDEX_SYSTEM] 	= 20u,
+	[CSINDEX_IRQ] 		= 2u,
+	[CSINDEX_SOFTIRQ] 	= 5u
+};
+
+/**
+ * Share of idle time spent in every idle state, in hundredths.
+*/
+static const unsigned IDLE_SHARES[CSINDEX_COUNT_] =
+{
+	[CSINDEX_IDLE] 		= 95u,
+	[CSINDEX_IOWAIT] 	= 5u
+};
+
+static const char* PATTERN_NAMES[PROCGEN_PATTERN_COUNT_] =
+{
+	[PROCGEN_PATTERN_CONSTANT] 	= "constant",
+	[PROCGEN_PATTERN_WAVE] 		= "wave",
+	[PROCGEN_PATTERN_RANDOM] 	= "random",
+	[PROCGEN_PATTERN_HOTSPOT] 	= "hotspot"
+};
+
+
+/**
+ * State of single generated processor.
+*/
+typedef struct GeneratedCpu
+{
+	/** Counters, as they appear in the file. */
+	CpuStat_t 	stat;
+	/** Fractions of ticks not yet added to counters. */
+	double 		carry[CSINDEX_COUNT_];
+	/** Current load, in percentage. Only used by random pattern. */
+	double 		loadPct;
+}
+GeneratedCpu_t;
+
+
+struct ProcGen
+{
+	/** Amount of generated processors. */
+	size_t 				cpuCount;
+	/** Shape of applied load. */
+	ProcGenPattern_t 	pattern;
+	/** Base load, in percentage. */
+	double 				baseLoadPct;
+	/** Simulated time elapsed since generator creation, in milliseconds. */
+	unsigned long long 	elapsedMs;
+	/** Pseudo-random number generator state. */
+	unsigned 			rngState;
+	/** Boot time reported in "btime" line, seconds since Epoch. */
+	unsigned long long 	bootTime;
+	/** Generated processors. */
+	GeneratedCpu_t* 	cpus;
+};
+
+
+/**
+ * \brief Generates next pseudo-random number (xorshift32).
+ * \return Number in 0-1 range.
+*/
+static double nextRandom(ProcGen_t* self)
+{
+	unsigned x = self->rngState;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	self->rngState = x;
+	return (double) x / (double) UINT_MAX;
+}
+
+
+static double clampLoad(double loadPct)
+{
+	return (loadPct < 0.0) ? 0.0 : ((loadPct > 100.0) ? 100.0 : loadPct);
+}
+
+
+/**
+ * \brief Calculates load of given processor at current simulated time.
+*/
+static double cpuLoad(ProcGen_t* self, size_t index)
+{
+	const double timeS = (double) self->elapsedMs / 1000.0;
+
+	switch (self->pattern)
+	{
+		case PROCGEN_PATTERN_WAVE:
+		{
+			const double phase = 2.0 * PROCGEN_PI * ((timeS / PROCGEN_WAVE_PERIOD_S) + (double) index / (double) self->cpuCount);
+			return clampLoad(self->baseLoadPct + PROCGEN_WAVE_AMPLITUDE_PCT * sin(phase));
+		}
+
+		case PROCGEN_PATTERN_RANDOM:
+		{
+			GeneratedCpu_t* cpu = &self->cpus[index];
+			cpu->loadPct = clampLoad(cpu->loadPct + (2.0 * nextRandom(self) - 1.0) * PROCGEN_RANDOM_STEP_PCT);
+			return cpu->loadPct;
+		}
+
+		case PROCGEN_PATTERN_HOTSPOT:
+		{
+			const size_t shift = (size_t) (self->elapsedMs / (PROCGEN_HOTSPOT_MOVE_PERIOD_S * 1000u));
+			return (0u == (index + shift) % PROCGEN_HOTSPOT_SPACING) ? 100.0 : self->baseLoadPct;
+		}
+
+		default:
+		{
+			return self->baseLoadPct;
+		}
+	}
+}
+
+
+/**
+ * \brief Adds given amount of ticks to processor counters, split between states according to load.
+*/
+static void addTicks(GeneratedCpu_t* cpu, double ticks, double loadPct)
+{
+	const double busyTicks = ticks * loadPct / 100.0;
+	const double idleTicks = ticks - busyTicks;
+
+	for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+	{
+		cpu->carry[ii] += (busyTicks * BUSY_SHARES[ii] + idleTicks * IDLE_SHARES[ii]) / 100.0;
+		const double whole = floor(cpu->carry[ii]);
+		cpu->stat.values[ii] += (CpuStatValue_t) whole;
+		cpu->carry[ii] -= whole;
+	}
+}
+
+
+int ProcGen_parsePattern(const char* name, ProcGenPattern_t* pattern)
+{
+	if ((NULL == name) || (NULL == pattern))
+	{
+		return -1;
+	}
+
+	for (int ii = 0; ii < PROCGEN_PATTERN_COUNT_; ++ii)
+	{
+		if (0 == strcmp(name, PATTERN_NAMES[ii]))
+		{
+			*pattern = (ProcGenPattern_t) ii;
+			return 0;
+		}
+	}
+
+	return -2;
+}
+
+
+ProcGen_t* ProcGen_create(size_t cpuCount, ProcGenPattern_t pattern, double baseLoadPct, unsigned seed)
+{
+	if ((0u == cpuCount) || ((unsigned) pattern >= PROCGEN_PATTERN_COUNT_) || (baseLoadPct < 0.0) || (baseLoadPct > 100.0))
+	{
+		goto error_exit_1;
+	}
+
+	ProcGen_t* self = calloc(1u, sizeof(ProcGen_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	self->cpus = calloc(cpuCount, sizeof(GeneratedCpu_t));
+
+	if (NULL == self->cpus)
+	{
+		goto error_exit_2;
+	}
+
+	self->cpuCount 		= cpuCount;
+	self->pattern 		= pattern;
+	self->baseLoadPct 	= baseLoadPct;
+	self->rngState 		= (0u != seed) ? seed : 1u;
+	self->bootTime 		= (unsigned long long) time(NULL) - PROCGEN_INITIAL_UPTIME_S;
+
+	// Start as if machine has been up for a while, with processors having seen slightly different load
+	for (size_t ii = 0; ii < cpuCount; ++ii)
+	{
+		self->cpus[ii].loadPct = baseLoadPct;
+		addTicks(&self->cpus[ii], (double) PROCGEN_INITIAL_UPTIME_S * PROCGEN_TICKS_PER_SECOND,
+			clampLoad(baseLoadPct + (2.0 * nextRandom(self) - 1.0) * PROCGEN_RANDOM_STEP_PCT));
+	}
+
+	return self;
+
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void ProcGen_destroy(ProcGen_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	free(self->cpus);
+	free(self);
+}
+
+
+void ProcGen_advance(ProcGen_t* self, unsigned elapsedMs)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	const double ticks = (double) elapsedMs * PROCGEN_TICKS_PER_SECOND / 1000.0;
+
+	// Load is sampled at the middle of the step, which keeps wave pattern symmetric regardless of step length
+	self->elapsedMs += elapsedMs / 2u;
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		addTicks(&self->cpus[ii], ticks, cpuLoad(self, ii));
+	}
+
+	self->elapsedMs += elapsedMs - elapsedMs / 2u;
+}
+
+
+int ProcGen_getCpuStat(const ProcGen_t* self, size_t index, CpuStat_t* out)
+{
+	if ((NULL == self) || (NULL == out) || (index > self->cpuCount))
+	{
+		return -1;
+	}
+
+	if (0u != index)
+	{
+		*out = self->cpus[index - 1u].stat;
+		return 0;
+	}
+
+	// Total line is a sum of all processors, as in the kernel
+	memset(out, 0, sizeof(CpuStat_t));
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			out->values[jj] += self->cpus[ii].stat.values[jj];
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * \brief Writes single "cpu(N)" line.
+*/
+static int writeCpuLine(FILE* stream, const char* label, const CpuStat_t* stat)
+{
+	const CpuStatValue_t* v = stat->values;
+
+	return (0 > fprintf(stream, "%s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu\n",
+		label, v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], v[8], v[9])) ? -1 : 0;
+}
+
+
+int ProcGen_write(const ProcGen_t* self, FILE* stream)
+{
+	if ((NULL == self) || (NULL == stream))
+	{
+		return -1;
+	}
+
+	CpuStat_t total;
+	ProcGen_getCpuStat(self, 0u, &total);
+
+	// Kernel pads total line label with two spaces
+	if (0 != writeCpuLine(stream, "cpu ", &total))
+	{
+		return -2;
+	}
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		char label[32];
+		snprintf(label, sizeof(label), "cpu%zu", ii);
+
+		if (0 != writeCpuLine(stream, label, &self->cpus[ii].stat))
+		{
+			return -2;
+		}
+	}
+
+	// Remaining lines only need to look plausible, their values are derived from processor counters
+	const unsigned long long interrupts = total.values[CSINDEX_IRQ] * 50u + total.values[CSINDEX_SYSTEM];
+	const unsigned long long softirqs = total.values[CSINDEX_SOFTIRQ] * 20u;
+
+	if (0 > fprintf(stream,
+		"intr %llu 0 9 0 0 0 0 0 0 1 0 0 0 0\n"
+		"ctxt %llu\n"
+		"btime %llu\n"
+		"processes %llu\n"
+		"procs_running %zu\n"
+		"procs_blocked 0\n"
+		"softirq %llu 0 %llu 0 0 0 0 %llu 0 0 0\n",
+		interrupts,
+		interrupts * 4u,
+		self->bootTime,
+		PROCGEN_INITIAL_UPTIME_S * 10u + self->elapsedMs / 100u,
+		1u + self->cpuCount / 2u,
+		softirqs,
+		softirqs / 2u,
+		softirqs / 2u))
+	{
+		return -2;
+	}
+
+	return 0;
+}
+
+
+int ProcGen_writeFile(const ProcGen_t* self, const char* procRoot)
+{
+	if ((NULL == self) || (NULL == procRoot))
+	{
+		return -1;
+	}
+
+	char tmpPath[PATH_MAX];
+	char path[PATH_MAX];
+
+	if (((size_t) snprintf(tmpPath, sizeof(tmpPath), "%s" PROCGEN_TMP_FILE_NAME, procRoot) >= sizeof(tmpPath)) ||
+		((size_t) snprintf(path, sizeof(path), "%s" PROCGEN_FILE_NAME, procRoot) >= sizeof(path)))
+	{
+		return -2;
+	}
+
+	FILE* stream = fopen(tmpPath, "w");
+
+	if (NULL == stream)
+	{
+		return -3;
+	}
+
+	const int writeResult = ProcGen_write(self, stream);
+
+	if ((0 != fclose(stream)) || (0 != writeResult))
+	{
+		remove(tmpPath);
+		return -4;
+	}
+
+	// Rename replaces file atomically, so readers see either the previous or the new contents
+	if (0 != rename(tmpPath, path))
+	{
+		remove(tmpPath);
+		return -5;
+	}
+
+	return 0;
+}
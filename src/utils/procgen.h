@@ -0,0 +1,113 @@
+/**
+ * \file procgen.h
+ * Generator of synthetic /proc/stat files, used to exercise the program at processor counts
+ * and load patterns not available on development machines.
+*/
+#ifndef PROCGEN_H_INCLUDED
+#define PROCGEN_H_INCLUDED
+#include <stddef.h>
+#include <stdio.h>
+#include "procstat.h"
+
+
+/**
+ * Clock ticks per second counters of generated files advance by, equal to USER_HZ on Linux.
+*/
+#define PROCGEN_TICKS_PER_SECOND 100u
+
+
+/**
+ * Shapes of load applied to generated processors.
+*/
+typedef enum ProcGenPattern
+{
+	/** Every processor is loaded at the base level. */
+	PROCGEN_PATTERN_CONSTANT = 0,
+
+	/** Load of every processor follows a sine wave around base level, phase shifted between processors. */
+	PROCGEN_PATTERN_WAVE,
+
+	/** Load of every processor wanders randomly around base level. */
+	PROCGEN_PATTERN_RANDOM,
+
+	/** Few processors are fully loaded, all others stay at base level. Hot processors move over time. */
+	PROCGEN_PATTERN_HOTSPOT,
+
+	/** Amount of values in this enum, not a valid value by itself. */
+	PROCGEN_PATTERN_COUNT_
+}
+ProcGenPattern_t;
+
+
+/**
+ * Generator handle type, used in every operation on generator.
+*/
+typedef struct ProcGen ProcGen_t;
+
+
+/**
+ * \brief Converts pattern name into pattern.
+ * \param name One of "constant", "wave", "random", "hotspot".
+ * \param pattern Pointer to write the pattern into.
+ * \return 0 if successful, negative value if name is not known.
+*/
+int ProcGen_parsePattern(const char* name, ProcGenPattern_t* pattern);
+
+
+/**
+ * \brief Creates generator with counters at values typical for a machine that has been running for a while.
+ * \param cpuCount Amount of processors to generate, at least 1.
+ * \param pattern Shape of applied load.
+ * \param baseLoadPct Base load of every processor, in percentage, 0-100.
+ * \param seed Seed of pseudo-random number generator, same seeds produce same files.
+ * \return Pointer to newly created generator if successful, NULL otherwise.
+ * \warning Resulting generator has to be destroyed with ProcGen_destroy() once no longer needed.
+*/
+ProcGen_t* ProcGen_create(size_t cpuCount, ProcGenPattern_t pattern, double baseLoadPct, unsigned seed);
+
+
+/**
+ * \brief Destroys generator, cleaning up any resources used by it.
+ * \param self Generator to be destroyed.
+*/
+void ProcGen_destroy(ProcGen_t* self);
+
+
+/**
+ * \brief Advances every counter as if given time has passed. Counters never decrease.
+ * \param self Generator.
+ * \param elapsedMs Time to simulate, in milliseconds.
+*/
+void ProcGen_advance(ProcGen_t* self, unsigned elapsedMs);
+
+
+/**
+ * \brief Writes current state in /proc/stat format: "cpu" and "cpuN" lines followed by the remaining usual lines.
+ * \param self Generator.
+ * \param stream Stream to write into.
+ * \return 0 if successful, negative value otherwise.
+*/
+int ProcGen_write(const ProcGen_t* self, FILE* stream);
+
+
+/**
+ * \brief Writes current state into "stat" file in given directory, replacing it atomically,
+ * so that readers never observe partially written file.
+ * \param self Generator.
+ * \param procRoot Directory to write "stat" file into.
+ * \return 0 if successful, negative value otherwise.
+*/
+int ProcGen_writeFile(const ProcGen_t* self, const char* procRoot);
+
+
+/**
+ * \brief Retrieves current counters of a single processor.
+ * \param self Generator.
+ * \param index Index of "cpu(N)" line, 0 for total "cpu" line.
+ * \param out Structure to write counters into.
+ * \return 0 if successful, negative value if index is out of range.
+*/
+int ProcGen_getCpuStat(const ProcGen_t* self, size_t index, CpuStat_t* out);
+
+
+#endif // !PROCGEN_H_INCLUDED
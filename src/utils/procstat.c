@@ -5,74 +5,576 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <sys/sysinfo.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 
-#define MAX_FILE_LINE_COUNT 2048u
-#define MAX_EXPECTED_PROCSTAT_LENGTH 16384u
-#define FILE_PATH "/proc/stat"
+#define READ_CHUNK_SIZE 16384u
+#define PROC_ROOT_DEFAULT "/proc"
+#define STAT_FILE_NAME "/stat"
+#define CPU_LINE_PREFIX "cpu"
+// Lines encoded at once, so that two snapshots and change of them fit in L1 cache
+#define ENCODE_BLOCK_LINES 32u
+// Pressure and load average files are a few lines long
+#define SCHED_FILE_MAX 256u
+
+
+// Directory holding the stat file, and path of the file, only changed before any thread starts reading it
+static char g_procRoot[PATH_MAX] = PROC_ROOT_DEFAULT;
+static char g_statPath[PATH_MAX] = PROC_ROOT_DEFAULT STAT_FILE_NAME;
 
 
 /**
- * \brief Parse contents of /proc/stat file, modifying contents in the process.
- * \param mutableFileContent Content of /proc/stat file. Will be modified.
- * \return Pointer to dynamically-allocated structure containing data extracted
- * from file contents if successful, NULL in case of failure.
+ * Lines following "cpu(N)" ones first value of which is kept, in order of appearance in the file.
 */
-static ProcStat_t* parse(char* mutableFileContent)
+typedef enum TailLine
 {
-	// Delimiting by '\n' allows us to split file content by lines
-	const char DELIMITERS[] 			= "\n";
-	// Accounts for initial "cpu(N)" string along with 10 significant values, asterisk to ignore assignment of string prefix
-	static const char SSCANF_FORMAT[] 	= "%*s %llu %llu %llu %llu %llu %llu %llu %llu %llu %llu";
+	TLINE_INTR = 0,
+	TLINE_CTXT,
+	TLINE_PROCS_RUNNING,
+	TLINE_PROCS_BLOCKED,
+	TLINE_COUNT_
+}
+TailLine_t;
 
-	// Create ProcStat structure first, since if it fails the entire function should abort
-	ProcStat_t* result = ProcStat_create();
-	if (NULL == result)
+static const char* const TAIL_LINE_KEYS[TLINE_COUNT_] =
+{
+	[TLINE_INTR] 			= "intr",
+	[TLINE_CTXT] 			= "ctxt",
+	[TLINE_PROCS_RUNNING] 	= "procs_running",
+	[TLINE_PROCS_BLOCKED] 	= "procs_blocked"
+};
+
+#define TAIL_LINES_ALL ((1u << TLINE_COUNT_) - 1u)
+
+
+/**
+ * \brief Parses single "cpu(N)" line of /proc/stat file.
+ * \details Columns missing at the end of the line, as is the case on older kernels, are filled with zeros.
+ * \param line Beginning of the line.
+ * \param end End of the line, one past it's last character.
+ * \param result Structure to write extracted values into.
+ * \return True if line is a "cpu(N)" line, false otherwise.
+*/
+static bool parseCpuLine(const char* line, const char* end, CpuStat_t* result)
+{
+	const size_t prefixLength = sizeof(CPU_LINE_PREFIX) - 1u;
+
+	if (((size_t) (end - line) < prefixLength) || (0 != memcmp(line, CPU_LINE_PREFIX, prefixLength)))
+	{
+		return false;
+	}
+
+	// Skip "cpu(N)" label
+	const char* p = line + prefixLength;
+
+	while ((p < end) && (' ' != *p))
+	{
+		++p;
+	}
+
+	for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+	{
+		while ((p < end) && (' ' == *p))
+		{
+			++p;
+		}
+
+		CpuStatValue_t value = 0u;
+
+		while ((p < end) && ('0' <= *p) && ('9' >= *p))
+		{
+			value = value * 10u + (CpuStatValue_t) (*p - '0');
+			++p;
+		}
+
+		result->values[ii] = value;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Extracts processor number from label of "cpu(N)" line, without converting any of it's values.
+ * \param line Beginning of the line.
+ * \param end End of the line, one past it's last character.
+ * \param cpuId Pointer to write processor number into, negative for total "cpu" line.
+ * \return True if line is a "cpu(N)" line, false otherwise.
+*/
+static bool parseCpuLabel(const char* line, const char* end, long* cpuId)
+{
+	const size_t prefixLength = sizeof(CPU_LINE_PREFIX) - 1u;
+
+	if (((size_t) (end - line) <= prefixLength) || (0 != memcmp(line, CPU_LINE_PREFIX, prefixLength)))
+	{
+		return false;
+	}
+
+	const char* p = line + prefixLength;
+
+	if (' ' == *p)
+	{
+		*cpuId = -1;
+		return true;
+	}
+
+	long value = 0;
+
+	while ((p < end) && ('0' <= *p) && ('9' >= *p) && (value <= INT_MAX))
+	{
+		value = value * 10 + (*p - '0');
+		++p;
+	}
+
+	if ((p == line + prefixLength) || (p == end) || (' ' != *p))
+	{
+		return false;
+	}
+
+	*cpuId = value;
+	return true;
+}
+
+
+/**
+ * \brief Incremental parser of /proc/stat file contents, fed with consecutive chunks of the file.
+ * Lines are matched with tracked processors by N in their "cpuN" label, since processors that are offline
+ * are missing from the file. Every tracked processor occupies a slot of the result, one past it's index.
+*/
+typedef struct ParserState
+{
+	/** Structure being filled. */
+	ProcStat_t* result;
+	/** Amount of slots to fill, including one of total "cpu" line. */
+	size_t 		expectedLines;
+	/** Amount of slots filled so far. */
+	size_t 		parsedLines;
+	/** Numbers of selected processors, as retrieved by CpuCount_getSelection(). NULL if every processor is tracked. */
+	const uint32_t* selection;
+	/** Set once malformed line, or line other than "cpu(N)" one before total "cpu" line, has been encountered. */
+	bool 		failed;
+	/** Lines following "cpu(N)" ones found so far, as bits of TailLine_t values. */
+	unsigned 	tailLines;
+	/** Set while the rest of a line first value of which has already been parsed is being skipped. */
+	bool 		skipping;
+}
+ParserState_t;
+
+
+/**
+ * \brief Prepares parser state for filling given structure with lines of tracked processors.
+*/
+static ParserState_t startParsing(ProcStat_t* result)
+{
+	memset(&result->sched, 0, sizeof(result->sched));
+	result->freqsLength = 0u;
+
+	return (ParserState_t)
+	{
+		.result 		= result,
+		.expectedLines 	= (size_t) CpuCount_get() + 1u,
+		.parsedLines 	= 0u,
+		.selection 		= CpuCount_getSelection(),
+		.failed 		= false,
+		.tailLines 		= 0u,
+		.skipping 		= false
+	};
+}
+
+
+/**
+ * \brief Checks whether every line of interest has been parsed, so that the rest of the file need not be read.
+*/
+static inline bool parsingDone(const ParserState_t* state)
+{
+	return (state->parsedLines == state->expectedLines) && (TAIL_LINES_ALL == state->tailLines);
+}
+
+
+/**
+ * \brief Retrieves number of processor tracked in given slot, as N in it's "cpuN" line.
+*/
+static inline long slotCpuId(const ParserState_t* state, size_t slot)
+{
+	return (NULL != state->selection) ? (long) state->selection[slot - 1u] : (long) (slot - 1u);
+}
+
+
+/**
+ * \brief Marks processors of slots up to given one as offline, zeroing all of their values.
+*/
+static void markOffline(ParserState_t* state, size_t untilSlot)
+{
+	if (untilSlot > state->parsedLines)
+	{
+		memset(&state->result->cpuStats[state->parsedLines], 0, (untilSlot - state->parsedLines) * sizeof(CpuStat_t));
+		state->parsedLines = untilSlot;
+	}
+}
+
+
+/**
+ * \brief Checks whether line, of which only given part may be available yet, can be a "cpu(N)" line.
+*/
+static inline bool mayBeCpuLine(const char* line, const char* end)
+{
+	const size_t prefixLength = sizeof(CPU_LINE_PREFIX) - 1u;
+	const size_t available = ((size_t) (end - line) < prefixLength) ? (size_t) (end - line) : prefixLength;
+	return 0 == memcmp(line, CPU_LINE_PREFIX, available);
+}
+
+
+/**
+ * \brief Parses single "cpu(N)" line into slot of processor it describes, marking slots of processors
+ * missing before it as offline. Lines of processors not tracked are skipped without converting their values,
+ * as is total "cpu" line while only selected processors are tracked, as it covers every processor.
+ * \return False if line is malformed or first line is not total "cpu" line, true otherwise.
+*/
+static bool parseKeyedLine(ParserState_t* state, const char* line, const char* end)
+{
+	long cpuId;
+
+	if (!parseCpuLabel(line, end, &cpuId))
+	{
+		return false;
+	}
+
+	if (0u == state->parsedLines)
+	{
+		if ((0 <= cpuId) || ((NULL == state->selection) && !parseCpuLine(line, end, &state->result->cpuStats[0])))
+		{
+			return false;
+		}
+
+		state->parsedLines = 1u;
+		return true;
+	}
+
+	if (0 > cpuId)
+	{
+		return false;
+	}
+
+	size_t slot = state->parsedLines;
+
+	while ((slot < state->expectedLines) && (slotCpuId(state, slot) < cpuId))
+	{
+		++slot;
+	}
+
+	markOffline(state, slot);
+
+	if ((slot < state->expectedLines) && (slotCpuId(state, slot) == cpuId))
+	{
+		parseCpuLine(line, end, &state->result->cpuStats[slot]);
+		state->parsedLines = slot + 1u;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Parses first value of single line following "cpu(N)" lines, of which only given part may be available yet.
+ * Only the beginning of a line is needed, so the rest of a long one, such as "intr" line holding a counter
+ * of every interrupt, is skipped without being buffered.
+ * \param final Whether no more data follows.
+ * \return Pointer past consumed part of data, NULL if more data is needed to parse the line.
+*/
+static const char* parseTailLine(ParserState_t* state, const char* line, const char* end, bool final)
+{
+	const char* lineEnd = memchr(line, '\n', (size_t) (end - line));
+	const char* const valueEnd = (NULL != lineEnd) ? lineEnd : end;
+	const char* const space = memchr(line, ' ', (size_t) (valueEnd - line));
+	const char* p = (NULL != space) ? space + 1 : valueEnd;
+	unsigned long long value = 0u;
+
+	while ((p < valueEnd) && ('0' <= *p) && ('9' >= *p))
+	{
+		value = value * 10u + (unsigned long long) (*p - '0');
+		++p;
+	}
+
+	// Key or value may continue in the next chunk
+	if ((p == valueEnd) && (NULL == lineEnd) && !final)
 	{
 		return NULL;
 	}
 
-	char* linesQueue[MAX_FILE_LINE_COUNT] = { NULL };
-	int linesQueueEnd = 0;
+	for (unsigned ii = 0; (NULL != space) && (ii < TLINE_COUNT_); ++ii)
+	{
+		const size_t keyLength = strlen(TAIL_LINE_KEYS[ii]);
+
+		if ((keyLength != (size_t) (space - line)) || (0 != memcmp(line, TAIL_LINE_KEYS[ii], keyLength)))
+		{
+			continue;
+		}
+
+		SchedStat_t* sched = &state->result->sched;
+
+		switch ((TailLine_t) ii)
+		{
+			case TLINE_INTR: 			sched->interrupts = value; 					break;
+			case TLINE_CTXT: 			sched->contextSwitches = value; 			break;
+			case TLINE_PROCS_RUNNING: 	sched->procsRunning = (uint32_t) value; 	break;
+			case TLINE_PROCS_BLOCKED: 	sched->procsBlocked = (uint32_t) value; 	break;
+			default: 															break;
+		}
+
+		state->tailLines |= 1u << ii;
+		break;
+	}
+
+	if (NULL != lineEnd)
+	{
+		return lineEnd + 1;
+	}
+
+	state->skipping = !final;
+	return end;
+}
+
+
+/**
+ * \brief Parses every complete line in given data.
+ * \param state Parser state.
+ * \param data Chunk of file contents.
+ * \param length Length of the chunk.
+ * \param final Whether this is the last chunk, in which case incomplete trailing line is parsed as well.
+ * \return Amount of bytes consumed; remaining bytes form an incomplete line to be fed again with more data.
+*/
+static size_t parseLines(ParserState_t* state, const char* data, size_t length, bool final)
+{
+	const char* p = data;
+	const char* const end = data + length;
+
+	while ((p < end) && !parsingDone(state) && !state->failed)
+	{
+		if (state->skipping)
+		{
+			const char* lineEnd = memchr(p, '\n', (size_t) (end - p));
+			state->skipping = (NULL == lineEnd);
+			p = (NULL != lineEnd) ? lineEnd + 1 : end;
+			continue;
+		}
+
+		// Lines following "cpu" and "cpuN" lines, as well as those of processors past the last tracked one
+		if (state->parsedLines == state->expectedLines)
+		{
+			const char* next = parseTailLine(state, p, end, final);
+
+			if (NULL == next)
+			{
+				break;
+			}
+
+			p = next;
+			continue;
+		}
+
+		// "cpu" and "cpuN" lines come first in the file, processors missing before the first other line are offline
+		if (!mayBeCpuLine(p, end))
+		{
+			if (0u == state->parsedLines)
+			{
+				state->failed = true;
+				break;
+			}
+
+			markOffline(state, state->expectedLines);
+			continue;
+		}
+
+		const char* lineEnd = memchr(p, '\n', (size_t) (end - p));
+
+		if (NULL == lineEnd)
+		{
+			if (!final)
+			{
+				break;
+			}
+
+			lineEnd = end;
+		}
+
+		if (!parseKeyedLine(state, p, lineEnd))
+		{
+			state->failed = true;
+			break;
+		}
+
+		p = (lineEnd < end) ? lineEnd + 1 : end;
+	}
+
+	return (size_t) (p - data);
+}
+
+
+/**
+ * \brief Completes parsing, marking processors missing at the end of the file as offline.
+ * \param state Parser state.
+ * \return True if successful, false otherwise.
+*/
+static bool finishParsing(ParserState_t* state)
+{
+	if (state->failed || (0u == state->parsedLines))
+	{
+		return false;
+	}
+
+	markOffline(state, state->expectedLines);
+	state->result->cpuStatsLength = state->expectedLines;
+	state->result->sched.flags = (TAIL_LINES_ALL == state->tailLines) ? SCHEDSTAT_HAVE_COUNTERS : 0u;
+
+	if (NULL != state->selection)
+	{
+		CpuStat_t* total = &state->result->cpuStats[0];
+		memset(total, 0, sizeof(CpuStat_t));
+
+		for (size_t ii = 1; ii < state->expectedLines; ++ii)
+		{
+			for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+			{
+				total->values[jj] += state->result->cpuStats[ii].values[jj];
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void ProcStat_setProcRoot(const char* procRoot)
+{
+	if ((NULL == procRoot) ||
+		((size_t) snprintf(g_statPath, sizeof(g_statPath), "%s" STAT_FILE_NAME, procRoot) >= sizeof(g_statPath)))
+	{
+		strcpy(g_statPath, PROC_ROOT_DEFAULT STAT_FILE_NAME);
+		strcpy(g_procRoot, PROC_ROOT_DEFAULT);
+		return;
+	}
+
+	strcpy(g_procRoot, procRoot);
+}
+
 
-	// Divide file content by lines, save them to queue
-	for (char* p = strtok(mutableFileContent, DELIMITERS); NULL != p; p = strtok(NULL, DELIMITERS))
+int ProcStat_openSibling(const char* name)
+{
+	char path[PATH_MAX];
+
+	if ((NULL == name) || ((size_t) snprintf(path, sizeof(path), "%s/%s", g_procRoot, name) >= sizeof(path)))
 	{
-		linesQueue[linesQueueEnd] = p;
-		++linesQueueEnd;
+		return -1;
 	}
 
-	/* CPU usage can be computed using only "cpu" and "cpuN" lines,
-	 * and since they are the first lines in the /proc/stat file
-	 * we can safely take only those first lines from it and ignore others.
-	 * Adding one to account for total "cpu" line.
-	 */
-	const int significantLinesCount = CpuCount_get() + 1;
+	return open(path, O_RDONLY | O_CLOEXEC);
+}
+
+
+/**
+ * \brief Reads beginning of already open file into given buffer, null-terminating it.
+ * \return Length of read contents, 0 if file cannot be read or is empty.
+*/
+static size_t readSibling(int fd, char* buf, size_t bufSize)
+{
+	ssize_t length;
 
-	// Scan "cpu(N)" lines into structure
-	for (int ii = 0; ii < significantLinesCount; ++ii)
+	do
 	{
-		// FIXME: Hard-coded indexes could result in errors if the structure of the /proc/stat file is not as expected.
-		sscanf(
-			linesQueue[ii],
-			SSCANF_FORMAT,
-			&result->cpuStats[ii].values[0],
-			&result->cpuStats[ii].values[1],
-			&result->cpuStats[ii].values[2],
-			&result->cpuStats[ii].values[3],
-			&result->cpuStats[ii].values[4],
-			&result->cpuStats[ii].values[5],
-			&result->cpuStats[ii].values[6],
-			&result->cpuStats[ii].values[7],
-			&result->cpuStats[ii].values[8],
-			&result->cpuStats[ii].values[9]);
+		length = pread(fd, buf, bufSize - 1u, 0);
 	}
+	while ((0 > length) && (EINTR == errno));
 
+	const size_t result = (0 < length) ? (size_t) length : 0u;
+	buf[result] = '\0';
 	return result;
 }
 
 
+bool SchedStat_readPressure(int fd, SchedStat_t* out)
+{
+	char buf[SCHED_FILE_MAX];
+
+	if ((NULL == out) || (0 == readSibling(fd, buf, sizeof(buf))))
+	{
+		return false;
+	}
+
+	// "some avg10=0.00 avg60=0.00 avg300=0.00 total=N" line, followed by "full" one on kernels since 5.13
+	const char* some = strstr(buf, "some ");
+	const char* full = strstr(buf, "full ");
+	const char* someTotal = (NULL != some) ? strstr(some, "total=") : NULL;
+	const char* fullTotal = (NULL != full) ? strstr(full, "total=") : NULL;
+
+	if (NULL == someTotal)
+	{
+		return false;
+	}
+
+	out->pressureSomeUs = strtoull(someTotal + sizeof("total=") - 1u, NULL, 10);
+	out->pressureFullUs = (NULL != fullTotal) ? strtoull(fullTotal + sizeof("total=") - 1u, NULL, 10) : 0u;
+	out->flags |= SCHEDSTAT_HAVE_PRESSURE;
+	return true;
+}
+
+
+bool SchedStat_readLoadAvg(int fd, SchedStat_t* out)
+{
+	char buf[SCHED_FILE_MAX];
+
+	if ((NULL == out) || (0 == readSibling(fd, buf, sizeof(buf))))
+	{
+		return false;
+	}
+
+	// "0.08 0.10 0.09 2/72 29480", averages have two decimal places
+	unsigned whole[3];
+	unsigned fraction[3];
+
+	if (6 != sscanf(buf, "%u.%2u %u.%2u %u.%2u", &whole[0], &fraction[0], &whole[1], &fraction[1], &whole[2], &fraction[2]))
+	{
+		return false;
+	}
+
+	for (size_t ii = 0; ii < 3u; ++ii)
+	{
+		out->loadAvg[ii] = whole[ii] * 100u + fraction[ii];
+	}
+
+	out->flags |= SCHEDSTAT_HAVE_LOADAVG;
+	return true;
+}
+
+
+/**
+ * \brief Calculates change of a single counter, treating one going backwards as unchanged.
+*/
+static inline unsigned long long counterChange(unsigned long long oldValue, unsigned long long newValue)
+{
+	return (newValue < oldValue) ? 0u : newValue - oldValue;
+}
+
+
+void SchedStat_change(const SchedStat_t* oldStat, const SchedStat_t* newStat, SchedStat_t* out)
+{
+	if ((NULL == oldStat) || (NULL == newStat) || (NULL == out))
+	{
+		return;
+	}
+
+	*out = *newStat;
+	out->contextSwitches 	= counterChange(oldStat->contextSwitches, newStat->contextSwitches);
+	out->interrupts 		= counterChange(oldStat->interrupts, newStat->interrupts);
+	out->pressureSomeUs 	= counterChange(oldStat->pressureSomeUs, newStat->pressureSomeUs);
+	out->pressureFullUs 	= counterChange(oldStat->pressureFullUs, newStat->pressureFullUs);
+	out->flags 				= oldStat->flags & newStat->flags;
+}
+
+
 ProcStat_t* ProcStat_create(void)
 {
 	// Add one to account for total "cpu" line
@@ -107,23 +609,125 @@ void ProcStat_destroy(ProcStat_t* self)
 
 size_t ProcStat_size(void)
 {
-	size_t size = sizeof(ProcStat_t) + (CpuCount_get() + 1) * sizeof(CpuStat_t);
+	size_t size = sizeof(ProcStat_t) + (CpuCount_get() + 1) * (sizeof(CpuStat_t) + sizeof(CpuFreqValue_t));
 	return size;
 }
 
 
+CpuFreqValue_t* ProcStat_getFreqs(const ProcStat_t* self)
+{
+	// Frequencies follow room of every tracked processor, so their place does not depend on amount of lines read
+	return (CpuFreqValue_t*) &self->cpuStats[CpuCount_get() + 1];
+}
+
+
+CpuFreqValue_t CpuFreq_mean(CpuFreqValue_t a, unsigned long long aWeight, CpuFreqValue_t b, unsigned long long bWeight)
+{
+	if (CPUFREQ_UNKNOWN == a)
+	{
+		return b;
+	}
+
+	if (CPUFREQ_UNKNOWN == b)
+	{
+		return a;
+	}
+
+	if ((0u == aWeight) && (0u == bWeight))
+	{
+		aWeight = 1u;
+		bWeight = 1u;
+	}
+
+	const unsigned long long total = aWeight + bWeight;
+	return (CpuFreqValue_t) ((a * aWeight + b * bWeight + total / 2u) / total);
+}
+
+
+bool ProcStat_read(ProcStat_t* out)
+{
+	if (NULL == out)
+	{
+		Log(LLEVEL_ERROR, "invalid argument provided: out");
+		return false;
+	}
+
+	const unsigned long long timestampNs = MonotonicTimeNs();
+	const int fd = open(g_statPath, O_RDONLY);
+
+	if (0 > fd)
+	{
+		Log(LLEVEL_ERROR, "cannot open %s", g_statPath);
+		return false;
+	}
+
+	// File is read in chunks and only up to "procs_blocked" line, so neither it's size nor amount of processors
+	// is limited, and long lines such as "intr" one are never buffered in full
+	char chunk[READ_CHUNK_SIZE];
+	size_t pending = 0u;
+	ParserState_t state = startParsing(out);
+	bool endOfFile = false;
+
+	while (!endOfFile && !parsingDone(&state) && !state.failed)
+	{
+		const ssize_t bytesRead = read(fd, chunk + pending, sizeof(chunk) - pending);
+
+		if (0 > bytesRead)
+		{
+			if (EINTR == errno)
+			{
+				continue;
+			}
+
+			Log(LLEVEL_ERROR, "cannot read %s", g_statPath);
+			close(fd);
+			return false;
+		}
+
+		endOfFile = (0 == bytesRead);
+		const size_t available = pending + (size_t) bytesRead;
+		const size_t consumed = parseLines(&state, chunk, available, endOfFile);
+		pending = available - consumed;
+
+		// Single "cpu(N)" line never comes close to chunk size, anything that long is not a valid file
+		if (pending == sizeof(chunk))
+		{
+			state.failed = true;
+		}
+
+		memmove(chunk, chunk + consumed, pending);
+	}
+
+	close(fd);
+
+	if (!finishParsing(&state))
+	{
+		return false;
+	}
+
+	out->timestampNs = timestampNs;
+	out->onlineEpoch = 0u;
+	return true;
+}
+
+
 ProcStat_t* ProcStat_loadFromFile(void)
 {
-	char fBuf[MAX_EXPECTED_PROCSTAT_LENGTH];
-	const size_t fBufSz = sizeof fBuf / sizeof *fBuf;
+	// Create ProcStat structure first, since if it fails the entire function should abort
+	ProcStat_t* result = ProcStat_create();
 
-	// Either no data has been read or error has occured, abort
-	if (ReadFileContent(FILE_PATH, fBuf, fBufSz) < 1)
+	if (NULL == result)
+	{
+		return NULL;
+	}
+
+	if (!ProcStat_read(result))
 	{
+		ProcStat_destroy(result);
 		return NULL;
 	}
 
-	return parse(fBuf);
+	return result;
 }
 
 
@@ -135,24 +739,188 @@ ProcStat_t* ProcStat_parse(const char* fileContent)
 		return NULL;
 	}
 
-	// Create mutable copy of original file content
-	size_t len = strlen(fileContent);
-	// Allocate buffer, adjust by +1 byte for null terminator
-	char* copy = (char*) malloc(len + 1u);
+	ProcStat_t* result = ProcStat_create();
 
-	if (NULL == copy)
+	if (NULL == result)
 	{
-		Log(LLEVEL_ERROR, "cannot allocate memory for content buffer");
 		return NULL;
 	}
 
-	strncpy(copy, fileContent, len);
-	// Append terminating null-character for safety
-	copy[len] = '\0';
-	ProcStat_t* result = parse(copy);
+	ParserState_t state = startParsing(result);
+	parseLines(&state, fileContent, strlen(fileContent), true);
 
-	// Release memory used for mutable copy
-	free(copy);
+	if (!finishParsing(&state))
+	{
+		ProcStat_destroy(result);
+		return NULL;
+	}
 
 	return result;
 }
+
+
+/**
+ * \brief Checks whether processor has been offline when measurement was taken, having every value zeroed.
+*/
+static bool isOffline(const CpuStat_t* stat)
+{
+	for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+	{
+		if (0u != stat->values[ii])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Checks whether processor has been offline at the end of interval change has been measured over.
+*/
+static inline bool isOfflineDelta(const CpuStatDelta_t* delta)
+{
+	return (CPUSTAT_DELTA_OFFLINE == delta->values[CSINDEX_IDLE]) && (CPUSTAT_DELTA_OFFLINE == delta->values[CSINDEX_USER]);
+}
+
+
+size_t ProcStatDelta_size(void)
+{
+	return sizeof(ProcStatDelta_t) + (CpuCount_get() + 1) * (sizeof(CpuStatDelta_t) + sizeof(CpuFreqValue_t));
+}
+
+
+CpuFreqValue_t* ProcStatDelta_getFreqs(const ProcStatDelta_t* self)
+{
+	return (CpuFreqValue_t*) &self->cpuDeltas[CpuCount_get() + 1];
+}
+
+
+void ProcStatDelta_encode(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, ProcStatDelta_t* out)
+{
+	if ((NULL == oldProcStat) || (NULL == newProcStat) || (NULL == out))
+	{
+		return;
+	}
+
+	const size_t cpuLineCount = (oldProcStat->cpuStatsLength < newProcStat->cpuStatsLength)
+		? oldProcStat->cpuStatsLength
+		: newProcStat->cpuStatsLength;
+
+	out->cpuDeltasLength = cpuLineCount;
+	SchedStat_change(&oldProcStat->sched, &newProcStat->sched, &out->sched);
+	out->timestampNs = newProcStat->timestampNs;
+	out->intervalNs = ((0u != oldProcStat->timestampNs) && (newProcStat->timestampNs > oldProcStat->timestampNs))
+		? newProcStat->timestampNs - oldProcStat->timestampNs
+		: 0u;
+	out->stamps = newProcStat->stamps;
+	out->onlineEpoch = newProcStat->onlineEpoch;
+	out->freqsLength = (0u != newProcStat->freqsLength) ? cpuLineCount : 0u;
+
+	if (0u != out->freqsLength)
+	{
+		const CpuFreqValue_t* newFreqs = ProcStat_getFreqs(newProcStat);
+		const CpuFreqValue_t* oldFreqs = (0u != oldProcStat->freqsLength) ? ProcStat_getFreqs(oldProcStat) : NULL;
+		CpuFreqValue_t* outFreqs = ProcStatDelta_getFreqs(out);
+
+		for (size_t ii = 0; ii < cpuLineCount; ++ii)
+		{
+			outFreqs[ii] = (NULL != oldFreqs) ? CpuFreq_mean(oldFreqs[ii], 1u, newFreqs[ii], 1u) : newFreqs[ii];
+		}
+	}
+
+	// Lines are laid out contiguously, so they are processed as one flat array the compiler is free to vectorize,
+	// block after block, so that offline processors are looked for while lines of the block are still cached
+	const CpuStatValue_t* restrict oldValues = oldProcStat->cpuStats[0].values;
+	const CpuStatValue_t* restrict newValues = newProcStat->cpuStats[0].values;
+	CpuStatDeltaValue_t* restrict outValues = out->cpuDeltas[0].values;
+
+	for (size_t first = 0; first < cpuLineCount; first += ENCODE_BLOCK_LINES)
+	{
+		const size_t last = (cpuLineCount - first < ENCODE_BLOCK_LINES) ? cpuLineCount : first + ENCODE_BLOCK_LINES;
+
+		for (size_t ii = first * CSINDEX_COUNT_; ii < last * CSINDEX_COUNT_; ++ii)
+		{
+			const CpuStatValue_t change = (newValues[ii] < oldValues[ii]) ? 0u : newValues[ii] - oldValues[ii];
+			outValues[ii] = (CpuStatDeltaValue_t) ((change > UINT32_MAX) ? UINT32_MAX : change);
+		}
+
+		// Idle time of online processors is almost never zero, so full checks are seldom made
+		for (size_t ii = (0u == first) ? 1u : first; ii < last; ++ii)
+		{
+			if ((0u == newProcStat->cpuStats[ii].values[CSINDEX_IDLE]) && isOffline(&newProcStat->cpuStats[ii]))
+			{
+				for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+				{
+					out->cpuDeltas[ii].values[jj] = CPUSTAT_DELTA_OFFLINE;
+				}
+			}
+			else if ((0u == oldProcStat->cpuStats[ii].values[CSINDEX_IDLE]) && isOffline(&oldProcStat->cpuStats[ii]))
+			{
+				// Counters of processor brought online have accumulated before the interval, not over it
+				memset(&out->cpuDeltas[ii], 0, sizeof(CpuStatDelta_t));
+			}
+		}
+	}
+}
+
+
+void ProcStatDelta_merge(ProcStatDelta_t* self, const ProcStatDelta_t* next)
+{
+	if ((NULL == self) || (NULL == next))
+	{
+		return;
+	}
+
+	if (next->cpuDeltasLength < self->cpuDeltasLength)
+	{
+		self->cpuDeltasLength = next->cpuDeltasLength;
+	}
+
+	if ((0u != self->freqsLength) && (0u != next->freqsLength))
+	{
+		CpuFreqValue_t* freqs = ProcStatDelta_getFreqs(self);
+		const CpuFreqValue_t* nextFreqs = ProcStatDelta_getFreqs(next);
+
+		for (size_t ii = 0; ii < self->cpuDeltasLength; ++ii)
+		{
+			freqs[ii] = CpuFreq_mean(freqs[ii], self->intervalNs, nextFreqs[ii], next->intervalNs);
+		}
+	}
+	else if (0u != next->freqsLength)
+	{
+		memcpy(ProcStatDelta_getFreqs(self), ProcStatDelta_getFreqs(next), self->cpuDeltasLength * sizeof(CpuFreqValue_t));
+	}
+
+	self->freqsLength = (0u != next->freqsLength) ? self->cpuDeltasLength : 0u;
+	self->intervalNs = ((0u != self->intervalNs) && (0u != next->intervalNs)) ? self->intervalNs + next->intervalNs : 0u;
+	self->timestampNs = next->timestampNs;
+	self->stamps = next->stamps;
+	self->onlineEpoch = next->onlineEpoch;
+
+	// Counters add up, gauges are those at the end of the later interval
+	const SchedStat_t earlier = self->sched;
+	self->sched = next->sched;
+	self->sched.contextSwitches += earlier.contextSwitches;
+	self->sched.interrupts += earlier.interrupts;
+	self->sched.pressureSomeUs += earlier.pressureSomeUs;
+	self->sched.pressureFullUs += earlier.pressureFullUs;
+	self->sched.flags &= earlier.flags;
+
+	for (size_t ii = 0; ii < self->cpuDeltasLength; ++ii)
+	{
+		if (isOfflineDelta(&next->cpuDeltas[ii]) || isOfflineDelta(&self->cpuDeltas[ii]))
+		{
+			self->cpuDeltas[ii] = next->cpuDeltas[ii];
+			continue;
+		}
+
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			const CpuStatDeltaValue_t a = self->cpuDeltas[ii].values[jj];
+			const CpuStatDeltaValue_t b = next->cpuDeltas[ii].values[jj];
+			self->cpuDeltas[ii].values[jj] = (a > UINT32_MAX - b) ? UINT32_MAX : a + b;
+		}
+	}
+}
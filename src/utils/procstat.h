@@ -6,9 +6,13 @@
 #ifndef PROCSTAT_H_INCLUDED
 #define PROCSTAT_H_INCLUDED
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "latency.h"
 
 
 typedef struct ProcStat ProcStat_t;
+typedef struct ProcStatDelta ProcStatDelta_t;
 
 
 /**
@@ -33,6 +37,15 @@ void ProcStat_destroy(ProcStat_t* self);
 size_t ProcStat_size(void);
 
 
+/**
+ * \brief Changes directory the stat file is read from, "/proc" by default.
+ * Allows pointing the program at generated files, e.g. to exercise it at processor counts not available locally.
+ * \warning This function is NOT thread-safe and should be called before any thread starts reading the file.
+ * \param procRoot Directory containing "stat" file, NULL restores the default.
+*/
+void ProcStat_setProcRoot(const char* procRoot);
+
+
 /**
  * \brief Reads /proc/stat file and parses it's content into specialized structure.
  * \return Pointer to dynamically-allocated structure containing data extracted
@@ -42,6 +55,19 @@ size_t ProcStat_size(void);
 ProcStat_t* ProcStat_loadFromFile(void);
 
 
+/**
+ * \brief Reads /proc/stat file and parses it's content into user-provided structure, without allocating memory.
+ * Lines are matched with tracked processors by N in their "cpuN" label, processors missing from the file,
+ * as offline ones are, have every value set to zero. Scheduler counters following them are read from the same file,
+ * up to "procs_blocked" line, while pressure and load averages are left unsampled.
+ * If tracked processors have been restricted with CpuCount_select(), lines of other processors are skipped
+ * without being converted, and total "cpu" line is the sum of selected ones.
+ * \param out Structure to write the data into, of size at least equal to that retrieved by ProcStat_size().
+ * \return True if successful, false otherwise. Content of output structure is unspecified in case of failure.
+*/
+bool ProcStat_read(ProcStat_t* out);
+
+
 /**
  * \brief Parses contents of /proc/stat file into specialized structure.
  * \param fileContent Contents of /proc/stat file.
@@ -89,6 +115,97 @@ typedef struct CpuStat
 CpuStat_t;
 
 
+/**
+ * Flags of SchedStat_t, set for every part of it that has been sampled.
+*/
+#define SCHEDSTAT_HAVE_COUNTERS 	0x1u
+#define SCHEDSTAT_HAVE_PRESSURE 	0x2u
+#define SCHEDSTAT_HAVE_LOADAVG 		0x4u
+
+
+/**
+ * Scheduler saturation and contention, sampled along with processor times. Parts not available on this system,
+ * as well as in replayed snapshots, are zero and have their flag cleared.
+*/
+typedef struct SchedStat
+{
+	/** Context switches since boot, from "ctxt" line of /proc/stat. */
+	unsigned long long contextSwitches;
+	/** Interrupts serviced since boot, first value of "intr" line of /proc/stat. */
+	unsigned long long interrupts;
+	/** Time some tasks have been stalled waiting for processor, "some" total of /proc/pressure/cpu, in microseconds. */
+	unsigned long long pressureSomeUs;
+	/** Time every non-idle task has been stalled at once, "full" total of /proc/pressure/cpu, in microseconds. */
+	unsigned long long pressureFullUs;
+	/** Tasks runnable and blocked on I/O, from "procs_running" and "procs_blocked" lines of /proc/stat. */
+	uint32_t 	procsRunning;
+	uint32_t 	procsBlocked;
+	/** Load averages over 1, 5 and 15 minutes, from /proc/loadavg, in hundredths. */
+	uint32_t 	loadAvg[3];
+	/** Parts that have been sampled, as combination of SCHEDSTAT_HAVE_* flags. */
+	uint32_t 	flags;
+}
+SchedStat_t;
+
+
+/**
+ * \brief Calculates change of scheduler counters between two samples. Counters going backwards are treated
+ * as unchanged, gauges are taken from the newer sample, and only parts present in both samples are flagged.
+ * \param oldStat Sample taken at the start of the interval.
+ * \param newStat Sample taken at the end of the interval.
+ * \param out Structure to write the change into.
+*/
+void SchedStat_change(const SchedStat_t* oldStat, const SchedStat_t* newStat, SchedStat_t* out);
+
+
+/**
+ * \brief Opens file of given name in directory the stat file is read from, see ProcStat_setProcRoot().
+ * \param name Path of file relative to that directory, e.g. "loadavg" or "pressure/cpu".
+ * \return Descriptor of the file, negative if it cannot be opened.
+*/
+int ProcStat_openSibling(const char* name);
+
+
+/**
+ * \brief Reads processor pressure stall totals from already open /proc/pressure/cpu file.
+ * \param fd Descriptor of the file, reread from it's beginning on every call.
+ * \param out Structure to write the totals into, flagged with SCHEDSTAT_HAVE_PRESSURE if successful.
+ * \return True if successful, false otherwise, in which case output structure is unchanged.
+*/
+bool SchedStat_readPressure(int fd, SchedStat_t* out);
+
+
+/**
+ * \brief Reads load averages from already open /proc/loadavg file.
+ * \param fd Descriptor of the file, reread from it's beginning on every call.
+ * \param out Structure to write load averages into, flagged with SCHEDSTAT_HAVE_LOADAVG if successful.
+ * \return True if successful, false otherwise, in which case output structure is unchanged.
+*/
+bool SchedStat_readLoadAvg(int fd, SchedStat_t* out);
+
+
+/**
+ * Frequency of a single processor, in basis points (0-10000) of it's maximum frequency.
+*/
+typedef uint16_t CpuFreqValue_t;
+
+/**
+ * Frequency value of processor no frequency has been sampled for, e.g. one without cpufreq driver or offline one.
+*/
+#define CPUFREQ_UNKNOWN UINT16_MAX
+
+
+/**
+ * \brief Calculates weighted mean of two frequencies, such as those at both ends of an interval.
+ * \param a First frequency.
+ * \param aWeight Weight of the first frequency, e.g. length of interval it has been sampled over.
+ * \param b Second frequency.
+ * \param bWeight Weight of the second frequency. Equal weights are assumed if both are zero.
+ * \return Weighted mean, the other frequency if either is CPUFREQ_UNKNOWN.
+*/
+CpuFreqValue_t CpuFreq_mean(CpuFreqValue_t a, unsigned long long aWeight, CpuFreqValue_t b, unsigned long long bWeight);
+
+
 /**
  * Representation of data from /proc/stat file, used to hold data parsed from said file.
 */
@@ -97,9 +214,137 @@ struct ProcStat
 	/** CPU stats array length. */
 	size_t 		cpuStatsLength;
 
-	/** Array of values corresponding to "cpu(N)" lines in /proc/stat file. */
+	/** Point in time at which the data has been read, on CLOCK_MONOTONIC, in nanoseconds. Zero if unknown. */
+	unsigned long long timestampNs;
+
+	/** Timestamps of pipeline stage boundaries crossed by this snapshot, see latency.h. */
+	LatencyStamps_t stamps;
+
+	/** Epoch of online processor set the snapshot has been taken in, see cpumap.h. Zero if not tracked. */
+	uint32_t 	onlineEpoch;
+
+	/** Scheduler counters following "cpu(N)" lines, along with pressure and load averages if sampled by source. */
+	SchedStat_t sched;
+
+	/**
+	 * Amount of processor frequencies retrieved by ProcStat_getFreqs(), equal to cpuStatsLength if they have been
+	 * sampled by source, zero otherwise.
+	*/
+	size_t 		freqsLength;
+
+	/**
+	 * Array of values corresponding to "cpu(N)" lines in /proc/stat file, total "cpu" line first,
+	 * followed by one line per tracked processor. Lines of offline processors have every value set to zero.
+	*/
 	CpuStat_t 	cpuStats[];
 };
 
 
+/**
+ * \brief Retrieves processor frequencies sampled along with snapshot, stored after it's cpuStats array
+ * in room reserved by ProcStat_size(). Mean frequency of processors it is known for comes first,
+ * followed by one frequency per tracked processor, as with cpuStats array.
+ * \param self Snapshot, valid only if it's freqsLength is not zero.
+ * \return Pointer to array of freqsLength frequencies.
+*/
+CpuFreqValue_t* ProcStat_getFreqs(const ProcStat_t* self);
+
+
+/**
+ * Change of a single processor state counter over one interval.
+ * Intervals are short enough for 32 bits to hold it, at USER_HZ of 100 they overflow after more than a year.
+*/
+typedef uint32_t CpuStatDeltaValue_t;
+
+
+/**
+ * Value every change of a processor offline at the end of the interval is set to.
+*/
+#define CPUSTAT_DELTA_OFFLINE UINT32_MAX
+
+
+/**
+ * Change of values of a single "cpu(N)" line over one interval.
+*/
+typedef struct CpuStatDelta
+{
+	/**
+	 * Array containing changes of time units spent in various processor states, indexed by CpuStatIndex_t.
+	*/
+	CpuStatDeltaValue_t values[CSINDEX_COUNT_];
+}
+CpuStatDelta_t;
+
+
+/**
+ * Change of /proc/stat data between two snapshots, half the size of a snapshot.
+ * Sufficient to calculate usage over the interval without either of the snapshots.
+*/
+struct ProcStatDelta
+{
+	/** CPU deltas array length. */
+	size_t 		cpuDeltasLength;
+
+	/** Point in time at which the newer snapshot has been read, on CLOCK_MONOTONIC, in nanoseconds. Zero if unknown. */
+	unsigned long long timestampNs;
+
+	/** Length of the interval, in nanoseconds. Zero if unknown. */
+	unsigned long long intervalNs;
+
+	/** Timestamps of pipeline stage boundaries, carried over from the newer snapshot. */
+	LatencyStamps_t stamps;
+
+	/** Epoch of online processor set, carried over from the newer snapshot. */
+	uint32_t 	onlineEpoch;
+
+	/** Change of scheduler counters, as calculated by SchedStat_change(). */
+	SchedStat_t sched;
+
+	/** Amount of processor frequencies retrieved by ProcStatDelta_getFreqs(), zero if none have been sampled. */
+	size_t 		freqsLength;
+
+	/** Array of changes of values of "cpu(N)" lines in /proc/stat file. */
+	CpuStatDelta_t 	cpuDeltas[];
+};
+
+
+/**
+ * \brief Retrieves mean processor frequencies over the interval, laid out as those of ProcStat_getFreqs().
+ * \param self Change of data, valid only if it's freqsLength is not zero.
+ * \return Pointer to array of freqsLength frequencies.
+*/
+CpuFreqValue_t* ProcStatDelta_getFreqs(const ProcStatDelta_t* self);
+
+
+/**
+ * \brief Retrieve size of struct ProcStatDelta on this system.
+ * \return Size of struct ProcStatDelta in bytes.
+*/
+size_t ProcStatDelta_size(void);
+
+
+/**
+ * \brief Calculates change of data between two snapshots.
+ * Processors offline in the newer snapshot have every change set to CPUSTAT_DELTA_OFFLINE, ones brought online
+ * since the older snapshot have no change. Other counters going backwards are treated as unchanged,
+ * changes not fitting in CpuStatDeltaValue_t saturate. Frequencies are mean of those at both ends of the interval,
+ * of the newer snapshot alone if the older one has none.
+ * \param oldProcStat Snapshot taken at the start of the interval.
+ * \param newProcStat Snapshot taken at the end of the interval.
+ * \param out Structure to write the change into, of size at least equal to that retrieved by ProcStatDelta_size().
+*/
+void ProcStatDelta_encode(const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, ProcStatDelta_t* out);
+
+
+/**
+ * \brief Extends change of data by one directly following it, so that it spans both intervals.
+ * Processors offline at the end of the later interval remain marked as such, ones offline at the end of the earlier
+ * interval only have change over the later one. Frequencies are mean of both, weighted by length of intervals,
+ * and are dropped unless the later change has them.
+ * \param self Change over the earlier interval, replaced by change over both intervals.
+ * \param next Change over the later interval.
+*/
+void ProcStatDelta_merge(ProcStatDelta_t* self, const ProcStatDelta_t* next);
+
+
 #endif // !PROCSTAT_H_INCLUDED
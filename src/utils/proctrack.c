@@ -0,0 +1,841 @@
+#include "proctrack.h"
+#include "helpers.h"
+#include "batchread.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define PROC_ROOT_DEFAULT 			"/proc"
+#define PROC_STAT_MAX 				1024u
+#define PROC_ENTRIES_INITIAL 		1024u
+// Descriptors left for the rest of the program when caching files of processes
+#define FD_RESERVE 					256u
+#define FD_CACHE_MAX 				65536u
+// Fields of /proc/[pid]/stat, numbered from 1 as in proc(5)
+#define FIELD_UTIME 				14u
+#define FIELD_STIME 				15u
+#define FIELD_STARTTIME 			22u
+#define FIELD_PROCESSOR 			39u
+#define NO_INDEX 					UINT32_MAX
+
+
+/**
+ * State of a single tracked process.
+*/
+typedef struct ProcEntry
+{
+	/** Process identifier. */
+	int 		pid;
+	/** Cached descriptor of the process' stat file, negative if not cached. */
+	int 		fd;
+	/** Processor the process has last run on. */
+	int 		lastCpu;
+	/** Usage over the interval between the last two reads, in basis points of a single processor. */
+	uint32_t 	usageBp;
+	/** Whether usage has been calculated, which takes two reads of the same process. */
+	bool 		measured;
+	/** Whether process has been listed by the last directory scan. */
+	bool 		listed;
+	/** Start time of the process, in clock ticks since boot, telling reused identifiers apart. */
+	unsigned long long startTime;
+	/** User and system time of the process as of the last read, in clock ticks. */
+	unsigned long long ticks;
+	/** Point in time of the last read, on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long readNs;
+	/** Name of the process executable. */
+	char 		comm[PROCTRACK_COMM_LENGTH];
+}
+ProcEntry_t;
+
+
+/**
+ * Values extracted from a single /proc/[pid]/stat file.
+*/
+typedef struct ProcSample
+{
+	unsigned long long ticks;
+	unsigned long long startTime;
+	int lastCpu;
+	const char* comm;
+	size_t commLength;
+}
+ProcSample_t;
+
+
+struct ProcTracker
+{
+	/** Descriptor of the directory holding process directories. */
+	int 			rootFd;
+	/** Path of the directory holding process directories. */
+	char 			procRoot[PATH_MAX];
+	/** Process threads of which are tracked instead of processes, 0 if processes are tracked. */
+	int 			targetPid;
+	/** Tracked processes, in order of discovery. */
+	ProcEntry_t* 	entries;
+	size_t 			entriesLength;
+	size_t 			entriesCapacity;
+	/** Open addressing index of entries by process identifier, power of two in size. */
+	uint32_t* 		index;
+	size_t 			indexCapacity;
+	/** Amount of top consumers to report. */
+	size_t 			topCount;
+	/** Indices of top consumers found so far, ordered from the top one. */
+	uint32_t* 		top;
+	/** Amount of steps a scan is spread across, and the step to be taken next. */
+	unsigned 		slices;
+	unsigned 		slice;
+	/** Amount of cached file descriptors, and the limit of them. */
+	size_t 			cachedFds;
+	size_t 			maxCachedFds;
+	/** Reader of cached files, along with a buffer and a request for every read of a single batch. */
+	BatchReader_t* 	reader;
+	char* 			batchBuffers;
+	BatchReadRequest_t* batchRequests;
+	/** Clock ticks per second, as used in /proc/[pid]/stat. */
+	long 			ticksPerSecond;
+	/** Start of the current and the previous scan, on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long scanStartNs;
+	unsigned long long prevScanStartNs;
+	/** Processor time spent on the current scan so far, in nanoseconds. */
+	unsigned long long scanCostNs;
+};
+
+
+/**
+ * \brief Retrieves processor time consumed by the calling thread, in nanoseconds.
+*/
+static unsigned long long threadCpuTimeNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (unsigned long long) ts.tv_sec * 1000000000ull + (unsigned long long) ts.tv_nsec;
+}
+
+
+/**
+ * \brief Hashes process identifier into position in index of given capacity.
+*/
+static inline size_t hashPid(int pid, size_t capacity)
+{
+	return (size_t) (((uint32_t) pid * 2654435761u) & (uint32_t) (capacity - 1u));
+}
+
+
+/**
+ * \brief Finds entry of given process.
+ * \return Pointer to index slot holding entry's position if found, or empty slot it would be inserted into.
+*/
+static uint32_t* findSlot(ProcTracker_t* self, int pid)
+{
+	size_t position = hashPid(pid, self->indexCapacity);
+
+	while ((NO_INDEX != self->index[position]) && (self->entries[self->index[position]].pid != pid))
+	{
+		position = (position + 1u) & (self->indexCapacity - 1u);
+	}
+
+	return &self->index[position];
+}
+
+
+/**
+ * \brief Rebuilds index of entries, with room for twice as many entries as can currently be stored.
+ * \return True if successful, false if allocation fails.
+*/
+static bool rebuildIndex(ProcTracker_t* self)
+{
+	size_t capacity = 1u;
+
+	while (capacity < 2u * self->entriesCapacity)
+	{
+		capacity *= 2u;
+	}
+
+	if (capacity != self->indexCapacity)
+	{
+		uint32_t* index = realloc(self->index, capacity * sizeof(uint32_t));
+
+		if (NULL == index)
+		{
+			return false;
+		}
+
+		self->index = index;
+		self->indexCapacity = capacity;
+	}
+
+	memset(self->index, 0xFF, self->indexCapacity * sizeof(uint32_t));
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		*findSlot(self, self->entries[ii].pid) = (uint32_t) ii;
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Closes cached file descriptor of given entry, if any.
+*/
+static void releaseFd(ProcTracker_t* self, ProcEntry_t* entry)
+{
+	if (0 <= entry->fd)
+	{
+		close(entry->fd);
+		entry->fd = -1;
+		--self->cachedFds;
+	}
+}
+
+
+/**
+ * \brief Parses unsigned decimal number, advancing given pointer past it.
+*/
+static inline unsigned long long parseNumber(const char** str, const char* end)
+{
+	const char* p = *str;
+	unsigned long long value = 0u;
+
+	while ((p < end) && ('0' <= *p) && ('9' >= *p))
+	{
+		value = value * 10u + (unsigned long long) (*p - '0');
+		++p;
+	}
+
+	*str = p;
+	return value;
+}
+
+
+/**
+ * \brief Extracts values of interest from contents of /proc/[pid]/stat file.
+ * Process name is enclosed in parentheses and may contain any characters, so fields are counted from the last ')'.
+ * \return True if successful, false if contents are malformed.
+*/
+static bool parseProcStat(const char* text, size_t length, ProcSample_t* out)
+{
+	const char* const end = text + length;
+	const char* open = memchr(text, '(', length);
+	const char* close = NULL;
+
+	for (const char* p = end; p > text; --p)
+	{
+		if (')' == p[-1])
+		{
+			close = p - 1;
+			break;
+		}
+	}
+
+	if ((NULL == open) || (NULL == close) || (close < open))
+	{
+		return false;
+	}
+
+	out->comm = open + 1;
+	out->commLength = (size_t) (close - open - 1);
+
+	const char* p = close + 1;
+	unsigned field = 2u;
+	unsigned long long utime = 0u;
+	bool complete = false;
+
+	while ((p < end) && !complete)
+	{
+		while ((p < end) && (' ' == *p))
+		{
+			++p;
+		}
+
+		++field;
+
+		switch (field)
+		{
+			case FIELD_UTIME:
+				utime = parseNumber(&p, end);
+				break;
+
+			case FIELD_STIME:
+				out->ticks = utime + parseNumber(&p, end);
+				break;
+
+			case FIELD_STARTTIME:
+				out->startTime = parseNumber(&p, end);
+				break;
+
+			case FIELD_PROCESSOR:
+				out->lastCpu = (int) parseNumber(&p, end);
+				complete = true;
+				break;
+
+			default:
+				while ((p < end) && (' ' != *p))
+				{
+					++p;
+				}
+				break;
+		}
+	}
+
+	return complete;
+}
+
+
+/**
+ * \brief Opens and reads stat file of given process, caching it's descriptor if limit allows.
+ * A cached descriptor keeps referring to the process it has been opened for, so once that process exits,
+ * reading it fails and the file is opened again, in case identifier has already been reused.
+ * \return Length of read contents, 0 if process does not exist.
+*/
+static size_t openProcStat(ProcTracker_t* self, ProcEntry_t* entry, char* buf, size_t bufSize)
+{
+	releaseFd(self, entry);
+
+	char path[16];
+	snprintf(path, sizeof(path), "%d/stat", entry->pid);
+	const int fd = openat(self->rootFd, path, O_RDONLY | O_CLOEXEC);
+
+	if (0 > fd)
+	{
+		return 0u;
+	}
+
+	const ssize_t length = pread(fd, buf, bufSize, 0);
+
+	if ((0 < length) && (self->cachedFds < self->maxCachedFds))
+	{
+		entry->fd = fd;
+		++self->cachedFds;
+	}
+	else
+	{
+		close(fd);
+	}
+
+	return (0 < length) ? (size_t) length : 0u;
+}
+
+
+/**
+ * \brief Updates given process from contents of it's stat file, calculating it's usage since the previous read.
+ * \param length Length of contents, 0 if process no longer exists.
+ * \param nowNs Point in time of the read, on CLOCK_MONOTONIC, in nanoseconds.
+*/
+static void updateEntry(ProcTracker_t* self, ProcEntry_t* entry, const char* text, size_t length, unsigned long long nowNs)
+{
+	ProcSample_t sample;
+
+	if ((0u == length) || !parseProcStat(text, length, &sample))
+	{
+		// Process has exited, it's entry is dropped by the next directory scan
+		entry->measured = false;
+		entry->listed = false;
+		return;
+	}
+
+	const size_t commLength = (sample.commLength < PROCTRACK_COMM_LENGTH) ? sample.commLength : PROCTRACK_COMM_LENGTH - 1u;
+	memcpy(entry->comm, sample.comm, commLength);
+	entry->comm[commLength] = '\0';
+	entry->lastCpu = sample.lastCpu;
+
+	// Reused identifier belongs to a process started later, which has no usage yet
+	if ((0u != entry->readNs) && (sample.startTime == entry->startTime) &&
+		(sample.ticks >= entry->ticks) && (nowNs > entry->readNs))
+	{
+		const double elapsedTicks = (double) (nowNs - entry->readNs) * (double) self->ticksPerSecond / 1e9;
+		entry->usageBp = (uint32_t) ((double) (sample.ticks - entry->ticks) * 10000.0 / elapsedTicks + 0.5);
+		entry->measured = true;
+	}
+	else
+	{
+		entry->measured = false;
+	}
+
+	entry->startTime = sample.startTime;
+	entry->ticks = sample.ticks;
+	entry->readNs = nowNs;
+}
+
+
+/**
+ * \brief Reads given range of processes. Files already open are read in batches through batch reader,
+ * the rest, as well as those whose process has exited since, are opened one by one.
+*/
+static void readEntries(ProcTracker_t* self, size_t first, size_t last)
+{
+	const size_t depth = BATCHREAD_DEFAULT_DEPTH;
+
+	for (size_t batchFirst = first; batchFirst < last; batchFirst += depth)
+	{
+		const size_t batchLast = (last - batchFirst < depth) ? last : batchFirst + depth;
+		size_t count = 0u;
+
+		for (size_t ii = batchFirst; ii < batchLast; ++ii)
+		{
+			if (0 <= self->entries[ii].fd)
+			{
+				self->batchRequests[count] = (BatchReadRequest_t)
+				{
+					.fd 	= self->entries[ii].fd,
+					.buf 	= &self->batchBuffers[count * PROC_STAT_MAX],
+					.size 	= PROC_STAT_MAX
+				};
+				++count;
+			}
+		}
+
+		// Entries of batch that could not be read keep their previous sample
+		if (0 != BatchReader_read(self->reader, self->batchRequests, count))
+		{
+			continue;
+		}
+
+		const unsigned long long batchNs = MonotonicTimeNs();
+		size_t request = 0u;
+
+		for (size_t ii = batchFirst; ii < batchLast; ++ii)
+		{
+			ProcEntry_t* entry = &self->entries[ii];
+			const BatchReadRequest_t* read = (0 <= entry->fd) ? &self->batchRequests[request++] : NULL;
+
+			if ((NULL != read) && (0 < read->result))
+			{
+				updateEntry(self, entry, read->buf, (size_t) read->result, batchNs);
+			}
+			else
+			{
+				char buf[PROC_STAT_MAX];
+				const size_t length = openProcStat(self, entry, buf, sizeof(buf));
+				updateEntry(self, entry, buf, length, MonotonicTimeNs());
+			}
+		}
+	}
+}
+
+
+/**
+ * \brief Lists process directories, adding entries of new processes and dropping those of exited ones.
+ * \return True if successful, false otherwise.
+*/
+static bool scanDirectory(ProcTracker_t* self)
+{
+	const int dirFd = openat(self->rootFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR* dir = (0 <= dirFd) ? fdopendir(dirFd) : NULL;
+
+	if (NULL == dir)
+	{
+		if (0 <= dirFd)
+		{
+			close(dirFd);
+		}
+
+		return false;
+	}
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		self->entries[ii].listed = false;
+	}
+
+	struct dirent* dirEntry;
+
+	while (NULL != (dirEntry = readdir(dir)))
+	{
+		if (!isdigit((unsigned char) dirEntry->d_name[0]))
+		{
+			continue;
+		}
+
+		const int pid = atoi(dirEntry->d_name);
+		uint32_t* slot = findSlot(self, pid);
+
+		if (NO_INDEX != *slot)
+		{
+			self->entries[*slot].listed = true;
+			continue;
+		}
+
+		if (self->entriesLength == self->entriesCapacity)
+		{
+			ProcEntry_t* entries = realloc(self->entries, 2u * self->entriesCapacity * sizeof(ProcEntry_t));
+
+			if (NULL == entries)
+			{
+				closedir(dir);
+				return false;
+			}
+
+			self->entries = entries;
+			self->entriesCapacity *= 2u;
+
+			if (!rebuildIndex(self))
+			{
+				closedir(dir);
+				return false;
+			}
+
+			slot = findSlot(self, pid);
+		}
+
+		*slot = (uint32_t) self->entriesLength;
+		self->entries[self->entriesLength++] = (ProcEntry_t) { .pid = pid, .fd = -1, .listed = true };
+	}
+
+	closedir(dir);
+
+	// Entries of exited processes are dropped, keeping the rest in order
+	size_t kept = 0u;
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		if (self->entries[ii].listed)
+		{
+			self->entries[kept++] = self->entries[ii];
+		}
+		else
+		{
+			releaseFd(self, &self->entries[ii]);
+		}
+	}
+
+	if (kept != self->entriesLength)
+	{
+		self->entriesLength = kept;
+		return rebuildIndex(self);
+	}
+
+	return true;
+}
+
+
+/**
+ * \brief Finds top consumers among measured processes, ordered from the top one.
+ * \return Amount of top consumers found.
+*/
+static size_t rankEntries(ProcTracker_t* self)
+{
+	size_t count = 0u;
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		const ProcEntry_t* entry = &self->entries[ii];
+
+		if (!entry->measured || ((count == self->topCount) && (entry->usageBp <= self->entries[self->top[count - 1u]].usageBp)))
+		{
+			continue;
+		}
+
+		// Insertion into short sorted list, most processes do not make it past the check above
+		size_t position = (count < self->topCount) ? count++ : count - 1u;
+
+		while ((0u < position) && (self->entries[self->top[position - 1u]].usageBp < entry->usageBp))
+		{
+			self->top[position] = self->top[position - 1u];
+			--position;
+		}
+
+		self->top[position] = (uint32_t) ii;
+	}
+
+	return count;
+}
+
+
+ProcTracker_t* ProcTracker_createForThreads(const char* procRoot, int pid, size_t topCount, unsigned slices)
+{
+	ProcTracker_t* self = ProcTracker_create(procRoot, topCount, slices);
+
+	if ((NULL != self) && (0 != ProcTracker_setTargetPid(self, pid)))
+	{
+		ProcTracker_destroy(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+
+ProcTracker_t* ProcTracker_create(const char* procRoot, size_t topCount, unsigned slices)
+{
+	if ((0u == topCount) || (0u == slices))
+	{
+		return NULL;
+	}
+
+	if (NULL == procRoot)
+	{
+		procRoot = PROC_ROOT_DEFAULT;
+	}
+
+	ProcTracker_t* self = calloc(1u, sizeof(ProcTracker_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	if ((size_t) snprintf(self->procRoot, sizeof(self->procRoot), "%s", procRoot) >= sizeof(self->procRoot))
+	{
+		goto error_exit_2;
+	}
+
+	self->rootFd = open(procRoot, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (0 > self->rootFd)
+	{
+		goto error_exit_2;
+	}
+
+	self->entriesCapacity = PROC_ENTRIES_INITIAL;
+	self->entries = malloc(self->entriesCapacity * sizeof(ProcEntry_t));
+	self->top = malloc(topCount * sizeof(uint32_t));
+	self->reader = BatchReader_create(BATCHREAD_DEFAULT_DEPTH, BREAD_BACKEND_AUTO);
+	self->batchBuffers = malloc(BATCHREAD_DEFAULT_DEPTH * PROC_STAT_MAX);
+	self->batchRequests = malloc(BATCHREAD_DEFAULT_DEPTH * sizeof(BatchReadRequest_t));
+
+	if ((NULL == self->entries) || (NULL == self->top) || (NULL == self->reader) ||
+		(NULL == self->batchBuffers) || (NULL == self->batchRequests) || !rebuildIndex(self))
+	{
+		goto error_exit_3;
+	}
+
+	// Half of descriptors still available are used to keep files of long-lived processes open
+	struct rlimit limit;
+	const size_t fdLimit = ((0 == getrlimit(RLIMIT_NOFILE, &limit)) && (RLIM_INFINITY != limit.rlim_cur))
+		? (size_t) limit.rlim_cur
+		: FD_CACHE_MAX;
+
+	self->maxCachedFds 		= (fdLimit > 2u * FD_RESERVE) ? (fdLimit - FD_RESERVE) / 2u : 0u;
+	self->maxCachedFds 		= (self->maxCachedFds > FD_CACHE_MAX) ? FD_CACHE_MAX : self->maxCachedFds;
+	self->topCount 			= topCount;
+	self->slices 			= slices;
+	self->ticksPerSecond 	= sysconf(_SC_CLK_TCK);
+
+	if (0 >= self->ticksPerSecond)
+	{
+		goto error_exit_3;
+	}
+
+	return self;
+
+error_exit_3:
+	free(self->batchRequests);
+	free(self->batchBuffers);
+	BatchReader_destroy(self->reader);
+	free(self->top);
+	free(self->index);
+	free(self->entries);
+	close(self->rootFd);
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void ProcTracker_destroy(ProcTracker_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		releaseFd(self, &self->entries[ii]);
+	}
+
+	close(self->rootFd);
+	free(self->batchRequests);
+	free(self->batchBuffers);
+	BatchReader_destroy(self->reader);
+	free(self->top);
+	free(self->index);
+	free(self->entries);
+	free(self);
+}
+
+
+int ProcTracker_setTargetPid(ProcTracker_t* self, int pid)
+{
+	if ((NULL == self) || (0 >= pid))
+	{
+		return -1;
+	}
+
+	char path[PATH_MAX + 32u];
+	snprintf(path, sizeof(path), "%s/%d/task", self->procRoot, pid);
+	const int taskFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if (0 > taskFd)
+	{
+		return -2;
+	}
+
+	// Threads of another process have nothing in common with tracked ones, tracking starts over
+	for (size_t ii = 0; ii < self->entriesLength; ++ii)
+	{
+		releaseFd(self, &self->entries[ii]);
+	}
+
+	self->entriesLength 	= 0u;
+	self->slice 			= 0u;
+	self->scanStartNs 		= 0u;
+	self->prevScanStartNs 	= 0u;
+	self->targetPid 		= pid;
+	close(self->rootFd);
+	self->rootFd = taskFd;
+	rebuildIndex(self);
+	return 0;
+}
+
+
+int ProcTracker_getTargetPid(const ProcTracker_t* self)
+{
+	return self->targetPid;
+}
+
+
+int ProcTracker_resolvePid(const char* spec)
+{
+	if ((NULL == spec) || ('\0' == spec[0]))
+	{
+		return -1;
+	}
+
+	char buf[32];
+	const char* text = spec;
+
+	// Anything but a plain number is a path of PID file
+	if (strspn(spec, "0123456789") != strlen(spec))
+	{
+		if (0 >= ReadFileContent(spec, buf, sizeof(buf)))
+		{
+			return -2;
+		}
+
+		text = buf;
+	}
+
+	char* end = NULL;
+	errno = 0;
+	const long pid = strtol(text, &end, 10);
+
+	if ((0 != errno) || (end == text) || (0 >= pid) || (pid > INT_MAX) || !((' ' >= *end) || ('\0' == *end)))
+	{
+		return -3;
+	}
+
+	return (int) pid;
+}
+
+
+int ProcTracker_step(ProcTracker_t* self, ProcUsageReport_t* report)
+{
+	if ((NULL == self) || (NULL == report))
+	{
+		return -1;
+	}
+
+	const unsigned long long costStartNs = threadCpuTimeNs();
+
+	if (0u == self->slice)
+	{
+		self->prevScanStartNs = self->scanStartNs;
+		self->scanStartNs = MonotonicTimeNs();
+		self->scanCostNs = 0u;
+
+		const bool scanned = scanDirectory(self);
+
+		// Task directory of exited process lists no threads, or cannot be listed at all once it is reaped
+		if ((0 != self->targetPid) && (!scanned || (0u == self->entriesLength)))
+		{
+			return PROCTRACK_TARGET_EXITED;
+		}
+
+		if (!scanned)
+		{
+			return -2;
+		}
+	}
+
+	// Processes are split evenly between steps, listing order keeps every process in the same step of every scan
+	const size_t first = self->entriesLength * self->slice / self->slices;
+	const size_t last = self->entriesLength * (self->slice + 1u) / self->slices;
+
+	readEntries(self, first, last);
+
+	self->slice = (self->slice + 1u) % self->slices;
+	self->scanCostNs += threadCpuTimeNs() - costStartNs;
+
+	if (0u != self->slice)
+	{
+		return 0;
+	}
+
+	report->count 			= rankEntries(self);
+	report->processCount 	= self->entriesLength;
+	report->targetPid 		= self->targetPid;
+	report->intervalNs 		= (0u != self->prevScanStartNs) ? self->scanStartNs - self->prevScanStartNs : 0u;
+	report->scanCostNs 		= self->scanCostNs;
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		const ProcEntry_t* entry = &self->entries[self->top[ii]];
+		report->top[ii] = (ProcUsage_t) { .pid = entry->pid, .lastCpu = entry->lastCpu, .usageBp = entry->usageBp };
+		memcpy(report->top[ii].comm, entry->comm, PROCTRACK_COMM_LENGTH);
+	}
+
+	return 1;
+}
+
+
+size_t ProcUsageReport_size(size_t topCount)
+{
+	return sizeof(ProcUsageReport_t) + topCount * sizeof(ProcUsage_t);
+}
+
+
+void ProcUsageReport_print(FILE* out, const ProcUsageReport_t* report)
+{
+	if ((NULL == out) || (NULL == report) || (0u == report->processCount))
+	{
+		return;
+	}
+
+	if (0 != report->targetPid)
+	{
+		fprintf(out, "Threads of PID%d:", report->targetPid);
+	}
+	else
+	{
+		fputs("Processes:", out);
+	}
+
+	fprintf(out, "\t%zu tracked, scan took %.2f ms of CPU every %.1f ms\n",
+		report->processCount,
+		report->scanCostNs / 1000000.0,
+		report->intervalNs / 1000000.0);
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		const ProcUsage_t* usage = &report->top[ii];
+		fprintf(out, "%s%d:\t%u.%02u %%\ton CPU%d\t%s\n",
+			(0 != report->targetPid) ? "TID" : "PID",
+			usage->pid,
+			usage->usageBp / 100u,
+			usage->usageBp % 100u,
+			usage->lastCpu,
+			usage->comm);
+	}
+}
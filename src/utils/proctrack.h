@@ -0,0 +1,153 @@
+/**
+ * \file proctrack.h
+ * Per-process CPU usage tracking, scanning /proc/[pid]/stat files incrementally over consecutive sampling periods.
+ * Threads of a single process are tracked the same way, from /proc/[pid]/task/[tid]/stat files.
+*/
+#ifndef PROCTRACK_H_INCLUDED
+#define PROCTRACK_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Length of process name buffer, including terminating null character. Longer names are truncated.
+*/
+#define PROCTRACK_COMM_LENGTH 32u
+
+/**
+ * Default amount of sampling periods a full scan of every process is spread across.
+*/
+#define PROCTRACK_DEFAULT_SLICES 4u
+
+/**
+ * Value returned by ProcTracker_step() once process threads of which are tracked has exited.
+*/
+#define PROCTRACK_TARGET_EXITED (-3)
+
+
+typedef struct ProcTracker ProcTracker_t;
+
+
+/**
+ * Usage of a single process, or thread, over the last full scan.
+*/
+typedef struct ProcUsage
+{
+	/** Process identifier, or thread identifier if threads are tracked. */
+	int 		pid;
+	/** Processor the process has last run on. */
+	int 		lastCpu;
+	/** Usage in basis points of a single processor, exceeding CPUUSAGE_BP_FULL for processes running on many of them. */
+	uint32_t 	usageBp;
+	/** Name of the process executable, as reported in /proc/[pid]/stat. */
+	char 		comm[PROCTRACK_COMM_LENGTH];
+}
+ProcUsage_t;
+
+
+/**
+ * Processes using the most of processor time over the last full scan, from the top consumer.
+*/
+typedef struct ProcUsageReport
+{
+	/** Amount of processes in top array. */
+	size_t 		count;
+	/** Amount of processes, or threads, tracked during the scan. */
+	size_t 		processCount;
+	/** Process threads of which have been tracked, 0 if processes have been tracked. */
+	int 		targetPid;
+	/** Length of the scan, from start of the previous one, in nanoseconds. */
+	unsigned long long intervalNs;
+	/** Processor time spent on the scan, in nanoseconds. */
+	unsigned long long scanCostNs;
+	/** Top consumers. */
+	ProcUsage_t top[];
+}
+ProcUsageReport_t;
+
+
+/**
+ * \brief Creates process tracker.
+ * \param procRoot Directory to scan for process directories, NULL for "/proc".
+ * \param topCount Amount of top consumers to report, at least 1.
+ * \param slices Amount of ProcTracker_step() calls a full scan of every process is spread across, at least 1.
+ * \return Pointer to tracker if successful, NULL otherwise.
+*/
+ProcTracker_t* ProcTracker_create(const char* procRoot, size_t topCount, unsigned slices);
+
+
+/**
+ * \brief Creates tracker of threads of a single process. Cost of every scan follows amount of it's threads only.
+ * \param procRoot Directory holding process directories, NULL for "/proc".
+ * \param pid Process to track threads of.
+ * \param topCount Amount of top consumers to report, at least 1.
+ * \param slices Amount of ProcTracker_step() calls a full scan of every thread is spread across, at least 1.
+ * \return Pointer to tracker if successful, NULL if process does not exist or tracker cannot be created.
+*/
+ProcTracker_t* ProcTracker_createForThreads(const char* procRoot, int pid, size_t topCount, unsigned slices);
+
+
+/**
+ * \brief Destroys process tracker, closing every cached file descriptor. Does nothing if NULL.
+ * \param self Tracker to destroy.
+*/
+void ProcTracker_destroy(ProcTracker_t* self);
+
+
+/**
+ * \brief Scans next slice of tracked processes. The first slice of every scan lists process directories,
+ * picking up new processes and dropping exited ones, the last one ranks processes by usage since their previous scan.
+ * Files of processes are kept open between scans as long as descriptor limit allows, and re-read with pread().
+ * Identifier reuse is detected by process start time.
+ * \param self Tracker to advance.
+ * \param report Output buffer, of size retrieved by ProcUsageReport_size(), filled once scan is complete.
+ * \return 1 if scan has been completed and report filled, 0 if scan is still in progress,
+ * PROCTRACK_TARGET_EXITED if tracked threads belong to a process that has exited, other negative value on error.
+*/
+int ProcTracker_step(ProcTracker_t* self, ProcUsageReport_t* report);
+
+
+/**
+ * \brief Switches tracker to threads of another process, eg. once the previous one has exited and been restarted.
+ * Every tracked thread is dropped and the next step starts a new scan.
+ * \param self Tracker to switch.
+ * \param pid Process to track threads of.
+ * \return 0 if successful, negative value if process does not exist, in which case tracker is unchanged.
+*/
+int ProcTracker_setTargetPid(ProcTracker_t* self, int pid);
+
+
+/**
+ * \brief Retrieves process threads of which are tracked.
+ * \param self Tracker to query.
+ * \return Process identifier, 0 if tracker tracks processes.
+*/
+int ProcTracker_getTargetPid(const ProcTracker_t* self);
+
+
+/**
+ * \brief Resolves process identifier given either as a number or as path of a PID file holding one.
+ * \param spec Process identifier or PID file path.
+ * \return Process identifier if successful, negative value if file cannot be read or holds no valid identifier.
+*/
+int ProcTracker_resolvePid(const char* spec);
+
+
+/**
+ * \brief Retrieves size of report of given amount of top consumers.
+ * \param topCount Amount of top consumers.
+ * \return Size of ProcUsageReport structure, in bytes.
+*/
+size_t ProcUsageReport_size(size_t topCount);
+
+
+/**
+ * \brief Prints top consumers, one line per process. Prints nothing for zeroed report, as no scan has been completed yet.
+ * \param out Stream to print into.
+ * \param report Report to print.
+*/
+void ProcUsageReport_print(FILE* out, const ProcUsageReport_t* report);
+
+
+#endif // !PROCTRACK_H_INCLUDED
@@ -0,0 +1,775 @@
+#include "recording.h"
+#include "varint.h"
+#include "logger.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+#define RECORDING_SEGMENT_NAME_FORMAT 	"%s.%06u" RECORDING_SEGMENT_EXTENSION
+#define RECORDING_INDEX_NAME_FORMAT 	"%s.%06u" RECORDING_INDEX_EXTENSION
+#define RECORDING_END_TIME_OFFSET 		48
+#define RECORDING_MIN_SEGMENT_BYTES 	4096u
+
+
+struct RecordingWriter
+{
+	/** Currently open segment. */
+	FILE* 			file;
+	/** Index of currently open segment. */
+	FILE* 			indexFile;
+	/** Path prefix of segment files. */
+	char 			basePath[PATH_MAX];
+	/** Sequence number of currently open segment. */
+	unsigned 		segmentSeq;
+	/** Size of currently open segment, in bytes. */
+	size_t 			segmentBytes;
+	/** Amount of samples written into currently open segment. */
+	uint64_t 		segmentSamples;
+	/** CLOCK_MONOTONIC at which current segment has been started, in nanoseconds. */
+	uint64_t 		segmentStartMonotonicNs;
+	/** CLOCK_REALTIME at which current segment has been started, in nanoseconds since Epoch. */
+	uint64_t 		segmentStartRealTimeNs;
+	/** CLOCK_REALTIME of most recent sample, in nanoseconds since Epoch. */
+	uint64_t 		lastRealTimeNs;
+	/** Size after which segment is rolled over, in bytes. */
+	size_t 			maxSegmentBytes;
+	/** Amount of samples between consecutive keyframes. */
+	unsigned 		keyframeInterval;
+	/** Amount of "cpu(N)" lines in every sample. */
+	size_t 			cpuStatsLength;
+	/** Timestamp of previous sample, on CLOCK_MONOTONIC, in nanoseconds. */
+	uint64_t 		prevTimestampNs;
+	/** Counter values of previous sample, delta base. */
+	CpuStat_t* 		prevStats;
+	/** Buffer for single encoded record, large enough for keyframe with every value at maximum length. */
+	uint8_t* 		record;
+};
+
+
+struct RecordingSegment
+{
+	/** Mapped segment file. */
+	const uint8_t* 		data;
+	/** Length of mapped segment file, in bytes. */
+	size_t 				dataLength;
+	/** Decoded segment header. */
+	RecordingHeader_t 	header;
+	/** Keyframe index entries, either mapped from index file or built by scanning the segment. */
+	const uint8_t* 		index;
+	/** Amount of index entries. */
+	size_t 				indexCount;
+	/** Length of mapped index file, in bytes. Zero if index has been built in memory. */
+	size_t 				indexMapLength;
+};
+
+
+/**
+ * \brief Stores 32-bit value in little-endian byte order.
+*/
+static void putU32(uint8_t* out, uint32_t value)
+{
+	for (size_t ii = 0; ii < 4u; ++ii)
+	{
+		out[ii] = (uint8_t) (value >> (8u * ii));
+	}
+}
+
+
+/**
+ * \brief Stores 64-bit value in little-endian byte order.
+*/
+static void putU64(uint8_t* out, uint64_t value)
+{
+	for (size_t ii = 0; ii < 8u; ++ii)
+	{
+		out[ii] = (uint8_t) (value >> (8u * ii));
+	}
+}
+
+
+/**
+ * \brief Loads 32-bit value stored in little-endian byte order.
+*/
+static uint32_t getU32(const uint8_t* in)
+{
+	uint32_t value = 0u;
+
+	for (size_t ii = 0; ii < 4u; ++ii)
+	{
+		value |= (uint32_t) in[ii] << (8u * ii);
+	}
+
+	return value;
+}
+
+
+/**
+ * \brief Loads 64-bit value stored in little-endian byte order.
+*/
+static uint64_t getU64(const uint8_t* in)
+{
+	uint64_t value = 0u;
+
+	for (size_t ii = 0; ii < 8u; ++ii)
+	{
+		value |= (uint64_t) in[ii] << (8u * ii);
+	}
+
+	return value;
+}
+
+
+/**
+ * \brief Writes trailing fields of current segment's header and closes it.
+ * \param self Recording writer.
+ * \return 0 if successful, negative value otherwise.
+*/
+static int closeSegment(RecordingWriter_t* self)
+{
+	if (NULL == self->file)
+	{
+		return 0;
+	}
+
+	int retval = 0;
+	uint8_t trailer[16];
+	putU64(trailer, self->lastRealTimeNs);
+	putU64(trailer + 8, self->segmentSamples);
+
+	if ((0 != fseek(self->file, RECORDING_END_TIME_OFFSET, SEEK_SET)) ||
+		(1u != fwrite(trailer, sizeof(trailer), 1u, self->file)))
+	{
+		Log(LLEVEL_ERROR, "cannot complete header of recording segment %u", self->segmentSeq);
+		retval = -1;
+	}
+
+	if (0 != fclose(self->file))
+	{
+		retval = -2;
+	}
+
+	if ((NULL != self->indexFile) && (0 != fclose(self->indexFile)))
+	{
+		retval = -3;
+	}
+
+	self->file = NULL;
+	self->indexFile = NULL;
+	return retval;
+}
+
+
+/**
+ * \brief Creates next segment file and writes it's header.
+ * \param self Recording writer.
+ * \return 0 if successful, negative value otherwise.
+*/
+static int openSegment(RecordingWriter_t* self)
+{
+	char path[PATH_MAX];
+	int pathLength = snprintf(path, sizeof(path), RECORDING_SEGMENT_NAME_FORMAT, self->basePath, self->segmentSeq);
+
+	if ((0 > pathLength) || ((size_t) pathLength >= sizeof(path)))
+	{
+		Log(LLEVEL_ERROR, "recording segment path too long");
+		return -1;
+	}
+
+	self->file = fopen(path, "wb");
+
+	if (NULL == self->file)
+	{
+		Log(LLEVEL_ERROR, "cannot create recording segment %s", path);
+		return -2;
+	}
+
+	pathLength = snprintf(path, sizeof(path), RECORDING_INDEX_NAME_FORMAT, self->basePath, self->segmentSeq);
+
+	// Segment remains readable without it's index, so failing to create one is not fatal
+	if ((0 > pathLength) || ((size_t) pathLength >= sizeof(path)) || (NULL == (self->indexFile = fopen(path, "wb"))))
+	{
+		Log(LLEVEL_WARNING, "cannot create index of recording segment %u", self->segmentSeq);
+	}
+
+	self->segmentStartMonotonicNs = MonotonicTimeNs();
+	self->segmentStartRealTimeNs = RealTimeNs();
+	self->segmentSamples = 0u;
+	self->lastRealTimeNs = self->segmentStartRealTimeNs;
+
+	uint8_t header[RECORDING_HEADER_SIZE] = { 0 };
+	memcpy(header, RECORDING_MAGIC, 8u);
+	putU32(header + 8, RECORDING_VERSION);
+	putU32(header + 12, RECORDING_HEADER_SIZE);
+	putU32(header + 16, (uint32_t) self->cpuStatsLength);
+	putU32(header + 20, CSINDEX_COUNT_);
+	putU32(header + 24, self->keyframeInterval);
+	putU64(header + 32, self->segmentStartRealTimeNs);
+	putU64(header + 40, self->segmentStartMonotonicNs);
+
+	if (1u != fwrite(header, sizeof(header), 1u, self->file))
+	{
+		Log(LLEVEL_ERROR, "cannot write header of recording segment %u", self->segmentSeq);
+		closeSegment(self);
+		return -3;
+	}
+
+	self->segmentBytes = sizeof(header);
+	Log(LLEVEL_INFO, "started recording segment %u", self->segmentSeq);
+	return 0;
+}
+
+
+RecordingWriter_t* RecordingWriter_create(const char* basePath, size_t cpuStatsLength, size_t maxSegmentBytes, unsigned keyframeInterval)
+{
+	if ((NULL == basePath) || (0u == cpuStatsLength) || (0u == keyframeInterval) ||
+		(strlen(basePath) >= PATH_MAX) || (cpuStatsLength > UINT32_MAX))
+	{
+		Log(LLEVEL_ERROR, "invalid argument provided");
+		goto error_exit_1;
+	}
+
+	RecordingWriter_t* self = calloc(1u, sizeof(RecordingWriter_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	self->prevStats = malloc(cpuStatsLength * sizeof(CpuStat_t));
+
+	if (NULL == self->prevStats)
+	{
+		goto error_exit_2;
+	}
+
+	self->record = malloc(1u + VARINT_MAX_LENGTH * (1u + cpuStatsLength * CSINDEX_COUNT_));
+
+	if (NULL == self->record)
+	{
+		goto error_exit_3;
+	}
+
+	strcpy(self->basePath, basePath);
+	self->cpuStatsLength 	= cpuStatsLength;
+	self->keyframeInterval 	= keyframeInterval;
+	self->maxSegmentBytes 	= (maxSegmentBytes < RECORDING_MIN_SEGMENT_BYTES) ? RECORDING_MIN_SEGMENT_BYTES : maxSegmentBytes;
+
+	if (0 != openSegment(self))
+	{
+		goto error_exit_4;
+	}
+
+	return self;
+
+error_exit_4:
+	free(self->record);
+error_exit_3:
+	free(self->prevStats);
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void RecordingWriter_destroy(RecordingWriter_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	closeSegment(self);
+	free(self->record);
+	free(self->prevStats);
+	free(self);
+}
+
+
+int RecordingWriter_append(RecordingWriter_t* self, const ProcStat_t* procStat)
+{
+	if ((NULL == self) || (NULL == procStat))
+	{
+		return -1;
+	}
+
+	if (procStat->cpuStatsLength != self->cpuStatsLength)
+	{
+		Log(LLEVEL_ERROR, "sample length %zu does not match recording length %zu",
+			procStat->cpuStatsLength, self->cpuStatsLength);
+		return -2;
+	}
+
+	if (self->segmentBytes >= self->maxSegmentBytes)
+	{
+		closeSegment(self);
+		++self->segmentSeq;
+
+		if (0 != openSegment(self))
+		{
+			return -3;
+		}
+	}
+
+	// First record of every segment is a keyframe, so that segments can be decoded independently
+	const bool keyframe = (0u == self->segmentSamples % self->keyframeInterval);
+	const uint64_t timestampNs = procStat->timestampNs;
+	uint8_t* out = self->record;
+
+	if (keyframe)
+	{
+		*out++ = RECORDING_TAG_KEYFRAME;
+		out += Varint_encode(timestampNs, out);
+
+		for (size_t ii = 0; ii < self->cpuStatsLength; ++ii)
+		{
+			for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+			{
+				out += Varint_encode(procStat->cpuStats[ii].values[jj], out);
+			}
+		}
+	}
+	else
+	{
+		*out++ = RECORDING_TAG_DELTA;
+		out += Varint_encode(timestampNs - self->prevTimestampNs, out);
+
+		for (size_t ii = 0; ii < self->cpuStatsLength; ++ii)
+		{
+			for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+			{
+				// Counters are cumulative, yet may occasionally go backwards, hence signed difference
+				const int64_t delta = (int64_t) (procStat->cpuStats[ii].values[jj] - self->prevStats[ii].values[jj]);
+				out += Varint_encode(Varint_zigzagEncode(delta), out);
+			}
+		}
+	}
+
+	const size_t recordLength = (size_t) (out - self->record);
+
+	// Deltas are left to stdio buffering, flushing every record would stall analyzer on disk latency every sample.
+	// Keyframes are flushed along with everything preceding them, before being indexed, so that index never points
+	// past data written so far, and at most a keyframe interval of samples is lost if the process dies.
+	if ((1u != fwrite(self->record, recordLength, 1u, self->file)) || (keyframe && (0 != fflush(self->file))))
+	{
+		Log(LLEVEL_ERROR, "cannot write into recording segment %u", self->segmentSeq);
+		return -4;
+	}
+
+	if (keyframe && (NULL != self->indexFile))
+	{
+		uint8_t entry[RECORDING_INDEX_ENTRY_SIZE];
+		putU64(entry, timestampNs);
+		putU64(entry + 8, self->segmentBytes);
+
+		if ((1u != fwrite(entry, sizeof(entry), 1u, self->indexFile)) || (0 != fflush(self->indexFile)))
+		{
+			Log(LLEVEL_WARNING, "cannot write index of recording segment %u", self->segmentSeq);
+		}
+	}
+
+	memcpy(self->prevStats, procStat->cpuStats, self->cpuStatsLength * sizeof(CpuStat_t));
+	self->prevTimestampNs 	= timestampNs;
+	// Derived from sample timestamp rather than read, so that header agrees with timestamps of records
+	self->lastRealTimeNs 	= self->segmentStartRealTimeNs + (timestampNs - self->segmentStartMonotonicNs);
+	self->segmentBytes 		+= recordLength;
+	++self->segmentSamples;
+	return 0;
+}
+
+
+int Recording_decodeHeader(const uint8_t* data, size_t dataLength, RecordingHeader_t* header)
+{
+	if ((NULL == data) || (NULL == header) || (dataLength < RECORDING_HEADER_SIZE))
+	{
+		return -1;
+	}
+
+	if (0 != memcmp(data, RECORDING_MAGIC, 8u))
+	{
+		return -2;
+	}
+
+	header->version = getU32(data + 8);
+
+	if ((RECORDING_VERSION != header->version) || (RECORDING_HEADER_SIZE != getU32(data + 12)))
+	{
+		return -3;
+	}
+
+	header->cpuStatsLength 		= getU32(data + 16);
+	header->valuesPerCpu 		= getU32(data + 20);
+	header->keyframeInterval 	= getU32(data + 24);
+	header->startRealTimeNs 	= getU64(data + 32);
+	header->startMonotonicNs 	= getU64(data + 40);
+	header->endRealTimeNs 		= getU64(data + RECORDING_END_TIME_OFFSET);
+	header->sampleCount 		= getU64(data + 56);
+
+	if ((0u == header->cpuStatsLength) || (CSINDEX_COUNT_ != header->valuesPerCpu))
+	{
+		return -4;
+	}
+
+	return 0;
+}
+
+
+/**
+ * \brief Decodes single record, applying it onto given sample, optionally skipping values of some lines.
+ * \param data Encoded record, positioned at it's tag byte.
+ * \param dataLength Amount of bytes available in data buffer.
+ * \param sample Sample to apply record onto.
+ * \param selectedLines Array of sample->cpuStatsLength flags telling which lines to decode, NULL to decode all.
+ * Values of lines that are not selected are left unchanged.
+ * \return Amount of bytes consumed, or 0 if record is truncated or malformed.
+*/
+static size_t decodeRecord(const uint8_t* data, size_t dataLength, ProcStat_t* sample, const bool* selectedLines)
+{
+	if ((NULL == data) || (NULL == sample) || (0u == dataLength))
+	{
+		return 0u;
+	}
+
+	const uint8_t tag = data[0];
+	size_t offset = 1u;
+	uint64_t value;
+	size_t consumed = Varint_decode(data + offset, dataLength - offset, &value);
+
+	if ((0u == consumed) || ((RECORDING_TAG_KEYFRAME != tag) && (RECORDING_TAG_DELTA != tag)))
+	{
+		return 0u;
+	}
+
+	offset += consumed;
+	sample->timestampNs = (RECORDING_TAG_KEYFRAME == tag) ? value : (sample->timestampNs + value);
+
+	for (size_t ii = 0; ii < sample->cpuStatsLength; ++ii)
+	{
+		// Every value is encoded independently, so values of other lines only have to be stepped over
+		if ((NULL != selectedLines) && !selectedLines[ii])
+		{
+			for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+			{
+				consumed = Varint_skip(data + offset, dataLength - offset);
+
+				if (0u == consumed)
+				{
+					return 0u;
+				}
+
+				offset += consumed;
+			}
+
+			continue;
+		}
+
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			consumed = Varint_decode(data + offset, dataLength - offset, &value);
+
+			if (0u == consumed)
+			{
+				return 0u;
+			}
+
+			offset += consumed;
+
+			if (RECORDING_TAG_KEYFRAME == tag)
+			{
+				sample->cpuStats[ii].values[jj] = value;
+			}
+			else
+			{
+				sample->cpuStats[ii].values[jj] += (CpuStatValue_t) Varint_zigzagDecode(value);
+			}
+		}
+	}
+
+	return offset;
+}
+
+
+size_t Recording_decodeRecord(const uint8_t* data, size_t dataLength, ProcStat_t* sample)
+{
+	return decodeRecord(data, dataLength, sample, NULL);
+}
+
+
+/**
+ * \brief Maps whole file into memory, read-only.
+ * \param path Path of file to map.
+ * \param length Pointer to write length of mapped file into.
+ * \return Pointer to mapped file contents if successful, NULL otherwise, including empty files.
+*/
+static const uint8_t* mapFile(const char* path, size_t* length)
+{
+	int fd = open(path, O_RDONLY);
+
+	if (0 > fd)
+	{
+		return NULL;
+	}
+
+	struct stat st;
+	void* data = MAP_FAILED;
+
+	if ((0 == fstat(fd, &st)) && (0 < st.st_size))
+	{
+		*length = (size_t) st.st_size;
+		data = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+
+	close(fd);
+	return (MAP_FAILED == data) ? NULL : data;
+}
+
+
+/**
+ * \brief Builds keyframe index of given segment by decoding all of it's records.
+ * Used for segments whose index file is missing or damaged.
+ * \param self Segment to build index for.
+ * \return 0 if successful, negative value otherwise.
+*/
+static int buildIndex(RecordingSegment_t* self)
+{
+	ProcStat_t* sample = malloc(sizeof(ProcStat_t) + self->header.cpuStatsLength * sizeof(CpuStat_t));
+	size_t capacity = 64u;
+	uint8_t* index = malloc(capacity * RECORDING_INDEX_ENTRY_SIZE);
+
+	if ((NULL == sample) || (NULL == index))
+	{
+		free(sample);
+		free(index);
+		return -1;
+	}
+
+	sample->cpuStatsLength = self->header.cpuStatsLength;
+	size_t count = 0u;
+
+	for (size_t offset = RECORDING_HEADER_SIZE, next; 0u != (next = RecordingSegment_next(self, offset, sample)); offset = next)
+	{
+		if (RECORDING_TAG_KEYFRAME != self->data[offset])
+		{
+			continue;
+		}
+
+		if (count == capacity)
+		{
+			uint8_t* grown = realloc(index, 2u * capacity * RECORDING_INDEX_ENTRY_SIZE);
+
+			if (NULL == grown)
+			{
+				free(sample);
+				free(index);
+				return -1;
+			}
+
+			index = grown;
+			capacity *= 2u;
+		}
+
+		putU64(index + count * RECORDING_INDEX_ENTRY_SIZE, sample->timestampNs);
+		putU64(index + count * RECORDING_INDEX_ENTRY_SIZE + 8u, offset);
+		++count;
+	}
+
+	free(sample);
+	self->index 		= index;
+	self->indexCount 	= count;
+	return 0;
+}
+
+
+RecordingSegment_t* RecordingSegment_open(const char* segmentPath)
+{
+	if (NULL == segmentPath)
+	{
+		goto error_exit_1;
+	}
+
+	RecordingSegment_t* self = calloc(1u, sizeof(RecordingSegment_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	self->data = mapFile(segmentPath, &self->dataLength);
+
+	if (NULL == self->data)
+	{
+		goto error_exit_2;
+	}
+
+	if (0 != Recording_decodeHeader(self->data, self->dataLength, &self->header))
+	{
+		goto error_exit_3;
+	}
+
+	// Index file name differs from segment file name by extension only
+	char indexPath[PATH_MAX];
+	const size_t pathLength = strlen(segmentPath);
+	const size_t extensionLength = strlen(RECORDING_SEGMENT_EXTENSION);
+
+	if ((pathLength > extensionLength) &&
+		(0 == strcmp(segmentPath + pathLength - extensionLength, RECORDING_SEGMENT_EXTENSION)) &&
+		(pathLength - extensionLength + strlen(RECORDING_INDEX_EXTENSION) < sizeof(indexPath)))
+	{
+		memcpy(indexPath, segmentPath, pathLength - extensionLength);
+		strcpy(indexPath + pathLength - extensionLength, RECORDING_INDEX_EXTENSION);
+		self->index = mapFile(indexPath, &self->indexMapLength);
+	}
+
+	if (NULL != self->index)
+	{
+		// Entries past the end of segment may come from writer interrupted between the two files
+		self->indexCount = self->indexMapLength / RECORDING_INDEX_ENTRY_SIZE;
+
+		while ((0u < self->indexCount) &&
+			(getU64(self->index + (self->indexCount - 1u) * RECORDING_INDEX_ENTRY_SIZE + 8u) >= self->dataLength))
+		{
+			--self->indexCount;
+		}
+	}
+	else if (0 != buildIndex(self))
+	{
+		goto error_exit_3;
+	}
+
+	return self;
+
+error_exit_3:
+	munmap((void*) self->data, self->dataLength);
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void RecordingSegment_close(RecordingSegment_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	if (0u != self->indexMapLength)
+	{
+		munmap((void*) self->index, self->indexMapLength);
+	}
+	else
+	{
+		free((void*) self->index);
+	}
+
+	munmap((void*) self->data, self->dataLength);
+	free(self);
+}
+
+
+const RecordingHeader_t* RecordingSegment_getHeader(const RecordingSegment_t* self)
+{
+	return (NULL != self) ? &self->header : NULL;
+}
+
+
+uint64_t RecordingSegment_toMonotonic(const RecordingSegment_t* self, uint64_t realTimeNs)
+{
+	if (NULL == self)
+	{
+		return 0u;
+	}
+
+	const RecordingHeader_t* header = &self->header;
+
+	if (realTimeNs >= header->startRealTimeNs)
+	{
+		const uint64_t after = realTimeNs - header->startRealTimeNs;
+		return (after < UINT64_MAX - header->startMonotonicNs) ? (header->startMonotonicNs + after) : UINT64_MAX;
+	}
+
+	const uint64_t before = header->startRealTimeNs - realTimeNs;
+	return (before < header->startMonotonicNs) ? (header->startMonotonicNs - before) : 0u;
+}
+
+
+uint64_t RecordingSegment_toRealTime(const RecordingSegment_t* self, uint64_t monotonicNs)
+{
+	if (NULL == self)
+	{
+		return 0u;
+	}
+
+	const RecordingHeader_t* header = &self->header;
+
+	if (monotonicNs >= header->startMonotonicNs)
+	{
+		const uint64_t after = monotonicNs - header->startMonotonicNs;
+		return (after < UINT64_MAX - header->startRealTimeNs) ? (header->startRealTimeNs + after) : UINT64_MAX;
+	}
+
+	const uint64_t before = header->startMonotonicNs - monotonicNs;
+	return (before < header->startRealTimeNs) ? (header->startRealTimeNs - before) : 0u;
+}
+
+
+size_t RecordingSegment_seek(const RecordingSegment_t* self, uint64_t monotonicNs)
+{
+	if ((NULL == self) || (0u == self->indexCount) ||
+		(getU64(self->index) > monotonicNs))
+	{
+		return RECORDING_HEADER_SIZE;
+	}
+
+	// Find last keyframe taken at or before given time
+	size_t low = 0u;
+	size_t high = self->indexCount;
+
+	while (high - low > 1u)
+	{
+		const size_t middle = low + (high - low) / 2u;
+
+		if (getU64(self->index + middle * RECORDING_INDEX_ENTRY_SIZE) <= monotonicNs)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return (size_t) getU64(self->index + low * RECORDING_INDEX_ENTRY_SIZE + 8u);
+}
+
+
+size_t RecordingSegment_next(const RecordingSegment_t* self, size_t offset, ProcStat_t* sample)
+{
+	if ((NULL == self) || (offset >= self->dataLength) || (offset < RECORDING_HEADER_SIZE))
+	{
+		return 0u;
+	}
+
+	const size_t consumed = decodeRecord(self->data + offset, self->dataLength - offset, sample, NULL);
+	return (0u != consumed) ? (offset + consumed) : 0u;
+}
+
+
+size_t RecordingSegment_nextSelected(const RecordingSegment_t* self, size_t offset, ProcStat_t* sample, const bool* selectedLines)
+{
+	if ((NULL == self) || (offset >= self->dataLength) || (offset < RECORDING_HEADER_SIZE))
+	{
+		return 0u;
+	}
+
+	const size_t consumed = decodeRecord(self->data + offset, self->dataLength - offset, sample, selectedLines);
+	return (0u != consumed) ? (offset + consumed) : 0u;
+}
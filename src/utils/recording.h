@@ -0,0 +1,243 @@
+/**
+ * \file recording.h
+ * Compact on-disk time-series recording of /proc/stat snapshots.
+ * \details Recording consists of append-only segment files named "<base>.<NNNNNN>.cutrec".
+ * Every segment starts with a fixed-size header (RECORDING_HEADER_SIZE bytes, little-endian):
+ *
+ * | Offset | Size | Field                                                        |
+ * |--------|------|--------------------------------------------------------------|
+ * | 0      | 8    | magic, RECORDING_MAGIC                                       |
+ * | 8      | 4    | format version, RECORDING_VERSION                            |
+ * | 12     | 4    | header size                                                  |
+ * | 16     | 4    | amount of "cpu(N)" lines per sample, including total "cpu"   |
+ * | 20     | 4    | amount of values per "cpu(N)" line                           |
+ * | 24     | 4    | keyframe interval, in samples                                |
+ * | 28     | 4    | reserved, zero                                               |
+ * | 32     | 8    | CLOCK_REALTIME at segment start, ns since Epoch              |
+ * | 40     | 8    | CLOCK_MONOTONIC at segment start, ns                         |
+ * | 48     | 8    | CLOCK_REALTIME of last sample, zero until segment is closed  |
+ * | 56     | 8    | amount of samples, zero until segment is closed              |
+ *
+ * Header is followed by records. Each record starts with a tag byte, followed by sample timestamp
+ * and counters encoded as variable-length integers:
+ * - RECORDING_TAG_KEYFRAME: CLOCK_MONOTONIC timestamp, then raw counter values.
+ * - RECORDING_TAG_DELTA: timestamp relative to previous sample, then zig-zag encoded differences
+ *   between counter values and their previous values.
+ * First record of every segment is a keyframe, so segments can be decoded independently.
+ *
+ * Every segment is accompanied by sparse time index "<base>.<NNNNNN>.cutidx", consisting of
+ * RECORDING_INDEX_ENTRY_SIZE-byte entries, one per keyframe: it's CLOCK_MONOTONIC timestamp (8 bytes)
+ * followed by it's offset in segment file (8 bytes), both little-endian. Index is optional,
+ * readers rebuild it by scanning the segment if it is missing.
+*/
+#ifndef RECORDING_H_INCLUDED
+#define RECORDING_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "procstat.h"
+
+
+/**
+ * Magic value opening every segment file.
+*/
+#define RECORDING_MAGIC "CUTREC\0"
+
+/**
+ * Version of recording format.
+*/
+#define RECORDING_VERSION 1u
+
+/**
+ * Size of segment header, in bytes.
+*/
+#define RECORDING_HEADER_SIZE 64u
+
+/**
+ * Extension of segment files.
+*/
+#define RECORDING_SEGMENT_EXTENSION ".cutrec"
+
+/**
+ * Extension of segment index files.
+*/
+#define RECORDING_INDEX_EXTENSION ".cutidx"
+
+/**
+ * Size of single segment index entry, in bytes.
+*/
+#define RECORDING_INDEX_ENTRY_SIZE 16u
+
+/**
+ * Tag of record holding absolute counter values.
+*/
+#define RECORDING_TAG_KEYFRAME 'K'
+
+/**
+ * Tag of record holding counter differences against previous record.
+*/
+#define RECORDING_TAG_DELTA 'D'
+
+
+/**
+ * Decoded segment header.
+*/
+typedef struct RecordingHeader
+{
+	/** Format version. */
+	uint32_t version;
+	/** Amount of "cpu(N)" lines per sample, including total "cpu" line. */
+	uint32_t cpuStatsLength;
+	/** Amount of values per "cpu(N)" line. */
+	uint32_t valuesPerCpu;
+	/** Keyframe interval, in samples. */
+	uint32_t keyframeInterval;
+	/** CLOCK_REALTIME at segment start, in nanoseconds since Epoch. */
+	uint64_t startRealTimeNs;
+	/** CLOCK_MONOTONIC at segment start, in nanoseconds. */
+	uint64_t startMonotonicNs;
+	/** CLOCK_REALTIME of last sample, in nanoseconds since Epoch. Zero if segment has not been closed. */
+	uint64_t endRealTimeNs;
+	/** Amount of samples in segment. Zero if segment has not been closed. */
+	uint64_t sampleCount;
+}
+RecordingHeader_t;
+
+
+/**
+ * Recording writer handle type, used in every operation on recording writer.
+*/
+typedef struct RecordingWriter RecordingWriter_t;
+
+
+/**
+ * Recording segment handle type, used to read single memory-mapped segment.
+*/
+typedef struct RecordingSegment RecordingSegment_t;
+
+
+/**
+ * \brief Creates recording writer and opens it's first segment.
+ * \param basePath Path prefix of segment files; sequence number and extension will be appended to it.
+ * \param cpuStatsLength Amount of "cpu(N)" lines in every recorded sample, including total "cpu" line.
+ * \param maxSegmentBytes Size after which current segment is closed and next one started.
+ * \param keyframeInterval Amount of samples between consecutive keyframes, at least 1.
+ * \return Pointer to newly created writer if successful, NULL otherwise.
+ * \warning Resulting writer has to be destroyed with RecordingWriter_destroy() once no longer needed.
+*/
+RecordingWriter_t* RecordingWriter_create(const char* basePath, size_t cpuStatsLength, size_t maxSegmentBytes, unsigned keyframeInterval);
+
+
+/**
+ * \brief Closes current segment, completing it's header, and destroys given writer.
+ * \param self Writer to be destroyed.
+*/
+void RecordingWriter_destroy(RecordingWriter_t* self);
+
+
+/**
+ * \brief Appends sample to recording, rolling over to new segment if current one has reached it's maximum size.
+ * Records are buffered, and written out along with every keyframe, when segment is rolled over, or once buffer fills.
+ * \param self Recording writer.
+ * \param procStat Sample to append. It's length has to match the one writer has been created with.
+ * \return 0 if successful, negative value otherwise.
+*/
+int RecordingWriter_append(RecordingWriter_t* self, const ProcStat_t* procStat);
+
+
+/**
+ * \brief Decodes segment header.
+ * \param data Segment data, at least RECORDING_HEADER_SIZE bytes long.
+ * \param dataLength Length of segment data, in bytes.
+ * \param header Structure to write decoded header into.
+ * \return 0 if successful, negative value if data does not start with valid header.
+*/
+int Recording_decodeHeader(const uint8_t* data, size_t dataLength, RecordingHeader_t* header);
+
+
+/**
+ * \brief Decodes single record, applying it onto given sample.
+ * \param data Encoded record, positioned at it's tag byte.
+ * \param dataLength Amount of bytes available in data buffer.
+ * \param sample Sample to apply record onto. Has to hold previously decoded sample for delta records
+ * and it's cpuStatsLength has to be set to value from segment header.
+ * \return Amount of bytes consumed, or 0 if record is truncated or malformed.
+*/
+size_t Recording_decodeRecord(const uint8_t* data, size_t dataLength, ProcStat_t* sample);
+
+
+/**
+ * \brief Maps recording segment and it's index into memory.
+ * \param segmentPath Path of segment file.
+ * \return Pointer to segment handle if successful, NULL otherwise.
+ * \warning Resulting handle has to be closed with RecordingSegment_close() once no longer needed.
+*/
+RecordingSegment_t* RecordingSegment_open(const char* segmentPath);
+
+
+/**
+ * \brief Unmaps recording segment and destroys it's handle.
+ * \param self Segment to be closed.
+*/
+void RecordingSegment_close(RecordingSegment_t* self);
+
+
+/**
+ * \brief Retrieves header of given segment.
+ * \param self Recording segment.
+ * \return Pointer to decoded segment header, valid until segment is closed.
+*/
+const RecordingHeader_t* RecordingSegment_getHeader(const RecordingSegment_t* self);
+
+
+/**
+ * \brief Converts CLOCK_REALTIME time point into CLOCK_MONOTONIC one, using clock readings from segment header.
+ * \param self Recording segment.
+ * \param realTimeNs Time point, in nanoseconds since Epoch.
+ * \return Corresponding CLOCK_MONOTONIC time point, in nanoseconds, 0 if self is NULL.
+*/
+uint64_t RecordingSegment_toMonotonic(const RecordingSegment_t* self, uint64_t realTimeNs);
+
+
+/**
+ * \brief Converts CLOCK_MONOTONIC time point into CLOCK_REALTIME one, using clock readings from segment header.
+ * \param self Recording segment.
+ * \param monotonicNs Time point on CLOCK_MONOTONIC, in nanoseconds.
+ * \return Corresponding time point, in nanoseconds since Epoch, 0 if self is NULL.
+*/
+uint64_t RecordingSegment_toRealTime(const RecordingSegment_t* self, uint64_t monotonicNs);
+
+
+/**
+ * \brief Finds keyframe decoding should start from to reach samples taken at given time.
+ * \param self Recording segment.
+ * \param monotonicNs Time point on CLOCK_MONOTONIC, in nanoseconds.
+ * \return Offset of last keyframe taken at or before given time, or of first record if there is none.
+*/
+size_t RecordingSegment_seek(const RecordingSegment_t* self, uint64_t monotonicNs);
+
+
+/**
+ * \brief Decodes record at given offset, applying it onto given sample.
+ * \param self Recording segment.
+ * \param offset Offset of record, as returned by RecordingSegment_seek() or previous call to this function.
+ * \param sample Sample to apply record onto, see Recording_decodeRecord().
+ * \return Offset of next record, or 0 if end of segment has been reached or record is malformed.
+*/
+size_t RecordingSegment_next(const RecordingSegment_t* self, size_t offset, ProcStat_t* sample);
+
+
+/**
+ * \brief Decodes record at given offset like RecordingSegment_next(), but only values of selected "cpu(N)" lines.
+ * Values of other lines are stepped over and left unchanged in the sample, which makes queries
+ * concerning few processors considerably faster.
+ * \param self Recording segment.
+ * \param offset Offset of record.
+ * \param sample Sample to apply record onto.
+ * \param selectedLines Array of sample->cpuStatsLength flags telling which lines to decode.
+ * \return Offset of next record, or 0 if end of segment has been reached or record is malformed.
+*/
+size_t RecordingSegment_nextSelected(const RecordingSegment_t* self, size_t offset, ProcStat_t* sample, const bool* selectedLines);
+
+
+#endif // !RECORDING_H_INCLUDED
@@ -0,0 +1,589 @@
+#define _XOPEN_SOURCE 700
+#include "recquery.h"
+#include "recording.h"
+#include "procstat.h"
+#include "cpuusage.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define RECQUERY_MAX_SEGMENTS 		65536u
+#define RECQUERY_TIME_FORMAT 		"%Y-%m-%dT%H:%M:%S"
+#define NANOSECONDS_IN_SECOND 		1000000000ull
+
+
+/**
+ * Recording segments opened for the query, ordered by sequence number.
+*/
+typedef struct SegmentList
+{
+	RecordingSegment_t** items;
+	size_t length;
+}
+SegmentList_t;
+
+
+/**
+ * Usage values collected for single selected processor.
+*/
+typedef struct UsageSeries
+{
+	PercentageValue_t* values;
+	size_t length;
+	size_t capacity;
+}
+UsageSeries_t;
+
+
+/**
+ * Lines selected by the query, and buffers shared by both kinds of it.
+*/
+typedef struct QueryState
+{
+	/** Indices of selected "cpu(N)" lines, in order of selection. */
+	size_t* cpus;
+	size_t cpusLength;
+	/** Flag of every line telling whether it has been selected, passed to RecordingSegment_nextSelected(). */
+	bool* selectedLines;
+	/** Samples decoded by the query, every one with values of selected lines only. */
+	ProcStat_t* samples[3];
+	/** Usage of selected lines, values of others are not calculated. */
+	CpuUsageInfo_t* usage;
+}
+QueryState_t;
+
+
+/**
+ * \brief Formats time point as local date and time.
+*/
+static const char* formatTime(uint64_t realTimeNs, char* buf, size_t bufSz)
+{
+	time_t t = (time_t) (realTimeNs / NANOSECONDS_IN_SECOND);
+	struct tm tm;
+
+	if ((NULL == localtime_r(&t, &tm)) || (0u == strftime(buf, bufSz, RECQUERY_TIME_FORMAT, &tm)))
+	{
+		snprintf(buf, bufSz, "%llu", (unsigned long long) t);
+	}
+
+	return buf;
+}
+
+
+/**
+ * \brief Opens segments given either directly or through recording path prefix.
+ * Segments not overlapping queried range are skipped without being kept open.
+ * \return 0 if successful, negative value otherwise.
+*/
+static int openSegments(SegmentList_t* list, const RecordingQuery_t* query, char* const paths[], size_t pathsLength)
+{
+	list->length = 0u;
+	list->items = calloc(RECQUERY_MAX_SEGMENTS, sizeof(RecordingSegment_t*));
+
+	if (NULL == list->items)
+	{
+		return -1;
+	}
+
+	const size_t extensionLength = strlen(RECORDING_SEGMENT_EXTENSION);
+
+	for (size_t ii = 0; ii < pathsLength; ++ii)
+	{
+		const size_t pathLength = strlen(paths[ii]);
+		const bool isSegment = (pathLength > extensionLength) &&
+			(0 == strcmp(paths[ii] + pathLength - extensionLength, RECORDING_SEGMENT_EXTENSION));
+
+		for (unsigned seq = 0u; list->length < RECQUERY_MAX_SEGMENTS; ++seq)
+		{
+			char path[4096];
+
+			if (isSegment)
+			{
+				snprintf(path, sizeof(path), "%s", paths[ii]);
+			}
+			else if ((size_t) snprintf(path, sizeof(path), "%s.%06u" RECORDING_SEGMENT_EXTENSION, paths[ii], seq) >= sizeof(path))
+			{
+				return -2;
+			}
+
+			RecordingSegment_t* segment = RecordingSegment_open(path);
+
+			if (NULL == segment)
+			{
+				if (isSegment || (0u == seq))
+				{
+					fprintf(stderr, "cannot open recording segment %s\n", path);
+					return -3;
+				}
+
+				break;
+			}
+
+			const RecordingHeader_t* header = RecordingSegment_getHeader(segment);
+			const bool overlaps = (header->startRealTimeNs <= query->untilNs) &&
+				((0u == header->endRealTimeNs) || (header->endRealTimeNs >= query->fromNs));
+
+			if (overlaps && (0u < list->length) &&
+				(header->cpuStatsLength != RecordingSegment_getHeader(list->items[0])->cpuStatsLength))
+			{
+				fprintf(stderr, "processor count of %s differs from previous segments\n", path);
+				RecordingSegment_close(segment);
+				return -4;
+			}
+
+			if (overlaps)
+			{
+				list->items[list->length++] = segment;
+			}
+			else
+			{
+				RecordingSegment_close(segment);
+			}
+
+			if (isSegment)
+			{
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+static void closeSegments(SegmentList_t* list)
+{
+	for (size_t ii = 0; ii < list->length; ++ii)
+	{
+		RecordingSegment_close(list->items[ii]);
+	}
+
+	free(list->items);
+}
+
+
+/**
+ * \brief Resolves selected processors into indices of "cpu(N)" lines.
+ * \return Amount of resolved indices, or 0 if any selected processor is not present in recording.
+*/
+static size_t resolveCpus(const RecordingQuery_t* query, size_t cpuStatsLength, size_t* indices)
+{
+	if (query->allCpus)
+	{
+		for (size_t ii = 0; ii < cpuStatsLength; ++ii)
+		{
+			indices[ii] = ii;
+		}
+
+		return cpuStatsLength;
+	}
+
+	if (0u == query->cpusLength)
+	{
+		indices[0] = 0u;
+		return 1u;
+	}
+
+	for (size_t ii = 0; ii < query->cpusLength; ++ii)
+	{
+		// Line 0 holds total, processor N is described by line N + 1
+		indices[ii] = (size_t) (query->cpus[ii] + 1);
+
+		if (indices[ii] >= cpuStatsLength)
+		{
+			fprintf(stderr, "processor %d is not present in recording\n", query->cpus[ii]);
+			return 0u;
+		}
+	}
+
+	return query->cpusLength;
+}
+
+
+static const char* cpuName(size_t index, char* buf, size_t bufSz)
+{
+	if (0u == index)
+	{
+		snprintf(buf, bufSz, "cpu");
+	}
+	else
+	{
+		snprintf(buf, bufSz, "cpu%zu", index - 1u);
+	}
+
+	return buf;
+}
+
+
+/**
+ * \brief Copies counters of selected lines between samples, values of others are never used.
+*/
+static void copySelected(const QueryState_t* state, ProcStat_t* to, const ProcStat_t* from)
+{
+	for (size_t ii = 0; ii < state->cpusLength; ++ii)
+	{
+		to->cpuStats[state->cpus[ii]] = from->cpuStats[state->cpus[ii]];
+	}
+
+	to->timestampNs = from->timestampNs;
+}
+
+
+/**
+ * \brief Finds most recent sample taken at or before given time, decoding only from the nearest keyframe.
+ * \param list Opened segments.
+ * \param state Selected lines, the only ones decoded.
+ * \param realTimeNs Time point, in nanoseconds since Epoch.
+ * \param out Sample to decode into. It's timestampNs is converted to CLOCK_REALTIME.
+ * \param scratch Sample records are applied onto.
+ * \return True if such sample exists, false otherwise.
+*/
+static bool findSample(const SegmentList_t* list, const QueryState_t* state, uint64_t realTimeNs, ProcStat_t* out, ProcStat_t* scratch)
+{
+	for (size_t ii = list->length; ii-- > 0u; )
+	{
+		const RecordingSegment_t* segment = list->items[ii];
+
+		if (RecordingSegment_getHeader(segment)->startRealTimeNs > realTimeNs)
+		{
+			continue;
+		}
+
+		const uint64_t target = RecordingSegment_toMonotonic(segment, realTimeNs);
+		bool found = false;
+		scratch->cpuStatsLength = out->cpuStatsLength;
+
+		for (size_t offset = RecordingSegment_seek(segment, target);
+			0u != (offset = RecordingSegment_nextSelected(segment, offset, scratch, state->selectedLines)) && (scratch->timestampNs <= target); )
+		{
+			copySelected(state, out, scratch);
+			out->timestampNs = RecordingSegment_toRealTime(segment, scratch->timestampNs);
+			found = true;
+		}
+
+		if (found)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * \brief Finds time of the most recent sample in given segment.
+ * \return Time of the sample, in nanoseconds since Epoch, or 0 if segment holds no samples.
+*/
+static uint64_t lastSampleTime(const RecordingSegment_t* segment, const QueryState_t* state, ProcStat_t* scratch)
+{
+	uint64_t result = 0u;
+
+	for (size_t offset = RecordingSegment_seek(segment, UINT64_MAX);
+		0u != (offset = RecordingSegment_nextSelected(segment, offset, scratch, state->selectedLines)); )
+	{
+		result = RecordingSegment_toRealTime(segment, scratch->timestampNs);
+	}
+
+	return result;
+}
+
+
+/**
+ * \brief Prints usage downsampled into buckets, each calculated from samples found at bucket boundaries.
+*/
+static int querySeries(const SegmentList_t* list, const RecordingQuery_t* query, QueryState_t* state, FILE* out)
+{
+	char buf[64];
+	ProcStat_t* scratch = state->samples[2];
+	CpuUsageInfo_t* usage = state->usage;
+
+	if (0u == RecordingSegment_nextSelected(list->items[0], RECORDING_HEADER_SIZE, scratch, state->selectedLines))
+	{
+		fprintf(stderr, "no recorded data in given range\n");
+		return -1;
+	}
+
+	const uint64_t firstTime = RecordingSegment_toRealTime(list->items[0], scratch->timestampNs);
+	const uint64_t from = (query->fromNs > firstTime) ? query->fromNs : firstTime;
+	const uint64_t lastTime = lastSampleTime(list->items[list->length - 1u], state, scratch);
+	const uint64_t until = (query->untilNs < lastTime) ? query->untilNs : lastTime;
+
+	fprintf(out, "%-20s", "time");
+
+	for (size_t ii = 0; ii < state->cpusLength; ++ii)
+	{
+		fprintf(out, "%9s", cpuName(state->cpus[ii], buf, sizeof(buf)));
+	}
+
+	fprintf(out, "\n");
+
+	ProcStat_t* begin = state->samples[0];
+	ProcStat_t* end = state->samples[1];
+	bool haveBegin = findSample(list, state, from, begin, scratch);
+
+	for (uint64_t bucket = from; bucket < until; bucket += query->stepNs)
+	{
+		const bool haveEnd = findSample(list, state, bucket + query->stepNs, end, scratch);
+
+		fprintf(out, "%-20s", formatTime(bucket, buf, sizeof(buf)));
+
+		if (haveBegin && haveEnd && (end->timestampNs > begin->timestampNs))
+		{
+			CpuUsageInfo_calculateSelected(begin, end, state->cpus, state->cpusLength, usage);
+		}
+		else
+		{
+			usage->valuesLength = 0u;
+		}
+
+		for (size_t ii = 0; ii < state->cpusLength; ++ii)
+		{
+			if ((state->cpus[ii] < usage->valuesLength) && (0.0 <= usage->values[state->cpus[ii]]))
+			{
+				fprintf(out, "%9.2f", usage->values[state->cpus[ii]]);
+			}
+			else
+			{
+				fprintf(out, "%9s", "-");
+			}
+		}
+
+		fprintf(out, "\n");
+
+		ProcStat_t* tmp = begin;
+		begin 		= end;
+		end 		= tmp;
+		haveBegin 	= haveEnd;
+
+		// Bucket boundary might wrap around at the very end of time range
+		if (bucket + query->stepNs < bucket)
+		{
+			break;
+		}
+	}
+
+	return 0;
+}
+
+
+static int compareValues(const void* a, const void* b)
+{
+	const PercentageValue_t lhs = *(const PercentageValue_t*) a;
+	const PercentageValue_t rhs = *(const PercentageValue_t*) b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+
+/**
+ * \brief Nearest-rank percentile of sorted values.
+*/
+static PercentageValue_t percentile(const UsageSeries_t* series, double pct)
+{
+	size_t rank = (size_t) ((pct / 100.0) * (double) series->length + 0.999999);
+	rank = (0u == rank) ? 1u : rank;
+	return series->values[rank - 1u];
+}
+
+
+/**
+ * \brief Prints aggregates of usage calculated between every pair of consecutive samples in range.
+*/
+static int queryAggregates(const SegmentList_t* list, const RecordingQuery_t* query, QueryState_t* state, FILE* out)
+{
+	int retval = 0;
+	const size_t cpusLength = state->cpusLength;
+	const size_t* cpus = state->cpus;
+	CpuUsageInfo_t* usage = state->usage;
+	UsageSeries_t* series = calloc(cpusLength, sizeof(UsageSeries_t));
+
+	if (NULL == series)
+	{
+		return -1;
+	}
+
+	ProcStat_t* current = state->samples[0];
+	ProcStat_t* previous = state->samples[1];
+	ProcStat_t* first = state->samples[2];
+	bool havePrevious = false;
+
+	for (size_t ii = 0; ii < list->length; ++ii)
+	{
+		const RecordingSegment_t* segment = list->items[ii];
+		const uint64_t fromMonotonic = RecordingSegment_toMonotonic(segment, query->fromNs);
+		const uint64_t untilMonotonic = RecordingSegment_toMonotonic(segment, query->untilNs);
+
+		for (size_t offset = RecordingSegment_seek(segment, fromMonotonic);
+			0u != (offset = RecordingSegment_nextSelected(segment, offset, current, state->selectedLines)) && (current->timestampNs <= untilMonotonic); )
+		{
+			if (current->timestampNs < fromMonotonic)
+			{
+				continue;
+			}
+
+			const uint64_t monotonicNs = current->timestampNs;
+			current->timestampNs = RecordingSegment_toRealTime(segment, monotonicNs);
+
+			if (havePrevious)
+			{
+				CpuUsageInfo_calculateSelected(previous, current, cpus, cpusLength, usage);
+
+				for (size_t jj = 0; jj < cpusLength; ++jj)
+				{
+					UsageSeries_t* s = &series[jj];
+
+					if (0.0 > usage->values[cpus[jj]])
+					{
+						continue;
+					}
+
+					if (s->length == s->capacity)
+					{
+						const size_t capacity = (0u == s->capacity) ? 1024u : 2u * s->capacity;
+						PercentageValue_t* grown = realloc(s->values, capacity * sizeof(PercentageValue_t));
+
+						if (NULL == grown)
+						{
+							retval = -2;
+							goto exit;
+						}
+
+						s->values = grown;
+						s->capacity = capacity;
+					}
+
+					s->values[s->length++] = usage->values[cpus[jj]];
+				}
+			}
+			else
+			{
+				copySelected(state, first, current);
+			}
+
+			copySelected(state, previous, current);
+			havePrevious = true;
+
+			// Deltas are applied onto decoded sample, which has to keep it's original timestamp
+			current->timestampNs = monotonicNs;
+		}
+	}
+
+	char buf[64];
+	fprintf(out, "%-8s %10s %8s %8s %8s %8s %8s %8s\n", "cpu", "samples", "min", "mean", "p50", "p90", "p99", "max");
+
+	// Mean is calculated over whole range rather than averaged, so that uneven intervals are weighted correctly
+	if (havePrevious && (previous->timestampNs > first->timestampNs))
+	{
+		CpuUsageInfo_calculateSelected(first, previous, cpus, cpusLength, usage);
+	}
+	else
+	{
+		usage->valuesLength = 0u;
+	}
+
+	for (size_t ii = 0; ii < cpusLength; ++ii)
+	{
+		UsageSeries_t* s = &series[ii];
+		fprintf(out, "%-8s %10zu", cpuName(cpus[ii], buf, sizeof(buf)), s->length);
+
+		if (0u == s->length)
+		{
+			fprintf(out, " %8s %8s %8s %8s %8s %8s\n", "-", "-", "-", "-", "-", "-");
+			continue;
+		}
+
+		qsort(s->values, s->length, sizeof(PercentageValue_t), compareValues);
+		fprintf(out, " %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+			s->values[0],
+			(cpus[ii] < usage->valuesLength) ? usage->values[cpus[ii]] : 0.0,
+			percentile(s, 50.0),
+			percentile(s, 90.0),
+			percentile(s, 99.0),
+			s->values[s->length - 1u]);
+	}
+
+exit:
+	for (size_t ii = 0; ii < cpusLength; ++ii)
+	{
+		free(series[ii].values);
+	}
+
+	free(series);
+	return retval;
+}
+
+
+int RecordingQuery_run(const RecordingQuery_t* query, char* const paths[], size_t pathsLength, FILE* out)
+{
+	if ((NULL == query) || (NULL == paths) || (NULL == out) || (query->fromNs > query->untilNs) ||
+		(query->cpusLength > RECQUERY_MAX_SELECTED_CPUS))
+	{
+		return -1;
+	}
+
+	int retval = -2;
+	SegmentList_t list;
+
+	if (0 != openSegments(&list, query, paths, pathsLength))
+	{
+		goto exit_1;
+	}
+
+	if (0u == list.length)
+	{
+		fprintf(stderr, "no recorded data in given range\n");
+		goto exit_1;
+	}
+
+	const size_t cpuStatsLength = RecordingSegment_getHeader(list.items[0])->cpuStatsLength;
+	const size_t sampleSize = sizeof(ProcStat_t) + cpuStatsLength * sizeof(CpuStat_t);
+	QueryState_t state =
+	{
+		.cpus 			= malloc(((cpuStatsLength > RECQUERY_MAX_SELECTED_CPUS) ? cpuStatsLength : RECQUERY_MAX_SELECTED_CPUS) * sizeof(size_t)),
+		.selectedLines 	= calloc(cpuStatsLength, sizeof(bool)),
+		.samples 		= { calloc(1u, sampleSize), calloc(1u, sampleSize), calloc(1u, sampleSize) },
+		.usage 			= malloc(sizeof(CpuUsageInfo_t) + cpuStatsLength * sizeof(PercentageValue_t))
+	};
+
+	if ((NULL == state.cpus) || (NULL == state.selectedLines) || (NULL == state.usage) ||
+		(NULL == state.samples[0]) || (NULL == state.samples[1]) || (NULL == state.samples[2]))
+	{
+		fprintf(stderr, "cannot allocate memory\n");
+		goto exit_2;
+	}
+
+	for (size_t ii = 0; ii < 3u; ++ii)
+	{
+		state.samples[ii]->cpuStatsLength = cpuStatsLength;
+	}
+
+	state.cpusLength = resolveCpus(query, cpuStatsLength, state.cpus);
+
+	if (0u == state.cpusLength)
+	{
+		goto exit_2;
+	}
+
+	for (size_t ii = 0; ii < state.cpusLength; ++ii)
+	{
+		state.selectedLines[state.cpus[ii]] = true;
+	}
+
+	const int result = (0u != query->stepNs)
+		? querySeries(&list, query, &state, out)
+		: queryAggregates(&list, query, &state, out);
+
+	retval = (0 == result) ? 0 : -3;
+
+exit_2:
+	free(state.usage);
+	free(state.samples[2]);
+	free(state.samples[1]);
+	free(state.samples[0]);
+	free(state.selectedLines);
+	free(state.cpus);
+exit_1:
+	closeSegments(&list);
+	return retval;
+}
@@ -0,0 +1,59 @@
+/**
+ * \file recquery.h
+ * Offline queries of recordings written by RecordingWriter_t: usage of selected processors over a time range,
+ * either downsampled into series or aggregated, decoding only segments and lines the query needs.
+*/
+#ifndef RECQUERY_H_INCLUDED
+#define RECQUERY_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+
+/**
+ * Maximum amount of processors selected one by one.
+*/
+#define RECQUERY_MAX_SELECTED_CPUS 256u
+
+/**
+ * Processor number selecting total "cpu" line.
+*/
+#define RECQUERY_SELECT_TOTAL -1
+
+
+/**
+ * Query parameters.
+*/
+typedef struct RecordingQuery
+{
+	/** Beginning of queried range, in nanoseconds since Epoch. */
+	uint64_t fromNs;
+	/** End of queried range, in nanoseconds since Epoch. */
+	uint64_t untilNs;
+	/** Length of downsampling step, in nanoseconds. Zero requests aggregates instead of series. */
+	uint64_t stepNs;
+	/** Whether every processor has been selected. */
+	bool allCpus;
+	/** Selected processors, RECQUERY_SELECT_TOTAL denoting total "cpu" line. */
+	int cpus[RECQUERY_MAX_SELECTED_CPUS];
+	/** Amount of selected processors. */
+	size_t cpusLength;
+}
+RecordingQuery_t;
+
+
+/**
+ * \brief Runs query over recording, printing usage of selected processors downsampled into buckets if step is given,
+ * or their minimum, mean, percentiles and maximum otherwise. Usage is only calculated for selected processors.
+ * Total "cpu" line is selected if no processor is. Errors are printed to standard error stream.
+ * \param query Query parameters.
+ * \param paths Segment files, or path prefixes given to RecordingWriter_create(), consecutive segments of which are queried.
+ * \param pathsLength Amount of paths.
+ * \param out Stream to print results into.
+ * \return 0 if successful, negative value otherwise.
+*/
+int RecordingQuery_run(const RecordingQuery_t* query, char* const paths[], size_t pathsLength, FILE* out);
+
+
+#endif // !RECQUERY_H_INCLUDED
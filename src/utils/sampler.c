@@ -0,0 +1,216 @@
+#include "sampler.h"
+#include "helpers.h"
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+
+
+#define NANOSECONDS_IN_MILLISECOND 	1000000ull
+#define NANOSECONDS_IN_SECOND 		1000000000ull
+
+
+/**
+ * \brief Converts amount of nanoseconds into time value represented as struct timespec.
+ * \param ns Amount of nanoseconds to convert.
+ * \return Time value representing given amount of nanoseconds.
+*/
+static struct timespec nsToTimespec(unsigned long long ns)
+{
+	struct timespec result =
+	{
+		.tv_sec 	= ns / NANOSECONDS_IN_SECOND,
+		.tv_nsec 	= ns % NANOSECONDS_IN_SECOND
+	};
+
+	return result;
+}
+
+
+/**
+ * \brief Sleeps until given point in time on CLOCK_MONOTONIC, resuming after interrupts.
+ * \param wakeNs Point in time to wake up at, in nanoseconds.
+ * \return 0 if successful, error number otherwise.
+*/
+static int sleepUntilNs(unsigned long long wakeNs)
+{
+	const struct timespec wakeTime = nsToTimespec(wakeNs);
+	int result;
+
+	do
+	{
+		result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL);
+	}
+	while (EINTR == result);
+
+	return result;
+}
+
+
+bool SamplerClock_isValidPeriod(unsigned periodMs)
+{
+	return (periodMs >= SAMPLER_MIN_PERIOD_MS) && (periodMs <= SAMPLER_MAX_PERIOD_MS);
+}
+
+
+int SamplerClock_init(SamplerClock_t* self, unsigned periodMs, bool alignToWallClock)
+{
+	if (NULL == self)
+	{
+		return -1;
+	}
+
+	if (!SamplerClock_isValidPeriod(periodMs))
+	{
+		return -2;
+	}
+
+	self->periodNs 		= periodMs * NANOSECONDS_IN_MILLISECOND;
+	self->stats 		= (SamplerStats_t) { 0 };
+	self->deadlineNs 	= MonotonicTimeNs();
+
+	if (alignToWallClock)
+	{
+		// Monotonic clock cannot be aligned directly, shift first deadline by distance to next wall-clock boundary
+		const unsigned long long sinceBoundaryNs = RealTimeNs() % self->periodNs;
+		self->deadlineNs += self->periodNs - sinceBoundaryNs;
+	}
+
+	return 0;
+}
+
+
+int SamplerClock_wait(SamplerClock_t* self, unsigned maxSliceMs)
+{
+	if (NULL == self)
+	{
+		return -1;
+	}
+
+	unsigned long long nowNs = MonotonicTimeNs();
+
+	// Skip every deadline that has already passed apart from the most recent one
+	if (nowNs >= self->deadlineNs + self->periodNs)
+	{
+		const unsigned long long missed = (nowNs - self->deadlineNs) / self->periodNs;
+		self->deadlineNs += missed * self->periodNs;
+		self->stats.missedDeadlines += missed;
+	}
+
+	if (nowNs < self->deadlineNs)
+	{
+		const unsigned long long sliceEndNs = nowNs + maxSliceMs * NANOSECONDS_IN_MILLISECOND;
+		const bool sliceOnly = sliceEndNs < self->deadlineNs;
+
+		if (0 != sleepUntilNs(sliceOnly ? sliceEndNs : self->deadlineNs))
+		{
+			return -2;
+		}
+
+		if (sliceOnly)
+		{
+			return 0;
+		}
+
+		nowNs = MonotonicTimeNs();
+	}
+
+	const unsigned long long jitterNs = nowNs - self->deadlineNs;
+	self->stats.lastJitterNs 	= jitterNs;
+	self->stats.totalJitterNs 	+= jitterNs;
+	self->stats.maxJitterNs 	= (jitterNs > self->stats.maxJitterNs) ? jitterNs : self->stats.maxJitterNs;
+	++self->stats.ticks;
+
+	self->deadlineNs += self->periodNs;
+	return 1;
+}
+
+
+int SamplerClock_setPeriod(SamplerClock_t* self, unsigned periodMs)
+{
+	if (NULL == self)
+	{
+		return -1;
+	}
+
+	if (!SamplerClock_isValidPeriod(periodMs))
+	{
+		return -2;
+	}
+
+	// Deadline is always one period past the most recent tick, rebase it onto the new period
+	const unsigned long long periodNs = periodMs * NANOSECONDS_IN_MILLISECOND;
+	self->deadlineNs = self->deadlineNs - self->periodNs + periodNs;
+	self->periodNs = periodNs;
+	return 0;
+}
+
+
+unsigned SamplerClock_getPeriod(const SamplerClock_t* self)
+{
+	if (NULL == self)
+	{
+		return 0u;
+	}
+
+	return (unsigned) (self->periodNs / NANOSECONDS_IN_MILLISECOND);
+}
+
+
+int SamplerClock_adapt(SamplerClock_t* self, const SamplerAdaptiveParams_t* params, double changePct)
+{
+	if ((NULL == self) || (NULL == params))
+	{
+		return -1;
+	}
+
+	const unsigned currentMs = SamplerClock_getPeriod(self);
+	unsigned newMs;
+
+	if (changePct > params->thresholdPct)
+	{
+		newMs = params->floorMs;
+	}
+	else
+	{
+		newMs = (currentMs > params->ceilingMs / 2u) ? params->ceilingMs : currentMs * 2u;
+	}
+
+	if (newMs == currentMs)
+	{
+		return 0;
+	}
+
+	return SamplerClock_setPeriod(self, newMs);
+}
+
+
+const SamplerStats_t* SamplerClock_getStats(const SamplerClock_t* self)
+{
+	if (NULL == self)
+	{
+		return NULL;
+	}
+
+	return &self->stats;
+}
+
+
+int SamplerClock_waitUntil(unsigned long long deadlineNs, unsigned maxSliceMs)
+{
+	const unsigned long long nowNs = MonotonicTimeNs();
+
+	if (nowNs >= deadlineNs)
+	{
+		return 1;
+	}
+
+	const unsigned long long sliceEndNs = nowNs + maxSliceMs * NANOSECONDS_IN_MILLISECOND;
+	const bool sliceOnly = sliceEndNs < deadlineNs;
+
+	if (0 != sleepUntilNs(sliceOnly ? sliceEndNs : deadlineNs))
+	{
+		return -1;
+	}
+
+	return sliceOnly ? 0 : 1;
+}
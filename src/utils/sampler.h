@@ -0,0 +1,160 @@
+/**
+ * \file sampler.h
+ * Absolute-deadline sampling clock. Deadlines are kept on CLOCK_MONOTONIC and advanced
+ * by a fixed period, so time spent on reading, parsing and waiting for locks does not
+ * accumulate into drift.
+*/
+#ifndef SAMPLER_H_INCLUDED
+#define SAMPLER_H_INCLUDED
+#include <stdbool.h>
+
+
+/**
+ * Shortest sampling period accepted by the sampling clock, in milliseconds.
+*/
+#define SAMPLER_MIN_PERIOD_MS 10u
+
+/**
+ * Longest sampling period accepted by the sampling clock, in milliseconds.
+*/
+#define SAMPLER_MAX_PERIOD_MS 60000u
+
+
+/**
+ * Parameters of adaptive sampling mode.
+*/
+typedef struct SamplerAdaptiveParams
+{
+	/** Shortest period the clock can tighten to, in milliseconds. */
+	unsigned floorMs;
+
+	/** Longest period the clock can back off to, in milliseconds. */
+	unsigned ceilingMs;
+
+	/** Change of total usage between consecutive samples, in percentage points,
+	 * above which sampling interval is tightened. */
+	double thresholdPct;
+}
+SamplerAdaptiveParams_t;
+
+
+/**
+ * Sampling clock statistics.
+*/
+typedef struct SamplerStats
+{
+	/** Amount of deadlines reached so far. */
+	unsigned long long ticks;
+
+	/** Amount of deadlines skipped because previous iteration took longer than a whole period. */
+	unsigned long long missedDeadlines;
+
+	/** Difference between actual wakeup time and the deadline of the most recent tick, in nanoseconds. */
+	unsigned long long lastJitterNs;
+
+	/** Highest jitter observed so far, in nanoseconds. */
+	unsigned long long maxJitterNs;
+
+	/** Sum of jitter of every tick, in nanoseconds. Used to compute the mean. */
+	unsigned long long totalJitterNs;
+}
+SamplerStats_t;
+
+
+/**
+ * Sampling clock state. Should be treated as opaque and only accessed through SamplerClock_* functions.
+*/
+typedef struct SamplerClock
+{
+	/** Sampling period, in nanoseconds. */
+	unsigned long long periodNs;
+
+	/** Next deadline on CLOCK_MONOTONIC, in nanoseconds. */
+	unsigned long long deadlineNs;
+
+	/** Statistics gathered so far. */
+	SamplerStats_t stats;
+}
+SamplerClock_t;
+
+
+/**
+ * \brief Tests whether given period can be used with sampling clock.
+ * \param periodMs Sampling period, in milliseconds.
+ * \return True if period lies within [SAMPLER_MIN_PERIOD_MS, SAMPLER_MAX_PERIOD_MS] range, false otherwise.
+*/
+bool SamplerClock_isValidPeriod(unsigned periodMs);
+
+
+/**
+ * \brief Initializes sampling clock. First deadline is due immediately, unless wall-clock alignment is requested.
+ * \param self Sampling clock to initialize.
+ * \param periodMs Sampling period, in milliseconds. Has to satisfy SamplerClock_isValidPeriod().
+ * \param alignToWallClock If true, deadlines will fall on multiples of the period in real (wall-clock) time,
+ * so that samples taken on different hosts line up.
+ * \return 0 if successful, negative value otherwise.
+*/
+int SamplerClock_init(SamplerClock_t* self, unsigned periodMs, bool alignToWallClock);
+
+
+/**
+ * \brief Blocks calling thread until next deadline, but no longer than given amount of time.
+ * Sleeping is split into slices so that callers can report activity and check kill switch in between.
+ * Once the deadline is reached, the next one is scheduled exactly one period later.
+ * If one or more deadlines have already passed, they are counted as missed and skipped.
+ * \param self Sampling clock.
+ * \param maxSliceMs Maximum amount of time to sleep during this call, in milliseconds.
+ * \return 1 if deadline has been reached, 0 if slice has elapsed before the deadline, negative value in case of error.
+*/
+int SamplerClock_wait(SamplerClock_t* self, unsigned maxSliceMs);
+
+
+/**
+ * \brief Changes sampling period. The change applies to the deadline following the most recent tick,
+ * so it takes effect immediately rather than after currently scheduled deadline.
+ * \param self Sampling clock.
+ * \param periodMs New sampling period, in milliseconds. Has to satisfy SamplerClock_isValidPeriod().
+ * \return 0 if successful, negative value otherwise.
+*/
+int SamplerClock_setPeriod(SamplerClock_t* self, unsigned periodMs);
+
+
+/**
+ * \brief Retrieves current sampling period.
+ * \param self Sampling clock.
+ * \return Sampling period, in milliseconds.
+*/
+unsigned SamplerClock_getPeriod(const SamplerClock_t* self);
+
+
+/**
+ * \brief Adjusts sampling period according to observed change of load.
+ * If the change exceeds threshold, period drops to the floor straight away so that bursts are captured.
+ * Otherwise, period is doubled up to the ceiling, backing off exponentially while load is stable.
+ * \param self Sampling clock.
+ * \param params Adaptive mode parameters.
+ * \param changePct Change of usage since previous sample, in percentage points.
+ * \return 0 if successful, negative value otherwise.
+*/
+int SamplerClock_adapt(SamplerClock_t* self, const SamplerAdaptiveParams_t* params, double changePct);
+
+
+/**
+ * \brief Sleeps until given deadline, independently of any sampling clock, for at most maxSliceMs at once.
+ * Used where deadlines are dictated from outside, e.g. by timestamps of replayed samples.
+ * \param deadlineNs Deadline on CLOCK_MONOTONIC, in nanoseconds.
+ * \param maxSliceMs Longest time to sleep in a single call, in milliseconds.
+ * \return 1 if deadline has been reached, 0 if only a slice has elapsed, negative value on error.
+*/
+int SamplerClock_waitUntil(unsigned long long deadlineNs, unsigned maxSliceMs);
+
+
+/**
+ * \brief Retrieves statistics of given sampling clock.
+ * \param self Sampling clock.
+ * \return Pointer to statistics structure, valid as long as the clock itself.
+*/
+const SamplerStats_t* SamplerClock_getStats(const SamplerClock_t* self);
+
+
+#endif // !SAMPLER_H_INCLUDED
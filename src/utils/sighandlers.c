@@ -1,5 +1,6 @@
 #include "sighandlers.h"
 #include "threadctl.h"
+#include "flightrec.h"
 #include <signal.h>
 #include <unistd.h>
 #include <string.h>
@@ -28,6 +29,17 @@ static void sigtermHandler(int signum)
 }
 
 
+/**
+ * \brief Signal handler for SIGUSR2. Requests flight recorder dump.
+ * \param signum Ignored.
+*/
+static void sigusr2Handler(int signum)
+{
+	(void) signum;
+	FlightRecorder_trigger(FREC_TRIGGER_SIGNAL);
+}
+
+
 /**
  * \brief Registers handler function for various signals.
  * \param signum Signal to associate the handler with, eg. SIGINT.
@@ -52,4 +64,10 @@ void RegisterSigintHandler()
 void RegisterSigtermHandler()
 {
 	registerHandler(SIGTERM, sigtermHandler);
+}
+
+
+void RegisterSigusr2Handler()
+{
+	registerHandler(SIGUSR2, sigusr2Handler);
 }
\ No newline at end of file
@@ -18,4 +18,10 @@ void RegisterSigintHandler(void);
 void RegisterSigtermHandler(void);
 
 
+/**
+ * \brief Registers handler for SIGUSR2 signal.
+*/
+void RegisterSigusr2Handler(void);
+
+
 #endif // !SIGHANDLERS_H_INCLUDED
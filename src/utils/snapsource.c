@@ -0,0 +1,314 @@
+#include "snapsource.h"
+#include "recording.h"
+#include "cpufreq.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+
+struct SnapshotSource
+{
+	/** Pacing of produced snapshots. */
+	SnapshotPacing_t 	pacing;
+	/** Amount of "cpu(N)" lines in every snapshot, 0 if not known in advance. */
+	size_t 				cpuStatsLength;
+	/** Produces next snapshot, see SnapshotSource_next(). */
+	int 				(*next)(SnapshotSource_t* self, ProcStat_t* out);
+
+	/** Live only: descriptors of processor pressure and load average files, kept open, negative if unavailable. */
+	int 				pressureFd;
+	int 				loadAvgFd;
+	/** Live only: directory frequencies are read from, empty if they are not sampled. */
+	char 				sysRoot[PATH_MAX];
+	/** Live only: sampler of processor frequencies, NULL if not created yet or unavailable. */
+	CpuFreqSampler_t* 	freq;
+	/** Live only: whether creation of frequency sampler has been attempted. */
+	bool 				freqProbed;
+
+	/** Replay only: path of single segment, or recording path prefix. */
+	char 				path[PATH_MAX];
+	/** Replay only: whether path refers to single segment. */
+	bool 				singleSegment;
+	/** Replay only: sequence number of currently mapped segment. */
+	unsigned 			segmentSeq;
+	/** Replay only: currently mapped segment, NULL once recording has been exhausted. */
+	RecordingSegment_t* segment;
+	/** Replay only: offset of next record in currently mapped segment. */
+	size_t 				offset;
+	/** Replay only: most recently decoded snapshot, base for following delta records. */
+	ProcStat_t* 		sample;
+};
+
+
+/**
+ * \brief Creates frequency sampler on first call, once processors tracked are settled.
+*/
+static void liveProbeFreqs(SnapshotSource_t* self)
+{
+	if (!self->freqProbed && ('\0' != self->sysRoot[0]))
+	{
+		self->freqProbed = true;
+		self->freq = CpuFreqSampler_create(self->sysRoot);
+	}
+}
+
+
+static int liveNext(SnapshotSource_t* self, ProcStat_t* out)
+{
+	if (!ProcStat_read(out))
+	{
+		return -1;
+	}
+
+	// Files missing on older kernels, or without CONFIG_PSI, leave their part of snapshot unsampled
+	if (0 <= self->pressureFd)
+	{
+		SchedStat_readPressure(self->pressureFd, &out->sched);
+	}
+
+	if (0 <= self->loadAvgFd)
+	{
+		SchedStat_readLoadAvg(self->loadAvgFd, &out->sched);
+	}
+
+	// Processors tracked are only settled by the time the first snapshot is taken
+	liveProbeFreqs(self);
+
+	if ((NULL != self->freq) && CpuFreqSampler_read(self->freq, ProcStat_getFreqs(out)))
+	{
+		out->freqsLength = out->cpuStatsLength;
+	}
+
+	return 1;
+}
+
+
+/**
+ * \brief Maps segment of given sequence number, unmapping previous one.
+ * \param self Replay source.
+ * \param seq Sequence number of segment, ignored for single-segment replay.
+ * \return 1 if segment has been mapped, 0 if it does not exist, negative value on error.
+*/
+static int replayOpenSegment(SnapshotSource_t* self, unsigned seq)
+{
+	char path[PATH_MAX];
+
+	RecordingSegment_close(self->segment);
+	self->segment = NULL;
+
+	if (self->singleSegment)
+	{
+		if (0u != seq)
+		{
+			return 0;
+		}
+
+		strcpy(path, self->path);
+	}
+	else if ((size_t) snprintf(path, sizeof(path), "%s.%06u" RECORDING_SEGMENT_EXTENSION, self->path, seq) >= sizeof(path))
+	{
+		return -1;
+	}
+
+	self->segment = RecordingSegment_open(path);
+
+	if (NULL == self->segment)
+	{
+		// Missing segment marks the end of recording, apart from the first one
+		if (0u == seq)
+		{
+			Log(LLEVEL_ERROR, "cannot open recording segment %s", path);
+			return -2;
+		}
+
+		return 0;
+	}
+
+	const size_t cpuStatsLength = RecordingSegment_getHeader(self->segment)->cpuStatsLength;
+
+	if ((0u != self->cpuStatsLength) && (cpuStatsLength != self->cpuStatsLength))
+	{
+		Log(LLEVEL_ERROR, "processor count of segment %s differs from previous segments", path);
+		RecordingSegment_close(self->segment);
+		self->segment = NULL;
+		return -3;
+	}
+
+	Log(LLEVEL_INFO, "replaying recording segment %s", path);
+	self->cpuStatsLength 	= cpuStatsLength;
+	self->segmentSeq 		= seq;
+	self->offset 			= RECORDING_HEADER_SIZE;
+	return 1;
+}
+
+
+static int replayNext(SnapshotSource_t* self, ProcStat_t* out)
+{
+	while (NULL != self->segment)
+	{
+		const size_t next = RecordingSegment_next(self->segment, self->offset, self->sample);
+
+		if (0u != next)
+		{
+			self->offset = next;
+			out->cpuStatsLength = self->sample->cpuStatsLength;
+			out->timestampNs = self->sample->timestampNs;
+			out->onlineEpoch = 0u;
+			memset(&out->sched, 0, sizeof(out->sched));
+			out->freqsLength = 0u;
+			memcpy(out->cpuStats, self->sample->cpuStats, self->sample->cpuStatsLength * sizeof(CpuStat_t));
+			return 1;
+		}
+
+		// Every segment starts with a keyframe, so decoded sample carries over without resetting
+		const int result = replayOpenSegment(self, self->segmentSeq + 1u);
+
+		if (0 > result)
+		{
+			return result;
+		}
+	}
+
+	return 0;
+}
+
+
+SnapshotSource_t* SnapshotSource_createLive(const char* sysRoot)
+{
+	if ((NULL != sysRoot) && (strlen(sysRoot) >= PATH_MAX))
+	{
+		Log(LLEVEL_ERROR, "invalid argument provided: sysRoot");
+		return NULL;
+	}
+
+	SnapshotSource_t* self = calloc(1u, sizeof(SnapshotSource_t));
+
+	if (NULL == self)
+	{
+		return NULL;
+	}
+
+	if (NULL != sysRoot)
+	{
+		strcpy(self->sysRoot, sysRoot);
+	}
+
+	self->pacing 		= SNAPSHOT_PACING_CLOCK;
+	self->next 			= liveNext;
+	self->pressureFd 	= ProcStat_openSibling("pressure/cpu");
+	self->loadAvgFd 	= ProcStat_openSibling("loadavg");
+	return self;
+}
+
+
+SnapshotSource_t* SnapshotSource_createReplay(const char* recordingPath, bool asFastAsPossible)
+{
+	if ((NULL == recordingPath) || (strlen(recordingPath) >= PATH_MAX))
+	{
+		Log(LLEVEL_ERROR, "invalid argument provided: recordingPath");
+		goto error_exit_1;
+	}
+
+	SnapshotSource_t* self = calloc(1u, sizeof(SnapshotSource_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	const size_t pathLength = strlen(recordingPath);
+	const size_t extensionLength = strlen(RECORDING_SEGMENT_EXTENSION);
+
+	strcpy(self->path, recordingPath);
+	self->singleSegment = (pathLength > extensionLength) &&
+		(0 == strcmp(recordingPath + pathLength - extensionLength, RECORDING_SEGMENT_EXTENSION));
+	self->pacing 		= asFastAsPossible ? SNAPSHOT_PACING_NONE : SNAPSHOT_PACING_RECORDED;
+	self->next 			= replayNext;
+	self->pressureFd 	= -1;
+	self->loadAvgFd 	= -1;
+
+	if (1 != replayOpenSegment(self, 0u))
+	{
+		goto error_exit_2;
+	}
+
+	self->sample = malloc(sizeof(ProcStat_t) + self->cpuStatsLength * sizeof(CpuStat_t));
+
+	if (NULL == self->sample)
+	{
+		goto error_exit_3;
+	}
+
+	self->sample->cpuStatsLength 	= self->cpuStatsLength;
+	self->sample->timestampNs 		= 0u;
+	return self;
+
+error_exit_3:
+	RecordingSegment_close(self->segment);
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void SnapshotSource_destroy(SnapshotSource_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	if (0 <= self->pressureFd)
+	{
+		close(self->pressureFd);
+	}
+
+	if (0 <= self->loadAvgFd)
+	{
+		close(self->loadAvgFd);
+	}
+
+	CpuFreqSampler_destroy(self->freq);
+	RecordingSegment_close(self->segment);
+	free(self->sample);
+	free(self);
+}
+
+
+SnapshotPacing_t SnapshotSource_getPacing(const SnapshotSource_t* self)
+{
+	return (NULL != self) ? self->pacing : SNAPSHOT_PACING_CLOCK;
+}
+
+
+size_t SnapshotSource_getCpuStatsLength(const SnapshotSource_t* self)
+{
+	return (NULL != self) ? self->cpuStatsLength : 0u;
+}
+
+
+bool SnapshotSource_hasFreqs(SnapshotSource_t* self)
+{
+	if (NULL == self)
+	{
+		return false;
+	}
+
+	liveProbeFreqs(self);
+	return NULL != self->freq;
+}
+
+
+int SnapshotSource_next(SnapshotSource_t* self, ProcStat_t* out)
+{
+	if ((NULL == self) || (NULL == out))
+	{
+		return -1;
+	}
+
+	return self->next(self, out);
+}
@@ -0,0 +1,101 @@
+/**
+ * \file snapsource.h
+ * Sources of /proc/stat snapshots consumed by reader thread. Live source reads /proc/stat of this system,
+ * replay source streams snapshots decoded from recording segments written by RecordingWriter_t.
+*/
+#ifndef SNAPSOURCE_H_INCLUDED
+#define SNAPSOURCE_H_INCLUDED
+#include <stddef.h>
+#include <stdbool.h>
+#include "procstat.h"
+
+
+/**
+ * Ways in which consumer of snapshot source should pace requests for consecutive snapshots.
+*/
+typedef enum SnapshotPacing
+{
+	/** Snapshots are taken on request, consumer decides when, e.g. using sampling clock. */
+	SNAPSHOT_PACING_CLOCK = 0,
+
+	/** Snapshots should be delivered at intervals given by differences between their timestamps. */
+	SNAPSHOT_PACING_RECORDED,
+
+	/** Snapshots should be delivered as fast as consumer can handle them. */
+	SNAPSHOT_PACING_NONE
+}
+SnapshotPacing_t;
+
+
+/**
+ * Snapshot source handle type, used in every operation on snapshot sources.
+*/
+typedef struct SnapshotSource SnapshotSource_t;
+
+
+/**
+ * \brief Creates snapshot source reading /proc/stat file of this system, along with processor pressure
+ * and load averages, from files kept open. Files are looked for in directory set with ProcStat_setProcRoot().
+ * Processor frequencies are sampled as well, by CpuFreqSampler_t created along with the first snapshot,
+ * once tracked processors are known, and are left unsampled if no processor has cpufreq directory.
+ * \param sysRoot Directory containing "cpu" sysfs directory frequencies are read from, NULL to not sample them.
+ * \return Pointer to newly created source if successful, NULL otherwise.
+ * \warning Resulting source has to be destroyed with SnapshotSource_destroy() once no longer needed.
+*/
+SnapshotSource_t* SnapshotSource_createLive(const char* sysRoot);
+
+
+/**
+ * \brief Creates snapshot source streaming snapshots from recording, mapped into memory one segment at a time.
+ * \param recordingPath Either path of single segment file, or path prefix recording has been written with,
+ * in which case consecutive segments are replayed until first missing one.
+ * \param asFastAsPossible Whether snapshots should be delivered without delay rather than at original cadence.
+ * \return Pointer to newly created source if successful, NULL otherwise.
+ * \warning Resulting source has to be destroyed with SnapshotSource_destroy() once no longer needed.
+*/
+SnapshotSource_t* SnapshotSource_createReplay(const char* recordingPath, bool asFastAsPossible);
+
+
+/**
+ * \brief Destroys snapshot source, cleaning up any resources used by it.
+ * \param self Source to be destroyed.
+*/
+void SnapshotSource_destroy(SnapshotSource_t* self);
+
+
+/**
+ * \brief Retrieves the way consecutive snapshots should be paced.
+ * \param self Snapshot source.
+ * \return Pacing of given source.
+*/
+SnapshotPacing_t SnapshotSource_getPacing(const SnapshotSource_t* self);
+
+
+/**
+ * \brief Retrieves amount of "cpu(N)" lines, including total "cpu" line, in every snapshot produced by given source.
+ * \param self Snapshot source.
+ * \return Amount of lines, or 0 if it is not known in advance.
+*/
+size_t SnapshotSource_getCpuStatsLength(const SnapshotSource_t* self);
+
+
+/**
+ * \brief Checks whether snapshots produced by given source carry processor frequencies, so that room for frequency-weighted
+ * usage is only reserved when it is going to be used. Frequency sampler of live source is created by the first call.
+ * \warning Tracked processors cannot change afterwards, so CpuCount_init() should be called before this function.
+ * \param self Snapshot source.
+ * \return True if frequencies are sampled, false otherwise.
+*/
+bool SnapshotSource_hasFreqs(SnapshotSource_t* self);
+
+
+/**
+ * \brief Produces next snapshot.
+ * \param self Snapshot source.
+ * \param out Structure to write the snapshot into, of size at least equal to that retrieved by ProcStat_size().
+ * \return 1 if snapshot has been produced, 0 if source has been exhausted, negative value on error.
+*/
+int SnapshotSource_next(SnapshotSource_t* self, ProcStat_t* out);
+
+
+#endif // !SNAPSOURCE_H_INCLUDED
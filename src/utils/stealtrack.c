@@ -0,0 +1,454 @@
+#include "stealtrack.h"
+#include "cpucount.h"
+#include "logger.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+// Intervals without any steal are the common case, and are told apart from ones with a little
+static const BasisPointValue_t BUCKET_BOUNDS[STEALTRACK_BUCKETS] = { 0u, 50u, 100u, 200u, 500u, 1000u, 2500u, CPUUSAGE_BP_FULL };
+
+
+/**
+ * Steal of a single processor, or of all of them, as of the last interval and since tracking has started.
+*/
+typedef struct StealState
+{
+	/** Intervals recorded in every histogram bucket. */
+	uint32_t 			buckets[STEALTRACK_BUCKETS];
+	/** Steal, guest time and own work over the last interval. */
+	BasisPointValue_t 	stealBp;
+	BasisPointValue_t 	guestBp;
+	BasisPointValue_t 	ownBp;
+	/** Whether steal has been sustained above threshold. */
+	bool 				sustained;
+	/** Consecutive intervals steal has stayed past threshold in the direction changing the flag. */
+	uint32_t 			run;
+	/** Consecutive intervals steal has been sustained for, zero if it is not. */
+	uint32_t 			sustainedIntervals;
+}
+StealState_t;
+
+
+struct StealTracker
+{
+	/** Amount of tracked processors, states of which follow the total one. */
+	size_t 				cpuCount;
+	BasisPointValue_t 	thresholdBp;
+	BasisPointValue_t 	releaseBp;
+	unsigned 			sustain;
+	/** Amount of recorded intervals. */
+	unsigned long long 	intervals;
+	StealState_t* 		states;
+};
+
+
+static size_t bucketIndex(BasisPointValue_t value)
+{
+	size_t index = 0u;
+
+	while ((index + 1u < STEALTRACK_BUCKETS) && (value > BUCKET_BOUNDS[index]))
+	{
+		++index;
+	}
+
+	return index;
+}
+
+
+/**
+ * \brief Finds upper bound of the bucket 95 % of recorded intervals lie below or at.
+*/
+static BasisPointValue_t percentile95(const StealState_t* state)
+{
+	unsigned long long count = 0u;
+
+	for (size_t ii = 0; ii < STEALTRACK_BUCKETS; ++ii)
+	{
+		count += state->buckets[ii];
+	}
+
+	const unsigned long long target = (count * 95u + 99u) / 100u;
+	unsigned long long seen = 0u;
+
+	for (size_t ii = 0; ii < STEALTRACK_BUCKETS; ++ii)
+	{
+		seen += state->buckets[ii];
+
+		if ((0u != seen) && (seen >= target))
+		{
+			return BUCKET_BOUNDS[ii];
+		}
+	}
+
+	return 0u;
+}
+
+
+/**
+ * \brief Records steal of single interval, flagging or clearing state once steal has stayed past threshold long enough.
+ * \return True if flag has changed, false otherwise.
+*/
+static bool record(StealTracker_t* self, StealState_t* state, BasisPointValue_t stealBp)
+{
+	uint32_t* bucket = &state->buckets[bucketIndex(stealBp)];
+	*bucket += (UINT32_MAX != *bucket) ? 1u : 0u;
+
+	// Separate thresholds keep steal hovering around one of them from flapping the flag
+	const bool crossing = state->sustained ? (stealBp < self->releaseBp) : (stealBp >= self->thresholdBp);
+	state->run = crossing ? state->run + 1u : 0u;
+
+	if (state->sustained)
+	{
+		++state->sustainedIntervals;
+	}
+
+	if (state->run < self->sustain)
+	{
+		return false;
+	}
+
+	state->sustained = !state->sustained;
+	state->sustainedIntervals = state->sustained ? state->run : 0u;
+	state->run = 0u;
+	return true;
+}
+
+
+StealTracker_t* StealTracker_create(unsigned thresholdPct, unsigned sustain)
+{
+	if ((0u == thresholdPct) || (100u < thresholdPct) || (0u == sustain))
+	{
+		goto error_exit_1;
+	}
+
+	StealTracker_t* self = calloc(1u, sizeof(StealTracker_t));
+
+	if (NULL == self)
+	{
+		goto error_exit_1;
+	}
+
+	self->cpuCount 		= (size_t) CpuCount_get();
+	self->thresholdBp 	= (BasisPointValue_t) (thresholdPct * 100u);
+	self->releaseBp 	= (BasisPointValue_t) (self->thresholdBp / 2u);
+	self->sustain 		= sustain;
+	self->states 		= calloc(self->cpuCount + 1u, sizeof(StealState_t));
+
+	if (NULL == self->states)
+	{
+		goto error_exit_2;
+	}
+
+	return self;
+
+error_exit_2:
+	free(self);
+error_exit_1:
+	return NULL;
+}
+
+
+void StealTracker_destroy(StealTracker_t* self)
+{
+	if (NULL == self)
+	{
+		return;
+	}
+
+	free(self->states);
+	free(self);
+}
+
+
+/**
+ * \brief Calculates share of measurement period spent in given part of processor time, rounded the way usage is.
+ * \return Share in basis points, CPUUSAGE_BP_INVALID if no time has passed over the period or part exceeds it.
+*/
+static BasisPointValue_t shareOf(CpuStatValue_t partd, CpuStatValue_t totald)
+{
+	if ((0u == totald) || (partd > totald))
+	{
+		return CPUUSAGE_BP_INVALID;
+	}
+
+	return (BasisPointValue_t) ((partd * CPUUSAGE_BP_FULL + totald / 2u) / totald);
+}
+
+
+/**
+ * \brief Sets steal and guest time of processor, or of all of them, from changes of it's counters over the interval.
+ * Total time is summed up the same way usage calculation does, guest time being part of user time already.
+*/
+static void setShares(StealState_t* state, const CpuStatValue_t* changes)
+{
+	const CpuStatValue_t totald =
+		changes[CSINDEX_IDLE] +
+		changes[CSINDEX_IOWAIT] +
+		changes[CSINDEX_USER] +
+		changes[CSINDEX_NICE] +
+		changes[CSINDEX_SYSTEM] +
+		changes[CSINDEX_IRQ] +
+		changes[CSINDEX_SOFTIRQ] +
+		changes[CSINDEX_STEAL];
+
+	state->stealBp = shareOf(changes[CSINDEX_STEAL], totald);
+	state->guestBp = shareOf(changes[CSINDEX_GUEST] + changes[CSINDEX_GUESTNICE], totald);
+}
+
+
+/**
+ * \brief Records steal of every processor, as set by setShares(), against usage over the same interval.
+ * \return Amount of processors flagged or cleared by the interval.
+*/
+static int recordInterval(StealTracker_t* self, const CpuUsageCompact_t* usage)
+{
+	int changed = 0;
+	++self->intervals;
+
+	for (size_t ii = 0; ii < usage->valuesLength; ++ii)
+	{
+		StealState_t* state = &self->states[ii];
+		const BasisPointValue_t value = usage->values[ii];
+
+		if ((CPUUSAGE_BP_FULL < value) || (CPUUSAGE_BP_FULL < state->stealBp))
+		{
+			const BasisPointValue_t marker = (CPUUSAGE_BP_FULL < value) ? value : CPUUSAGE_BP_INVALID;
+			state->stealBp 	= marker;
+			state->guestBp 	= marker;
+			state->ownBp 	= marker;
+			continue;
+		}
+
+		// Steal is part of usage, yet changes saturated in delta mode may leave it past usage
+		state->ownBp = (value > state->stealBp) ? (BasisPointValue_t) (value - state->stealBp) : 0u;
+
+		if (!record(self, state, state->stealBp))
+		{
+			continue;
+		}
+
+		++changed;
+
+		if (0u == ii)
+		{
+			Log(state->sustained ? LLEVEL_WARNING : LLEVEL_INFO, "total steal %s: %u bp",
+				state->sustained ? "sustained" : "cleared", (unsigned) state->stealBp);
+		}
+		else
+		{
+			Log(state->sustained ? LLEVEL_WARNING : LLEVEL_INFO, "steal of CPU%d %s: %u bp", CpuCount_getCpuId((int) ii - 1),
+				state->sustained ? "sustained" : "cleared", (unsigned) state->stealBp);
+		}
+	}
+
+	return changed;
+}
+
+
+int StealTracker_update(StealTracker_t* self, const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, const CpuUsageCompact_t* usage)
+{
+	if ((NULL == self) || (NULL == oldProcStat) || (NULL == newProcStat) || (NULL == usage) ||
+		(usage->valuesLength != self->cpuCount + 1u) ||
+		(oldProcStat->cpuStatsLength != usage->valuesLength) || (newProcStat->cpuStatsLength != usage->valuesLength))
+	{
+		return -1;
+	}
+
+	const CpuStatValue_t* oldTotal = oldProcStat->cpuStats[0].values;
+	const CpuStatValue_t* newTotal = newProcStat->cpuStats[0].values;
+
+	// Bare metal hosts neither lose time to a hypervisor nor run guests, and are spared the pass over counters
+	const bool virt =
+		(oldTotal[CSINDEX_STEAL] != newTotal[CSINDEX_STEAL]) ||
+		(oldTotal[CSINDEX_GUEST] != newTotal[CSINDEX_GUEST]) ||
+		(oldTotal[CSINDEX_GUESTNICE] != newTotal[CSINDEX_GUESTNICE]);
+
+	for (size_t ii = 0; ii < usage->valuesLength; ++ii)
+	{
+		StealState_t* state = &self->states[ii];
+
+		if (!virt)
+		{
+			state->stealBp = 0u;
+			state->guestBp = 0u;
+			continue;
+		}
+
+		// Counters going backwards are larger than the whole period once wrapped, and leave share invalid
+		CpuStatValue_t changes[CSINDEX_COUNT_];
+
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			changes[jj] = newProcStat->cpuStats[ii].values[jj] - oldProcStat->cpuStats[ii].values[jj];
+		}
+
+		setShares(state, changes);
+	}
+
+	return recordInterval(self, usage);
+}
+
+
+int StealTracker_updateFromDelta(StealTracker_t* self, const ProcStatDelta_t* delta, const CpuUsageCompact_t* usage)
+{
+	if ((NULL == self) || (NULL == delta) || (NULL == usage) ||
+		(usage->valuesLength != self->cpuCount + 1u) || (delta->cpuDeltasLength != usage->valuesLength))
+	{
+		return -1;
+	}
+
+	const CpuStatDeltaValue_t* totalValues = delta->cpuDeltas[0].values;
+	const bool virt = (0u != totalValues[CSINDEX_STEAL]) || (0u != totalValues[CSINDEX_GUEST]) || (0u != totalValues[CSINDEX_GUESTNICE]);
+
+	for (size_t ii = 0; ii < usage->valuesLength; ++ii)
+	{
+		StealState_t* state = &self->states[ii];
+
+		if (!virt)
+		{
+			state->stealBp = 0u;
+			state->guestBp = 0u;
+			continue;
+		}
+
+		CpuStatValue_t changes[CSINDEX_COUNT_];
+
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			changes[jj] = delta->cpuDeltas[ii].values[jj];
+		}
+
+		setShares(state, changes);
+	}
+
+	return recordInterval(self, usage);
+}
+
+
+/**
+ * \brief Fills report entry from state of processor, or of all of them.
+*/
+static void fillUsage(const StealState_t* state, unsigned cpu, StealCpuUsage_t* usage)
+{
+	*usage = (StealCpuUsage_t)
+	{
+		.cpu 				= cpu,
+		.stealBp 			= state->stealBp,
+		.guestBp 			= state->guestBp,
+		.ownBp 				= state->ownBp,
+		.p95StealBp 		= percentile95(state),
+		.sustained 			= state->sustained,
+		.sustainedIntervals = state->sustainedIntervals
+	};
+}
+
+
+void StealTracker_report(const StealTracker_t* self, StealUsageReport_t* report)
+{
+	if ((NULL == self) || (NULL == report))
+	{
+		return;
+	}
+
+	report->cpuCount 		= self->cpuCount;
+	report->sustainedCount 	= 0u;
+	report->thresholdBp 	= self->thresholdBp;
+	report->releaseBp 		= self->releaseBp;
+	report->sustain 		= self->sustain;
+	report->intervals 		= self->intervals;
+	memcpy(report->totalBuckets, self->states[0].buckets, sizeof(report->totalBuckets));
+	fillUsage(&self->states[0], 0u, &report->total);
+
+	for (size_t ii = 0; ii < self->cpuCount; ++ii)
+	{
+		fillUsage(&self->states[ii + 1u], (unsigned) CpuCount_getCpuId((int) ii), &report->cpus[ii]);
+		report->sustainedCount += report->cpus[ii].sustained ? 1u : 0u;
+	}
+}
+
+
+BasisPointValue_t StealTracker_bucketBound(size_t index)
+{
+	return (index < STEALTRACK_BUCKETS) ? BUCKET_BOUNDS[index] : CPUUSAGE_BP_FULL;
+}
+
+
+size_t StealUsageReport_size(size_t cpuCount)
+{
+	return sizeof(StealUsageReport_t) + cpuCount * sizeof(StealCpuUsage_t);
+}
+
+
+/**
+ * \brief Prints value in percent, or a dash if it is not valid.
+*/
+static void printBp(FILE* out, BasisPointValue_t value)
+{
+	if (CPUUSAGE_BP_FULL < value)
+	{
+		fputc('-', out);
+	}
+	else
+	{
+		fprintf(out, "%u.%02u %%", value / 100u, value % 100u);
+	}
+}
+
+
+/**
+ * \brief Prints steal, own work, guest time and 95th percentile of steal of processor, or of all of them.
+*/
+static void printUsage(FILE* out, const StealCpuUsage_t* usage)
+{
+	printBp(out, usage->stealBp);
+	fputs(", own work ", out);
+	printBp(out, usage->ownBp);
+	fputs(", guest ", out);
+	printBp(out, usage->guestBp);
+	fputs(", p95 up to ", out);
+	printBp(out, usage->p95StealBp);
+}
+
+
+void StealUsageReport_print(FILE* out, const StealUsageReport_t* report, bool printCpus)
+{
+	if ((NULL == out) || (NULL == report) || (0u == report->intervals))
+	{
+		return;
+	}
+
+	fputs("Steal:\t", out);
+	printUsage(out, &report->total);
+	fprintf(out, " over %llu intervals\n", report->intervals);
+
+	if (report->total.sustained || (0u != report->sustainedCount))
+	{
+		fprintf(out, "Sustained steal:\t%s%zu processors, flagged at ", report->total.sustained ? "total and " : "", report->sustainedCount);
+		printBp(out, report->thresholdBp);
+		fputs(", cleared below ", out);
+		printBp(out, report->releaseBp);
+		fprintf(out, " for %u intervals\n", report->sustain);
+	}
+
+	for (size_t ii = 0; printCpus && (ii < report->cpuCount); ++ii)
+	{
+		const StealCpuUsage_t* usage = &report->cpus[ii];
+
+		// Processors losing no time to hypervisor, now nor in 95 % of intervals, are left out
+		if (!usage->sustained && ((CPUUSAGE_BP_FULL < usage->stealBp) || (0u == usage->stealBp)) && (0u == usage->p95StealBp))
+		{
+			continue;
+		}
+
+		fprintf(out, "CPU%u steal:\t", usage->cpu);
+		printUsage(out, usage);
+
+		if (usage->sustained)
+		{
+			fprintf(out, ", sustained for %u intervals", usage->sustainedIntervals);
+		}
+
+		fputc('\n', out);
+	}
+}
@@ -0,0 +1,148 @@
+/**
+ * \file stealtrack.h
+ * Tracking of time processors lose to hypervisor running other machines, with a histogram of steal of every processor
+ * and detection of sustained steal, so that contention for the host is told apart from own load.
+*/
+#ifndef STEALTRACK_H_INCLUDED
+#define STEALTRACK_H_INCLUDED
+#include "cpuusage.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/**
+ * Amount of buckets of steal histogram of every processor. Bucket upper bounds are listed by StealTracker_bucketBound().
+*/
+#define STEALTRACK_BUCKETS 8u
+
+/**
+ * Default amount of consecutive intervals steal has to stay past threshold for, to be flagged or cleared.
+*/
+#define STEALTRACK_DEFAULT_SUSTAIN 5u
+
+
+typedef struct StealTracker StealTracker_t;
+
+
+/**
+ * Steal and guest time of a single processor, or of all of them, over the last interval and since tracking has started.
+*/
+typedef struct StealCpuUsage
+{
+	/** Processor number, unused for total one. */
+	unsigned 			cpu;
+	/** Share of the last interval lost to hypervisor, spent running guests, and spent on own work, that is usage
+	 * without steal, in basis points. CPUUSAGE_BP_INVALID or CPUUSAGE_BP_OFFLINE as usage of processor is. */
+	BasisPointValue_t 	stealBp;
+	BasisPointValue_t 	guestBp;
+	BasisPointValue_t 	ownBp;
+	/** Upper bound of histogram bucket 95 % of recorded intervals lie below or at, in basis points. */
+	BasisPointValue_t 	p95StealBp;
+	/** Whether steal has been sustained above threshold, and for how many intervals in a row it has been. */
+	bool 				sustained;
+	uint32_t 			sustainedIntervals;
+}
+StealCpuUsage_t;
+
+
+/**
+ * Steal and guest time of every tracked processor, as of the last interval.
+*/
+typedef struct StealUsageReport
+{
+	/** Amount of processors in cpus array. */
+	size_t 			cpuCount;
+	/** Amount of processors flagged with sustained steal. */
+	size_t 			sustainedCount;
+	/** Steal flagging a processor and one clearing it, in basis points, and intervals either has to last for. */
+	BasisPointValue_t thresholdBp;
+	BasisPointValue_t releaseBp;
+	unsigned 		sustain;
+	/** Amount of intervals recorded since tracking has started. */
+	unsigned long long intervals;
+	/** Intervals recorded in every bucket of total steal histogram. */
+	uint32_t 		totalBuckets[STEALTRACK_BUCKETS];
+	/** Total steal and guest time of all processors. */
+	StealCpuUsage_t total;
+	/** Every tracked processor, in order of CpuCount_getCpuId() indices. */
+	StealCpuUsage_t cpus[];
+}
+StealUsageReport_t;
+
+
+/**
+ * \brief Creates steal tracker of every processor tracked at the time of the call.
+ * \param thresholdPct Steal flagging processor, in percent, 1-100. Flag is cleared once steal drops below half of it.
+ * \param sustain Amount of consecutive intervals steal has to stay past threshold for, to flag or clear processor, at least 1.
+ * \return Pointer to tracker if successful, NULL on invalid argument or allocation failure.
+*/
+StealTracker_t* StealTracker_create(unsigned thresholdPct, unsigned sustain);
+
+
+/**
+ * \brief Destroys steal tracker. Does nothing if NULL.
+ * \param self Tracker to destroy.
+*/
+void StealTracker_destroy(StealTracker_t* self);
+
+
+/**
+ * \brief Records steal of every processor over single interval, updating histograms and flags. Steal and guest time
+ * are calculated from snapshots, so that usage statistics need no room for them, processors usage of which is not
+ * valid are left out.
+ * \param self Tracker.
+ * \param oldProcStat Snapshot taken at the start of the interval.
+ * \param newProcStat Snapshot taken at the end of the interval.
+ * \param usage Usage statistics of the interval, as calculated by CpuUsageCompact_calculate() or CpuUsageCompact_calculateMany().
+ * \return Amount of processors flagged or cleared by the interval, negative value on error.
+*/
+int StealTracker_update(StealTracker_t* self, const ProcStat_t* oldProcStat, const ProcStat_t* newProcStat, const CpuUsageCompact_t* usage);
+
+
+/**
+ * \brief Records steal of every processor over single interval from change of counters, counterpart of StealTracker_update().
+ * \param self Tracker.
+ * \param delta Change of counters over the interval.
+ * \param usage Usage statistics of the interval, as calculated by CpuUsageCompact_calculateFromDelta().
+ * \return Amount of processors flagged or cleared by the interval, negative value on error.
+*/
+int StealTracker_updateFromDelta(StealTracker_t* self, const ProcStatDelta_t* delta, const CpuUsageCompact_t* usage);
+
+
+/**
+ * \brief Fills report of the last recorded interval.
+ * \param self Tracker.
+ * \param report Output buffer, of size retrieved by StealUsageReport_size() for amount of tracked processors.
+*/
+void StealTracker_report(const StealTracker_t* self, StealUsageReport_t* report);
+
+
+/**
+ * \brief Retrieves upper bound of histogram bucket of given index.
+ * \param index Bucket index, lower than STEALTRACK_BUCKETS.
+ * \return Largest steal recorded in the bucket, in basis points.
+*/
+BasisPointValue_t StealTracker_bucketBound(size_t index);
+
+
+/**
+ * \brief Retrieves size of report of given amount of processors.
+ * \param cpuCount Amount of processors, as retrieved by CpuCount_get() when tracker has been created.
+ * \return Size of StealUsageReport structure, in bytes.
+*/
+size_t StealUsageReport_size(size_t cpuCount);
+
+
+/**
+ * \brief Prints total steal and guest time, followed by processors flagged with sustained steal,
+ * and by every processor losing any time to hypervisor if requested. Prints nothing for zeroed report.
+ * \param out Stream to print into.
+ * \param report Report to print.
+ * \param printCpus Whether every processor with steal should be printed as well.
+*/
+void StealUsageReport_print(FILE* out, const StealUsageReport_t* report, bool printCpus);
+
+
+#endif // !STEALTRACK_H_INCLUDED
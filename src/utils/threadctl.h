@@ -20,6 +20,9 @@ typedef enum ThreadId
 	TID_PRINTER,
 	TID_LOGGER,
 	TID_WATCHDOG,
+	TID_RECORDER,
+	TID_DUMPER,
+	TID_PROCSCAN,
 	TID_COUNT_
 }
 ThreadId_t;
@@ -0,0 +1,320 @@
+#include "topology.h"
+#include "helpers.h"
+#include "cpucount.h"
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TOPOLOGY_PATH_MAX 		512u
+#define TOPOLOGY_VALUE_MAX 		32u
+#define NODE_ENTRY_PREFIX 		"node"
+
+
+/**
+ * Group key of a single logical processor, sorted to group processors and order groups.
+*/
+typedef struct TopologyKey
+{
+	uint64_t key;
+	uint32_t cpu;
+	int id;
+}
+TopologyKey_t;
+
+
+/**
+ * \brief Orders keys by group key, then by processor index, so that members of every group are listed in order.
+*/
+static int compareKeys(const void* lhs, const void* rhs)
+{
+	const TopologyKey_t* a = lhs;
+	const TopologyKey_t* b = rhs;
+
+	if (a->key != b->key)
+	{
+		return (a->key < b->key) ? -1 : 1;
+	}
+
+	return (a->cpu < b->cpu) ? -1 : (a->cpu > b->cpu);
+}
+
+
+/**
+ * \brief Reads single integer from sysfs attribute file.
+ * \return True if successful, false if file is missing or malformed.
+*/
+static bool readIntAttribute(const char* path, int* out)
+{
+	char buf[TOPOLOGY_VALUE_MAX];
+
+	if (0 >= ReadFileContent(path, buf, sizeof(buf)))
+	{
+		return false;
+	}
+
+	char* end = NULL;
+	long value = strtol(buf, &end, 10);
+
+	if ((end == buf) || (value < -1) || (value > INT32_MAX))
+	{
+		return false;
+	}
+
+	*out = (int) value;
+	return true;
+}
+
+
+/**
+ * \brief Finds NUMA node of logical processor from "nodeN" entry of it's sysfs directory.
+ * \return Node number, 0 if processor directory has no such entry, negative if directory cannot be opened.
+*/
+static int findNode(const char* cpuDirPath)
+{
+	DIR* dir = opendir(cpuDirPath);
+
+	if (NULL == dir)
+	{
+		return -1;
+	}
+
+	int node = 0;
+	struct dirent* entry;
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		int value;
+		char trailing;
+
+		if ((0 == strncmp(entry->d_name, NODE_ENTRY_PREFIX, sizeof(NODE_ENTRY_PREFIX) - 1u)) &&
+			(1 == sscanf(entry->d_name + sizeof(NODE_ENTRY_PREFIX) - 1u, "%d%c", &value, &trailing)) &&
+			(0 <= value))
+		{
+			node = value;
+			break;
+		}
+	}
+
+	closedir(dir);
+	return node;
+}
+
+
+/**
+ * \brief Allocates topology structure along with arrays of every level.
+*/
+static CpuTopology_t* allocate(size_t cpuCount)
+{
+	CpuTopology_t* topology = calloc(1u, sizeof(CpuTopology_t));
+
+	if (NULL == topology)
+	{
+		return NULL;
+	}
+
+	topology->cpuCount = cpuCount;
+
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		// Every level has at most as many groups as there are processors
+		topology->groupOf[level] 		= malloc(cpuCount * sizeof(uint32_t));
+		topology->groupIds[level] 		= malloc(cpuCount * sizeof(int));
+		topology->members[level] 		= malloc(cpuCount * sizeof(uint32_t));
+		topology->memberStarts[level] 	= malloc((cpuCount + 1u) * sizeof(uint32_t));
+
+		if ((NULL == topology->groupOf[level]) || (NULL == topology->groupIds[level]) ||
+			(NULL == topology->members[level]) || (NULL == topology->memberStarts[level]))
+		{
+			Topology_destroy(topology);
+			return NULL;
+		}
+	}
+
+	return topology;
+}
+
+
+/**
+ * \brief Groups processors of a single level by their keys, filling precomputed index arrays of that level.
+ * \param keys Key of every processor, sorted in the process.
+*/
+static void buildLevel(CpuTopology_t* topology, TopologyLevel_t level, TopologyKey_t* keys)
+{
+	const size_t cpuCount = topology->cpuCount;
+	qsort(keys, cpuCount, sizeof(TopologyKey_t), compareKeys);
+
+	size_t groupCount = 0u;
+
+	for (size_t ii = 0; ii < cpuCount; ++ii)
+	{
+		if ((0u == ii) || (keys[ii].key != keys[ii - 1u].key))
+		{
+			topology->memberStarts[level][groupCount] = (uint32_t) ii;
+			topology->groupIds[level][groupCount] = keys[ii].id;
+			++groupCount;
+		}
+
+		topology->members[level][ii] = keys[ii].cpu;
+		topology->groupOf[level][keys[ii].cpu] = (uint32_t) (groupCount - 1u);
+	}
+
+	topology->memberStarts[level][groupCount] = (uint32_t) cpuCount;
+	topology->groupCounts[level] = groupCount;
+	topology->groupTotal += groupCount;
+}
+
+
+CpuTopology_t* Topology_load(const char* sysRoot, size_t cpuCount)
+{
+	if ((0u == cpuCount) || (cpuCount > UINT32_MAX))
+	{
+		return NULL;
+	}
+
+	if (NULL == sysRoot)
+	{
+		sysRoot = TOPOLOGY_SYS_ROOT_DEFAULT;
+	}
+
+	CpuTopology_t* topology = allocate(cpuCount);
+	TopologyKey_t* keys[TLEVEL_COUNT_] = { NULL };
+
+	if (NULL == topology)
+	{
+		goto error_exit_1;
+	}
+
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		keys[level] = malloc(cpuCount * sizeof(TopologyKey_t));
+
+		if (NULL == keys[level])
+		{
+			goto error_exit_2;
+		}
+	}
+
+	for (size_t ii = 0; ii < cpuCount; ++ii)
+	{
+		char path[TOPOLOGY_PATH_MAX];
+		int coreId = -1;
+		int packageId = -1;
+		const int cpuId = CpuCount_getCpuId((int) ii);
+
+		// Processors not present yet, which may be hot-added later, have no sysfs directory
+		snprintf(path, sizeof(path), "%s/cpu/cpu%d", sysRoot, cpuId);
+		int node = findNode(path);
+		node = (0 > node) ? 0 : node;
+
+		snprintf(path, sizeof(path), "%s/cpu/cpu%d/topology/core_id", sysRoot, cpuId);
+		readIntAttribute(path, &coreId);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%d/topology/physical_package_id", sysRoot, cpuId);
+		readIntAttribute(path, &packageId);
+
+		// Core identifiers repeat across packages, processors of unknown core are cores of their own
+		const uint64_t coreKey = (0 > coreId)
+			? ((1ull << 63) | ii)
+			: (((uint64_t) (uint32_t) packageId << 32) | (uint32_t) coreId);
+
+		keys[TLEVEL_CORE][ii] 		= (TopologyKey_t) { .key = coreKey, .cpu = (uint32_t) ii, .id = coreId };
+		keys[TLEVEL_PACKAGE][ii] 	= (TopologyKey_t) { .key = (uint32_t) packageId, .cpu = (uint32_t) ii, .id = packageId };
+		keys[TLEVEL_NODE][ii] 		= (TopologyKey_t) { .key = (uint32_t) node, .cpu = (uint32_t) ii, .id = node };
+	}
+
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		buildLevel(topology, (TopologyLevel_t) level, keys[level]);
+		free(keys[level]);
+	}
+
+	return topology;
+
+error_exit_2:
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		free(keys[level]);
+	}
+
+	Topology_destroy(topology);
+error_exit_1:
+	return NULL;
+}
+
+
+CpuTopology_t* Topology_createFlat(size_t cpuCount)
+{
+	if ((0u == cpuCount) || (cpuCount > UINT32_MAX))
+	{
+		return NULL;
+	}
+
+	CpuTopology_t* topology = allocate(cpuCount);
+
+	if (NULL == topology)
+	{
+		return NULL;
+	}
+
+	for (uint32_t ii = 0; ii < cpuCount; ++ii)
+	{
+		topology->groupOf[TLEVEL_CORE][ii] 		= ii;
+		topology->groupIds[TLEVEL_CORE][ii] 	= (int) ii;
+		topology->members[TLEVEL_CORE][ii] 		= ii;
+		topology->memberStarts[TLEVEL_CORE][ii] = ii;
+
+		for (int level = TLEVEL_PACKAGE; level < TLEVEL_COUNT_; ++level)
+		{
+			topology->groupOf[level][ii] = 0u;
+			topology->members[level][ii] = ii;
+		}
+	}
+
+	topology->memberStarts[TLEVEL_CORE][cpuCount] = (uint32_t) cpuCount;
+	topology->groupCounts[TLEVEL_CORE] = cpuCount;
+
+	for (int level = TLEVEL_PACKAGE; level < TLEVEL_COUNT_; ++level)
+	{
+		topology->groupIds[level][0] 		= 0;
+		topology->memberStarts[level][0] 	= 0u;
+		topology->memberStarts[level][1] 	= (uint32_t) cpuCount;
+		topology->groupCounts[level] 		= 1u;
+	}
+
+	topology->groupTotal = cpuCount + TLEVEL_COUNT_ - 1u;
+	return topology;
+}
+
+
+void Topology_destroy(CpuTopology_t* topology)
+{
+	if (NULL == topology)
+	{
+		return;
+	}
+
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		free(topology->groupOf[level]);
+		free(topology->groupIds[level]);
+		free(topology->members[level]);
+		free(topology->memberStarts[level]);
+	}
+
+	free(topology);
+}
+
+
+const char* Topology_getLevelName(TopologyLevel_t level)
+{
+	static const char* const LEVEL_NAMES[TLEVEL_COUNT_] =
+	{
+		[TLEVEL_CORE] 		= "Core",
+		[TLEVEL_PACKAGE] 	= "Package",
+		[TLEVEL_NODE] 		= "Node"
+	};
+
+	return ((0 <= (int) level) && (level < TLEVEL_COUNT_)) ? LEVEL_NAMES[level] : "?";
+}
@@ -0,0 +1,108 @@
+/**
+ * \file topology.h
+ * Processor topology, grouping logical processors into physical cores, packages and NUMA nodes.
+*/
+#ifndef TOPOLOGY_H_INCLUDED
+#define TOPOLOGY_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Default directory containing "cpu" and "node" sysfs directories.
+*/
+#define TOPOLOGY_SYS_ROOT_DEFAULT "/sys/devices/system"
+
+/**
+ * Bit representing given topology level in level masks.
+*/
+#define TOPOLOGY_LEVEL_BIT(level) (1u << (level))
+
+
+/**
+ * Levels logical processors are grouped at, from the finest one.
+*/
+typedef enum TopologyLevel
+{
+	/** Physical core, grouping SMT siblings. */
+	TLEVEL_CORE,
+	/** Physical package, or socket. */
+	TLEVEL_PACKAGE,
+	/** NUMA node. */
+	TLEVEL_NODE,
+	TLEVEL_COUNT_
+}
+TopologyLevel_t;
+
+
+/**
+ * Grouping of logical processors at every topology level. Groups of a level are ordered by their identifiers,
+ * and processors belonging to every group are listed in precomputed arrays, so that visiting every group
+ * of a level visits every processor exactly once.
+*/
+typedef struct CpuTopology
+{
+	/** Amount of logical processors. */
+	size_t cpuCount;
+
+	/** Amount of groups at every level. */
+	size_t groupCounts[TLEVEL_COUNT_];
+
+	/** Sum of groupCounts over all levels. */
+	size_t groupTotal;
+
+	/** For every level, index of group every logical processor belongs to. */
+	uint32_t* groupOf[TLEVEL_COUNT_];
+
+	/**
+	 * For every level, identifier of every group as reported by the system: core_id, physical_package_id or node number.
+	 * Core identifiers are only unique within package. Negative if unknown.
+	*/
+	int* groupIds[TLEVEL_COUNT_];
+
+	/** For every level, logical processors listed group after group. */
+	uint32_t* members[TLEVEL_COUNT_];
+
+	/** For every level, offset of every group's list in members array, followed by cpuCount. */
+	uint32_t* memberStarts[TLEVEL_COUNT_];
+}
+CpuTopology_t;
+
+
+/**
+ * \brief Loads topology of given amount of logical processors from sysfs.
+ * Processor numbers are retrieved with CpuCount_getCpuId(), so that only tracked processors are described.
+ * Processors with no topology information, including ones not present in sysfs until they are hot-added,
+ * are treated as separate cores of unknown package, processors with no NUMA node as belonging to node 0.
+ * \param sysRoot Directory containing "cpu" sysfs directory, NULL for TOPOLOGY_SYS_ROOT_DEFAULT.
+ * \param cpuCount Amount of logical processors, at least 1.
+ * \return Pointer to topology if successful, NULL otherwise.
+*/
+CpuTopology_t* Topology_load(const char* sysRoot, size_t cpuCount);
+
+
+/**
+ * \brief Creates topology of given amount of logical processors, each being a separate core of a single package and node.
+ * Used when processed data does not come from this system.
+ * \param cpuCount Amount of logical processors, at least 1.
+ * \return Pointer to topology if successful, NULL otherwise.
+*/
+CpuTopology_t* Topology_createFlat(size_t cpuCount);
+
+
+/**
+ * \brief Destroys topology created by Topology_load() or Topology_createFlat(). Does nothing if NULL.
+ * \param topology Topology to destroy.
+*/
+void Topology_destroy(CpuTopology_t* topology);
+
+
+/**
+ * \brief Retrieves name of given topology level, as used in printed statistics and command-line arguments.
+ * \param level Topology level.
+ * \return Level name, "?" if invalid.
+*/
+const char* Topology_getLevelName(TopologyLevel_t level);
+
+
+#endif // !TOPOLOGY_H_INCLUDED
@@ -0,0 +1,64 @@
+#include "varint.h"
+
+
+size_t Varint_encode(uint64_t value, uint8_t* out)
+{
+	size_t length = 0u;
+
+	while (value >= 0x80u)
+	{
+		out[length++] = (uint8_t) (value | 0x80u);
+		value >>= 7;
+	}
+
+	out[length++] = (uint8_t) value;
+	return length;
+}
+
+
+size_t Varint_decode(const uint8_t* in, size_t inLength, uint64_t* value)
+{
+	uint64_t result = 0u;
+	const size_t maxLength = (inLength < VARINT_MAX_LENGTH) ? inLength : VARINT_MAX_LENGTH;
+
+	for (size_t ii = 0; ii < maxLength; ++ii)
+	{
+		result |= (uint64_t) (in[ii] & 0x7Fu) << (7u * ii);
+
+		if (0u == (in[ii] & 0x80u))
+		{
+			*value = result;
+			return ii + 1u;
+		}
+	}
+
+	return 0u;
+}
+
+
+size_t Varint_skip(const uint8_t* in, size_t inLength)
+{
+	const size_t maxLength = (inLength < VARINT_MAX_LENGTH) ? inLength : VARINT_MAX_LENGTH;
+
+	for (size_t ii = 0; ii < maxLength; ++ii)
+	{
+		if (0u == (in[ii] & 0x80u))
+		{
+			return ii + 1u;
+		}
+	}
+
+	return 0u;
+}
+
+
+uint64_t Varint_zigzagEncode(int64_t value)
+{
+	return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+
+int64_t Varint_zigzagDecode(uint64_t value)
+{
+	return (int64_t) (value >> 1) ^ -(int64_t) (value & 1u);
+}
@@ -0,0 +1,62 @@
+/**
+ * \file varint.h
+ * Variable-length integer encoding (LEB128) along with zig-zag mapping of signed values,
+ * used by compact on-disk formats.
+*/
+#ifndef VARINT_H_INCLUDED
+#define VARINT_H_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * Maximum amount of bytes single encoded 64-bit value can occupy.
+*/
+#define VARINT_MAX_LENGTH 10u
+
+
+/**
+ * \brief Encodes unsigned value as variable-length integer, seven bits per byte, least significant group first.
+ * \param value Value to encode.
+ * \param out Output buffer, has to be able to hold at least VARINT_MAX_LENGTH bytes.
+ * \return Amount of bytes written into output buffer.
+*/
+size_t Varint_encode(uint64_t value, uint8_t* out);
+
+
+/**
+ * \brief Decodes variable-length integer.
+ * \param in Buffer containing encoded value.
+ * \param inLength Amount of bytes available in input buffer.
+ * \param value Pointer to write decoded value into.
+ * \return Amount of bytes consumed, or 0 if input is truncated or malformed.
+*/
+size_t Varint_decode(const uint8_t* in, size_t inLength, uint64_t* value);
+
+
+/**
+ * \brief Steps over variable-length integer without decoding it.
+ * \param in Buffer containing encoded value.
+ * \param inLength Amount of bytes available in input buffer.
+ * \return Amount of bytes the value occupies, or 0 if input is truncated or malformed.
+*/
+size_t Varint_skip(const uint8_t* in, size_t inLength);
+
+
+/**
+ * \brief Maps signed value onto unsigned one, so that values of small magnitude encode into few bytes.
+ * \param value Signed value.
+ * \return Zig-zag mapped value: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+*/
+uint64_t Varint_zigzagEncode(int64_t value);
+
+
+/**
+ * \brief Reverses mapping performed by Varint_zigzagEncode().
+ * \param value Zig-zag mapped value.
+ * \return Original signed value.
+*/
+int64_t Varint_zigzagDecode(uint64_t value);
+
+
+#endif // !VARINT_H_INCLUDED
@@ -0,0 +1,242 @@
+#include "cgtrack.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define TEST_PATH_MAX 			256u
+#define TEST_LIST_MAX 			1024u
+#define TEST_TOP_COUNT 			3u
+#define TEST_SLICES 			2u
+#define TEST_SCAN_PERIOD_MS 	20
+
+
+/**
+ * Contents of cpu.stat and cpu.max files of a single cgroup, quota of 0 written as "max".
+*/
+typedef struct TestCgroup
+{
+	const char* name;
+	unsigned long long usageUsec;
+	unsigned long long nrPeriods;
+	unsigned long long nrThrottled;
+	unsigned long long throttledUsec;
+	unsigned long long quotaUsec;
+}
+TestCgroup_t;
+
+
+static void writeCgroup(const char* root, const TestCgroup_t* cgroup)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", root, cgroup->name);
+	mkdir(path, 0700);
+
+	// Files are rewritten in place, so that descriptors kept open by tracker see new contents
+	snprintf(path, sizeof(path), "%s/%s/cpu.stat", root, cgroup->name);
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fprintf(file,
+		"usage_usec %llu\nuser_usec %llu\nsystem_usec 0\nnr_periods %llu\nnr_throttled %llu\nthrottled_usec %llu\nnr_bursts 0\nburst_usec 0\n",
+		cgroup->usageUsec, cgroup->usageUsec, cgroup->nrPeriods, cgroup->nrThrottled, cgroup->throttledUsec);
+	fclose(file);
+
+	snprintf(path, sizeof(path), "%s/%s/cpu.max", root, cgroup->name);
+	file = fopen(path, "w");
+	assert(NULL != file);
+
+	if (0u != cgroup->quotaUsec)
+	{
+		fprintf(file, "%llu 100000\n", cgroup->quotaUsec);
+	}
+	else
+	{
+		fputs("max 100000\n", file);
+	}
+
+	fclose(file);
+}
+
+
+static void removeCgroup(const char* root, const char* name)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s/cpu.stat", root, name);
+	assert(0 == unlink(path));
+	snprintf(path, sizeof(path), "%s/%s/cpu.max", root, name);
+	assert(0 == unlink(path));
+	snprintf(path, sizeof(path), "%s/%s", root, name);
+	assert(0 == rmdir(path));
+}
+
+
+/**
+ * \brief Runs a full scan, checking that only it's last step completes it.
+*/
+static void scan(CgroupTracker_t* tracker, CgroupUsageReport_t* report)
+{
+	nanosleep(&(struct timespec) { .tv_nsec = TEST_SCAN_PERIOD_MS * 1000000L }, NULL);
+
+	for (unsigned ii = 1; ii < TEST_SLICES; ++ii)
+	{
+		assert(0 == CgroupTracker_step(tracker, report));
+	}
+
+	assert(1 == CgroupTracker_step(tracker, report));
+}
+
+
+static void test_CgroupTracker_create(void)
+{
+	assert(NULL == CgroupTracker_create(NULL, false, TEST_TOP_COUNT, TEST_SLICES));
+	assert(NULL == CgroupTracker_create("/tmp", false, 0u, TEST_SLICES));
+	assert(NULL == CgroupTracker_create("/tmp", false, TEST_TOP_COUNT, 0u));
+	assert(NULL == CgroupTracker_create(",,", false, TEST_TOP_COUNT, TEST_SLICES));
+	assert(CgroupUsageReport_size(TEST_TOP_COUNT) == sizeof(CgroupUsageReport_t) + TEST_TOP_COUNT * sizeof(CgroupUsage_t));
+
+	// Cgroup that does not exist is not tracked until it is created
+	CgroupTracker_t* tracker = CgroupTracker_create("/nonexistent/cgroup", true, TEST_TOP_COUNT, 1u);
+	assert(NULL != tracker);
+	CgroupUsageReport_t* report = calloc(1u, CgroupUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+	assert(1 == CgroupTracker_step(tracker, report));
+	assert(0u == report->cgroupCount);
+	assert(0u == report->count);
+	free(report);
+	CgroupTracker_destroy(tracker);
+}
+
+
+static void test_CgroupTracker_step(void)
+{
+	char root[] = "/tmp/cut_cgtrack_XXXXXX";
+	assert(NULL != mkdtemp(root));
+
+	TestCgroup_t cgroups[] =
+	{
+		{ .name = "a", 		.usageUsec = 1000u, .nrPeriods = 100u, .nrThrottled = 10u, .throttledUsec = 500u, .quotaUsec = 50000u },
+		{ .name = "a/b", 	.usageUsec = 2000u },
+		{ .name = "a/c", 	.usageUsec = 3000u, .quotaUsec = 200000u },
+		{ .name = "a/c/d", 	.usageUsec = 4000u }
+	};
+
+	for (size_t ii = 0; ii < sizeof(cgroups) / sizeof(cgroups[0]); ++ii)
+	{
+		writeCgroup(root, &cgroups[ii]);
+	}
+
+	// Trailing slash and duplicate name the same cgroup, missing one is picked up once created
+	char list[TEST_LIST_MAX];
+	snprintf(list, sizeof(list), "%s/a/,,%s/a,%s/x", root, root, root);
+	CgroupTracker_t* tracker = CgroupTracker_create(list, true, TEST_TOP_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	CgroupUsageReport_t* report = calloc(1u, CgroupUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+
+	// Usage takes two reads of every cgroup
+	scan(tracker, report);
+	assert(4u == report->cgroupCount);
+	assert(0u == report->count);
+	assert(0u == report->intervalNs);
+
+	// Against their quota, a uses 16000 us worth of a processor, c 10000 us, b 2000 us, d none
+	cgroups[0].usageUsec += 8000u;
+	cgroups[0].nrPeriods += 100u;
+	cgroups[0].nrThrottled += 50u;
+	cgroups[0].throttledUsec += 1000u;
+	cgroups[1].usageUsec += 2000u;
+	cgroups[2].usageUsec += 20000u;
+	cgroups[2].nrPeriods += 100u;
+
+	for (size_t ii = 0; ii < sizeof(cgroups) / sizeof(cgroups[0]); ++ii)
+	{
+		writeCgroup(root, &cgroups[ii]);
+	}
+
+	scan(tracker, report);
+	assert(4u == report->cgroupCount);
+	assert(TEST_TOP_COUNT == report->count);
+	assert(0u < report->intervalNs);
+	assert(0 == strcmp(strrchr(report->top[0].path, '/'), "/a"));
+	assert(500u == report->top[0].quotaMilliCpus);
+	assert(5000u == report->top[0].throttledPeriodsBp);
+	assert(0u < report->top[0].throttledTimeBp);
+	assert(0 == strcmp(strrchr(report->top[1].path, '/'), "/c"));
+	assert(2000u == report->top[1].quotaMilliCpus);
+	assert(0u == report->top[1].throttledPeriodsBp);
+	assert(0 == strcmp(strrchr(report->top[2].path, '/'), "/b"));
+	assert(0u == report->top[2].quotaMilliCpus);
+	assert(report->top[0].usageBp > report->top[1].usageBp);
+	assert(report->top[1].usageBp > report->top[2].usageBp);
+	assert(0u < report->top[2].usageBp);
+
+	// Removed cgroup is dropped along with it's subtree, new one picked up, counters going back start over
+	removeCgroup(root, "a/c/d");
+	removeCgroup(root, "a/c");
+	writeCgroup(root, &(TestCgroup_t) { .name = "x", .usageUsec = 100000u });
+	cgroups[0].usageUsec += 1000u;
+	cgroups[1].usageUsec = 0u;
+	writeCgroup(root, &cgroups[0]);
+	writeCgroup(root, &cgroups[1]);
+
+	scan(tracker, report);
+	assert(3u == report->cgroupCount);
+	assert(1u == report->count);
+	assert(0 == strcmp(strrchr(report->top[0].path, '/'), "/a"));
+
+	CgroupTracker_destroy(tracker);
+
+	// Without subtree only listed cgroup is tracked
+	snprintf(list, sizeof(list), "%s/a", root);
+	tracker = CgroupTracker_create(list, false, TEST_TOP_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	scan(tracker, report);
+	assert(1u == report->cgroupCount);
+	CgroupTracker_destroy(tracker);
+	free(report);
+
+	removeCgroup(root, "x");
+	removeCgroup(root, "a/b");
+	removeCgroup(root, "a");
+	assert(0 == rmdir(root));
+}
+
+
+static void test_CgroupUsageReport_print(void)
+{
+	char buf[TEST_LIST_MAX];
+	FILE* out = fmemopen(buf, sizeof(buf), "w");
+	assert(NULL != out);
+
+	// Zeroed report, of no completed scan, prints nothing
+	CgroupUsageReport_t* report = calloc(1u, CgroupUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+	CgroupUsageReport_print(out, report);
+	fflush(out);
+	assert(0 == ftell(out));
+
+	report->cgroupCount = 2u;
+	report->count = 2u;
+	report->top[0] = (CgroupUsage_t) { .usageBp = 8012u, .quotaMilliCpus = 500u, .throttledPeriodsBp = 5000u, .throttledTimeBp = 5u, .path = "a" };
+	report->top[1] = (CgroupUsage_t) { .usageBp = 1000u, .path = "a/b" };
+	CgroupUsageReport_print(out, report);
+	fclose(out);
+
+	assert(NULL != strstr(buf, "Cgroups:\t2 tracked"));
+	assert(NULL != strstr(buf, "a:\t80.12 % of 0.500 CPU quota\tthrottled in 50.00 % of periods, for 0.05 % of time\n"));
+	assert(NULL != strstr(buf, "a/b:\t10.00 %\tno quota\n"));
+	free(report);
+}
+
+
+int main(void)
+{
+	test_CgroupTracker_create();
+	test_CgroupTracker_step();
+	test_CgroupUsageReport_print();
+	return 0;
+}
@@ -5,7 +5,7 @@
 
 int main()
 {
-	int cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+	int cpuCount = sysconf(_SC_NPROCESSORS_CONF);
 
 	assert(0 < cpuCount);
 
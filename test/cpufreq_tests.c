@@ -0,0 +1,143 @@
+#include "cpufreq.h"
+#include "cpucount.h"
+#include "procstat.h"
+#include "testfs.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define TEST_CPU_COUNT 		3
+#define TEST_REOPEN_SAMPLES 64u
+
+
+/**
+ * \brief Writes file of cpufreq directory of given processor.
+*/
+static void writeFreqFile(int cpu, const char* name, const char* content)
+{
+	char relative[TESTFS_PATH_MAX];
+	snprintf(relative, sizeof(relative), "cpu/cpu%d/cpufreq/%s", cpu, name);
+	TestFs_writeFile(relative, content);
+}
+
+
+static void makeCpu(int cpu, const char* maxFreq, const char* curFreq)
+{
+	char name[TESTFS_PATH_MAX];
+	snprintf(name, sizeof(name), "cpu/cpu%d", cpu);
+	TestFs_makeDir(name);
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpufreq", cpu);
+	TestFs_makeDir(name);
+	writeFreqFile(cpu, "cpuinfo_max_freq", maxFreq);
+	writeFreqFile(cpu, "scaling_cur_freq", curFreq);
+}
+
+
+static void removeCpu(int cpu)
+{
+	char name[TESTFS_PATH_MAX];
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpufreq", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d", cpu);
+	assert(TestFs_remove(name));
+}
+
+
+static void test_CpuFreq_mean(void)
+{
+	assert(5000u == CpuFreq_mean(4000u, 1u, 6000u, 1u));
+	assert(4500u == CpuFreq_mean(4000u, 3u, 6000u, 1u));
+	assert(5000u == CpuFreq_mean(4000u, 0u, 6000u, 0u));
+	assert(6000u == CpuFreq_mean(CPUFREQ_UNKNOWN, 1u, 6000u, 1u));
+	assert(4000u == CpuFreq_mean(4000u, 1u, CPUFREQ_UNKNOWN, 1u));
+	assert(CPUFREQ_UNKNOWN == CpuFreq_mean(CPUFREQ_UNKNOWN, 1u, CPUFREQ_UNKNOWN, 1u));
+
+	// Frequencies are kept after room of every tracked processor
+	ProcStat_t* stat = ProcStat_create();
+	assert(NULL != stat);
+	assert(ProcStat_size() == sizeof(ProcStat_t) + (TEST_CPU_COUNT + 1u) * (sizeof(CpuStat_t) + sizeof(CpuFreqValue_t)));
+	assert((char*) ProcStat_getFreqs(stat) == (char*) stat + sizeof(ProcStat_t) + (TEST_CPU_COUNT + 1u) * sizeof(CpuStat_t));
+	ProcStat_destroy(stat);
+}
+
+
+static void test_CpuFreqSampler(void)
+{
+	CpuFreqValue_t freqs[TEST_CPU_COUNT + 1];
+
+	assert(NULL == CpuFreqSampler_create("/nonexistent"));
+	assert(!CpuFreqSampler_read(NULL, freqs));
+
+	// Processor 1 has no cpufreq directory, processor 2 runs above it's advertised maximum
+	TestFs_makeDir("cpu");
+	makeCpu(0, "2000000\n", "1000000\n");
+	makeCpu(2, "3000000\n", "3300000\n");
+
+	CpuFreqSampler_t* sampler = CpuFreqSampler_create(TestFs_getRoot());
+	assert(NULL != sampler);
+	assert(CpuFreqSampler_read(sampler, freqs));
+	assert(5000u == freqs[1]);
+	assert(CPUFREQ_UNKNOWN == freqs[2]);
+	assert(10000u == freqs[3]);
+	assert(7500u == freqs[0]);
+
+	writeFreqFile(0, "scaling_cur_freq", "500000\n");
+	assert(CpuFreqSampler_read(sampler, freqs));
+	assert(2500u == freqs[1]);
+
+	// File that cannot be read is closed, and opened again a while later, as are new cpufreq directories
+	writeFreqFile(2, "scaling_cur_freq", "\n");
+	assert(CpuFreqSampler_read(sampler, freqs));
+	assert(CPUFREQ_UNKNOWN == freqs[3]);
+	assert(2500u == freqs[0]);
+
+	writeFreqFile(2, "scaling_cur_freq", "1500000\n");
+	makeCpu(1, "1000000\n", "1000000\n");
+
+	unsigned samples = 0u;
+
+	do
+	{
+		assert(CpuFreqSampler_read(sampler, freqs));
+		++samples;
+	}
+	while ((CPUFREQ_UNKNOWN == freqs[3]) && (samples <= TEST_REOPEN_SAMPLES));
+
+	assert((1u < samples) && (samples <= TEST_REOPEN_SAMPLES));
+	assert((2500u == freqs[1]) && (10000u == freqs[2]) && (5000u == freqs[3]));
+	assert(5833u == freqs[0]);
+
+	// No known frequency leaves snapshot unsampled
+	writeFreqFile(0, "scaling_cur_freq", "x\n");
+	writeFreqFile(1, "scaling_cur_freq", "\n");
+	writeFreqFile(2, "scaling_cur_freq", "\n");
+	assert(!CpuFreqSampler_read(sampler, freqs));
+	assert(CPUFREQ_UNKNOWN == freqs[0]);
+
+	CpuFreqSampler_destroy(sampler);
+	CpuFreqSampler_destroy(NULL);
+
+	for (int cpu = 0; cpu < TEST_CPU_COUNT; ++cpu)
+	{
+		removeCpu(cpu);
+	}
+}
+
+
+int main(void)
+{
+	TestFs_create("cut_cpufreq");
+	CpuCount_override(TEST_CPU_COUNT);
+
+	test_CpuFreq_mean();
+	test_CpuFreqSampler();
+
+	assert(TestFs_remove("cpu"));
+	TestFs_destroy();
+	return 0;
+}
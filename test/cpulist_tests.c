@@ -0,0 +1,268 @@
+#include "cpulist.h"
+#include "cpumap.h"
+#include "cpucount.h"
+#include "procstat.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define TEST_HOST_CPU_COUNT 	32u
+#define TEST_PATH_MAX 			256u
+#define TEST_LONG_LINE_VALUES 	20000u
+
+
+static void assertList(const char* text, const uint32_t* expected, size_t expectedLength)
+{
+	CpuList_t* list = CpuList_parse(text);
+	assert(NULL != list);
+	assert(expectedLength == list->length);
+	assert(0 == memcmp(expected, list->cpus, expectedLength * sizeof(uint32_t)));
+	CpuList_destroy(list);
+}
+
+
+static void test_CpuList_parse(void)
+{
+	assertList("5", (const uint32_t[]) { 5 }, 1u);
+	assertList("0-3,8,16-18\n", (const uint32_t[]) { 0, 1, 2, 3, 8, 16, 17, 18 }, 8u);
+	// Entries are sorted and merged
+	assertList(" 9,2-4,3,1-2 ", (const uint32_t[]) { 1, 2, 3, 4, 9 }, 5u);
+
+	const char* const INVALID[] =
+	{
+		"", "\n", "a", "1,", ",1", "1,,2", "3-1", "1-", "-1", "1-2-3", "1 2", "0x1", "65536"
+	};
+
+	for (size_t ii = 0; ii < sizeof(INVALID) / sizeof(INVALID[0]); ++ii)
+	{
+		assert(NULL == CpuList_parse(INVALID[ii]));
+	}
+
+	// Calling thread is allowed to run on at least one processor
+	CpuList_t* affinity = CpuList_fromSpec(CPULIST_SPEC_AFFINITY);
+	assert((NULL != affinity) && (0u < affinity->length));
+	CpuList_destroy(affinity);
+}
+
+
+static void test_ProcStat_parseSelected(void)
+{
+	// Line of every processor has it's number as the first value, total line has different values than sum of them
+	char* text = NULL;
+	size_t textSize = 0u;
+	FILE* stream = open_memstream(&text, &textSize);
+	assert(NULL != stream);
+	fprintf(stream, "cpu  1 1 1 1 1 1 1 1 1 1\n");
+
+	for (unsigned ii = 0; ii < TEST_HOST_CPU_COUNT; ++ii)
+	{
+		fprintf(stream, "cpu%u %u 10 0 100 0 0 0 0 0 0\n", ii, ii);
+	}
+
+	fprintf(stream, "intr 12345 0 0\nctxt 42\n");
+	fclose(stream);
+
+	CpuList_t* selection = CpuList_parse("2,7-8,31");
+	assert(NULL != selection);
+	CpuCount_select(selection->cpus, selection->length);
+	assert(4 == CpuCount_get());
+	assert(31 == CpuCount_getCpuId(3));
+
+	// Buffers are sized to selected processors
+	assert(ProcStat_size() == sizeof(ProcStat_t) + 5u * (sizeof(CpuStat_t) + sizeof(CpuFreqValue_t)));
+
+	ProcStat_t* stat = ProcStat_parse(text);
+	assert(NULL != stat);
+	assert(5u == stat->cpuStatsLength);
+	assert(2u == stat->cpuStats[1].values[CSINDEX_USER]);
+	assert(7u == stat->cpuStats[2].values[CSINDEX_USER]);
+	assert(8u == stat->cpuStats[3].values[CSINDEX_USER]);
+	assert(31u == stat->cpuStats[4].values[CSINDEX_USER]);
+
+	// Total line is summed up from selected processors
+	assert(48u == stat->cpuStats[0].values[CSINDEX_USER]);
+	assert(40u == stat->cpuStats[0].values[CSINDEX_NICE]);
+	assert(400u == stat->cpuStats[0].values[CSINDEX_IDLE]);
+	assert(0u == stat->cpuStats[0].values[CSINDEX_STEAL]);
+	ProcStat_destroy(stat);
+	CpuList_destroy(selection);
+
+	// Selected processor missing from the file is offline
+	selection = CpuList_parse("4,32");
+	assert(NULL != selection);
+	CpuCount_select(selection->cpus, selection->length);
+	stat = ProcStat_parse(text);
+	assert(NULL != stat);
+	assert(4u == stat->cpuStats[1].values[CSINDEX_USER]);
+	assert(0 == memcmp(&stat->cpuStats[2], &(CpuStat_t) { { 0 } }, sizeof(CpuStat_t)));
+	assert(4u == stat->cpuStats[0].values[CSINDEX_USER]);
+	ProcStat_destroy(stat);
+
+	CpuCount_select(NULL, 0u);
+	CpuList_destroy(selection);
+	free(text);
+}
+
+
+static void writeFile(const char* path, const char* content)
+{
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fputs(content, file);
+	fclose(file);
+}
+
+
+static void test_ProcStat_readKeyed(void)
+{
+	// Processors 2 and 4 are offline, 6 and 7 have not been hot-added yet, and the line following "cpuN" ones
+	// is longer than a single read, so that only it's beginning is parsed and the rest skipped
+	char root[] = "/tmp/cut_cpulist_XXXXXX";
+	char path[TEST_PATH_MAX];
+	assert(NULL != mkdtemp(root));
+	snprintf(path, sizeof(path), "%s/stat", root);
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fprintf(file, "cpu  9 10 0 400 0 0 0 0 0 0\n");
+
+	for (unsigned ii = 0; ii < 6u; ++ii)
+	{
+		if ((2u != ii) && (4u != ii))
+		{
+			fprintf(file, "cpu%u %u 10 0 100 0 0 0 0 0 0\n", ii, ii);
+		}
+	}
+
+	fputs("intr 1", file);
+
+	for (unsigned ii = 0; ii < TEST_LONG_LINE_VALUES; ++ii)
+	{
+		fputs(" 0", file);
+	}
+
+	fputs("\nctxt 42\nbtime 1700000000\nprocesses 99\nprocs_running 3\nprocs_blocked 1\nsoftirq 7 1 2 3\n", file);
+	fclose(file);
+	snprintf(path, sizeof(path), "%s/loadavg", root);
+	writeFile(path, "1.25 0.50 0.07 3/120 4567\n");
+	snprintf(path, sizeof(path), "%s/stat", root);
+
+	CpuCount_override(8);
+	ProcStat_setProcRoot(root);
+	ProcStat_t* stat = ProcStat_loadFromFile();
+	assert(NULL != stat);
+	assert(9u == stat->cpuStatsLength);
+	assert(9u == stat->cpuStats[0].values[CSINDEX_USER]);
+
+	for (unsigned ii = 0; ii < 8u; ++ii)
+	{
+		const bool online = (2u != ii) && (4u != ii) && (6u > ii);
+		assert((online ? ii : 0u) == stat->cpuStats[ii + 1u].values[CSINDEX_USER]);
+		assert((online ? 100u : 0u) == stat->cpuStats[ii + 1u].values[CSINDEX_IDLE]);
+	}
+
+	assert(1u == stat->sched.interrupts);
+	assert(42u == stat->sched.contextSwitches);
+	assert((3u == stat->sched.procsRunning) && (1u == stat->sched.procsBlocked));
+	assert(SCHEDSTAT_HAVE_COUNTERS == stat->sched.flags);
+
+	// Files next to the stat one are read separately, missing pressure file leaves it's part unsampled
+	const int loadAvgFd = ProcStat_openSibling("loadavg");
+	const int pressureFd = ProcStat_openSibling("pressure/cpu");
+	assert((0 <= loadAvgFd) && (0 > pressureFd));
+	assert(SchedStat_readLoadAvg(loadAvgFd, &stat->sched));
+	assert(!SchedStat_readPressure(pressureFd, &stat->sched));
+	assert((125u == stat->sched.loadAvg[0]) && (50u == stat->sched.loadAvg[1]) && (7u == stat->sched.loadAvg[2]));
+	assert((SCHEDSTAT_HAVE_COUNTERS | SCHEDSTAT_HAVE_LOADAVG) == stat->sched.flags);
+	close(loadAvgFd);
+
+	snprintf(path, sizeof(path), "%s/pressure", root);
+	assert(0 == mkdir(path, 0700));
+	snprintf(path, sizeof(path), "%s/pressure/cpu", root);
+	writeFile(path, "some avg10=1.00 avg60=0.50 avg300=0.10 total=123456\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=789\n");
+	const int newPressureFd = ProcStat_openSibling("pressure/cpu");
+	assert(SchedStat_readPressure(newPressureFd, &stat->sched));
+	assert((123456u == stat->sched.pressureSomeUs) && (789u == stat->sched.pressureFullUs));
+	assert(0u != (SCHEDSTAT_HAVE_PRESSURE & stat->sched.flags));
+	close(newPressureFd);
+	assert(0 == unlink(path));
+	snprintf(path, sizeof(path), "%s/pressure", root);
+	assert(0 == rmdir(path));
+	snprintf(path, sizeof(path), "%s/loadavg", root);
+	assert(0 == unlink(path));
+	snprintf(path, sizeof(path), "%s/stat", root);
+
+	ProcStat_destroy(stat);
+
+	// Anything but total "cpu" line first is not a valid file
+	writeFile(path, "cpu0 1 2 3 4 5 6 7 8 9 10\n");
+	assert(NULL == ProcStat_loadFromFile());
+	writeFile(path, "intr 1\n");
+	assert(NULL == ProcStat_loadFromFile());
+
+	ProcStat_setProcRoot(NULL);
+	CpuCount_override(TEST_HOST_CPU_COUNT);
+	assert(0 == unlink(path));
+	assert(0 == rmdir(root));
+}
+
+
+static void test_CpuMap(void)
+{
+	char root[] = "/tmp/cut_cpumap_XXXXXX";
+	char dir[TEST_PATH_MAX];
+	char online[TEST_PATH_MAX];
+	char possible[TEST_PATH_MAX];
+	assert(NULL != mkdtemp(root));
+	snprintf(dir, sizeof(dir), "%s/cpu", root);
+	snprintf(online, sizeof(online), "%s/cpu/online", root);
+	snprintf(possible, sizeof(possible), "%s/cpu/possible", root);
+
+	assert(NULL == CpuMap_create(root));
+	assert(0 == CpuMap_getPossibleCount(root));
+	assert(0 == mkdir(dir, 0700));
+	writeFile(online, "0-3\n");
+	writeFile(possible, "0-7\n");
+	assert(8 == CpuMap_getPossibleCount(root));
+
+	CpuMap_t* map = CpuMap_create(root);
+	assert(NULL != map);
+	assert(0u == CpuMap_getEpoch(map));
+	assert(4u == CpuMap_getOnline(map)->length);
+	assert(0 == CpuMap_refresh(map));
+
+	// Every change of the set advances epoch once
+	writeFile(online, "0-1,3\n");
+	assert(1 == CpuMap_refresh(map));
+	assert(0 == CpuMap_refresh(map));
+	assert(1u == CpuMap_getEpoch(map));
+	assert(3u == CpuMap_getOnline(map)->length);
+	assert(3u == CpuMap_getOnline(map)->cpus[2]);
+
+	// Unreadable set leaves the map unchanged
+	writeFile(online, "x\n");
+	assert(0 > CpuMap_refresh(map));
+	assert(0 == unlink(online));
+	assert(0 > CpuMap_refresh(map));
+	assert(1u == CpuMap_getEpoch(map));
+	assert(3u == CpuMap_getOnline(map)->length);
+	CpuMap_destroy(map);
+
+	assert(0 == unlink(possible));
+	assert(0 == rmdir(dir));
+	assert(0 == rmdir(root));
+}
+
+
+int main(void)
+{
+	test_CpuList_parse();
+	test_ProcStat_parseSelected();
+	test_ProcStat_readKeyed();
+	test_CpuMap();
+	return 0;
+}
@@ -0,0 +1,637 @@
+#include "cpuusage.h"
+#include "cpucount.h"
+#include "procstat.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TEST_CPU_COUNT 		7
+#define TEST_BACKLOG_LENGTH 5u
+#define TEST_PERIOD_NS 		100000000ull
+#define TEST_MAX_TOTAL_TICKS 	1000u
+
+
+static ProcStat_t* backlogItem(ProcStat_t* backlog, size_t index)
+{
+	return (ProcStat_t*) ((char*) backlog + index * ProcStat_size());
+}
+
+
+static CpuUsageInfo_t* usageItem(CpuUsageInfo_t* usage, size_t index)
+{
+	return (CpuUsageInfo_t*) ((char*) usage + index * CpuUsageInfo_size());
+}
+
+
+static void fillSnapshot(ProcStat_t* stat, const ProcStat_t* previous, unsigned seed)
+{
+	stat->cpuStatsLength = TEST_CPU_COUNT + 1u;
+	stat->timestampNs = (NULL != previous) ? previous->timestampNs + TEST_PERIOD_NS : 1u;
+	memset(&stat->stamps, 0, sizeof(stat->stamps));
+	memset(&stat->sched, 0, sizeof(stat->sched));
+	stat->freqsLength = 0u;
+
+	for (size_t ii = 0; ii < stat->cpuStatsLength; ++ii)
+	{
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			const CpuStatValue_t base = (NULL != previous) ? previous->cpuStats[ii].values[jj] : 1000u * jj;
+			// Last processor never advances, so that it's usage is reported as invalid
+			const CpuStatValue_t step = (TEST_CPU_COUNT == ii) ? 0u : (CpuStatValue_t) ((seed * 31u + ii * 7u + jj * 13u) % 17u);
+			stat->cpuStats[ii].values[jj] = base + step;
+		}
+	}
+}
+
+
+static void test_CpuUsageInfo_calculateMany(void)
+{
+	ProcStat_t* oldStat = malloc(ProcStat_size());
+	ProcStat_t* backlog = malloc(TEST_BACKLOG_LENGTH * ProcStat_size());
+	CpuUsageInfo_t* batchUsage = malloc(TEST_BACKLOG_LENGTH * CpuUsageInfo_size());
+	CpuUsageInfo_t* singleUsage = malloc(CpuUsageInfo_size());
+	assert((NULL != oldStat) && (NULL != backlog) && (NULL != batchUsage) && (NULL != singleUsage));
+
+	fillSnapshot(oldStat, NULL, 0u);
+
+	for (size_t kk = 0; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		fillSnapshot(backlogItem(backlog, kk), (0u == kk) ? oldStat : backlogItem(backlog, kk - 1u), (unsigned) kk + 1u);
+	}
+
+	CpuUsageInfo_calculateMany(oldStat, backlog, TEST_BACKLOG_LENGTH, batchUsage);
+
+	// Every interval calculated in a single pass is identical to one calculated on it's own
+	for (size_t kk = 0; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		const ProcStat_t* prev = (0u == kk) ? oldStat : backlogItem(backlog, kk - 1u);
+		CpuUsageInfo_calculate(prev, backlogItem(backlog, kk), singleUsage);
+
+		const CpuUsageInfo_t* batched = usageItem(batchUsage, kk);
+		assert(singleUsage->valuesLength == batched->valuesLength);
+		assert(TEST_PERIOD_NS == batched->intervalNs);
+		assert(0 == memcmp(singleUsage->values, batched->values, singleUsage->valuesLength * sizeof(PercentageValue_t)));
+		assert(batched->values[TEST_CPU_COUNT] < 0.0);
+	}
+
+	// Coalesced interval covers the whole backlog
+	CpuUsageInfo_calculate(oldStat, backlogItem(backlog, TEST_BACKLOG_LENGTH - 1u), singleUsage);
+	assert(TEST_BACKLOG_LENGTH * TEST_PERIOD_NS == singleUsage->intervalNs);
+
+	for (size_t ii = 0; ii < TEST_CPU_COUNT; ++ii)
+	{
+		assert((singleUsage->values[ii] >= 0.0) && (singleUsage->values[ii] <= 100.0));
+	}
+
+	free(singleUsage);
+	free(batchUsage);
+	free(backlog);
+	free(oldStat);
+}
+
+
+static void test_ProcStatDelta(void)
+{
+	ProcStat_t* oldStat = malloc(ProcStat_size());
+	ProcStat_t* backlog = malloc(TEST_BACKLOG_LENGTH * ProcStat_size());
+	ProcStatDelta_t* deltas = malloc(TEST_BACKLOG_LENGTH * ProcStatDelta_size());
+	CpuUsageInfo_t* fromSnapshots = malloc(CpuUsageInfo_size());
+	CpuUsageInfo_t* fromDelta = malloc(CpuUsageInfo_size());
+	assert((NULL != oldStat) && (NULL != backlog) && (NULL != deltas) && (NULL != fromSnapshots) && (NULL != fromDelta));
+
+	// Delta carries half the counter data of a snapshot, along with the same amount of frequencies
+	const size_t freqsSize = (TEST_CPU_COUNT + 1u) * sizeof(CpuFreqValue_t);
+	assert(2u * (ProcStatDelta_size() - sizeof(ProcStatDelta_t) - freqsSize) == ProcStat_size() - sizeof(ProcStat_t) - freqsSize);
+
+	fillSnapshot(oldStat, NULL, 0u);
+
+	for (size_t kk = 0; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		const ProcStat_t* prev = (0u == kk) ? oldStat : backlogItem(backlog, kk - 1u);
+		fillSnapshot(backlogItem(backlog, kk), prev, (unsigned) kk + 1u);
+		ProcStatDelta_t* delta = (ProcStatDelta_t*) ((char*) deltas + kk * ProcStatDelta_size());
+		ProcStatDelta_encode(prev, backlogItem(backlog, kk), delta);
+
+		// Usage calculated from change is identical to one calculated from snapshots
+		CpuUsageInfo_calculate(prev, backlogItem(backlog, kk), fromSnapshots);
+		CpuUsageInfo_calculateFromDelta(delta, fromDelta);
+		assert(fromSnapshots->valuesLength == fromDelta->valuesLength);
+		assert(fromSnapshots->intervalNs == fromDelta->intervalNs);
+		assert(0 == memcmp(fromSnapshots->values, fromDelta->values, fromSnapshots->valuesLength * sizeof(PercentageValue_t)));
+	}
+
+	// Merged changes span the whole backlog, same as the coalesced interval
+	for (size_t kk = 1; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		ProcStatDelta_merge(deltas, (ProcStatDelta_t*) ((char*) deltas + kk * ProcStatDelta_size()));
+	}
+
+	CpuUsageInfo_calculate(oldStat, backlogItem(backlog, TEST_BACKLOG_LENGTH - 1u), fromSnapshots);
+	CpuUsageInfo_calculateFromDelta(deltas, fromDelta);
+	assert(fromSnapshots->intervalNs == fromDelta->intervalNs);
+	assert(0 == memcmp(fromSnapshots->values, fromDelta->values, fromSnapshots->valuesLength * sizeof(PercentageValue_t)));
+
+	// Counters going backwards are treated as unchanged, overly large changes saturate
+	backlogItem(backlog, 0u)->cpuStats[0].values[CSINDEX_USER] = 0u;
+	backlogItem(backlog, 0u)->cpuStats[1].values[CSINDEX_USER] = oldStat->cpuStats[1].values[CSINDEX_USER] + (1ull << 40);
+	ProcStatDelta_encode(oldStat, backlogItem(backlog, 0u), deltas);
+	assert(0u == deltas->cpuDeltas[0].values[CSINDEX_USER]);
+	assert(UINT32_MAX == deltas->cpuDeltas[1].values[CSINDEX_USER]);
+
+	free(fromDelta);
+	free(fromSnapshots);
+	free(deltas);
+	free(backlog);
+	free(oldStat);
+}
+
+
+static char* printToString(const void* usage, bool compact)
+{
+	char* text = NULL;
+	size_t textSize = 0u;
+	FILE* stream = open_memstream(&text, &textSize);
+	assert(NULL != stream);
+
+	if (compact)
+	{
+		CpuUsageCompact_print(stream, usage);
+	}
+	else
+	{
+		CpuUsageInfo_print(stream, usage);
+	}
+
+	fclose(stream);
+	return text;
+}
+
+
+static void test_CpuUsageCompact(void)
+{
+	ProcStat_t* oldStat = malloc(ProcStat_size());
+	ProcStat_t* newStat = malloc(ProcStat_size());
+	ProcStat_t* backlog = malloc(TEST_BACKLOG_LENGTH * ProcStat_size());
+	ProcStatDelta_t* delta = malloc(ProcStatDelta_size());
+	CpuUsageInfo_t* usage = malloc(CpuUsageInfo_size());
+	CpuUsageCompact_t* compact = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* fromDelta = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* batchCompact = malloc(TEST_BACKLOG_LENGTH * CpuUsageCompact_size());
+	assert((NULL != oldStat) && (NULL != newStat) && (NULL != backlog) && (NULL != delta));
+	assert((NULL != usage) && (NULL != compact) && (NULL != fromDelta) && (NULL != batchCompact));
+
+	// Room for frequency-weighted usage is only reserved on request
+	assert(4u * (CpuUsageCompact_size() - sizeof(CpuUsageCompact_t)) == CpuUsageInfo_size() - sizeof(CpuUsageInfo_t));
+
+	// Every split of every interval length up to the limit, on every processor line at once
+	fillSnapshot(oldStat, NULL, 0u);
+	memcpy(newStat, oldStat, ProcStat_size());
+	newStat->timestampNs += TEST_PERIOD_NS;
+
+	for (CpuStatValue_t total = 1u; total <= TEST_MAX_TOTAL_TICKS; ++total)
+	{
+		for (CpuStatValue_t busy = 0u; busy <= total; ++busy)
+		{
+			for (size_t ii = 0; ii < newStat->cpuStatsLength; ++ii)
+			{
+				newStat->cpuStats[ii].values[CSINDEX_USER] = oldStat->cpuStats[ii].values[CSINDEX_USER] + busy;
+				newStat->cpuStats[ii].values[CSINDEX_IDLE] = oldStat->cpuStats[ii].values[CSINDEX_IDLE] + (total - busy);
+			}
+
+			CpuUsageInfo_calculate(oldStat, newStat, usage);
+			CpuUsageCompact_calculate(oldStat, newStat, compact);
+			assert(usage->valuesLength == compact->valuesLength);
+			assert(usage->intervalNs == compact->intervalNs);
+
+			// Value exactly halfway between two basis points may be rounded either way by floating-point path
+			const bool tie = ((busy * 2u * CPUUSAGE_BP_FULL) % (2u * total)) == total;
+			const long expected = (long) (usage->values[1] * 100.0 + 0.5);
+			const long actual = compact->values[1];
+			assert(tie ? ((actual - expected <= 1) && (expected - actual <= 1)) : (actual == expected));
+
+			if (!tie)
+			{
+				char* usageText = printToString(usage, false);
+				char* compactText = printToString(compact, true);
+				assert(0 == strcmp(usageText, compactText));
+				free(compactText);
+				free(usageText);
+			}
+		}
+	}
+
+	// Batch and delta variants agree with single interval calculation, invalid values are printed the same way
+	for (size_t kk = 0; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		fillSnapshot(backlogItem(backlog, kk), (0u == kk) ? oldStat : backlogItem(backlog, kk - 1u), (unsigned) kk + 1u);
+	}
+
+	CpuUsageCompact_calculateMany(oldStat, backlog, TEST_BACKLOG_LENGTH, batchCompact);
+
+	for (size_t kk = 0; kk < TEST_BACKLOG_LENGTH; ++kk)
+	{
+		const ProcStat_t* prev = (0u == kk) ? oldStat : backlogItem(backlog, kk - 1u);
+		const CpuUsageCompact_t* batchItem = (const CpuUsageCompact_t*) ((const char*) batchCompact + kk * CpuUsageCompact_size());
+		CpuUsageCompact_calculate(prev, backlogItem(backlog, kk), compact);
+		assert(compact->intervalNs == batchItem->intervalNs);
+		assert(0 == memcmp(compact->values, batchItem->values, compact->valuesLength * sizeof(BasisPointValue_t)));
+		assert(CPUUSAGE_BP_INVALID == compact->values[TEST_CPU_COUNT]);
+
+		ProcStatDelta_encode(prev, backlogItem(backlog, kk), delta);
+		CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+		assert(compact->intervalNs == fromDelta->intervalNs);
+		assert(0 == memcmp(compact->values, fromDelta->values, compact->valuesLength * sizeof(BasisPointValue_t)));
+	}
+
+	CpuUsageInfo_calculate(backlogItem(backlog, 0u), backlogItem(backlog, 0u), usage);
+	CpuUsageCompact_calculate(backlogItem(backlog, 0u), backlogItem(backlog, 0u), compact);
+	char* usageText = printToString(usage, false);
+	char* compactText = printToString(compact, true);
+	assert(0 == strcmp(usageText, compactText));
+	free(compactText);
+	free(usageText);
+
+	free(batchCompact);
+	free(fromDelta);
+	free(compact);
+	free(usage);
+	free(delta);
+	free(backlog);
+	free(newStat);
+	free(oldStat);
+}
+
+
+static void test_CpuUsage_hotplug(void)
+{
+	// Processor of slot 2 goes offline in the second snapshot and comes back in the third,
+	// processor of slot 3 comes online in the second one
+	ProcStat_t* stats = malloc(3u * ProcStat_size());
+	ProcStatDelta_t* delta = malloc(ProcStatDelta_size());
+	ProcStatDelta_t* nextDelta = malloc(ProcStatDelta_size());
+	CpuUsageInfo_t* usage = malloc(CpuUsageInfo_size());
+	CpuUsageCompact_t* compact = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* fromDelta = malloc(CpuUsageCompact_size());
+	assert((NULL != stats) && (NULL != delta) && (NULL != nextDelta));
+	assert((NULL != usage) && (NULL != compact) && (NULL != fromDelta));
+
+	fillSnapshot(backlogItem(stats, 0u), NULL, 0u);
+	fillSnapshot(backlogItem(stats, 1u), backlogItem(stats, 0u), 1u);
+	fillSnapshot(backlogItem(stats, 2u), backlogItem(stats, 1u), 2u);
+	memset(&backlogItem(stats, 1u)->cpuStats[2], 0, sizeof(CpuStat_t));
+	memset(&backlogItem(stats, 0u)->cpuStats[3], 0, sizeof(CpuStat_t));
+
+	for (size_t kk = 0; kk < 3u; ++kk)
+	{
+		backlogItem(stats, kk)->onlineEpoch = (0u == kk) ? 0u : 1u;
+	}
+
+	CpuUsageCompact_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), compact);
+	assert(CPUUSAGE_BP_OFFLINE == compact->values[2]);
+	assert(CPUUSAGE_BP_INVALID == compact->values[3]);
+	assert(CPUUSAGE_BP_FULL >= compact->values[1]);
+	assert(1u == compact->onlineEpoch);
+
+	CpuUsageInfo_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), usage);
+	assert((0.0 > usage->values[2]) && (0.0 > usage->values[3]) && (0.0 <= usage->values[1]));
+
+	// Offline processors are left out of printed statistics
+	char* text = printToString(compact, true);
+	assert(NULL == strstr(text, "CPU1:"));
+	assert(NULL != strstr(text, "CPU2:"));
+	free(text);
+
+	ProcStatDelta_encode(backlogItem(stats, 0u), backlogItem(stats, 1u), delta);
+	assert(1u == delta->onlineEpoch);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(0 == memcmp(compact->values, fromDelta->values, compact->valuesLength * sizeof(BasisPointValue_t)));
+	CpuUsageInfo_calculateFromDelta(delta, usage);
+	assert(0.0 > usage->values[2]);
+
+	// Processor back online has no usage until the following interval, merged intervals only cover the later one
+	CpuUsageCompact_calculate(backlogItem(stats, 1u), backlogItem(stats, 2u), compact);
+	assert(CPUUSAGE_BP_INVALID == compact->values[2]);
+	ProcStatDelta_encode(backlogItem(stats, 1u), backlogItem(stats, 2u), nextDelta);
+	CpuUsageCompact_calculateFromDelta(nextDelta, fromDelta);
+	assert(0 == memcmp(compact->values, fromDelta->values, compact->valuesLength * sizeof(BasisPointValue_t)));
+
+	ProcStatDelta_merge(delta, nextDelta);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(CPUUSAGE_BP_INVALID == fromDelta->values[2]);
+	assert(compact->values[3] == fromDelta->values[3]);
+
+	ProcStatDelta_encode(backlogItem(stats, 0u), backlogItem(stats, 1u), nextDelta);
+	ProcStatDelta_merge(delta, nextDelta);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(CPUUSAGE_BP_OFFLINE == fromDelta->values[2]);
+
+	free(fromDelta);
+	free(compact);
+	free(usage);
+	free(nextDelta);
+	free(delta);
+	free(stats);
+}
+
+
+static void test_SchedUsage(void)
+{
+	const uint32_t allFlags = SCHEDSTAT_HAVE_COUNTERS | SCHEDSTAT_HAVE_PRESSURE | SCHEDSTAT_HAVE_LOADAVG;
+	ProcStat_t* stats = malloc(3u * ProcStat_size());
+	ProcStatDelta_t* delta = malloc(ProcStatDelta_size());
+	ProcStatDelta_t* nextDelta = malloc(ProcStatDelta_size());
+	CpuUsageCompact_t* compact = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* fromDelta = malloc(CpuUsageCompact_size());
+	assert((NULL != stats) && (NULL != delta) && (NULL != nextDelta) && (NULL != compact) && (NULL != fromDelta));
+
+	for (size_t kk = 0; kk < 3u; ++kk)
+	{
+		fillSnapshot(backlogItem(stats, kk), (0u == kk) ? NULL : backlogItem(stats, kk - 1u), (unsigned) kk);
+	}
+
+	backlogItem(stats, 0u)->sched = (SchedStat_t)
+	{
+		.contextSwitches = 1000u, .interrupts = 500u, .pressureSomeUs = 7000u, .pressureFullUs = 3000u,
+		.procsRunning = 1u, .loadAvg = { 10u, 20u, 30u }, .flags = allFlags
+	};
+
+	// A quarter of the period stalled, one tenth fully
+	backlogItem(stats, 1u)->sched = (SchedStat_t)
+	{
+		.contextSwitches = 6000u, .interrupts = 2500u, .pressureSomeUs = 32000u, .pressureFullUs = 13000u,
+		.procsRunning = 4u, .procsBlocked = 2u, .loadAvg = { 150u, 120u, 105u }, .flags = allFlags
+	};
+
+	// Counter going backwards is unchanged, part missing from either snapshot is not reported
+	backlogItem(stats, 2u)->sched = (SchedStat_t)
+	{
+		.contextSwitches = 5000u, .interrupts = 4500u, .procsRunning = 3u, .loadAvg = { 160u, 125u, 106u },
+		.flags = SCHEDSTAT_HAVE_COUNTERS | SCHEDSTAT_HAVE_LOADAVG
+	};
+
+	CpuUsageCompact_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), compact);
+	assert(50000u == compact->sched.contextSwitchesPerSec);
+	assert(20000u == compact->sched.interruptsPerSec);
+	assert(2500u == compact->sched.pressureSomeBp);
+	assert(1000u == compact->sched.pressureFullBp);
+	assert((4u == compact->sched.procsRunning) && (2u == compact->sched.procsBlocked));
+	assert((150u == compact->sched.loadAvg[0]) && (105u == compact->sched.loadAvg[2]));
+	assert(allFlags == compact->sched.flags);
+
+	ProcStatDelta_encode(backlogItem(stats, 0u), backlogItem(stats, 1u), delta);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(0 == memcmp(&compact->sched, &fromDelta->sched, sizeof(SchedUsage_t)));
+
+	CpuUsageCompact_calculate(backlogItem(stats, 1u), backlogItem(stats, 2u), compact);
+	assert(0u == compact->sched.contextSwitchesPerSec);
+	assert(20000u == compact->sched.interruptsPerSec);
+	assert((SCHEDSTAT_HAVE_COUNTERS | SCHEDSTAT_HAVE_LOADAVG) == compact->sched.flags);
+
+	// Counters of merged changes add up over both intervals, gauges are those at the end
+	ProcStatDelta_encode(backlogItem(stats, 1u), backlogItem(stats, 2u), nextDelta);
+	ProcStatDelta_merge(delta, nextDelta);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(25000u == fromDelta->sched.contextSwitchesPerSec);
+	assert(20000u == fromDelta->sched.interruptsPerSec);
+	assert(3u == fromDelta->sched.procsRunning);
+	assert((SCHEDSTAT_HAVE_COUNTERS | SCHEDSTAT_HAVE_LOADAVG) == fromDelta->sched.flags);
+
+	char buf[512];
+	FILE* out = fmemopen(buf, sizeof(buf), "w");
+	assert(NULL != out);
+	CpuUsageCompact_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), compact);
+	CpuUsageCompact_printSched(out, compact);
+	fclose(out);
+	assert(0 == strcmp(buf,
+		"Run queue:\t4 running, 2 blocked\n"
+		"Load average:\t1.50 1.20 1.05\n"
+		"CPU pressure:\tsome 25.00 %, full 10.00 %\n"
+		"Context switches:\t50000 /s, interrupts 20000 /s\n"));
+
+	// Nothing sampled, nothing printed
+	out = fmemopen(buf, sizeof(buf), "w");
+	assert(NULL != out);
+	compact->sched.flags = 0u;
+	CpuUsageCompact_printSched(out, compact);
+	fflush(out);
+	assert(0 == ftell(out));
+	fclose(out);
+
+	free(fromDelta);
+	free(compact);
+	free(nextDelta);
+	free(delta);
+	free(stats);
+}
+
+
+/**
+ * \brief Sets frequency of every processor of snapshot, leaving the second one unknown, and mean of the rest first.
+*/
+static void fillFreqs(ProcStat_t* stat, CpuFreqValue_t base)
+{
+	CpuFreqValue_t* freqs = ProcStat_getFreqs(stat);
+	unsigned long sum = 0u;
+
+	for (size_t ii = 1; ii < stat->cpuStatsLength; ++ii)
+	{
+		freqs[ii] = (2u == ii) ? CPUFREQ_UNKNOWN : (CpuFreqValue_t) (base + 500u * ii);
+		sum += (2u == ii) ? 0u : freqs[ii];
+	}
+
+	freqs[0] = (CpuFreqValue_t) (sum / (stat->cpuStatsLength - 2u));
+	stat->freqsLength = stat->cpuStatsLength;
+}
+
+
+/**
+ * \brief Checks frequency-weighted usage against usage and given frequencies, unknown ones counting as full.
+*/
+static void checkEffective(const CpuUsageCompact_t* compact, const CpuFreqValue_t* freqs)
+{
+	const BasisPointValue_t* effective = compact->values + compact->valuesLength;
+	unsigned long sum = 0u;
+	unsigned long valid = 0u;
+	assert(compact->effectiveLength == compact->valuesLength);
+
+	for (size_t ii = 1; ii < compact->valuesLength; ++ii)
+	{
+		const unsigned long freq = (CPUFREQ_UNKNOWN == freqs[ii]) ? CPUUSAGE_BP_FULL : freqs[ii];
+
+		if (CPUUSAGE_BP_FULL < compact->values[ii])
+		{
+			assert(effective[ii] == compact->values[ii]);
+			continue;
+		}
+
+		assert(effective[ii] == (compact->values[ii] * freq + CPUUSAGE_BP_FULL / 2u) / CPUUSAGE_BP_FULL);
+		assert(effective[ii] <= compact->values[ii]);
+		sum += effective[ii];
+		++valid;
+	}
+
+	assert(effective[0] == (sum + valid / 2u) / valid);
+}
+
+
+static void test_EffectiveUsage(void)
+{
+	const size_t unreservedSize = CpuUsageCompact_size();
+	CpuUsageCompact_reserveEffective(true);
+	assert(CpuUsageCompact_size() == unreservedSize + (TEST_CPU_COUNT + 1u) * sizeof(BasisPointValue_t));
+
+	ProcStat_t* stats = malloc(3u * ProcStat_size());
+	ProcStatDelta_t* delta = malloc(ProcStatDelta_size());
+	ProcStatDelta_t* nextDelta = malloc(ProcStatDelta_size());
+	CpuUsageCompact_t* compact = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* fromDelta = malloc(CpuUsageCompact_size());
+	CpuUsageCompact_t* batchCompact = malloc(2u * CpuUsageCompact_size());
+	assert((NULL != stats) && (NULL != delta) && (NULL != nextDelta) && (NULL != compact) && (NULL != fromDelta) && (NULL != batchCompact));
+
+	for (size_t kk = 0; kk < 3u; ++kk)
+	{
+		fillSnapshot(backlogItem(stats, kk), (0u == kk) ? NULL : backlogItem(stats, kk - 1u), (unsigned) kk);
+	}
+
+	// No frequencies, no weighted usage
+	CpuUsageCompact_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), compact);
+	assert(0u == compact->effectiveLength);
+	ProcStatDelta_encode(backlogItem(stats, 0u), backlogItem(stats, 1u), delta);
+	assert(0u == delta->freqsLength);
+
+	// Frequencies of the newer snapshot alone are used if the older one has none
+	fillFreqs(backlogItem(stats, 1u), 3000u);
+	fillFreqs(backlogItem(stats, 2u), 5000u);
+	CpuUsageCompact_calculate(backlogItem(stats, 0u), backlogItem(stats, 1u), compact);
+	checkEffective(compact, ProcStat_getFreqs(backlogItem(stats, 1u)));
+
+	ProcStatDelta_encode(backlogItem(stats, 0u), backlogItem(stats, 1u), delta);
+	assert(TEST_CPU_COUNT + 1u == delta->freqsLength);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(0 == memcmp(compact->values, fromDelta->values, 2u * compact->valuesLength * sizeof(BasisPointValue_t)));
+
+	// Otherwise mean of both ends of the interval
+	CpuUsageCompact_calculate(backlogItem(stats, 1u), backlogItem(stats, 2u), compact);
+	ProcStatDelta_encode(backlogItem(stats, 1u), backlogItem(stats, 2u), nextDelta);
+	const CpuFreqValue_t* meanFreqs = ProcStatDelta_getFreqs(nextDelta);
+	assert((3500u + 5500u) / 2u == meanFreqs[1]);
+	assert(CPUFREQ_UNKNOWN == meanFreqs[2]);
+	checkEffective(compact, meanFreqs);
+
+	CpuUsageCompact_calculateFromDelta(nextDelta, fromDelta);
+	assert(0 == memcmp(compact->values, fromDelta->values, 2u * compact->valuesLength * sizeof(BasisPointValue_t)));
+
+	CpuUsageCompact_calculateMany(backlogItem(stats, 0u), backlogItem(stats, 1u), 2u, batchCompact);
+	const CpuUsageCompact_t* lastBatched = (const CpuUsageCompact_t*) ((const char*) batchCompact + CpuUsageCompact_size());
+	assert(lastBatched->effectiveLength == compact->effectiveLength);
+	assert(0 == memcmp(compact->values, lastBatched->values, 2u * compact->valuesLength * sizeof(BasisPointValue_t)));
+
+	// Merged changes weigh frequencies by length of their intervals
+	nextDelta->intervalNs = 3u * delta->intervalNs;
+	ProcStatDelta_merge(delta, nextDelta);
+	assert(TEST_CPU_COUNT + 1u == delta->freqsLength);
+	assert((3500u + 3u * 4500u) / 4u == ProcStatDelta_getFreqs(delta)[1]);
+	assert(CPUFREQ_UNKNOWN == ProcStatDelta_getFreqs(delta)[2]);
+
+	// Later change without frequencies drops them
+	nextDelta->freqsLength = 0u;
+	ProcStatDelta_merge(delta, nextDelta);
+	assert(0u == delta->freqsLength);
+	CpuUsageCompact_calculateFromDelta(delta, fromDelta);
+	assert(0u == fromDelta->effectiveLength);
+
+	char buf[1024];
+	FILE* out = fmemopen(buf, sizeof(buf), "w");
+	assert(NULL != out);
+	CpuUsageCompact_print(out, compact);
+	fclose(out);
+
+	char expected[64];
+	const BasisPointValue_t* effective = compact->values + compact->valuesLength;
+	snprintf(expected, sizeof(expected), "CPU0:\t%u.%02u %%, %u.%02u %% of capacity\n",
+		compact->values[1] / 100u, compact->values[1] % 100u, effective[1] / 100u, effective[1] % 100u);
+	assert(NULL != strstr(buf, expected));
+	assert(NULL != strstr(buf, "\nCPU6:\t-100.00 %, -100.00 % of capacity\n"));
+
+	// Frequencies are ignored unless room has been reserved for weighted usage
+	CpuUsageCompact_reserveEffective(false);
+	CpuUsageCompact_calculate(backlogItem(stats, 1u), backlogItem(stats, 2u), compact);
+	assert(0u == compact->effectiveLength);
+	ProcStatDelta_encode(backlogItem(stats, 1u), backlogItem(stats, 2u), nextDelta);
+	assert(0u != nextDelta->freqsLength);
+	CpuUsageCompact_calculateFromDelta(nextDelta, fromDelta);
+	assert(0u == fromDelta->effectiveLength);
+	CpuUsageCompact_calculateMany(backlogItem(stats, 0u), backlogItem(stats, 1u), 2u, batchCompact);
+	assert(0u == batchCompact->effectiveLength);
+
+	free(batchCompact);
+	free(fromDelta);
+	free(compact);
+	free(nextDelta);
+	free(delta);
+	free(stats);
+}
+
+
+static void test_CpuUsageInfo_maxDifference(void)
+{
+	CpuUsageInfo_t* a = calloc(1u, CpuUsageInfo_size());
+	CpuUsageInfo_t* b = calloc(1u, CpuUsageInfo_size());
+	assert((NULL != a) && (NULL != b));
+
+	// Largest change in either direction counts, lines with invalid usage are skipped
+	a->valuesLength = 4u;
+	b->valuesLength = 4u;
+	memcpy(a->values, (PercentageValue_t[]) { 50.0, 10.0, -1.0, 90.0 }, 4u * sizeof(PercentageValue_t));
+	memcpy(b->values, (PercentageValue_t[]) { 45.0, 22.5, 0.0, 85.0 }, 4u * sizeof(PercentageValue_t));
+	assert(12.5 == CpuUsageInfo_maxDifference(a, b));
+	assert(12.5 == CpuUsageInfo_maxDifference(b, a));
+	assert(0.0 == CpuUsageInfo_maxDifference(a, a));
+
+	// Only lines present in both are compared
+	a->values[3] = 0.0;
+	b->valuesLength = 3u;
+	assert(12.5 == CpuUsageInfo_maxDifference(a, b));
+	assert(0.0 == CpuUsageInfo_maxDifference(NULL, b));
+
+	// Usage of total line alone, as followed by adaptive sampling mode, is calculated from single line snapshots
+	ProcStat_t* oldTotal = calloc(1u, sizeof(ProcStat_t) + sizeof(CpuStat_t));
+	ProcStat_t* newTotal = calloc(1u, sizeof(ProcStat_t) + sizeof(CpuStat_t));
+	assert((NULL != oldTotal) && (NULL != newTotal));
+	oldTotal->cpuStatsLength = 1u;
+	newTotal->cpuStatsLength = 1u;
+	oldTotal->cpuStats[0].values[CSINDEX_USER] = 100u;
+	oldTotal->cpuStats[0].values[CSINDEX_IDLE] = 100u;
+	newTotal->cpuStats[0].values[CSINDEX_USER] = 130u;
+	newTotal->cpuStats[0].values[CSINDEX_IDLE] = 170u;
+	CpuUsageInfo_calculate(oldTotal, newTotal, a);
+	assert((1u == a->valuesLength) && (30.0 == a->values[0]));
+	b->valuesLength = 1u;
+	b->values[0] = 25.0;
+	assert(5.0 == CpuUsageInfo_maxDifference(a, b));
+
+	free(newTotal);
+	free(oldTotal);
+	free(b);
+	free(a);
+}
+
+
+int main(void)
+{
+	CpuCount_override(TEST_CPU_COUNT);
+	CpuCount_init();
+
+	test_CpuUsageInfo_calculateMany();
+	test_ProcStatDelta();
+	test_CpuUsageCompact();
+	test_CpuUsage_hotplug();
+	test_SchedUsage();
+	test_EffectiveUsage();
+	test_CpuUsageInfo_maxDifference();
+	return 0;
+}
@@ -0,0 +1,216 @@
+#include "flightrec.h"
+#include "watchdog.h"
+#include "threadctl.h"
+#include "cpucount.h"
+#include "procstat.h"
+#include "procgen.h"
+#include "helpers.h"
+#include <assert.h>
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+
+#define TEST_CPU_COUNT 			4u
+#define TEST_WINDOW_MS 			1000u
+#define TEST_PERIOD_MS 			20u
+#define TEST_CAPACITY 			(TEST_WINDOW_MS / TEST_PERIOD_MS)
+#define TEST_THRESHOLD_PCT 		90.0
+#define TEST_SATURATED_BP 		9500u
+#define TEST_POLL_MS 			10u
+#define TEST_DUMP_TIMEOUT_MS 	2000u
+// Dump file shows up once opened, before it has been written
+#define TEST_SETTLE_MS 			200u
+
+
+/**
+ * \brief Looks for dump of given trigger in given directory.
+ * \return True if found, with it's path written into path, false otherwise.
+*/
+static bool findDump(const char* dir, const char* triggerName, char* path, size_t pathSize)
+{
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), "_%s.bin", triggerName);
+	DIR* dp = opendir(dir);
+	assert(NULL != dp);
+	bool found = false;
+
+	for (struct dirent* entry = readdir(dp); (NULL != entry) && !found; entry = readdir(dp))
+	{
+		const size_t nameLength = strlen(entry->d_name);
+		const size_t suffixLength = strlen(suffix);
+		found = (0 == strncmp(entry->d_name, "cut_flightrec_", 14u)) && (nameLength > suffixLength)
+			&& (0 == strcmp(entry->d_name + nameLength - suffixLength, suffix));
+
+		if (found)
+		{
+			snprintf(path, pathSize, "%s/%s", dir, entry->d_name);
+		}
+	}
+
+	closedir(dp);
+	return found;
+}
+
+
+/**
+ * \brief Waits for dump of given trigger to be written.
+ * \return True if it has been, false if it has not shown up in time.
+*/
+static bool waitForDump(const char* dir, const char* triggerName, char* path, size_t pathSize)
+{
+	for (unsigned waitedMs = 0u; waitedMs < TEST_DUMP_TIMEOUT_MS; waitedMs += TEST_POLL_MS)
+	{
+		if (findDump(dir, triggerName, path, pathSize))
+		{
+			Thread_sleepMs(TEST_SETTLE_MS);
+			return true;
+		}
+
+		Thread_sleepMs(TEST_POLL_MS);
+	}
+
+	return false;
+}
+
+
+/**
+ * \brief Decodes dump file, checking that every snapshot holds lines written by generator, from oldest to newest,
+ * all of them taken after given time, and removes it.
+ * \return Header of dump.
+*/
+static FlightRecorderFileHeader_t checkDump(const char* path, FlightRecorderTrigger_t trigger, const ProcGen_t* generator, uint64_t afterNs)
+{
+	FILE* fp = fopen(path, "rb");
+	assert(NULL != fp);
+
+	FlightRecorderFileHeader_t header;
+	assert(1u == fread(&header, sizeof(header), 1u, fp));
+	assert(0 == strcmp(header.magic, FREC_FILE_MAGIC));
+	assert((FREC_FILE_VERSION == header.version) && ((uint32_t) trigger == header.trigger));
+	assert((TEST_CPU_COUNT + 1u == header.cpuStatsLength) && (TEST_PERIOD_MS * 1000000ull == header.periodNs));
+	assert((0u < header.snapshotCount) && (header.snapshotCount <= TEST_CAPACITY));
+	assert(0u != header.triggerRealTimeNs);
+
+	CpuStat_t stats[TEST_CPU_COUNT + 1u];
+	uint64_t prevTimestampNs = afterNs;
+
+	for (uint64_t ii = 0; ii < header.snapshotCount; ++ii)
+	{
+		uint64_t timestampNs;
+		assert(1u == fread(&timestampNs, sizeof(timestampNs), 1u, fp));
+		assert(TEST_CPU_COUNT + 1u == fread(stats, sizeof(CpuStat_t), TEST_CPU_COUNT + 1u, fp));
+		assert((prevTimestampNs < timestampNs) && (timestampNs <= header.triggerMonotonicNs));
+		prevTimestampNs = timestampNs;
+
+		for (size_t cpu = 0; cpu <= TEST_CPU_COUNT; ++cpu)
+		{
+			CpuStat_t expected;
+			assert(0 == ProcGen_getCpuStat(generator, cpu, &expected));
+			assert(0 == memcmp(expected.values, stats[cpu].values, sizeof(expected.values)));
+		}
+	}
+
+	// Nothing follows last snapshot
+	assert(EOF == fgetc(fp));
+	fclose(fp);
+	remove(path);
+	return header;
+}
+
+
+int main(void)
+{
+	char root[] = "/tmp/cut_flightrec_XXXXXX";
+	assert(NULL != mkdtemp(root));
+
+	ProcGen_t* generator = ProcGen_create(TEST_CPU_COUNT, PROCGEN_PATTERN_CONSTANT, 50.0, 1u);
+	assert(NULL != generator);
+	assert(0 == ProcGen_writeFile(generator, root));
+
+	ProcStat_setProcRoot(root);
+	CpuCount_override((int) TEST_CPU_COUNT);
+	CpuCount_init();
+	assert(ThreadInfo_init());
+	assert(Watchdog_init());
+
+	// Window has to hold at least a single period
+	assert(0 > FlightRecorder_init(TEST_PERIOD_MS - 1u, TEST_PERIOD_MS, TEST_THRESHOLD_PCT, root));
+	assert(0 > FlightRecorder_init(TEST_WINDOW_MS, TEST_PERIOD_MS, TEST_THRESHOLD_PCT, NULL));
+	assert(0 == FlightRecorder_init(TEST_WINDOW_MS, TEST_PERIOD_MS, TEST_THRESHOLD_PCT, root));
+
+	CpuUsageCompact_t* usage = calloc(1u, CpuUsageCompact_size());
+	assert(NULL != usage);
+	usage->valuesLength = TEST_CPU_COUNT + 1u;
+
+	thrd_t recorderThrd;
+	thrd_t dumperThrd;
+	assert(thrd_success == thrd_create(&recorderThrd, FlightRecorderThread, NULL));
+	assert(thrd_success == thrd_create(&dumperThrd, FlightRecorderDumpThread, NULL));
+
+	// Usage below threshold, or of total line alone, triggers nothing
+	char path[512];
+	usage->values[0] = TEST_SATURATED_BP;
+	usage->values[1] = TEST_SATURATED_BP - 1000u;
+	FlightRecorder_checkUsage(usage);
+
+	// Ring keeps only the last window once it has been filled
+	Thread_sleepMs(TEST_WINDOW_MS + TEST_WINDOW_MS / 2u);
+	assert(!findDump(root, "threshold", path, sizeof(path)));
+
+	usage->values[1] = TEST_SATURATED_BP;
+	const unsigned long long thresholdNs = MonotonicTimeNs();
+	FlightRecorder_checkUsage(usage);
+	assert(waitForDump(root, "threshold", path, sizeof(path)));
+	const FlightRecorderFileHeader_t first = checkDump(path, FREC_TRIGGER_THRESHOLD, generator, 0u);
+	assert(TEST_CAPACITY == first.snapshotCount);
+
+	// Saturation sustained within the same window does not dump again
+	FlightRecorder_checkUsage(usage);
+	Thread_sleepMs(TEST_SETTLE_MS);
+	assert(!findDump(root, "threshold", path, sizeof(path)));
+
+	// Other triggers are not rate-limited, and once ring has been handed over,
+	// sampling continues into the spare one, holding only snapshots taken since
+	FlightRecorder_trigger(FREC_TRIGGER_SIGNAL);
+	assert(waitForDump(root, "signal", path, sizeof(path)));
+	const FlightRecorderFileHeader_t second = checkDump(path, FREC_TRIGGER_SIGNAL, generator, first.triggerMonotonicNs);
+	assert(second.snapshotCount < TEST_CAPACITY);
+
+	// Threshold triggers again once window has passed
+	while (MonotonicTimeNs() - thresholdNs <= TEST_WINDOW_MS * 1000000ull)
+	{
+		Thread_sleepMs(TEST_POLL_MS);
+	}
+
+	FlightRecorder_checkUsage(usage);
+	assert(waitForDump(root, "threshold", path, sizeof(path)));
+	const FlightRecorderFileHeader_t third = checkDump(path, FREC_TRIGGER_THRESHOLD, generator, second.triggerMonotonicNs);
+
+	// Trigger raised while shutting down is still written before dump thread exits
+	FlightRecorder_trigger(FREC_TRIGGER_WATCHDOG);
+	Thread_activateKillSwitch();
+
+	int recorderResult;
+	int dumperResult;
+	thrd_join(recorderThrd, &recorderResult);
+	thrd_join(dumperThrd, &dumperResult);
+	assert((0 == recorderResult) && (0 == dumperResult));
+	assert(findDump(root, "watchdog", path, sizeof(path)));
+	checkDump(path, FREC_TRIGGER_WATCHDOG, generator, third.triggerMonotonicNs);
+
+	free(usage);
+	FlightRecorder_finalize();
+	Watchdog_finalize();
+	ThreadInfo_finalize();
+	ProcStat_setProcRoot(NULL);
+	ProcGen_destroy(generator);
+
+	snprintf(path, sizeof(path), "%s/stat", root);
+	remove(path);
+	remove(root);
+	return 0;
+}
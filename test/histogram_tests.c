@@ -0,0 +1,59 @@
+#include "histogram.h"
+#include <assert.h>
+#include <stdio.h>
+#include <limits.h>
+
+
+static Histogram_t g_histogram;
+
+
+static void testBuckets(void)
+{
+	// Buckets are contiguous, cover every value and every value lands in the bucket containing it
+	assert(0u == Histogram_bucketLowerBound(0u));
+	assert(ULLONG_MAX == Histogram_bucketUpperBound(HISTOGRAM_BUCKETS - 1u));
+	assert(HISTOGRAM_BUCKETS - 1u == Histogram_bucketIndex(ULLONG_MAX));
+
+	for (size_t ii = 1; ii < HISTOGRAM_BUCKETS; ++ii)
+	{
+		assert(Histogram_bucketLowerBound(ii) == Histogram_bucketUpperBound(ii - 1u) + 1u);
+		assert(ii == Histogram_bucketIndex(Histogram_bucketLowerBound(ii)));
+		assert(ii == Histogram_bucketIndex(Histogram_bucketUpperBound(ii)));
+	}
+}
+
+
+static void testPercentiles(void)
+{
+	Histogram_reset(&g_histogram);
+	assert(0u == Histogram_count(&g_histogram));
+	assert(0u == Histogram_percentile(&g_histogram, 50.0));
+
+	for (unsigned long long value = 1u; value <= 1000000u; ++value)
+	{
+		Histogram_record(&g_histogram, value);
+	}
+
+	assert(1000000u == Histogram_count(&g_histogram));
+	assert(1000000u == Histogram_max(&g_histogram));
+	assert(1000000u == Histogram_percentile(&g_histogram, 100.0));
+
+	// Reported percentile never underestimates, and overestimates by at most one sub-bucket
+	const unsigned long long p50 = Histogram_percentile(&g_histogram, 50.0);
+	const unsigned long long p99 = Histogram_percentile(&g_histogram, 99.0);
+	assert((p50 >= 500000u) && (p50 <= 500000u + 500000u / HISTOGRAM_SUB_BUCKETS));
+	assert((p99 >= 990000u) && (p99 <= 1000000u));
+
+	Histogram_reset(&g_histogram);
+	Histogram_record(&g_histogram, 3u);
+	assert(3u == Histogram_percentile(&g_histogram, 0.0));
+	assert(3u == Histogram_percentile(&g_histogram, 99.9));
+}
+
+
+int main(void)
+{
+	testBuckets();
+	testPercentiles();
+	return 0;
+}
@@ -0,0 +1,231 @@
+#include "idletrack.h"
+#include "cpucount.h"
+#include "testfs.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TEST_CPU_COUNT 		3
+#define TEST_STATE_COUNT 	3u
+#define TEST_SLICES 		2u
+#define TEST_REPORT_MAX 	1024u
+#define TEST_REOPEN_SCANS 	17u
+
+
+static const char* const STATE_NAMES[TEST_STATE_COUNT] = { "POLL", "C1", "C6" };
+
+
+static void writeState(int cpu, unsigned state, unsigned long long timeUs, unsigned long long usage)
+{
+	char relative[TESTFS_PATH_MAX];
+	char content[64];
+	snprintf(relative, sizeof(relative), "cpu/cpu%d/cpuidle/state%u/time", cpu, state);
+	snprintf(content, sizeof(content), "%llu\n", timeUs);
+	TestFs_writeFile(relative, content);
+	snprintf(relative, sizeof(relative), "cpu/cpu%d/cpuidle/state%u/usage", cpu, state);
+	snprintf(content, sizeof(content), "%llu\n", usage);
+	TestFs_writeFile(relative, content);
+}
+
+
+static void writeThrottle(int cpu, unsigned long long core, unsigned long long package)
+{
+	char relative[TESTFS_PATH_MAX];
+	char content[64];
+	snprintf(relative, sizeof(relative), "cpu/cpu%d/thermal_throttle/core_throttle_count", cpu);
+	snprintf(content, sizeof(content), "%llu\n", core);
+	TestFs_writeFile(relative, content);
+	snprintf(relative, sizeof(relative), "cpu/cpu%d/thermal_throttle/package_throttle_count", cpu);
+	snprintf(content, sizeof(content), "%llu\n", package);
+	TestFs_writeFile(relative, content);
+}
+
+
+static void makeCpu(int cpu)
+{
+	char name[TESTFS_PATH_MAX];
+	snprintf(name, sizeof(name), "cpu/cpu%d", cpu);
+	TestFs_makeDir(name);
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle", cpu);
+	TestFs_makeDir(name);
+
+	for (unsigned ii = 0; ii < TEST_STATE_COUNT; ++ii)
+	{
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u", cpu, ii);
+		TestFs_makeDir(name);
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u/name", cpu, ii);
+		char content[16];
+		snprintf(content, sizeof(content), "%s\n", STATE_NAMES[ii]);
+		TestFs_writeFile(name, content);
+		writeState(cpu, ii, 0u, 0u);
+	}
+
+	snprintf(name, sizeof(name), "cpu/cpu%d/thermal_throttle", cpu);
+	TestFs_makeDir(name);
+	writeThrottle(cpu, 0u, 0u);
+}
+
+
+static void removeCpu(int cpu)
+{
+	char name[TESTFS_PATH_MAX];
+
+	for (unsigned ii = 0; ii < TEST_STATE_COUNT; ++ii)
+	{
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u/name", cpu, ii);
+		assert(TestFs_remove(name));
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u/time", cpu, ii);
+		assert(TestFs_remove(name));
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u/usage", cpu, ii);
+		assert(TestFs_remove(name));
+		snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle/state%u", cpu, ii);
+		assert(TestFs_remove(name));
+	}
+
+	snprintf(name, sizeof(name), "cpu/cpu%d/thermal_throttle/core_throttle_count", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d/thermal_throttle/package_throttle_count", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d/thermal_throttle", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d/cpuidle", cpu);
+	assert(TestFs_remove(name));
+	snprintf(name, sizeof(name), "cpu/cpu%d", cpu);
+	assert(TestFs_remove(name));
+}
+
+
+/**
+ * \brief Steps tracker through a full scan, expecting report only at it's end if one is expected at all.
+*/
+static void scan(IdleTracker_t* tracker, IdleUsageReport_t* report, bool reported)
+{
+	for (unsigned ii = 0; ii < TEST_SLICES; ++ii)
+	{
+		const int expected = (reported && (TEST_SLICES - 1u == ii)) ? 1 : 0;
+		assert(expected == IdleTracker_step(tracker, report));
+	}
+}
+
+
+static void test_IdleTracker_create(void)
+{
+	assert(NULL == IdleTracker_create("/nonexistent", 8u, 1u));
+	assert(NULL == IdleTracker_create(TestFs_getRoot(), 0u, 1u));
+	assert(NULL == IdleTracker_create(TestFs_getRoot(), 8u, 0u));
+	// Neither throttling counters nor a single state fit into a single file
+	assert(NULL == IdleTracker_create(TestFs_getRoot(), 1u, 1u));
+	assert(IdleUsageReport_size(TEST_CPU_COUNT) == sizeof(IdleUsageReport_t) + TEST_CPU_COUNT * sizeof(IdleCpuUsage_t));
+	assert(-1 == IdleTracker_step(NULL, NULL));
+	IdleTracker_destroy(NULL);
+}
+
+
+static void test_IdleTracker_step(void)
+{
+	IdleUsageReport_t* report = calloc(1u, IdleUsageReport_size(TEST_CPU_COUNT));
+	assert(NULL != report);
+
+	// Throttling counters come first, leaving room for the two deepest states
+	IdleTracker_t* tracker = IdleTracker_create(TestFs_getRoot(), 6u, TEST_SLICES);
+	assert(NULL != tracker);
+	assert(-1 == IdleTracker_step(tracker, NULL));
+
+	// Nothing is reported until processors have been read twice
+	scan(tracker, report, false);
+
+	writeState(0, 1u, 0u, 10u);
+	writeState(0, 2u, 1000000000000ull, 20u);
+	writeState(1, 2u, 1000000000000ull, 0u);
+	writeThrottle(1, 5u, 3u);
+	scan(tracker, report, true);
+
+	assert(TEST_CPU_COUNT == report->cpuCount);
+	assert(2u == report->measuredCount);
+	assert(2u == report->stateCount);
+	assert(6u == report->filesPerCpu);
+	assert(report->throttleTracked);
+	assert(0u == strcmp("C1", report->states[0].name));
+	assert(0u == strcmp("C6", report->states[1].name));
+
+	// Residency past the interval counts as all of it
+	assert(0u == report->states[0].residencyBp);
+	assert(10000u == report->states[1].residencyBp);
+	assert(0u < report->states[0].entriesPerSec);
+	assert(0u < report->states[1].entriesPerSec);
+
+	assert((0u == report->cpus[0].cpu) && (2u == report->cpus[2].cpu));
+	assert(report->cpus[0].measured && report->cpus[1].measured && !report->cpus[2].measured);
+	assert(IDLETRACK_BP_UNKNOWN == report->cpus[2].residencyBp[0]);
+	assert(1u == report->throttledCount);
+	assert(0u == report->cpus[0].coreThrottlesPerSec);
+	assert(0u < report->cpus[1].coreThrottlesPerSec);
+	assert(report->coreThrottlesPerSec == report->cpus[1].coreThrottlesPerSec);
+	assert(report->packageThrottlesPerSec == report->cpus[1].packageThrottlesPerSec);
+
+	char text[TEST_REPORT_MAX];
+	FILE* out = fmemopen(text, sizeof(text), "w");
+	assert(NULL != out);
+	IdleUsageReport_print(out, report, true);
+	fclose(out);
+	assert(NULL != strstr(text, "Idle:\tC1 0.00 %"));
+	assert(NULL != strstr(text, "CPU0 idle:\tC1 0.00 %, C6 100.00 %\n"));
+	assert(NULL != strstr(text, "CPU1 idle:\tC1 0.00 %, C6 100.00 %, throttled"));
+	assert(NULL == strstr(text, "CPU2"));
+
+	// File that cannot be read leaves it's state unknown, until it is opened again
+	TestFs_writeFile("cpu/cpu1/cpuidle/state2/time", "\n");
+	scan(tracker, report, true);
+	assert(IDLETRACK_BP_UNKNOWN == report->cpus[1].residencyBp[1]);
+	assert(0u == report->cpus[1].residencyBp[0]);
+	assert(0u == report->throttledCount);
+
+	TestFs_writeFile("cpu/cpu1/cpuidle/state2/time", "2000000000000\n");
+	unsigned scans = 0u;
+
+	do
+	{
+		scan(tracker, report, true);
+		++scans;
+	}
+	while ((IDLETRACK_BP_UNKNOWN == report->cpus[1].residencyBp[1]) && (scans <= TEST_REOPEN_SCANS));
+
+	// Counter read for the first time after reopening has nothing to be compared against
+	assert((1u < scans) && (scans <= TEST_REOPEN_SCANS));
+	assert(0u == report->cpus[1].residencyBp[1]);
+	IdleTracker_destroy(tracker);
+
+	// Odd file left over from the budget is not used
+	tracker = IdleTracker_create(TestFs_getRoot(), 5u, 1u);
+	assert(NULL != tracker);
+	assert(0 == IdleTracker_step(tracker, report));
+	assert(1 == IdleTracker_step(tracker, report));
+	assert((1u == report->stateCount) && (4u == report->filesPerCpu) && report->throttleTracked);
+	assert(0u == strcmp("C6", report->states[0].name));
+	IdleTracker_destroy(tracker);
+
+	free(report);
+}
+
+
+int main(void)
+{
+	TestFs_create("cut_idletrack");
+	CpuCount_override(TEST_CPU_COUNT);
+	TestFs_makeDir("cpu");
+
+	// Processor 2 is offline, having no cpuidle directory
+	makeCpu(0);
+	makeCpu(1);
+
+	test_IdleTracker_create();
+	test_IdleTracker_step();
+
+	removeCpu(0);
+	removeCpu(1);
+	assert(TestFs_remove("cpu"));
+	TestFs_destroy();
+	return 0;
+}
@@ -0,0 +1,207 @@
+#include "irqtrack.h"
+#include "testfs.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define TEST_BUF_MAX 			1024u
+#define TEST_HOT_COUNT 			2u
+#define TEST_SLICES 			2u
+#define TEST_SAMPLE_PERIOD_MS 	20
+
+
+/**
+ * \brief Writes interrupts and softirqs files of processors 0, 1 and 2, with counters advanced by given amount.
+ * Processor 1 takes most of network interrupts, processor 2 most of timer ones.
+*/
+static void writeCounters(unsigned long long step)
+{
+	char buf[TEST_BUF_MAX];
+	snprintf(buf, sizeof(buf),
+		"           CPU0       CPU1       CPU2       \n"
+		"  0:         %llu          0          0  IO-APIC   2-edge      timer\n"
+		" 24: %10llu %10llu %10llu  PCI-MSIX-0000:00:03.0   0-edge      eth0-rx-0\n"
+		"NMI: %10llu %10llu %10llu   Non-maskable interrupts\n"
+		"LOC: %10llu %10llu %10llu   Local timer interrupts\n"
+		"ERR:          %llu\n",
+		step,
+		10u + 1u * step, 20u + 100u * step, 30ull,
+		0ull, 0ull, 0ull,
+		5u + 2u * step, 5u + 3u * step, 5u + 40u * step,
+		step);
+	TestFs_writeFile("interrupts", buf);
+
+	snprintf(buf, sizeof(buf),
+		"                    CPU0       CPU1       CPU2       \n"
+		"          HI: %10llu %10llu %10llu\n"
+		"       TIMER: %10llu %10llu %10llu\n"
+		"      NET_RX: %10llu %10llu %10llu\n",
+		0ull, 0ull, 0ull,
+		1u * step, 1u * step, 20u * step,
+		0ull, 50u * step, 0ull);
+	TestFs_writeFile("softirqs", buf);
+}
+
+
+/**
+ * \brief Takes a full sample, checking that only it's first step reads files.
+ * \return Result of the first step.
+*/
+static int sample(IrqTracker_t* tracker, IrqUsageReport_t* report)
+{
+	nanosleep(&(struct timespec) { .tv_nsec = TEST_SAMPLE_PERIOD_MS * 1000000L }, NULL);
+	const int result = IrqTracker_step(tracker, report);
+
+	for (unsigned ii = 1; ii < TEST_SLICES; ++ii)
+	{
+		assert(0 == IrqTracker_step(tracker, report));
+	}
+
+	return result;
+}
+
+
+static void test_IrqTracker_create(void)
+{
+	assert(NULL == IrqTracker_create(TestFs_getRoot(), 0u, TEST_SLICES));
+	assert(NULL == IrqTracker_create(TestFs_getRoot(), TEST_HOT_COUNT, 0u));
+	assert(NULL == IrqTracker_create("/nonexistent", TEST_HOT_COUNT, TEST_SLICES));
+	assert(IrqUsageReport_size(TEST_HOT_COUNT) == sizeof(IrqUsageReport_t) + TEST_HOT_COUNT * sizeof(IrqCpuUsage_t));
+
+	// Either file is enough
+	TestFs_writeFile("softirqs", "    CPU0\n  TIMER: 1\n");
+	IrqTracker_t* tracker = IrqTracker_create(TestFs_getRoot(), TEST_HOT_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	IrqTracker_destroy(tracker);
+	IrqTracker_destroy(NULL);
+
+	// File which is not a per-processor table is an error
+	TestFs_writeFile("softirqs", "garbage\n");
+	tracker = IrqTracker_create(TestFs_getRoot(), TEST_HOT_COUNT, 1u);
+	IrqUsageReport_t* report = calloc(1u, IrqUsageReport_size(TEST_HOT_COUNT));
+	assert(NULL != report);
+	assert(0 > IrqTracker_step(tracker, report));
+	assert(0 > IrqTracker_step(NULL, report));
+	free(report);
+	IrqTracker_destroy(tracker);
+}
+
+
+static void test_IrqTracker_step(void)
+{
+	writeCounters(0u);
+	IrqTracker_t* tracker = IrqTracker_create(TestFs_getRoot(), TEST_HOT_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	IrqUsageReport_t* report = calloc(1u, IrqUsageReport_size(TEST_HOT_COUNT));
+	assert(NULL != report);
+
+	// Rates take two samples
+	assert(0 == sample(tracker, report));
+
+	writeCounters(10u);
+	assert(1 == sample(tracker, report));
+	assert(3u == report->cpuCount);
+	assert(8u == report->sourceCount);
+	assert(0u < report->intervalNs);
+	assert(TEST_HOT_COUNT == report->count);
+
+	// Processor 1 has 1000 + 30 + 10 + 500 interrupts, processor 2 400 + 200, processor 0 the fewest
+	const IrqCpuUsage_t* hot = &report->hot[0];
+	assert(1u == hot->cpu);
+	assert((1540ull * 1000000000ull / report->intervalNs) == hot->perSec);
+	assert(4u == hot->sourceCount);
+	assert(0 == strcmp(hot->sources[0].name, "24 eth0-rx-0"));
+	assert(!hot->sources[0].softirq);
+	assert((1000ull * 1000000000ull / report->intervalNs) == hot->sources[0].perSec);
+	assert(0 == strcmp(hot->sources[1].name, "NET_RX"));
+	assert(hot->sources[1].softirq);
+	assert(0 == strcmp(hot->sources[2].name, "LOC Local timer interrupts"));
+	assert(0 == strcmp(hot->sources[3].name, "TIMER"));
+
+	hot = &report->hot[1];
+	assert(2u == hot->cpu);
+	assert(2u == hot->sourceCount);
+	assert(0 == strcmp(hot->sources[0].name, "LOC Local timer interrupts"));
+	assert(0 == strcmp(hot->sources[1].name, "TIMER"));
+
+	// Processor going offline shifts columns, so that no rates are calculated until the next sample
+	TestFs_writeFile("interrupts",
+		"           CPU0       CPU2       \n"
+		" 24:        100        200  PCI-MSIX-0000:00:03.0   0-edge      eth0-rx-0\n");
+	TestFs_writeFile("softirqs",
+		"                    CPU0       CPU2       \n"
+		"       TIMER:         10        200\n");
+	assert(1 == sample(tracker, report));
+	assert(2u == report->cpuCount);
+	assert(2u == report->sourceCount);
+	assert(0u == report->count);
+
+	TestFs_writeFile("interrupts",
+		"           CPU0       CPU2       \n"
+		" 24:        100        300  PCI-MSIX-0000:00:03.0   0-edge      eth0-rx-0\n");
+	assert(1 == sample(tracker, report));
+	assert(1u == report->count);
+	assert(2u == report->hot[0].cpu);
+	assert(1u == report->hot[0].sourceCount);
+
+	// Newly added processor resizes every row, which takes another sample
+	TestFs_writeFile("interrupts",
+		"           CPU0       CPU2       CPU5       \n"
+		" 24:        100        300          7  PCI-MSIX-0000:00:03.0   0-edge      eth0-rx-0\n");
+	assert(0 == sample(tracker, report));
+	assert(1 == sample(tracker, report));
+	assert(0u == report->count);
+
+	free(report);
+	IrqTracker_destroy(tracker);
+}
+
+
+static void test_IrqUsageReport_print(void)
+{
+	char buf[TEST_BUF_MAX];
+	FILE* out = fmemopen(buf, sizeof(buf), "w");
+	assert(NULL != out);
+
+	// Zeroed report, of no completed interval, prints nothing
+	IrqUsageReport_t* report = calloc(1u, IrqUsageReport_size(TEST_HOT_COUNT));
+	assert(NULL != report);
+	IrqUsageReport_print(out, report);
+	fflush(out);
+	assert(0 == ftell(out));
+
+	report->cpuCount = 4u;
+	report->sourceCount = 30u;
+	report->count = 2u;
+	report->hot[0] = (IrqCpuUsage_t)
+	{
+		.cpu = 3u, .perSec = 90000u, .sourceCount = 2u,
+		.sources = { { .perSec = 60000u, .name = "24 eth0-rx-0" }, { .perSec = 30000u, .softirq = true, .name = "NET_RX" } }
+	};
+	report->hot[1] = (IrqCpuUsage_t) { .cpu = 0u, .perSec = 250u };
+	IrqUsageReport_print(out, report);
+	fclose(out);
+
+	assert(NULL != strstr(buf, "Interrupts:\t30 sources on 4 processors"));
+	assert(NULL != strstr(buf, "CPU3:\t90000 /s\t24 eth0-rx-0 60000 /s, NET_RX (softirq) 30000 /s\n"));
+	assert(NULL != strstr(buf, "CPU0:\t250 /s\n"));
+	free(report);
+}
+
+
+int main(void)
+{
+	TestFs_create("cut_irqtrack");
+
+	test_IrqTracker_create();
+	test_IrqTracker_step();
+	test_IrqUsageReport_print();
+
+	TestFs_remove("interrupts");
+	assert(TestFs_remove("softirqs"));
+	TestFs_destroy();
+	return 0;
+}
@@ -0,0 +1,359 @@
+#include "reader.h"
+#include "analyzer.h"
+#include "printer.h"
+#include "watchdog.h"
+#include "threadctl.h"
+#include "cpucount.h"
+#include "procstat.h"
+#include "procgen.h"
+#include "snapsource.h"
+#include "cpuusage.h"
+#include "latency.h"
+#include "mailbox.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+
+#define TEST_CPU_COUNT 				4096u
+#define TEST_LOAD_PCT 				50.0
+#define TEST_LOAD_TOLERANCE_PCT 	5.0
+#define TEST_SAMPLE_PERIOD_MS 		50u
+#define TEST_UPDATE_COUNT 			40u
+#define TEST_SIMULATED_STEP_MS 		10000u
+#define TEST_PROCSTAT_CAPACITY 		10u
+#define TEST_FULL_CPU_COUNT 		4u
+#define TEST_FULL_CAPACITY 			2u
+// Longer than reader waits for buffer to have space
+#define TEST_FULL_WAIT_MS 			2500u
+#define TEST_FULL_DRAIN_MS 			500u
+
+
+static void testGeneratorFormat(void)
+{
+	ProcGen_t* generator = ProcGen_create(8u, PROCGEN_PATTERN_WAVE, TEST_LOAD_PCT, 7u);
+	assert(NULL != generator);
+
+	CpuStat_t before;
+	CpuStat_t after;
+	assert(0 == ProcGen_getCpuStat(generator, 3u, &before));
+	ProcGen_advance(generator, 1000u);
+	assert(0 == ProcGen_getCpuStat(generator, 3u, &after));
+	assert(0 != ProcGen_getCpuStat(generator, 9u, &after));
+
+	// A second worth of ticks, give or take carried fractions, is spread over the states without any counter going backwards
+	CpuStatValue_t elapsed = 0u;
+
+	for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+	{
+		assert(after.values[ii] >= before.values[ii]);
+		elapsed += after.values[ii] - before.values[ii];
+	}
+
+	assert((elapsed >= PROCGEN_TICKS_PER_SECOND - CSINDEX_COUNT_) && (elapsed <= PROCGEN_TICKS_PER_SECOND + CSINDEX_COUNT_));
+
+	char* text = NULL;
+	size_t textSize = 0u;
+	FILE* stream = open_memstream(&text, &textSize);
+	assert(NULL != stream);
+	assert(0 == ProcGen_write(generator, stream));
+	fclose(stream);
+
+	assert(0 == strncmp(text, "cpu  ", 5u));
+	assert(NULL != strstr(text, "\ncpu7 "));
+	assert(NULL == strstr(text, "\ncpu8 "));
+	assert(NULL != strstr(text, "\nctxt "));
+
+	free(text);
+	ProcGen_destroy(generator);
+}
+
+
+static void testPipelineAtScale(bool deltaMode)
+{
+	char root[] = "/tmp/cut_pipeline_XXXXXX";
+	assert(NULL != mkdtemp(root));
+
+	ProcGen_t* generator = ProcGen_create(TEST_CPU_COUNT, PROCGEN_PATTERN_CONSTANT, TEST_LOAD_PCT, 1u);
+	assert(NULL != generator);
+	assert(0 == ProcGen_writeFile(generator, root));
+
+	ProcStat_setProcRoot(root);
+	CpuCount_override((int) TEST_CPU_COUNT);
+	CpuCount_init();
+	assert(TEST_CPU_COUNT == (unsigned) CpuCount_get());
+	assert(ThreadInfo_init());
+	assert(Watchdog_init());
+
+	mtx_t procStatMtx;
+	mtx_t usageInfoMtx;
+	cnd_t procStatNotEmptyCv;
+	cnd_t procStatNotFullCv;
+	cnd_t usageInfoNotEmptyCv;
+	assert(thrd_success == mtx_init(&procStatMtx, mtx_timed));
+	assert(thrd_success == mtx_init(&usageInfoMtx, mtx_timed));
+	assert(thrd_success == cnd_init(&procStatNotEmptyCv));
+	assert(thrd_success == cnd_init(&procStatNotFullCv));
+	assert(thrd_success == cnd_init(&usageInfoNotEmptyCv));
+
+	CircularBuffer_t* procStatCbuf = CircularBuffer_create(deltaMode ? ProcStatDelta_size() : ProcStat_size(), TEST_PROCSTAT_CAPACITY);
+	Mailbox_t* usageInfoMailbox = Mailbox_create(CpuUsageCompact_size());
+	SnapshotSource_t* source = SnapshotSource_createLive(NULL);
+	FILE* output = tmpfile();
+	assert((NULL != procStatCbuf) && (NULL != usageInfoMailbox) && (NULL != source) && (NULL != output));
+
+	ReaderThreadParams_t readerParams =
+	{
+		.outMtx 			= &procStatMtx,
+		.outNotEmptyCv 		= &procStatNotEmptyCv,
+		.outNotFullCv 		= &procStatNotFullCv,
+		.outBuf 			= procStatCbuf,
+		.deltaMode 			= deltaMode,
+		.samplePeriodMs 	= TEST_SAMPLE_PERIOD_MS,
+		.alignToWallClock 	= false,
+		.adaptiveParams 	= NULL,
+		.source 			= source
+	};
+
+	AnalyzerThreadParams_t analyzerParams =
+	{
+		.inMtx 			= &procStatMtx,
+		.inNotEmptyCv 	= &procStatNotEmptyCv,
+		.inNotFullCv 	= &procStatNotFullCv,
+		.inBuf 			= procStatCbuf,
+		.deltaMode 		= deltaMode,
+		.outMtx 		= &usageInfoMtx,
+		.outNotEmptyCv 	= &usageInfoNotEmptyCv,
+		.outMailbox 	= usageInfoMailbox,
+		.topology 		= NULL,
+		.catchUp 		= deltaMode ? ACATCHUP_COALESCE : ACATCHUP_BATCH,
+		.recorder 		= NULL
+	};
+
+	PrinterThreadParams_t printerParams =
+	{
+		.inMtx 			= &usageInfoMtx,
+		.inNotEmptyCv 	= &usageInfoNotEmptyCv,
+		.inMailbox 		= usageInfoMailbox,
+		.topology 		= NULL,
+		.printCpus 		= true,
+		.rollupLevels 	= 0u,
+		.out 			= output,
+		.clearScreen 	= false
+	};
+
+	thrd_t readerThrd;
+	thrd_t analyzerThrd;
+	thrd_t printerThrd;
+	assert(thrd_success == thrd_create(&readerThrd, ReaderThread, &readerParams));
+	assert(thrd_success == thrd_create(&analyzerThrd, AnalyzerThread, &analyzerParams));
+	assert(thrd_success == thrd_create(&printerThrd, PrinterThread, &printerParams));
+
+	for (unsigned ii = 0; ii < TEST_UPDATE_COUNT; ++ii)
+	{
+		// Simulated time runs faster than real one, so that tick granularity does not distort measured usage
+		Thread_sleepMs(TEST_SAMPLE_PERIOD_MS);
+		ProcGen_advance(generator, TEST_SIMULATED_STEP_MS);
+		assert(0 == ProcGen_writeFile(generator, root));
+	}
+
+	Thread_activateKillSwitch();
+
+	int readerResult;
+	int analyzerResult;
+	int printerResult;
+	thrd_join(printerThrd, &printerResult);
+	thrd_join(analyzerThrd, &analyzerResult);
+	thrd_join(readerThrd, &readerResult);
+	assert(0 == readerResult);
+	assert(0 == analyzerResult);
+	assert(0 == printerResult);
+
+	// Last processor has to be present in printed output, with usage matching generated load
+	rewind(output);
+	char line[256];
+	unsigned lastCpuLines = 0u;
+
+	while (NULL != fgets(line, sizeof(line), output))
+	{
+		double usage;
+
+		// Negative value marks interval in which the file has not been updated
+		if ((1 == sscanf(line, "CPU4095:\t%lf", &usage)) && (usage >= 0.0))
+		{
+			assert((usage > TEST_LOAD_PCT - TEST_LOAD_TOLERANCE_PCT) && (usage < TEST_LOAD_PCT + TEST_LOAD_TOLERANCE_PCT));
+			++lastCpuLines;
+		}
+	}
+
+	assert(0u < lastCpuLines);
+
+	// Every printed frame has been traced through the whole pipeline
+	const unsigned long long tracedFrames = Histogram_count(Latency_getHistogram(LSPAN_END_TO_END));
+	assert(tracedFrames >= lastCpuLines);
+
+	for (int ii = 0; ii < LSPAN_COUNT_; ++ii)
+	{
+		assert(tracedFrames == Histogram_count(Latency_getHistogram((LatencySpan_t) ii)));
+	}
+
+	assert(Histogram_max(Latency_getHistogram(LSPAN_END_TO_END)) >= Histogram_max(Latency_getHistogram(LSPAN_PRINT)));
+
+	// Analyzer never waits for printer, every published frame has been either printed or dropped
+	const uint64_t publishCount = Mailbox_getPublishCount(usageInfoMailbox);
+	assert(publishCount >= tracedFrames);
+	assert(publishCount - Mailbox_getDropCount(usageInfoMailbox) >= tracedFrames);
+
+	fclose(output);
+	SnapshotSource_destroy(source);
+	Mailbox_destroy(usageInfoMailbox);
+	CircularBuffer_destroy(procStatCbuf);
+	cnd_destroy(&usageInfoNotEmptyCv);
+	cnd_destroy(&procStatNotFullCv);
+	cnd_destroy(&procStatNotEmptyCv);
+	mtx_destroy(&usageInfoMtx);
+	mtx_destroy(&procStatMtx);
+	Watchdog_finalize();
+	ThreadInfo_finalize();
+	ProcStat_setProcRoot(NULL);
+	ProcGen_destroy(generator);
+
+	char path[64];
+	snprintf(path, sizeof(path), "%s/stat", root);
+	remove(path);
+	remove(root);
+}
+
+
+/**
+ * \brief Keeps buffer of changes full while load is generated, checking that once it's drained, changes read add up to
+ * all of the generated load, rather than losing intervals to overwritten changes.
+*/
+static void testDeltaBufferFull(void)
+{
+	char root[] = "/tmp/cut_pipeline_XXXXXX";
+	assert(NULL != mkdtemp(root));
+
+	ProcGen_t* generator = ProcGen_create(TEST_FULL_CPU_COUNT, PROCGEN_PATTERN_WAVE, TEST_LOAD_PCT, 1u);
+	assert(NULL != generator);
+	assert(0 == ProcGen_writeFile(generator, root));
+
+	CpuStat_t before;
+	CpuStat_t after;
+	assert(0 == ProcGen_getCpuStat(generator, 0u, &before));
+
+	ProcStat_setProcRoot(root);
+	CpuCount_override((int) TEST_FULL_CPU_COUNT);
+	CpuCount_init();
+	assert(ThreadInfo_init());
+	assert(Watchdog_init());
+
+	mtx_t procStatMtx;
+	cnd_t procStatNotEmptyCv;
+	cnd_t procStatNotFullCv;
+	assert(thrd_success == mtx_init(&procStatMtx, mtx_timed));
+	assert(thrd_success == cnd_init(&procStatNotEmptyCv));
+	assert(thrd_success == cnd_init(&procStatNotFullCv));
+
+	CircularBuffer_t* procStatCbuf = CircularBuffer_create(ProcStatDelta_size(), TEST_FULL_CAPACITY);
+	ProcStatDelta_t* delta = malloc(ProcStatDelta_size());
+	SnapshotSource_t* source = SnapshotSource_createLive(NULL);
+	assert((NULL != procStatCbuf) && (NULL != delta) && (NULL != source));
+
+	ReaderThreadParams_t readerParams =
+	{
+		.outMtx 			= &procStatMtx,
+		.outNotEmptyCv 		= &procStatNotEmptyCv,
+		.outNotFullCv 		= &procStatNotFullCv,
+		.outBuf 			= procStatCbuf,
+		.deltaMode 			= true,
+		.samplePeriodMs 	= TEST_SAMPLE_PERIOD_MS,
+		.alignToWallClock 	= false,
+		.adaptiveParams 	= NULL,
+		.source 			= source
+	};
+
+	thrd_t readerThrd;
+	assert(thrd_success == thrd_create(&readerThrd, ReaderThread, &readerParams));
+
+	// Buffer fills up within first few periods, reader then times out waiting for it while load keeps changing
+	for (unsigned ii = 0; ii < TEST_UPDATE_COUNT; ++ii)
+	{
+		Thread_sleepMs(TEST_SAMPLE_PERIOD_MS);
+		ProcGen_advance(generator, TEST_SIMULATED_STEP_MS);
+		assert(0 == ProcGen_writeFile(generator, root));
+	}
+
+	assert(0 == ProcGen_getCpuStat(generator, 0u, &after));
+	Thread_sleepMs(TEST_FULL_WAIT_MS);
+
+	CpuStatValue_t generated = 0u;
+	CpuStatValue_t read = 0u;
+
+	for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+	{
+		generated += after.values[ii] - before.values[ii];
+	}
+
+	// Drain twice, second time after reader had a chance to write change spanning snapshots it could not write
+	for (unsigned pass = 0; pass < 2u; ++pass)
+	{
+		assert(thrd_success == mtx_lock(&procStatMtx));
+		assert((0u != pass) || CircularBuffer_isFull(procStatCbuf));
+
+		while (CircularBuffer_read(procStatCbuf, delta))
+		{
+			for (size_t ii = 0; ii < CSINDEX_COUNT_; ++ii)
+			{
+				read += delta->cpuDeltas[0].values[ii];
+			}
+		}
+
+		assert(thrd_success == mtx_unlock(&procStatMtx));
+		assert(thrd_success == cnd_signal(&procStatNotFullCv));
+		Thread_sleepMs(TEST_FULL_DRAIN_MS);
+	}
+
+	assert(generated == read);
+
+	Thread_activateKillSwitch();
+	int readerResult;
+	thrd_join(readerThrd, &readerResult);
+	assert(0 == readerResult);
+
+	SnapshotSource_destroy(source);
+	free(delta);
+	CircularBuffer_destroy(procStatCbuf);
+	cnd_destroy(&procStatNotFullCv);
+	cnd_destroy(&procStatNotEmptyCv);
+	mtx_destroy(&procStatMtx);
+	Watchdog_finalize();
+	ThreadInfo_finalize();
+	ProcStat_setProcRoot(NULL);
+	ProcGen_destroy(generator);
+
+	char path[64];
+	snprintf(path, sizeof(path), "%s/stat", root);
+	remove(path);
+	remove(root);
+}
+
+
+int main(int argc, char* argv[])
+{
+	// Kill switch cannot be reset, so every pipeline configuration runs in it's own process
+	const bool deltaMode = (1 < argc) && (0 == strcmp(argv[1], "--delta"));
+
+	if ((1 < argc) && (0 == strcmp(argv[1], "--delta-full")))
+	{
+		testDeltaBufferFull();
+		return 0;
+	}
+
+	testGeneratorFormat();
+	testPipelineAtScale(deltaMode);
+	return 0;
+}
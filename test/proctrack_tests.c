@@ -0,0 +1,364 @@
+#include "proctrack.h"
+#include "batchread.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define TEST_PATH_MAX 			256u
+#define TEST_PROCESS_COUNT 		5u
+#define TEST_TOP_COUNT 			3u
+#define TEST_SLICES 			2u
+#define TEST_FIELD_COUNT 		52u
+#define TEST_SCAN_PERIOD_MS 	20
+#define TEST_BATCH_FILES 		10u
+#define TEST_BATCH_DEPTH 		4u
+
+
+/**
+ * Contents of a single /proc/[pid]/stat file, fields not listed are zero.
+*/
+typedef struct TestProcess
+{
+	int pid;
+	const char* comm;
+	unsigned long long utime;
+	unsigned long long stime;
+	unsigned long long startTime;
+	int processor;
+}
+TestProcess_t;
+
+
+static void writeProcess(const char* root, const TestProcess_t* process)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%d", root, process->pid);
+	mkdir(path, 0700);
+	snprintf(path, sizeof(path), "%s/%d/stat", root, process->pid);
+
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fprintf(file, "%d (%s) S", process->pid, process->comm);
+
+	for (unsigned field = 4u; field <= TEST_FIELD_COUNT; ++field)
+	{
+		switch (field)
+		{
+			case 14u: 	fprintf(file, " %llu", process->utime); 	break;
+			case 15u: 	fprintf(file, " %llu", process->stime); 	break;
+			case 22u: 	fprintf(file, " %llu", process->startTime); break;
+			case 39u: 	fprintf(file, " %d", process->processor); 	break;
+			default: 	fputs(" 0", file); 							break;
+		}
+	}
+
+	fputc('\n', file);
+	fclose(file);
+}
+
+
+static void removeProcess(const char* root, int pid)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%d/stat", root, pid);
+	assert(0 == unlink(path));
+	snprintf(path, sizeof(path), "%s/%d", root, pid);
+	assert(0 == rmdir(path));
+}
+
+
+/**
+ * \brief Runs a full scan, checking that only it's last step completes it.
+*/
+static void scan(ProcTracker_t* tracker, ProcUsageReport_t* report)
+{
+	nanosleep(&(struct timespec) { .tv_nsec = TEST_SCAN_PERIOD_MS * 1000000L }, NULL);
+
+	for (unsigned ii = 1; ii < TEST_SLICES; ++ii)
+	{
+		assert(0 == ProcTracker_step(tracker, report));
+	}
+
+	assert(1 == ProcTracker_step(tracker, report));
+}
+
+
+static void test_ProcTracker_create(void)
+{
+	assert(NULL == ProcTracker_create("/tmp", 0u, TEST_SLICES));
+	assert(NULL == ProcTracker_create("/tmp", TEST_TOP_COUNT, 0u));
+	assert(NULL == ProcTracker_create("/nonexistent/proc", TEST_TOP_COUNT, TEST_SLICES));
+	assert(ProcUsageReport_size(TEST_TOP_COUNT) == sizeof(ProcUsageReport_t) + TEST_TOP_COUNT * sizeof(ProcUsage_t));
+
+	// Processes of this system are scanned by default
+	ProcTracker_t* tracker = ProcTracker_create(NULL, TEST_TOP_COUNT, 1u);
+	assert(NULL != tracker);
+	ProcUsageReport_t* report = malloc(ProcUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+	assert(1 == ProcTracker_step(tracker, report));
+	assert(0u < report->processCount);
+	assert(0u == report->count);
+	free(report);
+	ProcTracker_destroy(tracker);
+}
+
+
+static void test_ProcTracker_step(void)
+{
+	char root[] = "/tmp/cut_proctrack_XXXXXX";
+	assert(NULL != mkdtemp(root));
+
+	// Process name may contain spaces and parentheses, and is longer than reported one
+	TestProcess_t processes[TEST_PROCESS_COUNT] =
+	{
+		{ .pid = 1, 	.comm = "init", 											.startTime = 1u, 	.processor = 0 },
+		{ .pid = 20, 	.comm = "idle", 											.startTime = 5u, 	.processor = 1 },
+		{ .pid = 300, 	.comm = "a (b) c", 											.startTime = 7u, 	.processor = 2 },
+		{ .pid = 4000, 	.comm = "idle too", 										.startTime = 9u, 	.processor = 3 },
+		{ .pid = 50000, .comm = "a name longer than thirty one characters", 		.startTime = 11u, 	.processor = 4 }
+	};
+
+	for (unsigned ii = 0; ii < TEST_PROCESS_COUNT; ++ii)
+	{
+		writeProcess(root, &processes[ii]);
+	}
+
+	ProcTracker_t* tracker = ProcTracker_create(root, TEST_TOP_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	ProcUsageReport_t* report = malloc(ProcUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+
+	// Usage takes two reads of every process
+	scan(tracker, report);
+	assert(TEST_PROCESS_COUNT == report->processCount);
+	assert(0u == report->count);
+	assert(0u == report->intervalNs);
+
+	processes[0].utime += 10u;
+	processes[2].utime += 30u;
+	processes[2].stime += 20u;
+	processes[2].processor = 6;
+	processes[4].stime += 20u;
+
+	for (unsigned ii = 0; ii < TEST_PROCESS_COUNT; ++ii)
+	{
+		writeProcess(root, &processes[ii]);
+	}
+
+	scan(tracker, report);
+	assert(TEST_PROCESS_COUNT == report->processCount);
+	assert(TEST_TOP_COUNT == report->count);
+	assert(0u < report->intervalNs);
+	assert(300 == report->top[0].pid);
+	assert(6 == report->top[0].lastCpu);
+	assert(0 == strcmp("a (b) c", report->top[0].comm));
+	assert(50000 == report->top[1].pid);
+	assert(0 == strncmp("a name longer than thirty one c", report->top[1].comm, PROCTRACK_COMM_LENGTH));
+	assert(1 == report->top[2].pid);
+	assert(report->top[0].usageBp > report->top[1].usageBp);
+	assert(report->top[1].usageBp > report->top[2].usageBp);
+	assert(0u < report->top[2].usageBp);
+
+	// Reused identifier starts over, exited process is dropped and new one picked up
+	processes[2].startTime = 100u;
+	processes[2].utime += 1000u;
+	processes[4].stime += 1u;
+	writeProcess(root, &processes[2]);
+	writeProcess(root, &processes[4]);
+	removeProcess(root, processes[0].pid);
+	writeProcess(root, &(TestProcess_t) { .pid = 6, .comm = "new", .utime = 500u, .startTime = 120u });
+
+	scan(tracker, report);
+	assert(TEST_PROCESS_COUNT == report->processCount);
+	assert(TEST_TOP_COUNT == report->count);
+	assert(50000 == report->top[0].pid);
+	assert(0u < report->top[0].usageBp);
+
+	for (size_t ii = 0; ii < report->count; ++ii)
+	{
+		assert(300 != report->top[ii].pid);
+		assert(6 != report->top[ii].pid);
+	}
+
+	ProcTracker_destroy(tracker);
+	free(report);
+
+	removeProcess(root, 6);
+
+	for (unsigned ii = 1; ii < TEST_PROCESS_COUNT; ++ii)
+	{
+		removeProcess(root, processes[ii].pid);
+	}
+
+	assert(0 == rmdir(root));
+}
+
+
+static void test_ProcTracker_threads(void)
+{
+	char root[] = "/tmp/cut_procthreads_XXXXXX";
+	char path[TEST_PATH_MAX];
+	char taskRoot[TEST_PATH_MAX];
+	assert(NULL != mkdtemp(root));
+
+	// Process identifier is given either as a number or in PID file
+	assert(4321 == ProcTracker_resolvePid("4321"));
+	snprintf(path, sizeof(path), "%s/service.pid", root);
+	FILE* pidFile = fopen(path, "w");
+	assert(NULL != pidFile);
+	fputs("77\n", pidFile);
+	fclose(pidFile);
+	assert(77 == ProcTracker_resolvePid(path));
+	assert(0 > ProcTracker_resolvePid("0"));
+	assert(0 > ProcTracker_resolvePid(""));
+	assert(0 > ProcTracker_resolvePid("/nonexistent/service.pid"));
+	assert(0 == unlink(path));
+
+	// Threads of this very process
+	ProcUsageReport_t* report = malloc(ProcUsageReport_size(TEST_TOP_COUNT));
+	assert(NULL != report);
+	ProcTracker_t* tracker = ProcTracker_createForThreads(NULL, getpid(), TEST_TOP_COUNT, 1u);
+	assert(NULL != tracker);
+	assert(getpid() == ProcTracker_getTargetPid(tracker));
+	assert(1 == ProcTracker_step(tracker, report));
+	assert(1u <= report->processCount);
+	assert(getpid() == report->targetPid);
+	ProcTracker_destroy(tracker);
+
+	// Process 77 has two threads, only it's task directory is scanned
+	snprintf(path, sizeof(path), "%s/77", root);
+	assert(0 == mkdir(path, 0700));
+	snprintf(taskRoot, sizeof(taskRoot), "%s/77/task", root);
+	assert(0 == mkdir(taskRoot, 0700));
+	TestProcess_t threads[2] =
+	{
+		{ .pid = 77, .comm = "service", .startTime = 3u, .processor = 1 },
+		{ .pid = 78, .comm = "worker", .startTime = 4u, .processor = 5 }
+	};
+	writeProcess(taskRoot, &threads[0]);
+	writeProcess(taskRoot, &threads[1]);
+	writeProcess(root, &(TestProcess_t) { .pid = 90, .comm = "other", .startTime = 2u });
+
+	assert(NULL == ProcTracker_createForThreads(root, 88, TEST_TOP_COUNT, TEST_SLICES));
+	tracker = ProcTracker_createForThreads(root, 77, TEST_TOP_COUNT, TEST_SLICES);
+	assert(NULL != tracker);
+	scan(tracker, report);
+	assert(2u == report->processCount);
+	assert(77 == report->targetPid);
+
+	threads[1].utime += 40u;
+	writeProcess(taskRoot, &threads[1]);
+	scan(tracker, report);
+	assert(2u == report->count);
+	assert(78 == report->top[0].pid);
+	assert(5 == report->top[0].lastCpu);
+	assert(0 == strcmp("worker", report->top[0].comm));
+
+	// Exited process leaves empty task directory behind, until another process is followed
+	removeProcess(taskRoot, 77);
+	removeProcess(taskRoot, 78);
+	assert(PROCTRACK_TARGET_EXITED == ProcTracker_step(tracker, report));
+	assert(0 > ProcTracker_setTargetPid(tracker, 88));
+	assert(77 == ProcTracker_getTargetPid(tracker));
+	assert(0 == rmdir(taskRoot));
+	snprintf(path, sizeof(path), "%s/77", root);
+	assert(0 == rmdir(path));
+
+	snprintf(path, sizeof(path), "%s/90/task", root);
+	assert(0 == mkdir(path, 0700));
+	writeProcess(path, &(TestProcess_t) { .pid = 90, .comm = "other", .startTime = 2u });
+	assert(0 == ProcTracker_setTargetPid(tracker, 90));
+	scan(tracker, report);
+	assert(1u == report->processCount);
+	assert(90 == report->targetPid);
+	ProcTracker_destroy(tracker);
+	free(report);
+
+	removeProcess(path, 90);
+	assert(0 == rmdir(path));
+	removeProcess(root, 90);
+	assert(0 == rmdir(root));
+}
+
+
+static void test_BatchReader_read(BatchReadBackend_t backend)
+{
+	char root[] = "/tmp/cut_batchread_XXXXXX";
+	char path[TEST_PATH_MAX];
+	char buffers[TEST_BATCH_FILES + 1u][TEST_PATH_MAX];
+	BatchReadRequest_t requests[TEST_BATCH_FILES + 1u];
+	assert(NULL != mkdtemp(root));
+
+	assert(NULL == BatchReader_create(0u, backend));
+	BatchReader_t* reader = BatchReader_create(TEST_BATCH_DEPTH, backend);
+	assert(NULL != reader);
+	assert(BREAD_BACKEND_AUTO != BatchReader_getBackend(reader));
+	assert((BREAD_BACKEND_PREADV != backend) || (BREAD_BACKEND_PREADV == BatchReader_getBackend(reader)));
+
+	// More files than depth, so that they are split into batches, and one descriptor that is not open
+	for (unsigned ii = 0; ii < TEST_BATCH_FILES; ++ii)
+	{
+		snprintf(path, sizeof(path), "%s/%u", root, ii);
+		FILE* file = fopen(path, "w");
+		assert(NULL != file);
+		fprintf(file, "file %u", ii);
+		fclose(file);
+		requests[ii] = (BatchReadRequest_t) { .fd = open(path, O_RDONLY), .buf = buffers[ii], .size = TEST_PATH_MAX };
+		assert(0 <= requests[ii].fd);
+	}
+
+	requests[TEST_BATCH_FILES] = (BatchReadRequest_t) { .fd = -1, .buf = buffers[TEST_BATCH_FILES], .size = TEST_PATH_MAX };
+
+	// Files are read from the beginning every time
+	for (unsigned pass = 0; pass < 2u; ++pass)
+	{
+		const unsigned long long syscalls = BatchReader_getSyscallCount(reader);
+		assert(0 == BatchReader_read(reader, requests, TEST_BATCH_FILES + 1u));
+
+		for (unsigned ii = 0; ii < TEST_BATCH_FILES; ++ii)
+		{
+			char expected[TEST_PATH_MAX];
+			const int length = snprintf(expected, sizeof(expected), "file %u", ii);
+			assert(length == requests[ii].result);
+			assert(0 == memcmp(expected, buffers[ii], (size_t) length));
+		}
+
+		assert(-EBADF == requests[TEST_BATCH_FILES].result);
+
+		// io_uring takes a single call per batch
+		const unsigned long long expectedSyscalls = (BREAD_BACKEND_URING == BatchReader_getBackend(reader))
+			? (TEST_BATCH_FILES + TEST_BATCH_DEPTH) / TEST_BATCH_DEPTH
+			: TEST_BATCH_FILES + 1u;
+		assert(expectedSyscalls == BatchReader_getSyscallCount(reader) - syscalls);
+	}
+
+	assert(0 == BatchReader_read(reader, requests, 0u));
+	BatchReader_destroy(reader);
+
+	for (unsigned ii = 0; ii < TEST_BATCH_FILES; ++ii)
+	{
+		close(requests[ii].fd);
+		snprintf(path, sizeof(path), "%s/%u", root, ii);
+		assert(0 == unlink(path));
+	}
+
+	assert(0 == rmdir(root));
+}
+
+
+int main(void)
+{
+	test_BatchReader_read(BREAD_BACKEND_PREADV);
+	test_BatchReader_read(BREAD_BACKEND_AUTO);
+	test_ProcTracker_create();
+	test_ProcTracker_step();
+	test_ProcTracker_threads();
+	return 0;
+}
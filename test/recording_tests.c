@@ -0,0 +1,303 @@
+#include "recording.h"
+#include "varint.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+#define TEST_CPU_STATS_LENGTH 		65u
+#define TEST_SAMPLE_COUNT 			200u
+#define TEST_KEYFRAME_INTERVAL 		16u
+#define TEST_SEGMENT_BYTES 			4096u
+#define TEST_PERIOD_NS 				1000000000ull
+
+
+static void testVarint(void)
+{
+	static const uint64_t VALUES[] = { 0u, 1u, 127u, 128u, 300u, 16383u, 16384u, UINT32_MAX, UINT64_MAX };
+	uint8_t buf[VARINT_MAX_LENGTH];
+
+	for (size_t ii = 0; ii < sizeof(VALUES) / sizeof(VALUES[0]); ++ii)
+	{
+		uint64_t decoded = 0u;
+		size_t length = Varint_encode(VALUES[ii], buf);
+
+		assert(0u < length && length <= VARINT_MAX_LENGTH);
+		assert(length == Varint_decode(buf, length, &decoded)); // Value should round-trip
+		assert(VALUES[ii] == decoded);
+		assert(0u == Varint_decode(buf, length - 1u, &decoded)); // Truncated value should be rejected
+	}
+
+	static const int64_t SIGNED_VALUES[] = { 0, -1, 1, -2, 2, INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX };
+
+	for (size_t ii = 0; ii < sizeof(SIGNED_VALUES) / sizeof(SIGNED_VALUES[0]); ++ii)
+	{
+		assert(SIGNED_VALUES[ii] == Varint_zigzagDecode(Varint_zigzagEncode(SIGNED_VALUES[ii])));
+	}
+
+	assert(1u == Varint_zigzagEncode(-1));
+	assert(2u == Varint_zigzagEncode(1));
+}
+
+
+static void fillSample(ProcStat_t* sample, size_t index)
+{
+	sample->timestampNs = 5000000000ull + index * TEST_PERIOD_NS;
+
+	for (size_t ii = 0; ii < sample->cpuStatsLength; ++ii)
+	{
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			// Mostly growing counters, with one occasionally stepping backwards
+			CpuStatValue_t value = 1000000ull * (jj + 1u) + index * (ii + jj);
+
+			if ((CSINDEX_IOWAIT == jj) && (index % 7u == 3u))
+			{
+				value -= 5u;
+			}
+
+			sample->cpuStats[ii].values[jj] = value;
+		}
+	}
+}
+
+
+static uint8_t* loadFile(const char* path, size_t* length)
+{
+	FILE* file = fopen(path, "rb");
+
+	if (NULL == file)
+	{
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	*length = (size_t) ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	uint8_t* data = malloc(*length);
+	assert(NULL != data);
+	assert(1u == fread(data, *length, 1u, file));
+	fclose(file);
+	return data;
+}
+
+
+static void testWriter(void)
+{
+	char dir[] = "/tmp/cut_recording_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char basePath[64];
+	snprintf(basePath, sizeof(basePath), "%s/rec", dir);
+
+	const size_t sampleSize = sizeof(ProcStat_t) + TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t);
+	ProcStat_t* expected = malloc(sampleSize);
+	ProcStat_t* decoded = malloc(sampleSize);
+	assert((NULL != expected) && (NULL != decoded));
+	expected->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, TEST_CPU_STATS_LENGTH, TEST_SEGMENT_BYTES, TEST_KEYFRAME_INTERVAL);
+	assert(NULL != writer);
+
+	for (size_t ii = 0; ii < TEST_SAMPLE_COUNT; ++ii)
+	{
+		fillSample(expected, ii);
+		assert(0 == RecordingWriter_append(writer, expected));
+	}
+
+	RecordingWriter_destroy(writer);
+
+	// Decode every segment independently and compare against generated samples
+	size_t sampleIndex = 0u;
+	size_t totalBytes = 0u;
+	unsigned segmentCount = 0u;
+
+	for (;; ++segmentCount)
+	{
+		char path[96];
+		snprintf(path, sizeof(path), "%s.%06u" RECORDING_SEGMENT_EXTENSION, basePath, segmentCount);
+
+		size_t length = 0u;
+		uint8_t* data = loadFile(path, &length);
+
+		if (NULL == data)
+		{
+			break;
+		}
+
+		RecordingHeader_t header;
+		assert(0 == Recording_decodeHeader(data, length, &header));
+		assert(TEST_CPU_STATS_LENGTH == header.cpuStatsLength);
+		assert(TEST_KEYFRAME_INTERVAL == header.keyframeInterval);
+		assert(0u != header.endRealTimeNs); // Header should be completed once segment is closed
+		assert(RECORDING_TAG_KEYFRAME == data[RECORDING_HEADER_SIZE]); // Segments should start with a keyframe
+
+		decoded->cpuStatsLength = header.cpuStatsLength;
+		size_t offset = RECORDING_HEADER_SIZE;
+		uint64_t segmentSamples = 0u;
+
+		while (offset < length)
+		{
+			size_t consumed = Recording_decodeRecord(data + offset, length - offset, decoded);
+			assert(0u != consumed);
+			offset += consumed;
+
+			fillSample(expected, sampleIndex++);
+			assert(expected->timestampNs == decoded->timestampNs);
+			assert(0 == memcmp(expected->cpuStats, decoded->cpuStats, TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t)));
+			++segmentSamples;
+		}
+
+		assert(header.sampleCount == segmentSamples);
+		totalBytes += length;
+		free(data);
+		remove(path);
+		snprintf(path, sizeof(path), "%s.%06u" RECORDING_INDEX_EXTENSION, basePath, segmentCount);
+		remove(path);
+	}
+
+	assert(TEST_SAMPLE_COUNT == sampleIndex); // Every sample should be recovered
+	assert(1u < segmentCount); // Recording should have rolled over to further segments
+	// Encoded recording should be several times smaller than raw counters, despite frequent keyframes
+	assert(totalBytes * 4u < TEST_SAMPLE_COUNT * TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t));
+
+	remove(dir);
+	free(decoded);
+	free(expected);
+}
+
+
+static void testSegmentReader(void)
+{
+	char dir[] = "/tmp/cut_recording_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char basePath[64];
+	char segmentPath[96];
+	char indexPath[96];
+	snprintf(basePath, sizeof(basePath), "%s/rec", dir);
+	snprintf(segmentPath, sizeof(segmentPath), "%s.000000" RECORDING_SEGMENT_EXTENSION, basePath);
+	snprintf(indexPath, sizeof(indexPath), "%s.000000" RECORDING_INDEX_EXTENSION, basePath);
+
+	const size_t sampleSize = sizeof(ProcStat_t) + TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t);
+	ProcStat_t* expected = malloc(sampleSize);
+	ProcStat_t* decoded = malloc(sampleSize);
+	assert((NULL != expected) && (NULL != decoded));
+	expected->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+	decoded->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, TEST_CPU_STATS_LENGTH, SIZE_MAX, TEST_KEYFRAME_INTERVAL);
+	assert(NULL != writer);
+
+	for (size_t ii = 0; ii < TEST_SAMPLE_COUNT; ++ii)
+	{
+		fillSample(expected, ii);
+		assert(0 == RecordingWriter_append(writer, expected));
+	}
+
+	RecordingWriter_destroy(writer);
+
+	// Second pass runs without index file, which has to be rebuilt from segment contents
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		RecordingSegment_t* segment = RecordingSegment_open(segmentPath);
+		assert(NULL != segment);
+		assert(TEST_SAMPLE_COUNT == RecordingSegment_getHeader(segment)->sampleCount);
+
+		static const size_t TARGETS[] = { 0u, 1u, 15u, 16u, 17u, 100u, TEST_SAMPLE_COUNT - 1u };
+
+		for (size_t ii = 0; ii < sizeof(TARGETS) / sizeof(TARGETS[0]); ++ii)
+		{
+			fillSample(expected, TARGETS[ii]);
+
+			// Seeking should land on the nearest preceding keyframe, at most a keyframe interval away
+			size_t offset = RecordingSegment_seek(segment, expected->timestampNs);
+			size_t decodedCount = 0u;
+
+			do
+			{
+				offset = RecordingSegment_next(segment, offset, decoded);
+				assert(0u != offset);
+				++decodedCount;
+			}
+			while (decoded->timestampNs < expected->timestampNs);
+
+			assert(decodedCount <= TEST_KEYFRAME_INTERVAL);
+			assert(0 == memcmp(expected->cpuStats, decoded->cpuStats, TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t)));
+		}
+
+		// Clock conversions should be inverse of each other
+		const uint64_t realTimeNs = RecordingSegment_getHeader(segment)->startRealTimeNs + 12345u;
+		assert(realTimeNs == RecordingSegment_toRealTime(segment, RecordingSegment_toMonotonic(segment, realTimeNs)));
+		assert((0u == RecordingSegment_toMonotonic(NULL, realTimeNs)) && (0u == RecordingSegment_toRealTime(NULL, realTimeNs)));
+
+		RecordingSegment_close(segment);
+		remove(indexPath);
+	}
+
+	remove(segmentPath);
+	remove(dir);
+	free(decoded);
+	free(expected);
+}
+
+
+static void testOpenSegment(void)
+{
+	char dir[] = "/tmp/cut_recording_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char basePath[64];
+	char segmentPath[96];
+	char indexPath[96];
+	snprintf(basePath, sizeof(basePath), "%s/rec", dir);
+	snprintf(segmentPath, sizeof(segmentPath), "%s.000000" RECORDING_SEGMENT_EXTENSION, basePath);
+	snprintf(indexPath, sizeof(indexPath), "%s.000000" RECORDING_INDEX_EXTENSION, basePath);
+
+	const size_t sampleSize = sizeof(ProcStat_t) + TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t);
+	ProcStat_t* expected = malloc(sampleSize);
+	ProcStat_t* decoded = malloc(sampleSize);
+	assert((NULL != expected) && (NULL != decoded));
+	expected->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+	decoded->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, TEST_CPU_STATS_LENGTH, SIZE_MAX, TEST_KEYFRAME_INTERVAL);
+	assert(NULL != writer);
+
+	for (size_t ii = 0; ii <= TEST_KEYFRAME_INTERVAL; ++ii)
+	{
+		fillSample(expected, ii);
+		assert(0 == RecordingWriter_append(writer, expected));
+	}
+
+	// Segment still being written is readable up to the last keyframe, which is indexed only once it has been written out
+	RecordingSegment_t* segment = RecordingSegment_open(segmentPath);
+	assert(NULL != segment);
+	size_t offset = RecordingSegment_seek(segment, expected->timestampNs);
+	assert(RECORDING_HEADER_SIZE < offset);
+	assert(0u != RecordingSegment_next(segment, offset, decoded));
+	assert(expected->timestampNs == decoded->timestampNs);
+	assert(0 == memcmp(expected->cpuStats, decoded->cpuStats, TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t)));
+	RecordingSegment_close(segment);
+
+	RecordingWriter_destroy(writer);
+	remove(indexPath);
+	remove(segmentPath);
+	remove(dir);
+	free(decoded);
+	free(expected);
+}
+
+
+int main()
+{
+	testVarint();
+	testWriter();
+	testSegmentReader();
+	testOpenSegment();
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+#include "recquery.h"
+#include "recording.h"
+#include "helpers.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+#define TEST_CPU_STATS_LENGTH 		3u
+#define TEST_SAMPLE_COUNT 			600u
+#define TEST_KEYFRAME_INTERVAL 		16u
+#define TEST_SEGMENT_BYTES 			4096u
+#define TEST_PERIOD_NS 				1000000000ull
+#define TEST_OUTPUT_MAX 			4096u
+
+
+/**
+ * \brief Writes recording of two processors, first one busy for a quarter of every interval and second one for three quarters.
+*/
+static void writeRecording(const char* basePath)
+{
+	const size_t sampleSize = sizeof(ProcStat_t) + TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t);
+	ProcStat_t* sample = calloc(1u, sampleSize);
+	assert(NULL != sample);
+	sample->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, TEST_CPU_STATS_LENGTH, TEST_SEGMENT_BYTES, TEST_KEYFRAME_INTERVAL);
+	assert(NULL != writer);
+	const unsigned long long startNs = MonotonicTimeNs();
+
+	for (size_t ii = 0; ii < TEST_SAMPLE_COUNT; ++ii)
+	{
+		sample->timestampNs = startNs + ii * TEST_PERIOD_NS;
+		sample->cpuStats[1].values[CSINDEX_USER] += 25u;
+		sample->cpuStats[1].values[CSINDEX_IDLE] += 75u;
+		sample->cpuStats[2].values[CSINDEX_USER] += 75u;
+		sample->cpuStats[2].values[CSINDEX_IDLE] += 25u;
+		sample->cpuStats[0].values[CSINDEX_USER] += 100u;
+		sample->cpuStats[0].values[CSINDEX_IDLE] += 100u;
+		assert(0 == RecordingWriter_append(writer, sample));
+	}
+
+	RecordingWriter_destroy(writer);
+	free(sample);
+}
+
+
+/**
+ * \brief Runs query, capturing it's output.
+*/
+static int runQuery(const RecordingQuery_t* query, const char* basePath, char* text)
+{
+	char path[64];
+	snprintf(path, sizeof(path), "%s", basePath);
+	char* paths[] = { path };
+
+	// Stream left unwritten does not terminate the buffer
+	memset(text, 0, TEST_OUTPUT_MAX);
+	FILE* out = fmemopen(text, TEST_OUTPUT_MAX, "w");
+	assert(NULL != out);
+	const int retval = RecordingQuery_run(query, paths, 1u, out);
+	fclose(out);
+	return retval;
+}
+
+
+static void testAggregates(const char* basePath)
+{
+	char text[TEST_OUTPUT_MAX];
+	RecordingQuery_t query =
+	{
+		.fromNs 	= 0u,
+		.untilNs 	= UINT64_MAX,
+		.cpus 		= { 1, 0 },
+		.cpusLength = 2u
+	};
+
+	assert(0 == runQuery(&query, basePath, text));
+
+	// Usage of every interval between recorded samples is accounted for, across all segments
+	char name[16];
+	size_t samples = 0u;
+	double min = 0.0, mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+	const char* line = strchr(text, '\n');
+	assert(NULL != line);
+	assert(7 == sscanf(line + 1, "%15s %zu %lf %lf %lf %lf %lf", name, &samples, &min, &mean, &p50, &p90, &p99));
+	assert((0 == strcmp(name, "cpu1")) && (TEST_SAMPLE_COUNT - 1u == samples));
+	assert((75.0 == min) && (75.0 == mean) && (75.0 == p99));
+
+	line = strchr(line + 1, '\n');
+	assert(NULL != line);
+	assert(8 == sscanf(line + 1, "%15s %zu %lf %lf %lf %lf %lf %lf", name, &samples, &min, &mean, &p50, &p90, &p99, &max));
+	assert((0 == strcmp(name, "cpu0")) && (TEST_SAMPLE_COUNT - 1u == samples));
+	assert((25.0 == min) && (25.0 == mean) && (25.0 == max));
+
+	// Total line is queried if no processor is selected
+	query.cpusLength = 0u;
+	assert(0 == runQuery(&query, basePath, text));
+	line = strchr(text, '\n');
+	assert(NULL != line);
+	assert(4 == sscanf(line + 1, "%15s %zu %lf %lf", name, &samples, &min, &mean));
+	assert((0 == strcmp(name, "cpu")) && (50.0 == mean));
+
+	// Processor missing from recording is rejected
+	query.cpus[0] = 2;
+	query.cpusLength = 1u;
+	assert(0 > runQuery(&query, basePath, text));
+}
+
+
+static void testSeries(const char* basePath)
+{
+	char text[TEST_OUTPUT_MAX];
+	RecordingQuery_t query =
+	{
+		.fromNs 	= 0u,
+		.untilNs 	= UINT64_MAX,
+		.stepNs 	= 60u * TEST_PERIOD_NS,
+		.cpus 		= { 0, RECQUERY_SELECT_TOTAL },
+		.cpusLength = 2u
+	};
+
+	assert(0 == runQuery(&query, basePath, text));
+
+	// Every bucket has usage of both selected lines, and nothing else
+	size_t buckets = 0u;
+
+	for (const char* line = strchr(text, '\n'); (NULL != line) && ('\0' != line[1]); line = strchr(line + 1, '\n'), ++buckets)
+	{
+		char time[32];
+		double cpu0 = 0.0, total = 0.0;
+		int length = 0;
+		assert(3 == sscanf(line + 1, "%31s %lf %lf%n", time, &cpu0, &total, &length));
+		assert((25.0 == cpu0) && (50.0 == total) && ('\n' == line[1 + length]));
+	}
+
+	assert(TEST_SAMPLE_COUNT / 60u - 1u <= buckets);
+}
+
+
+int main()
+{
+	char dir[] = "/tmp/cut_recquery_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char basePath[64];
+	snprintf(basePath, sizeof(basePath), "%s/rec", dir);
+	writeRecording(basePath);
+
+	testAggregates(basePath);
+	testSeries(basePath);
+
+	char path[96];
+
+	for (unsigned seq = 0u; ; ++seq)
+	{
+		snprintf(path, sizeof(path), "%s.%06u" RECORDING_INDEX_EXTENSION, basePath, seq);
+		remove(path);
+		snprintf(path, sizeof(path), "%s.%06u" RECORDING_SEGMENT_EXTENSION, basePath, seq);
+
+		if (0 != remove(path))
+		{
+			assert(1u < seq); // Recording should have spanned several segments
+			break;
+		}
+	}
+
+	remove(dir);
+	return 0;
+}
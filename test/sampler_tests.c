@@ -0,0 +1,174 @@
+#include "sampler.h"
+#include "helpers.h"
+#include <assert.h>
+#include <stddef.h>
+#include <time.h>
+
+
+#define TEST_PERIOD_MS					20u
+#define TEST_PERIOD_NS					(TEST_PERIOD_MS * 1000000ull)
+#define TEST_STALLED_PERIODS			5u
+#define TEST_ALIGNED_PERIOD_MS			100u
+#define TEST_ADAPTIVE_CEILING_MS		1000u
+#define TEST_ADAPTIVE_THRESHOLD_PCT		5.0
+// Real and monotonic clocks cannot be read at once, so their offset is only known this closely
+#define TEST_CLOCK_SKEW_NS				1000000ull
+
+
+/**
+ * \brief Stalls calling thread, as if it had taken that long to process a sample.
+*/
+static void stallNs(unsigned long long ns)
+{
+	const struct timespec duration = { .tv_sec = ns / 1000000000ull, .tv_nsec = ns % 1000000000ull };
+	struct timespec remaining;
+
+	while (0 != nanosleep(&duration, &remaining))
+	{
+	}
+}
+
+
+static void test_SamplerClock_init(void)
+{
+	SamplerClock_t clock;
+	assert(0 > SamplerClock_init(NULL, TEST_PERIOD_MS, false));
+	assert(0 > SamplerClock_init(&clock, SAMPLER_MIN_PERIOD_MS - 1u, false));
+	assert(0 > SamplerClock_init(&clock, SAMPLER_MAX_PERIOD_MS + 1u, false));
+	assert(0 == SamplerClock_init(&clock, TEST_PERIOD_MS, false));
+	assert(TEST_PERIOD_MS == SamplerClock_getPeriod(&clock));
+
+	// First deadline is due immediately
+	assert(1 == SamplerClock_wait(&clock, 0u));
+	assert(1u == SamplerClock_getStats(&clock)->ticks);
+}
+
+
+static void test_SamplerClock_wait(void)
+{
+	SamplerClock_t clock;
+	assert(0 == SamplerClock_init(&clock, TEST_PERIOD_MS, false));
+	assert(1 == SamplerClock_wait(&clock, 0u));
+	const unsigned long long firstDeadlineNs = clock.deadlineNs - TEST_PERIOD_NS;
+
+	// Slice shorter than the rest of the period elapses without a tick
+	assert(0 == SamplerClock_wait(&clock, 1u));
+	assert(1u == SamplerClock_getStats(&clock)->ticks);
+
+	// Deadlines advance by exactly one period, however late the thread wakes up
+	for (unsigned ii = 1; ii <= TEST_STALLED_PERIODS; ++ii)
+	{
+		while (0 == SamplerClock_wait(&clock, TEST_PERIOD_MS))
+		{
+		}
+
+		assert(MonotonicTimeNs() >= firstDeadlineNs + ii * TEST_PERIOD_NS);
+		assert(clock.deadlineNs == firstDeadlineNs + (ii + 1u) * TEST_PERIOD_NS);
+	}
+
+	// Jitter of every tick is recorded
+	const SamplerStats_t* stats = SamplerClock_getStats(&clock);
+	assert(1u + TEST_STALLED_PERIODS == stats->ticks);
+	assert(stats->maxJitterNs >= stats->lastJitterNs);
+	assert(stats->totalJitterNs >= stats->maxJitterNs);
+	const unsigned long long totalJitterNs = stats->totalJitterNs;
+	const unsigned long long deadlineNs = clock.deadlineNs;
+
+	// Iteration taking several periods misses every deadline it has overrun, only the most recent one ticks,
+	// late by less than a period
+	stallNs((TEST_STALLED_PERIODS + 1u) * TEST_PERIOD_NS);
+	assert(1 == SamplerClock_wait(&clock, TEST_PERIOD_MS));
+	assert(2u + TEST_STALLED_PERIODS == stats->ticks);
+	assert(TEST_STALLED_PERIODS <= stats->missedDeadlines);
+	assert(clock.deadlineNs == deadlineNs + (stats->missedDeadlines + 1u) * TEST_PERIOD_NS);
+	assert((0u < stats->lastJitterNs) && (stats->lastJitterNs < TEST_PERIOD_NS));
+	assert(totalJitterNs + stats->lastJitterNs == stats->totalJitterNs);
+	assert(stats->maxJitterNs >= stats->lastJitterNs);
+}
+
+
+static void test_SamplerClock_align(void)
+{
+	SamplerClock_t clock;
+	const unsigned long long periodNs = TEST_ALIGNED_PERIOD_MS * 1000000ull;
+	const unsigned long long beforeNs = MonotonicTimeNs();
+	assert(0 == SamplerClock_init(&clock, TEST_ALIGNED_PERIOD_MS, true));
+	const unsigned long long offsetNs = RealTimeNs() - MonotonicTimeNs();
+
+	// First deadline falls on the next multiple of the period in real time, within a period from now
+	assert((beforeNs < clock.deadlineNs) && (clock.deadlineNs <= beforeNs + periodNs + TEST_CLOCK_SKEW_NS));
+	const unsigned long long sinceBoundaryNs = (clock.deadlineNs + offsetNs) % periodNs;
+	assert((sinceBoundaryNs < TEST_CLOCK_SKEW_NS) || (sinceBoundaryNs > periodNs - TEST_CLOCK_SKEW_NS));
+
+	// Every following deadline stays aligned
+	while (0 == SamplerClock_wait(&clock, TEST_ALIGNED_PERIOD_MS))
+	{
+	}
+
+	const unsigned long long nextSinceBoundaryNs = (clock.deadlineNs + offsetNs) % periodNs;
+	assert((nextSinceBoundaryNs < TEST_CLOCK_SKEW_NS) || (nextSinceBoundaryNs > periodNs - TEST_CLOCK_SKEW_NS));
+}
+
+
+static void test_SamplerClock_setPeriod(void)
+{
+	SamplerClock_t clock;
+	assert(0 == SamplerClock_init(&clock, TEST_ALIGNED_PERIOD_MS, false));
+	assert(1 == SamplerClock_wait(&clock, 0u));
+	const unsigned long long tickNs = clock.deadlineNs - TEST_ALIGNED_PERIOD_MS * 1000000ull;
+
+	// Next deadline is rebased onto the most recent tick rather than waiting out the old period
+	assert(0 == SamplerClock_setPeriod(&clock, TEST_PERIOD_MS));
+	assert((TEST_PERIOD_MS == SamplerClock_getPeriod(&clock)) && (tickNs + TEST_PERIOD_NS == clock.deadlineNs));
+	assert(0 > SamplerClock_setPeriod(&clock, SAMPLER_MIN_PERIOD_MS - 1u));
+	assert(0 > SamplerClock_setPeriod(NULL, TEST_PERIOD_MS));
+	assert((TEST_PERIOD_MS == SamplerClock_getPeriod(&clock)) && (tickNs + TEST_PERIOD_NS == clock.deadlineNs));
+
+	assert(1 == SamplerClock_wait(&clock, TEST_ALIGNED_PERIOD_MS));
+	assert(tickNs + 2u * TEST_PERIOD_NS == clock.deadlineNs);
+}
+
+
+static void test_SamplerClock_adapt(void)
+{
+	const SamplerAdaptiveParams_t params =
+	{
+		.floorMs 		= TEST_PERIOD_MS,
+		.ceilingMs 		= TEST_ADAPTIVE_CEILING_MS,
+		.thresholdPct 	= TEST_ADAPTIVE_THRESHOLD_PCT
+	};
+
+	SamplerClock_t clock;
+	assert(0 == SamplerClock_init(&clock, TEST_ALIGNED_PERIOD_MS, false));
+	assert(0 > SamplerClock_adapt(&clock, NULL, 0.0));
+	assert(0 > SamplerClock_adapt(NULL, &params, 0.0));
+
+	// Change above threshold tightens period to the floor straight away
+	assert(0 == SamplerClock_adapt(&clock, &params, TEST_ADAPTIVE_THRESHOLD_PCT + 0.5));
+	assert(TEST_PERIOD_MS == SamplerClock_getPeriod(&clock));
+
+	// Period doubles while change stays at threshold or below, up to the ceiling, which it is clamped to
+	const unsigned expectedMs[] = { 40u, 80u, 160u, 320u, 640u, TEST_ADAPTIVE_CEILING_MS, TEST_ADAPTIVE_CEILING_MS };
+
+	for (size_t ii = 0; ii < sizeof(expectedMs) / sizeof(expectedMs[0]); ++ii)
+	{
+		const unsigned long long tickNs = clock.deadlineNs - clock.periodNs;
+		assert(0 == SamplerClock_adapt(&clock, &params, TEST_ADAPTIVE_THRESHOLD_PCT));
+		assert(expectedMs[ii] == SamplerClock_getPeriod(&clock));
+		assert(tickNs + expectedMs[ii] * 1000000ull == clock.deadlineNs);
+	}
+
+	assert(0 == SamplerClock_adapt(&clock, &params, 2.0 * TEST_ADAPTIVE_THRESHOLD_PCT));
+	assert(TEST_PERIOD_MS == SamplerClock_getPeriod(&clock));
+}
+
+
+int main(void)
+{
+	test_SamplerClock_init();
+	test_SamplerClock_wait();
+	test_SamplerClock_align();
+	test_SamplerClock_setPeriod();
+	test_SamplerClock_adapt();
+	return 0;
+}
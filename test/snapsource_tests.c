@@ -0,0 +1,140 @@
+#include "snapsource.h"
+#include "recording.h"
+#include "procstat.h"
+#include "cpucount.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TEST_CPU_STATS_LENGTH 		9u
+#define TEST_SAMPLE_COUNT 			100u
+#define TEST_KEYFRAME_INTERVAL 		8u
+
+
+static void fillSample(ProcStat_t* sample, size_t index)
+{
+	sample->timestampNs = 1000000000ull + index * 10000000ull;
+
+	for (size_t ii = 0; ii < sample->cpuStatsLength; ++ii)
+	{
+		for (size_t jj = 0; jj < CSINDEX_COUNT_; ++jj)
+		{
+			sample->cpuStats[ii].values[jj] = 1000u * ii + index * jj;
+		}
+	}
+}
+
+
+static void testLiveSource(void)
+{
+	CpuCount_init();
+
+	SnapshotSource_t* source = SnapshotSource_createLive(NULL);
+	assert(NULL != source);
+	assert(SNAPSHOT_PACING_CLOCK == SnapshotSource_getPacing(source));
+
+	ProcStat_t* snapshot = malloc(ProcStat_size());
+	assert(NULL != snapshot);
+	assert(1 == SnapshotSource_next(source, snapshot));
+	assert((size_t) CpuCount_get() + 1u == snapshot->cpuStatsLength);
+	assert(0u != snapshot->timestampNs);
+
+	// Frequencies are not sampled without directory to read them from
+	assert(!SnapshotSource_hasFreqs(source));
+
+	free(snapshot);
+	SnapshotSource_destroy(source);
+
+	// Sampled once any tracked processor has cpufreq directory
+	char dir[] = "/tmp/cut_snapsource_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char command[128];
+	snprintf(command, sizeof(command), "mkdir -p %s/cpu/cpu0/cpufreq", dir);
+	assert(0 == system(command));
+
+	static const char* const FREQ_FILES[] = { "cpuinfo_max_freq", "scaling_cur_freq" };
+
+	for (size_t ii = 0; ii < sizeof(FREQ_FILES) / sizeof(FREQ_FILES[0]); ++ii)
+	{
+		char path[96];
+		snprintf(path, sizeof(path), "%s/cpu/cpu0/cpufreq/%s", dir, FREQ_FILES[ii]);
+		FILE* file = fopen(path, "w");
+		assert(NULL != file);
+		fputs("3000000\n", file);
+		fclose(file);
+	}
+
+	source = SnapshotSource_createLive(dir);
+	assert(NULL != source);
+	assert(SnapshotSource_hasFreqs(source));
+	SnapshotSource_destroy(source);
+
+	snprintf(command, sizeof(command), "rm -rf %s", dir);
+	assert(0 == system(command));
+}
+
+
+static void testReplaySource(void)
+{
+	char dir[] = "/tmp/cut_snapsource_XXXXXX";
+	assert(NULL != mkdtemp(dir));
+
+	char basePath[64];
+	snprintf(basePath, sizeof(basePath), "%s/rec", dir);
+
+	const size_t sampleSize = sizeof(ProcStat_t) + TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t);
+	ProcStat_t* expected = malloc(sampleSize);
+	ProcStat_t* replayed = malloc(sampleSize);
+	assert((NULL != expected) && (NULL != replayed));
+	expected->cpuStatsLength = TEST_CPU_STATS_LENGTH;
+
+	// Small segments make replay cross several segment boundaries
+	RecordingWriter_t* writer = RecordingWriter_create(basePath, TEST_CPU_STATS_LENGTH, 0u, TEST_KEYFRAME_INTERVAL);
+	assert(NULL != writer);
+
+	for (size_t ii = 0; ii < TEST_SAMPLE_COUNT; ++ii)
+	{
+		fillSample(expected, ii);
+		assert(0 == RecordingWriter_append(writer, expected));
+	}
+
+	RecordingWriter_destroy(writer);
+
+	SnapshotSource_t* source = SnapshotSource_createReplay(basePath, true);
+	assert(NULL != source);
+	assert(SNAPSHOT_PACING_NONE == SnapshotSource_getPacing(source));
+	assert(TEST_CPU_STATS_LENGTH == SnapshotSource_getCpuStatsLength(source));
+	assert(!SnapshotSource_hasFreqs(source));
+
+	for (size_t ii = 0; ii < TEST_SAMPLE_COUNT; ++ii)
+	{
+		fillSample(expected, ii);
+		assert(1 == SnapshotSource_next(source, replayed));
+		assert(TEST_CPU_STATS_LENGTH == replayed->cpuStatsLength);
+		assert(expected->timestampNs == replayed->timestampNs);
+		assert(0 == memcmp(expected->cpuStats, replayed->cpuStats, TEST_CPU_STATS_LENGTH * sizeof(CpuStat_t)));
+	}
+
+	assert(0 == SnapshotSource_next(source, replayed)); // Source should be exhausted
+	SnapshotSource_destroy(source);
+
+	assert(NULL == SnapshotSource_createReplay("/nonexistent/recording", false));
+
+	char command[128];
+	snprintf(command, sizeof(command), "rm -rf %s", dir);
+	assert(0 == system(command));
+	free(replayed);
+	free(expected);
+}
+
+
+int main()
+{
+	testLiveSource();
+	testReplaySource();
+
+	return 0;
+}
@@ -0,0 +1,262 @@
+#include "stealtrack.h"
+#include "cpucount.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TEST_CPU_COUNT 		2
+#define TEST_VALUES_LENGTH 	(TEST_CPU_COUNT + 1u)
+#define TEST_THRESHOLD_PCT 	10u
+#define TEST_SUSTAIN 		3u
+#define TEST_REPORT_MAX 	1024u
+// Ticks every line advances by over an interval, so that every tick is a basis point
+#define TEST_TICKS 			CPUUSAGE_BP_FULL
+#define TEST_BASE_TICKS 	1000000u
+
+
+/**
+ * Snapshots at both ends of the last interval, usage over it, and trackers fed from snapshots and from their change.
+*/
+typedef struct TestState
+{
+	ProcStat_t* 		oldStat;
+	ProcStat_t* 		newStat;
+	ProcStatDelta_t* 	delta;
+	CpuUsageCompact_t* 	usage;
+	CpuUsageCompact_t* 	fromDelta;
+	StealTracker_t* 	tracker;
+	StealTracker_t* 	deltaTracker;
+}
+TestState_t;
+
+
+/**
+ * \brief Advances every line, total one first, by a single interval busy for given share of it, part of which has been
+ * lost to hypervisor and part spent running guests, and records it into both trackers. Steal and guest are left out
+ * if steal is NULL, processors marked offline have every counter zeroed.
+ * \return Amount of processors flagged or cleared by the interval, the same for both trackers.
+*/
+static int update(TestState_t* state, const BasisPointValue_t* values, const BasisPointValue_t* steal, const BasisPointValue_t* guest)
+{
+	memcpy(state->oldStat, state->newStat, ProcStat_size());
+
+	for (size_t ii = 0; ii < TEST_VALUES_LENGTH; ++ii)
+	{
+		CpuStatValue_t* counters = state->newStat->cpuStats[ii].values;
+
+		if (CPUUSAGE_BP_OFFLINE == values[ii])
+		{
+			memset(counters, 0, sizeof(state->newStat->cpuStats[ii].values));
+			continue;
+		}
+
+		const BasisPointValue_t steald = (NULL != steal) ? steal[ii] : 0u;
+		counters[CSINDEX_IDLE] 	+= TEST_TICKS - values[ii];
+		counters[CSINDEX_USER] 	+= values[ii] - steald;
+		counters[CSINDEX_STEAL] += steald;
+		counters[CSINDEX_GUEST] += (NULL != guest) ? guest[ii] : 0u;
+	}
+
+	CpuUsageCompact_calculate(state->oldStat, state->newStat, state->usage);
+	ProcStatDelta_encode(state->oldStat, state->newStat, state->delta);
+	CpuUsageCompact_calculateFromDelta(state->delta, state->fromDelta);
+
+	const int changed = StealTracker_update(state->tracker, state->oldStat, state->newStat, state->usage);
+	assert(changed == StealTracker_updateFromDelta(state->deltaTracker, state->delta, state->fromDelta));
+	return changed;
+}
+
+
+/**
+ * \brief Checks that both trackers have recorded the same.
+*/
+static void checkSameReports(const StealUsageReport_t* report, const StealUsageReport_t* deltaReport)
+{
+	assert((report->intervals == deltaReport->intervals) && (report->sustainedCount == deltaReport->sustainedCount));
+	assert(0 == memcmp(report->totalBuckets, deltaReport->totalBuckets, sizeof(report->totalBuckets)));
+
+	for (size_t ii = 0; ii <= TEST_CPU_COUNT; ++ii)
+	{
+		const StealCpuUsage_t* usage = (0u == ii) ? &report->total : &report->cpus[ii - 1u];
+		const StealCpuUsage_t* deltaUsage = (0u == ii) ? &deltaReport->total : &deltaReport->cpus[ii - 1u];
+		assert((usage->stealBp == deltaUsage->stealBp) && (usage->guestBp == deltaUsage->guestBp) && (usage->ownBp == deltaUsage->ownBp));
+		assert((usage->p95StealBp == deltaUsage->p95StealBp) && (usage->sustained == deltaUsage->sustained));
+		assert(usage->sustainedIntervals == deltaUsage->sustainedIntervals);
+	}
+}
+
+
+static void printReport(const StealUsageReport_t* report, char* text)
+{
+	// Stream left unwritten does not terminate the buffer
+	memset(text, 0, TEST_REPORT_MAX);
+	FILE* out = fmemopen(text, TEST_REPORT_MAX, "w");
+	assert(NULL != out);
+	StealUsageReport_print(out, report, true);
+	fclose(out);
+}
+
+
+static void test_StealTracker_create(void)
+{
+	assert(NULL == StealTracker_create(0u, TEST_SUSTAIN));
+	assert(NULL == StealTracker_create(101u, TEST_SUSTAIN));
+	assert(NULL == StealTracker_create(TEST_THRESHOLD_PCT, 0u));
+	assert(-1 == StealTracker_update(NULL, NULL, NULL, NULL));
+	assert(-1 == StealTracker_updateFromDelta(NULL, NULL, NULL));
+	StealTracker_destroy(NULL);
+
+	assert(0u == StealTracker_bucketBound(0u));
+	assert(CPUUSAGE_BP_FULL == StealTracker_bucketBound(STEALTRACK_BUCKETS - 1u));
+	assert(CPUUSAGE_BP_FULL == StealTracker_bucketBound(STEALTRACK_BUCKETS));
+
+	for (size_t ii = 1; ii < STEALTRACK_BUCKETS; ++ii)
+	{
+		assert(StealTracker_bucketBound(ii - 1u) < StealTracker_bucketBound(ii));
+	}
+
+	assert(StealUsageReport_size(TEST_CPU_COUNT) == sizeof(StealUsageReport_t) + TEST_CPU_COUNT * sizeof(StealCpuUsage_t));
+}
+
+
+static void test_StealTracker_update(void)
+{
+	TestState_t state =
+	{
+		.oldStat 		= calloc(1u, ProcStat_size()),
+		.newStat 		= calloc(1u, ProcStat_size()),
+		.delta 			= calloc(1u, ProcStatDelta_size()),
+		.usage 			= calloc(1u, CpuUsageCompact_size()),
+		.fromDelta 		= calloc(1u, CpuUsageCompact_size()),
+		.tracker 		= StealTracker_create(TEST_THRESHOLD_PCT, TEST_SUSTAIN),
+		.deltaTracker 	= StealTracker_create(TEST_THRESHOLD_PCT, TEST_SUSTAIN)
+	};
+
+	StealUsageReport_t* report = calloc(1u, StealUsageReport_size(TEST_CPU_COUNT));
+	StealUsageReport_t* deltaReport = calloc(1u, StealUsageReport_size(TEST_CPU_COUNT));
+	assert((NULL != state.oldStat) && (NULL != state.newStat) && (NULL != state.delta) && (NULL != state.usage) && (NULL != state.fromDelta));
+	assert((NULL != state.tracker) && (NULL != state.deltaTracker) && (NULL != report) && (NULL != deltaReport));
+	char text[TEST_REPORT_MAX];
+
+	state.newStat->cpuStatsLength = TEST_VALUES_LENGTH;
+
+	for (size_t ii = 0; ii < TEST_VALUES_LENGTH; ++ii)
+	{
+		state.newStat->cpuStats[ii].values[CSINDEX_IDLE] = TEST_BASE_TICKS;
+	}
+
+	// Nothing is printed until an interval has been recorded
+	StealTracker_report(state.tracker, report);
+	assert(0u == report->intervals);
+	printReport(report, text);
+	assert('\0' == text[0]);
+
+	// Interval without steal nor guest time counts as none of either, processor offline is left out
+	const BasisPointValue_t bareValues[TEST_VALUES_LENGTH] = { 2000u, 4000u, CPUUSAGE_BP_OFFLINE };
+	assert(0 == update(&state, bareValues, NULL, NULL));
+	StealTracker_report(state.tracker, report);
+	assert((1u == report->intervals) && (TEST_CPU_COUNT == report->cpuCount));
+	assert((0u == report->total.stealBp) && (2000u == report->total.ownBp));
+	assert((4000u == report->cpus[0].ownBp) && (0u == report->cpus[0].guestBp));
+	assert(CPUUSAGE_BP_OFFLINE == report->cpus[1].stealBp);
+	assert(CPUUSAGE_BP_OFFLINE == report->cpus[1].ownBp);
+	assert(1u == report->totalBuckets[0]);
+
+	// Processors losing no time to hypervisor are left out
+	printReport(report, text);
+	assert(0 == strcmp(text, "Steal:\t0.00 %, own work 20.00 %, guest 0.00 %, p95 up to 0.00 % over 1 intervals\n"));
+
+	// Steal has to stay past threshold for a few intervals in a row to flag processor,
+	// processor brought back online has no valid usage over the first of them
+	const BasisPointValue_t values[TEST_VALUES_LENGTH] = { 2500u, 5000u, 100u };
+	const BasisPointValue_t guest[TEST_VALUES_LENGTH] = { 100u, 200u, 0u };
+	const BasisPointValue_t highSteal[TEST_VALUES_LENGTH] = { 750u, 1500u, 100u };
+
+	for (unsigned ii = 1; ii < TEST_SUSTAIN; ++ii)
+	{
+		assert(0 == update(&state, values, highSteal, guest));
+	}
+
+	assert(1 == update(&state, values, highSteal, guest));
+	StealTracker_report(state.tracker, report);
+	assert(1u == report->sustainedCount);
+	assert(report->cpus[0].sustained && !report->cpus[1].sustained && !report->total.sustained);
+	assert(TEST_SUSTAIN == report->cpus[0].sustainedIntervals);
+	assert((1500u == report->cpus[0].stealBp) && (3500u == report->cpus[0].ownBp) && (200u == report->cpus[0].guestBp));
+	assert((1750u == report->total.ownBp) && (1000u == report->thresholdBp) && (500u == report->releaseBp));
+	// Processor busy only with steal has no own work
+	assert((100u == report->cpus[1].stealBp) && (0u == report->cpus[1].ownBp));
+	assert((1u == report->totalBuckets[0]) && (TEST_SUSTAIN == report->totalBuckets[5]));
+	assert(2500u == report->cpus[0].p95StealBp);
+	assert(100u == report->cpus[1].p95StealBp);
+	StealTracker_report(state.deltaTracker, deltaReport);
+	checkSameReports(report, deltaReport);
+
+	printReport(report, text);
+	assert(text == strstr(text, "Steal:\t7.50 %, own work 17.50 %, guest 1.00 %, p95 up to 10.00 % over 4 intervals\n"));
+	assert(NULL != strstr(text, "Sustained steal:\t1 processors, flagged at 10.00 %, cleared below 5.00 % for 3 intervals\n"));
+	assert(NULL != strstr(text, "CPU0 steal:\t15.00 %, own work 35.00 %, guest 2.00 %, p95 up to 25.00 %, sustained for 3 intervals\n"));
+	assert(NULL != strstr(text, "CPU1 steal:\t1.00 %, own work 0.00 %, guest 0.00 %, p95 up to 1.00 %\n"));
+
+	// Steal between both thresholds keeps processor flagged
+	const BasisPointValue_t midSteal[TEST_VALUES_LENGTH] = { 300u, 600u, 0u };
+
+	for (unsigned ii = 0; ii < 2u * TEST_SUSTAIN; ++ii)
+	{
+		assert(0 == update(&state, values, midSteal, guest));
+	}
+
+	StealTracker_report(state.tracker, report);
+	assert(report->cpus[0].sustained);
+	assert(3u * TEST_SUSTAIN == report->cpus[0].sustainedIntervals);
+
+	// Steal dropping below release threshold for a single interval is not enough to clear it
+	const BasisPointValue_t lowSteal[TEST_VALUES_LENGTH] = { 200u, 400u, 0u };
+	assert(0 == update(&state, values, lowSteal, guest));
+	assert(0 == update(&state, values, midSteal, guest));
+
+	for (unsigned ii = 1; ii < TEST_SUSTAIN; ++ii)
+	{
+		assert(0 == update(&state, values, lowSteal, guest));
+	}
+
+	assert(1 == update(&state, values, lowSteal, guest));
+	StealTracker_report(state.tracker, report);
+	assert((0u == report->sustainedCount) && !report->cpus[0].sustained);
+	assert(0u == report->cpus[0].sustainedIntervals);
+	StealTracker_report(state.deltaTracker, deltaReport);
+	checkSameReports(report, deltaReport);
+
+	printReport(report, text);
+	assert(NULL == strstr(text, "Sustained steal:"));
+	assert(NULL != strstr(text, "CPU0 steal:\t4.00 %"));
+	// Processor without steal now is still printed, as long as it has had some in enough intervals
+	assert(NULL != strstr(text, "CPU1 steal:\t0.00 %, own work 1.00 %, guest 0.00 %, p95 up to 1.00 %\n"));
+
+	// Usage of mismatched processor count is rejected
+	state.usage->valuesLength = TEST_VALUES_LENGTH + 1u;
+	assert(-1 == StealTracker_update(state.tracker, state.oldStat, state.newStat, state.usage));
+	state.fromDelta->valuesLength = TEST_VALUES_LENGTH + 1u;
+	assert(-1 == StealTracker_updateFromDelta(state.deltaTracker, state.delta, state.fromDelta));
+
+	StealTracker_destroy(state.deltaTracker);
+	StealTracker_destroy(state.tracker);
+	free(deltaReport);
+	free(report);
+	free(state.fromDelta);
+	free(state.usage);
+	free(state.delta);
+	free(state.newStat);
+	free(state.oldStat);
+}
+
+
+int main(void)
+{
+	CpuCount_override(TEST_CPU_COUNT);
+	test_StealTracker_create();
+	test_StealTracker_update();
+	return 0;
+}
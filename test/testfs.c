@@ -0,0 +1,67 @@
+#include "testfs.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+static char g_root[TESTFS_PATH_MAX];
+
+
+/**
+ * \brief Builds path of given file within the tree.
+*/
+static void buildPath(char* path, const char* relative)
+{
+	const int length = snprintf(path, TESTFS_PATH_MAX, "%s/%s", g_root, relative);
+	assert((0 < length) && ((size_t) length < TESTFS_PATH_MAX));
+}
+
+
+const char* TestFs_create(const char* prefix)
+{
+	snprintf(g_root, sizeof(g_root), "/tmp/%s_XXXXXX", prefix);
+	assert(NULL != mkdtemp(g_root));
+	return g_root;
+}
+
+
+void TestFs_destroy(void)
+{
+	assert(0 == rmdir(g_root));
+}
+
+
+const char* TestFs_getRoot(void)
+{
+	return g_root;
+}
+
+
+void TestFs_makeDir(const char* relative)
+{
+	char path[TESTFS_PATH_MAX];
+	buildPath(path, relative);
+	assert(0 == mkdir(path, 0755));
+}
+
+
+void TestFs_writeFile(const char* relative, const char* content)
+{
+	char path[TESTFS_PATH_MAX];
+	buildPath(path, relative);
+
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fputs(content, file);
+	fclose(file);
+}
+
+
+bool TestFs_remove(const char* relative)
+{
+	char path[TESTFS_PATH_MAX];
+	buildPath(path, relative);
+	return 0 == remove(path);
+}
@@ -0,0 +1,62 @@
+/**
+ * \file testfs.h
+ * Temporary directory trees standing in for sysfs and procfs in tests.
+ * Every path is relative to the root directory created by TestFs_create().
+*/
+#ifndef TESTFS_H_INCLUDED
+#define TESTFS_H_INCLUDED
+#include <stdbool.h>
+
+
+/**
+ * Longest path of a file within the tree, including root directory.
+*/
+#define TESTFS_PATH_MAX 256u
+
+
+/**
+ * \brief Creates temporary root directory of the tree.
+ * \param prefix Prefix of it's name, e.g. "cut_cpufreq".
+ * \return Path of root directory.
+*/
+const char* TestFs_create(const char* prefix);
+
+
+/**
+ * \brief Removes root directory of the tree, which has to be empty by then.
+*/
+void TestFs_destroy(void);
+
+
+/**
+ * \brief Retrieves path of root directory of the tree.
+ * \return Path of root directory.
+*/
+const char* TestFs_getRoot(void);
+
+
+/**
+ * \brief Creates directory within the tree.
+ * \param relative Path of directory, relative to root.
+*/
+void TestFs_makeDir(const char* relative);
+
+
+/**
+ * \brief Writes file within the tree, rewriting it in place if it exists,
+ * so that descriptors kept open by code under test see new contents.
+ * \param relative Path of file, relative to root.
+ * \param content Text to write.
+*/
+void TestFs_writeFile(const char* relative, const char* content);
+
+
+/**
+ * \brief Removes file or empty directory within the tree.
+ * \param relative Path of file or directory, relative to root.
+ * \return True if it has been removed, false otherwise.
+*/
+bool TestFs_remove(const char* relative);
+
+
+#endif // !TESTFS_H_INCLUDED
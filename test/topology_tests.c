@@ -0,0 +1,200 @@
+#include "topology.h"
+#include "cpuusage.h"
+#include "cpucount.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+#define TEST_CPU_COUNT 		8u
+#define TEST_PATH_MAX 		256u
+
+
+// Two packages, two cores each with two SMT siblings, one NUMA node per package; cpu7 exposes no topology
+static const int TEST_PACKAGES[TEST_CPU_COUNT] 	= { 0, 0, 1, 1, 0, 0, 1, -1 };
+static const int TEST_CORES[TEST_CPU_COUNT] 	= { 0, 1, 0, 1, 0, 1, 0, -1 };
+static const int TEST_NODES[TEST_CPU_COUNT] 	= { 0, 0, 1, 1, 0, 0, 1, 1 };
+
+
+static void writeAttribute(const char* path, int value)
+{
+	FILE* file = fopen(path, "w");
+	assert(NULL != file);
+	fprintf(file, "%d\n", value);
+	fclose(file);
+}
+
+
+static void createSysTree(const char* root)
+{
+	char path[TEST_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/cpu", root);
+	assert(0 == mkdir(path, 0700));
+
+	for (unsigned ii = 0; ii < TEST_CPU_COUNT; ++ii)
+	{
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u", root, ii);
+		assert(0 == mkdir(path, 0700));
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/node%d", root, ii, TEST_NODES[ii]);
+		assert(0 == mkdir(path, 0700));
+
+		if (0 > TEST_CORES[ii])
+		{
+			continue;
+		}
+
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology", root, ii);
+		assert(0 == mkdir(path, 0700));
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology/core_id", root, ii);
+		writeAttribute(path, TEST_CORES[ii]);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology/physical_package_id", root, ii);
+		writeAttribute(path, TEST_PACKAGES[ii]);
+	}
+}
+
+
+static void removeSysTree(const char* root)
+{
+	char path[TEST_PATH_MAX];
+
+	for (unsigned ii = 0; ii < TEST_CPU_COUNT; ++ii)
+	{
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology/core_id", root, ii);
+		remove(path);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology/physical_package_id", root, ii);
+		remove(path);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/topology", root, ii);
+		rmdir(path);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u/node%d", root, ii, TEST_NODES[ii]);
+		rmdir(path);
+		snprintf(path, sizeof(path), "%s/cpu/cpu%u", root, ii);
+		rmdir(path);
+	}
+
+	snprintf(path, sizeof(path), "%s/cpu", root);
+	rmdir(path);
+	rmdir(root);
+}
+
+
+static void test_Topology_load(const char* root)
+{
+	// Processors missing from sysfs are cores of their own in unknown package
+	CpuTopology_t* topology = Topology_load(root, TEST_CPU_COUNT + 1u);
+	assert(NULL != topology);
+	assert(6u == topology->groupCounts[TLEVEL_CORE]);
+	assert(-1 == topology->groupIds[TLEVEL_PACKAGE][topology->groupOf[TLEVEL_PACKAGE][TEST_CPU_COUNT]]);
+	assert(0 == topology->groupIds[TLEVEL_NODE][topology->groupOf[TLEVEL_NODE][TEST_CPU_COUNT]]);
+	Topology_destroy(topology);
+
+	topology = Topology_load(root, TEST_CPU_COUNT);
+	assert(NULL != topology);
+
+	// Four cores, one of them with a single known sibling, and cpu7 as a core of it's own
+	assert(5u == topology->groupCounts[TLEVEL_CORE]);
+	assert(3u == topology->groupCounts[TLEVEL_PACKAGE]);
+	assert(2u == topology->groupCounts[TLEVEL_NODE]);
+	assert(10u == topology->groupTotal);
+
+	assert(topology->groupOf[TLEVEL_CORE][0] == topology->groupOf[TLEVEL_CORE][4]);
+	assert(topology->groupOf[TLEVEL_CORE][0] != topology->groupOf[TLEVEL_CORE][2]);
+	assert(topology->groupOf[TLEVEL_CORE][3] != topology->groupOf[TLEVEL_CORE][7]);
+	assert(-1 == topology->groupIds[TLEVEL_PACKAGE][topology->groupOf[TLEVEL_PACKAGE][7]]);
+
+	// Visiting every group of a level visits every processor exactly once
+	for (int level = 0; level < TLEVEL_COUNT_; ++level)
+	{
+		unsigned seen[TEST_CPU_COUNT] = { 0 };
+		assert(TEST_CPU_COUNT == topology->memberStarts[level][topology->groupCounts[level]]);
+
+		for (size_t group = 0; group < topology->groupCounts[level]; ++group)
+		{
+			for (uint32_t ii = topology->memberStarts[level][group]; ii < topology->memberStarts[level][group + 1u]; ++ii)
+			{
+				const uint32_t cpu = topology->members[level][ii];
+				assert(group == topology->groupOf[level][cpu]);
+				++seen[cpu];
+			}
+		}
+
+		for (unsigned ii = 0; ii < TEST_CPU_COUNT; ++ii)
+		{
+			assert(1u == seen[ii]);
+		}
+	}
+
+	Topology_destroy(topology);
+}
+
+
+static void test_CpuUsageCompact_rollup(const char* root)
+{
+	CpuTopology_t* topology = Topology_load(root, TEST_CPU_COUNT);
+	CpuUsageCompact_t* usage = malloc(CpuUsageCompact_sizeWithRollups(topology));
+	assert((NULL != topology) && (NULL != usage));
+	assert(CpuUsageCompact_sizeWithRollups(topology) == CpuUsageCompact_size() + topology->groupTotal * sizeof(BasisPointValue_t));
+
+	memset(usage, 0, sizeof(CpuUsageCompact_t));
+	usage->valuesLength = TEST_CPU_COUNT + 1u;
+	usage->values[0] = 3500u;
+
+	for (unsigned ii = 0; ii < TEST_CPU_COUNT; ++ii)
+	{
+		usage->values[ii + 1u] = (6u == ii) ? CPUUSAGE_BP_INVALID : (BasisPointValue_t) (1000u * ii);
+	}
+
+	CpuUsageCompact_rollup(topology, usage);
+	assert(topology->groupTotal == usage->rollupsLength);
+
+	char* text = NULL;
+	size_t textSize = 0u;
+	FILE* stream = open_memstream(&text, &textSize);
+	assert(NULL != stream);
+	CpuUsageCompact_printRollups(stream, topology, usage, TOPOLOGY_LEVEL_BIT(TLEVEL_CORE) | TOPOLOGY_LEVEL_BIT(TLEVEL_NODE));
+	fclose(stream);
+
+	// Invalid processor values are left out of averages
+	assert(NULL != strstr(text, "Node0:\t25.00 %\n"));
+	assert(NULL != strstr(text, "Node1:\t40.00 %\n"));
+	assert(NULL != strstr(text, "Core0.0:\t20.00 %\n"));
+	assert(NULL != strstr(text, "Core1.0:\t20.00 %\n"));
+	assert(NULL != strstr(text, "Core-1.-1:\t70.00 %\n"));
+	assert(NULL == strstr(text, "Package"));
+	assert(strstr(text, "Node0:") < strstr(text, "Core0.0:"));
+	free(text);
+
+	Topology_destroy(topology);
+
+	// Flat topology puts every processor into a separate core of the only package and node
+	topology = Topology_createFlat(TEST_CPU_COUNT);
+	assert(NULL != topology);
+	assert(TEST_CPU_COUNT + 2u == topology->groupTotal);
+	CpuUsageCompact_rollup(topology, usage);
+	const BasisPointValue_t* groups = usage->values + usage->valuesLength;
+	assert(1000u == groups[1]);
+	assert(3143u == groups[TEST_CPU_COUNT]);
+	assert(groups[TEST_CPU_COUNT] == groups[TEST_CPU_COUNT + 1u]);
+
+	Topology_destroy(topology);
+	free(usage);
+}
+
+
+int main(void)
+{
+	CpuCount_override(TEST_CPU_COUNT);
+	CpuCount_init();
+
+	char root[] = "/tmp/cut_topology_XXXXXX";
+	assert(NULL != mkdtemp(root));
+	createSysTree(root);
+
+	test_Topology_load(root);
+	test_CpuUsageCompact_rollup(root);
+
+	removeSysTree(root);
+	return 0;
+}